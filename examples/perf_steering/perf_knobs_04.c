@@ -0,0 +1,141 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <math.h>
+#include <string.h>
+
+/*
+ * Let a knob tuner find the value of the dmda alpha knob which maximizes the
+ * number of tasks per second. For the sake of the example, the tasks
+ * themselves are made faster when alpha gets close to 2.
+ */
+
+#define NTASKS 100
+#define NPHASES 30
+#define BEST_ALPHA 2.
+
+#ifdef STARPU_QUICK_CHECK
+#define TASK_DURATION 1000
+#else
+#define TASK_DURATION 5000
+#endif
+
+static int alpha_id;
+
+void cpu_func(void *buffer[], void *cl_arg)
+{
+	(void)buffer;
+	(void)cl_arg;
+	double alpha = starpu_perf_knob_get_per_scheduler_double_value(alpha_id, "dmda");
+	starpu_usleep(TASK_DURATION * (1. + 2. * fabs(alpha - BEST_ALPHA)));
+}
+
+static struct starpu_codelet cl =
+{
+	.cpu_funcs = {cpu_func},
+	.name = "knob_sensitive"
+};
+
+static void phase(void)
+{
+	int i, ret;
+	for (i = 0; i < NTASKS; i++)
+	{
+		ret = starpu_task_insert(&cl, 0);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_task_wait_for_all();
+}
+
+int main(int argc, char **argv)
+{
+	struct starpu_perf_knob_tuner *tuner;
+	int ret, i, calibrate_id;
+	double alpha;
+
+	struct starpu_conf conf;
+	starpu_conf_init(&conf);
+	starpu_conf_noworker(&conf);
+	conf.ncpus = 2;
+	{
+		const char *sched_pol_name = starpu_getenv("STARPU_SCHED");
+		if (sched_pol_name != NULL && strcmp(sched_pol_name, "dmda") != 0)
+		{
+			fprintf(stderr, "example uses 'dmda' scheduling policy.\n");
+			return 77;
+		}
+	}
+
+	conf.sched_policy_name = "dmda";
+
+	ret = starpu_initialize(&conf, &argc, &argv);
+	if (ret == -ENODEV)
+		return 77;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (starpu_cpu_worker_get_count() == 0)
+	{
+		starpu_shutdown();
+		fprintf(stderr, "example needs cpu cores.\n");
+		return 77;
+	}
+
+	alpha_id = starpu_perf_knob_name_to_id(starpu_perf_knob_scope_per_scheduler, "starpu.dmda.s_alpha_knob");
+	calibrate_id = starpu_perf_knob_name_to_id(starpu_perf_knob_scope_global, "starpu.global.g_calibrate_knob");
+
+	/* Start from the default alpha, and make sure to explore rather than
+	 * reusing what a previous run has found */
+	starpu_perf_knob_set_per_scheduler_double_value(alpha_id, "dmda", 1.);
+	starpu_perf_knob_set_global_int32_value(calibrate_id, 2);
+
+	tuner = starpu_perf_knob_tuner_init("perf_knobs_04", starpu_perf_knob_tuner_objective_tasks_per_second);
+	starpu_perf_knob_tuner_add_knob(tuner, alpha_id, 0.5, 4., 0.5);
+	for (i = 0; i < NPHASES && !starpu_perf_knob_tuner_converged(tuner); i++)
+	{
+		starpu_perf_knob_tuner_phase_start(tuner);
+		alpha = starpu_perf_knob_get_per_scheduler_double_value(alpha_id, "dmda");
+		phase();
+		double value = starpu_perf_knob_tuner_phase_end(tuner);
+		printf("phase %d: alpha %g, %g tasks per second\n", i, alpha, value);
+	}
+	STARPU_ASSERT_MSG(starpu_perf_knob_tuner_converged(tuner), "tuner did not converge in %d phases\n", NPHASES);
+	printf("best configuration:");
+	starpu_perf_knob_tuner_print(tuner, stdout);
+	starpu_perf_knob_tuner_exit(tuner);
+
+	alpha = starpu_perf_knob_get_per_scheduler_double_value(alpha_id, "dmda");
+	STARPU_ASSERT_MSG(alpha == BEST_ALPHA, "tuner found alpha %g instead of %g\n", alpha, BEST_ALPHA);
+
+	/* A new tuner directly reuses the saved configuration */
+	starpu_perf_knob_set_per_scheduler_double_value(alpha_id, "dmda", 1.);
+	starpu_perf_knob_set_global_int32_value(calibrate_id, 0);
+
+	tuner = starpu_perf_knob_tuner_init("perf_knobs_04", starpu_perf_knob_tuner_objective_tasks_per_second);
+	starpu_perf_knob_tuner_add_knob(tuner, alpha_id, 0.5, 4., 0.5);
+	starpu_perf_knob_tuner_phase_start(tuner);
+	STARPU_ASSERT(starpu_perf_knob_tuner_converged(tuner));
+	phase();
+	starpu_perf_knob_tuner_phase_end(tuner);
+	starpu_perf_knob_tuner_exit(tuner);
+
+	alpha = starpu_perf_knob_get_per_scheduler_double_value(alpha_id, "dmda");
+	STARPU_ASSERT_MSG(alpha == BEST_ALPHA, "saved configuration has alpha %g instead of %g\n", alpha, BEST_ALPHA);
+
+	starpu_shutdown();
+
+	return 0;
+}
@@ -137,7 +137,34 @@ struct starpu_disk_ops
 	*/
 	void (*free_request)(void *async_channel);
 
-	/* TODO: readv, writev, read2d, write2d, etc. */
+	/**
+	   Read \p numblocks blocks of \p blocksize bytes from \p obj in \p base,
+	   starting at offset \p offset and \p ld_obj bytes apart, and put them
+	   into \p buf, \p ld_buf bytes apart. Return 0 on success. This method is
+	   optional, StarPU otherwise reads the blocks one by one.
+	*/
+	int (*read2d)(void *base, void *obj, void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf);
+	/**
+	   Write \p numblocks blocks of \p blocksize bytes to \p obj in \p base,
+	   starting at offset \p offset and \p ld_obj bytes apart, from \p buf,
+	   \p ld_buf bytes apart. Return 0 on success. This method is optional,
+	   StarPU otherwise writes the blocks one by one.
+	*/
+	int (*write2d)(void *base, void *obj, const void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf);
+	/**
+	   Asynchronous version of starpu_disk_ops::read2d, submitted as one
+	   request. Return a void* pointer that StarPU will pass to \c xxx_request
+	   methods for testing for the completion, or <c>NULL</c> if it could not
+	   be submitted.
+	*/
+	void *(*async_read2d)(void *base, void *obj, void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf);
+	/**
+	   Asynchronous version of starpu_disk_ops::write2d, submitted as one
+	   request. Return a void* pointer that StarPU will pass to \c xxx_request
+	   methods for testing for the completion, or <c>NULL</c> if it could not
+	   be submitted.
+	*/
+	void *(*async_write2d)(void *base, void *obj, void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf);
 };
 
 /**
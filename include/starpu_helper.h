@@ -216,6 +216,9 @@ double starpu_timing_now(void);
    \p callback_func is not <c>NULL</c>, this callback function is executed after
    the handle has been copied, and it is given the pointer \p
    callback_arg as argument.
+   When no callback is given, the copy may be deferred until either handle is
+   modified, read-only accesses to \p dst_handle being meanwhile performed on
+   \p src_handle.
    See \ref DataHandlesHelpers for more details.
 */
 int starpu_data_cpy(starpu_data_handle_t dst_handle, starpu_data_handle_t src_handle, int asynchronous, void (*callback_func)(void *), void *callback_arg);
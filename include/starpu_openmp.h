@@ -1302,6 +1302,19 @@ extern void starpu_omp_handle_unregister(starpu_data_handle_t handle) __STARPU_O
 */
 extern starpu_data_handle_t starpu_omp_data_lookup(const void *ptr) __STARPU_OMP_NOTHROW;
 
+/**
+   Look for the handles registered with starpu_omp_handle_register() whose
+   data overlaps the \p size bytes pointed to by the \p ptr host pointer,
+   and store at most \p max of them in \p handles.
+
+   \return the number of such handles, which may be larger than \p max.
+
+   \sa starpu_omp_data_lookup
+
+   See \ref OMPDataDependencies for more details.
+*/
+extern int starpu_omp_data_lookup_overlaps(const void *ptr, size_t size, starpu_data_handle_t *handles, int max) __STARPU_OMP_NOTHROW;
+
 /** @} */
 
 #ifdef __cplusplus
@@ -261,6 +261,75 @@ void starpu_perf_knob_set_per_scheduler_double_value(const int knob_id, const ch
 
 /** @} */
 
+/**
+   @name Knob Autotuning
+   \anchor PM_Tuner
+   @{
+*/
+
+/**
+   Enum of the objectives which can be maximized by a knob tuner.
+ */
+enum starpu_perf_knob_tuner_objective
+{
+	starpu_perf_knob_tuner_objective_tasks_per_second = 1, /**< number of tasks executed per second */
+	starpu_perf_knob_tuner_objective_busy_ratio	  = 2  /**< ratio of the time spent by workers executing tasks */
+};
+
+/**
+   Opaque knob tuner structure.
+ */
+struct starpu_perf_knob_tuner;
+
+/**
+   Create a knob tuner maximizing \p objective. \p name identifies the
+   tuner of the application, the best configuration found is saved in the
+   \c tuning directory of the performance model directory under this name
+   and the host name, so that later runs directly reuse it. This enables the
+   collection of performance counters until starpu_perf_knob_tuner_exit() is
+   called.
+*/
+struct starpu_perf_knob_tuner *starpu_perf_knob_tuner_init(const char *name, enum starpu_perf_knob_tuner_objective objective);
+
+/**
+   Let the tuner \p tuner explore values from \p min to \p max with
+   increments of \p step for the knob \p knob_id. Per-worker knobs are
+   given the same value on all workers, per-scheduler knobs are set for the
+   current scheduling policy. This must be called before the first phase.
+*/
+void starpu_perf_knob_tuner_add_knob(struct starpu_perf_knob_tuner *tuner, int knob_id, double min, double max, double step);
+
+/**
+   Start a measurement phase, typically an iteration of the application,
+   after applying the next configuration to be evaluated.
+*/
+void starpu_perf_knob_tuner_phase_start(struct starpu_perf_knob_tuner *tuner);
+
+/**
+   End a measurement phase, which should be called after waiting for the
+   tasks of the phase, and choose the next configuration to be evaluated.
+   Return the value of the objective measured over the phase.
+*/
+double starpu_perf_knob_tuner_phase_end(struct starpu_perf_knob_tuner *tuner);
+
+/**
+   Return whether the tuner has settled on its best configuration, either
+   after exploration, or by loading the configuration saved by a previous run.
+*/
+int starpu_perf_knob_tuner_converged(struct starpu_perf_knob_tuner *tuner);
+
+/**
+   Print the best knob values found so far on \p output.
+*/
+void starpu_perf_knob_tuner_print(struct starpu_perf_knob_tuner *tuner, FILE *output);
+
+/**
+   Apply the best configuration found so far and release \p tuner.
+*/
+void starpu_perf_knob_tuner_exit(struct starpu_perf_knob_tuner *tuner);
+
+/** @} */
+
 /** @} */
 
 #ifdef __cplusplus
@@ -512,6 +512,53 @@ double starpu_transfer_latency(unsigned src_node, unsigned dst_node);
 */
 double starpu_transfer_predict(unsigned src_node, unsigned dst_node, size_t size);
 
+/**
+   Describe a kind of task of an algorithm, for
+   starpu_perfmodel_select_tile_size(). All functions get the tile size
+   and the field starpu_tile_size_kernel::arg.
+   See \ref TileSizeSelection for more details.
+*/
+struct starpu_tile_size_kernel
+{
+	/**
+	   Codelet of the tasks. Its performance model must be of type
+	   ::STARPU_REGRESSION_BASED or ::STARPU_NL_REGRESSION_BASED.
+	*/
+	struct starpu_codelet *cl;
+	/**
+	   Return the number of such tasks run by the algorithm.
+	*/
+	double (*ntasks)(unsigned tile_size, void *arg);
+	/**
+	   Optional: return the number of such tasks on the critical path
+	   of the algorithm.
+	*/
+	double (*ncritical)(unsigned tile_size, void *arg);
+	/**
+	   Return the size of such tasks, as computed by the performance
+	   model, i.e. the size of their data unless the model has a
+	   starpu_perfmodel::size_base function.
+	*/
+	size_t (*size)(unsigned tile_size, void *arg);
+	void *arg;
+};
+
+/**
+   Return the tile size among the \p ntile_sizes ones of \p tile_sizes
+   which minimizes the makespan of the algorithm described by the \p
+   nkernels kinds of tasks of \p kernels, as predicted by a list
+   scheduling of its tasks on the workers, using the performance models
+   of the codelets. The prediction is stored in \p makespan (in µs) if
+   it is not <c>NULL</c>.
+
+   If a tile size cannot be predicted because the performance models
+   are not calibrated for it yet, it is returned, and \p makespan is set
+   to NaN, so that running the application with it calibrates the
+   models. The choice is thus refined over the runs of the application.
+   See \ref TileSizeSelection for more details.
+*/
+unsigned starpu_perfmodel_select_tile_size(const struct starpu_tile_size_kernel *kernels, unsigned nkernels, const unsigned *tile_sizes, unsigned ntile_sizes, double *makespan);
+
 /**
    Performance model which just always return 1µs.
 */
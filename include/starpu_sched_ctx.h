@@ -321,6 +321,18 @@ void starpu_sched_ctx_set_priority(int *workers, int nworkers, unsigned sched_ct
 
 unsigned starpu_sched_ctx_get_priority(int worker, unsigned sched_ctx_id);
 
+/**
+   Let the \p nsched_ctxs contexts of \p sched_ctx_ids, typically
+   sibling contexts of the different components of an application,
+   borrow idle workers from each other. Up to \p max_lent workers of
+   each context are also added to the other contexts, with a lower
+   priority than their own context, so that they only execute tasks of
+   the other contexts when their own context has no task ready.
+   This has to be called before submitting tasks to the contexts.
+   See \ref SharingWorkersBetweenContexts for more details.
+*/
+void starpu_sched_ctx_share_workers(unsigned *sched_ctx_ids, unsigned nsched_ctxs, unsigned max_lent);
+
 void starpu_sched_ctx_get_available_cpuids(unsigned sched_ctx_id, int **cpuids, int *ncpuids);
 
 void starpu_sched_ctx_bind_current_thread_to_cpuid(unsigned cpuid);
@@ -118,6 +118,24 @@ extern "C" {
 */
 #define STARPU_CODELET_NOPLANS (1 << 2)
 
+/**
+   Value to be set in starpu_codelet::flags to make the callback of the
+   codelet's tasks run on a callback thread rather than on the worker which
+   executed the task, see starpu_task::callback_offload.
+*/
+#define STARPU_CODELET_CALLBACK_OFFLOAD (1 << 3)
+
+/**
+   Value to be set in starpu_codelet::flags to declare that the CPU
+   implementation of the codelet is elementwise: all its buffers are
+   vectors of the same size, and applying the implementation to the same
+   part of each of them separately gives the same result as applying it to
+   the whole vectors. When the \ref STARPU_TASK_FUSION environment
+   variable is set, consecutive tasks of such codelets which work on the
+   same vectors are merged into one task. See \ref TaskFusion.
+*/
+#define STARPU_CODELET_FUSABLE (1 << 4)
+
 /**
    Value to be set in starpu_codelet::cuda_flags to allow asynchronous
    CUDA kernel execution. This requires to use the proper CUDA stream,
@@ -1238,6 +1256,23 @@ struct starpu_task
 	*/
 	unsigned no_submitorder : 1;
 
+	/**
+	   Optional field. If set, the callback of the task (either
+	   starpu_task::callback_func or starpu_codelet::callback_func)
+	   is not executed on the worker which executed the task, but
+	   queued to a pool of callback threads, so that the worker can
+	   proceed with other tasks. Dependencies of the task are still
+	   released by the worker before queuing the callback, but
+	   starpu_task_wait() and starpu_task_wait_for_all() still wait
+	   for the callback to complete. The number of callback threads
+	   is set by the environment variable \ref
+	   STARPU_NCALLBACK_THREADS. This can also be enabled for all
+	   tasks of a codelet with ::STARPU_CODELET_CALLBACK_OFFLOAD.
+
+	   This is ignored for starpu_task::epilogue_callback_func.
+	*/
+	unsigned callback_offload : 1;
+
 	/**
 	   @private
 	   This is only used for tasks that use multiformat handle.
@@ -1449,6 +1484,14 @@ struct starpu_task
 	   Set by StarPU.
 	*/
 	double predicted_transfer;
+	/**
+	   Output field. Predicted start date of the task in microseconds, as
+	   returned by starpu_timing_now(). This field is only valid if the
+	   scheduling strategy uses performance models. It is used to process
+	   the data transfers for the task in time.
+
+	   Set by StarPU.
+	*/
 	double predicted_start;
 
 	/**
@@ -0,0 +1,86 @@
+# StarPU --- Runtime system for heterogeneous multicore architectures.
+#
+# Copyright (C) 2020-2024   University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+#
+# StarPU is free software; you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation; either version 2.1 of the License, or (at
+# your option) any later version.
+#
+# StarPU is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+#
+# See the GNU Lesser General Public License in COPYING.LGPL for more details.
+#
+using StarPU
+
+# Submit many tasks with slow callbacks, and check that the workers do not
+# wait for the callbacks: all the tasks must be over before all the
+# callbacks are.
+
+const NTASKS = 200
+const CALLBACK_DURATION = 0.005
+
+@target STARPU_CPU
+@codelet function increment(val ::Ref{Int32}) :: Nothing
+    val[] = val[] + 1
+
+    return
+end
+
+ncallbacks = Threads.Atomic{Int}(0)
+
+function callback(arg)
+    Libc.systemsleep(CALLBACK_DURATION)
+    Threads.atomic_add!(ncallbacks, 1)
+end
+
+function run_tasks(ntasks)
+    vals = [Ref(Int32(0)) for i in 1:ntasks]
+    ncallbacks[] = 0
+
+    cl = starpu_codelet(
+        cpu_func = "increment",
+        modes = [STARPU_RW]
+    )
+
+    @starpu_block let
+        handles = [starpu_data_register(v) for v in vals]
+
+        for i in 1:ntasks
+            task = starpu_task(cl = cl, handles = [handles[i]],
+                               callback = callback, callback_arg = i)
+            ret = starpu_task_submit(task)
+            if ret != 0
+                error("task submission failed: $ret")
+            end
+        end
+
+        # Only wait for the tasks themselves: if the workers waited for
+        # the callbacks, they would all be over by now
+        StarPU.@starpucall starpu_task_wait_for_all Cint ()
+        done = ncallbacks[]
+
+        starpu_task_wait_for_all()
+
+        println(done, " callbacks out of ", ntasks, " were over when the tasks were")
+        if done == ntasks
+            error("workers waited for the callbacks")
+        end
+    end
+
+    if ncallbacks[] != ntasks
+        error("$(ncallbacks[]) callbacks run instead of $ntasks")
+    end
+    if any(v -> v[] != 1, vals)
+        error("result is incorrect")
+    end
+end
+
+starpu_init()
+# Get the codelet and the callback path compiled first
+run_tasks(2)
+run_tasks(NTASKS)
+println("result is correct")
+starpu_shutdown()
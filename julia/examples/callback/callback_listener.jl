@@ -0,0 +1,84 @@
+# StarPU --- Runtime system for heterogeneous multicore architectures.
+#
+# Copyright (C) 2020-2024   University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+#
+# StarPU is free software; you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation; either version 2.1 of the License, or (at
+# your option) any later version.
+#
+# StarPU is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+#
+# See the GNU Lesser General Public License in COPYING.LGPL for more details.
+#
+using StarPU
+
+# Check that task callbacks are run on the Julia side, by the callback
+# listener: they must all run in the same Julia task, which is not the one
+# submitting the tasks, and each with its own argument.
+
+const NTASKS = 50
+
+@target STARPU_CPU
+@codelet function increment(val ::Ref{Int32}) :: Nothing
+    val[] = val[] + 1
+
+    return
+end
+
+callback_tasks = Vector{Task}()
+callback_args = Vector{Int}()
+callback_lock = ReentrantLock()
+
+function callback(arg)
+    lock(callback_lock)
+    push!(callback_tasks, current_task())
+    push!(callback_args, arg)
+    unlock(callback_lock)
+end
+
+function run_tasks(ntasks)
+    vals = [Ref(Int32(0)) for i in 1:ntasks]
+    empty!(callback_tasks)
+    empty!(callback_args)
+
+    cl = starpu_codelet(
+        cpu_func = "increment",
+        modes = [STARPU_RW]
+    )
+
+    @starpu_block let
+        handles = [starpu_data_register(v) for v in vals]
+
+        for i in 1:ntasks
+            task = starpu_task(cl = cl, handles = [handles[i]],
+                               callback = callback, callback_arg = i)
+            ret = starpu_task_submit(task)
+            if ret != 0
+                error("task submission failed: $ret")
+            end
+        end
+
+        starpu_task_wait_for_all()
+    end
+
+    if sort(callback_args) != collect(1:ntasks)
+        error("callbacks run with arguments $(sort(callback_args)) instead of 1:$ntasks")
+    end
+    if any(t -> t !== callback_tasks[1], callback_tasks)
+        error("callbacks were not all run by the listener task")
+    end
+    if callback_tasks[1] === current_task()
+        error("callbacks were run by the submitting task")
+    end
+    if any(v -> v[] != 1, vals)
+        error("result is incorrect")
+    end
+end
+
+starpu_init()
+run_tasks(NTASKS)
+println("result is correct")
+starpu_shutdown()
@@ -18,6 +18,7 @@ __precompile__()
 """
 module StarPU
 import Libdl
+import SHA
 using CBinding
 
 include("utils.jl")
@@ -22,18 +22,94 @@ void  *dummy_function_list[] = {
 				starpu_init,
 };
 
+/*
+ * Julia task callbacks are not run by the StarPU workers: the worker only
+ * pushes the callback on a lock-free list and wakes up the Julia listener
+ * through a libuv async handle (a Julia AsyncCondition), and goes on with
+ * its work. The listener then pops the callbacks in the order in which they
+ * were triggered and runs them.
+ */
+struct julia_callback
+{
+  struct julia_callback *next;
+  uintptr_t id;
+};
+
+/* Pushed by the workers */
+static struct julia_callback *volatile julia_callback_pending;
+/* Only accessed by the Julia listener */
+static struct julia_callback *julia_callback_ready;
+
+static void *julia_callback_handle;
+static int (*julia_callback_notify)(void *handle);
+
+void julia_callback_init(void *handle, void *notify)
+{
+  julia_callback_handle = handle;
+  julia_callback_notify = notify;
+}
+
+void *julia_callback_new(uintptr_t id)
+{
+  struct julia_callback *callback = malloc(sizeof(*callback));
+  STARPU_ASSERT(callback);
+  callback->next = NULL;
+  callback->id = id;
+  return callback;
+}
+
+/* Release a callback which will never be triggered */
+void julia_callback_delete(void *user_data)
+{
+  free(user_data);
+}
+
 void julia_callback_func(void *user_data)
 {
-  volatile int *signal = (int *) user_data;
+  struct julia_callback *callback = user_data;
+  struct julia_callback *head;
 
-  // wakeup callback
-  *(signal) = 1;
+  do
+  {
+    head = julia_callback_pending;
+    callback->next = head;
+  }
+  while (!STARPU_BOOL_COMPARE_AND_SWAP_PTR(&julia_callback_pending, head, callback));
 
-  // Wait for callback to end.
-  while ((*signal) != 0);
+  julia_callback_notify(julia_callback_handle);
 }
 
-void julia_wait_signal(volatile int *signal)
+/* Return the id of the next callback to be run, 0 if there is none */
+uintptr_t julia_callback_next(void)
 {
-  while ((*signal) == 0);
+  struct julia_callback *callback;
+  uintptr_t id;
+
+  if (!julia_callback_ready)
+  {
+    struct julia_callback *head;
+
+    do
+      head = julia_callback_pending;
+    while (head && !STARPU_BOOL_COMPARE_AND_SWAP_PTR(&julia_callback_pending, head, NULL));
+
+    /* The list was pushed in reverse order */
+    while (head)
+    {
+      struct julia_callback *next = head->next;
+      head->next = julia_callback_ready;
+      julia_callback_ready = head;
+      head = next;
+    }
+
+    if (!julia_callback_ready)
+      return 0;
+  }
+
+  callback = julia_callback_ready;
+  julia_callback_ready = callback->next;
+  id = callback->id;
+  free(callback);
+
+  return id;
 }
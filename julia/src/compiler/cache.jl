@@ -0,0 +1,134 @@
+# StarPU --- Runtime system for heterogeneous multicore architectures.
+#
+# Copyright (C) 2020-2024   University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+#
+# StarPU is free software; you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation; either version 2.1 of the License, or (at
+# your option) any later version.
+#
+# StarPU is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+#
+# See the GNU Lesser General Public License in COPYING.LGPL for more details.
+#
+
+# Each generated codelet is compiled into its own shared object, kept in an
+# on-disk cache so that later sessions do not compile it again. Objects are
+# named after a SHA-256 of the codelet code (including the types of its
+# parameters), of the targets, of this compiler and of the compilation rules.
+# The compilation is started in the background as soon as the codelet is
+# generated, and only waited for when the codelet is first used.
+
+mutable struct starpu_kernel_lib
+    path :: String
+    tmp_path :: String
+    process :: Union{Nothing, Base.Process}
+    handle :: Ptr{Cvoid}
+end
+
+# codelet name -> shared object
+global kernel_libs = Dict{String, starpu_kernel_lib}()
+# function name -> codelet name
+global kernel_functions = Dict{String, String}()
+
+global compiler_hash = nothing
+
+function starpu_kernel_cache_dir()
+    dir = get(ENV, "STARPU_JULIA_CACHE_DIR", "")
+    if isempty(dir)
+        dir = joinpath(get(ENV, "STARPU_HOME", homedir()), ".starpu", "julia")
+    end
+    mkpath(dir)
+    return dir
+end
+
+function starpu_kernel_makefile()
+    srcdir = get(ENV, "STARPU_JULIA_BUILD", 0)
+    if (srcdir == 0)
+        error("Must define environment variable STARPU_JULIA_BUILD")
+    end
+    return string(srcdir, "/src/dynamic_compiler/Makefile")
+end
+
+# Each input is prefixed by its length, so that moving bytes from one to the
+# next does not give the same key. Unlike Base.hash, the digest does not depend
+# on the Julia version or on the session.
+function starpu_kernel_key(inputs...)
+    io = IOBuffer()
+    for input in inputs
+        bytes = Vector{UInt8}(string(input))
+        write(io, UInt64(length(bytes)))
+        write(io, bytes)
+    end
+    return bytes2hex(SHA.sha256(take!(io)))
+end
+
+function starpu_compiler_hash()
+    if compiler_hash == nothing
+        files = sort(readdir(@__DIR__))
+        global compiler_hash = starpu_kernel_key(VERSION, (read(joinpath(@__DIR__, file), String) for file in files)...)
+    end
+    return compiler_hash
+end
+
+"""
+    Starts compiling the given generated sources of codelet name, unless they
+    are already in the cache.
+"""
+function starpu_compile_kernel(name :: String, code :: Expr, functions :: Vector{String}, sources :: Vector{String})
+    # The codelets are taken from an external library instead
+    if (get(ENV, "JULIA_TASK_LIB", 0) != 0)
+        return
+    end
+
+    makefile = starpu_kernel_makefile()
+
+    key = starpu_kernel_key(starpu_compiler_hash(), read(makefile, String), starpu_target,
+                            Base.remove_linenums!(deepcopy(code)))
+    path = joinpath(starpu_kernel_cache_dir(), string(name, "_", key, ".so"))
+
+    for f in functions
+        kernel_functions[f] = name
+    end
+
+    if isfile(path)
+        debug_print("using cached ", path)
+        kernel_libs[name] = starpu_kernel_lib(path, "", nothing, C_NULL)
+        return
+    end
+
+    # Concurrent sessions may compile the same codelet, only rename complete objects
+    tmp_path = string(path, ".", getpid())
+    debug_print("compiling ", path)
+    cmd = `make -s -f $makefile KERNEL_SOURCES=$(join(sources, " ")) KERNELLIB=$tmp_path $tmp_path`
+    process = run(pipeline(cmd, stdout = stderr), wait = false)
+    kernel_libs[name] = starpu_kernel_lib(path, tmp_path, process, C_NULL)
+end
+
+"""
+    Returns the handle of the shared object containing function func_name,
+    waiting for its compilation if needed, or C_NULL if it was not generated.
+"""
+function starpu_kernel_library_handle(func_name :: String)
+    name = get(kernel_functions, func_name, nothing)
+    if (name == nothing)
+        return C_NULL
+    end
+
+    lib = kernel_libs[name]
+    if (lib.process != nothing)
+        wait(lib.process)
+        if !success(lib.process)
+            error("compilation of codelet $name failed")
+        end
+        mv(lib.tmp_path, lib.path, force = true)
+        lib.process = nothing
+    end
+    if (lib.handle == C_NULL)
+        lib.handle = Libdl.dlopen(lib.path)
+    end
+
+    return lib.handle
+end
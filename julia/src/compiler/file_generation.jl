@@ -113,6 +113,8 @@ macro codelet(x)
 
     generated_cpu_kernel_file_name=string("genc_",string(x.args[1].args[1].args[1]),".c")
     generated_cuda_kernel_file_name=string("gencuda_",string(x.args[1].args[1].args[1]),".cu")
+    functions = String[]
+    sources = String[]
 
     if (starpu_target & STARPU_CPU != 0)
         kernel_file = open(generated_cpu_kernel_file_name, "w")
@@ -122,6 +124,8 @@ macro codelet(x)
         print(kernel_file, cpu_expr)
         close(kernel_file)
         CPU_CODELETS[name]=cpu_name
+        push!(functions, cpu_name)
+        push!(sources, generated_cpu_kernel_file_name)
     end
 
     if (starpu_target & STARPU_CUDA!=0) && STARPU_USE_CUDA == 1
@@ -138,7 +142,11 @@ macro codelet(x)
         print(kernel_file, "\nextern \"C\" ", prekernel)
         close(kernel_file)
         CUDA_CODELETS[name]=cuda_name
+        push!(functions, cuda_name)
+        push!(sources, generated_cuda_kernel_file_name)
     end
+
+    starpu_compile_kernel(name, x, functions, sources)
 end
 
 function parse_scalar_parameters(expr :: StarpuExprFunction, codelet_name)
@@ -25,4 +25,5 @@ include("expression_manipulation.jl")
 include("c.jl")
 include("cuda.jl")
 include("file_generation.jl")
+include("cache.jl")
 
@@ -33,21 +33,11 @@ function starpu_init()
             end
             print(k,">>>>",CPU_CODELETS[k],"\n")
         end
-    else
-        srcdir=get(ENV,"STARPU_JULIA_BUILD",0)
-        if (srcdir == 0)
-            error("Must define environment variable STARPU_JULIA_BUILD")
-        end
-        makefile=string(srcdir, "/src/dynamic_compiler/Makefile")
-        debug_print("generating codelet library with ")
-        debug_print(makefile)
-        run(`make -f $makefile generated_tasks.so`)
-        global starpu_tasks_library_handle=Libdl.dlopen("generated_tasks.so")
     end
     global starpu_wrapper_library_handle= Libdl.dlopen(starpu_wrapper_library_name)
     output = starpu_init(C_NULL)
 
-    global task_pool = ThreadPools.QueuePool(2)
+    starpu_callback_start()
 
     starpu_enter_new_block()
 
@@ -62,6 +52,7 @@ function starpu_shutdown()
 
     starpu_exit_block()
     @starpucall starpu_shutdown Cvoid ()
+    starpu_callback_stop()
 
     lock(mutex)
     empty!(perfmodel_list)
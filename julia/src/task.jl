@@ -13,8 +13,6 @@
 #
 # See the GNU Lesser General Public License in COPYING.LGPL for more details.
 #
-using ThreadPools
-
 mutable struct jl_starpu_codelet
     c_codelet :: starpu_codelet
     perfmodel :: starpu_perfmodel
@@ -91,7 +89,6 @@ mutable struct jl_starpu_task
     handle_pointers :: Vector{StarpuDataHandlePointer}
     synchronous :: Bool
     cl_arg # type depends on codelet
-    callback_signal :: Vector{Cint}
     callback_function :: Union{Cvoid, Function}
     callback_arg
     c_task :: starpu_task
@@ -99,6 +96,55 @@ end
 
 task_list = Vector{jl_starpu_task}()
 
+# Task callbacks are run by a Julia task, once the StarPU worker has queued
+# them (see julia_callback_func), so that workers never wait for Julia. A
+# callback thus runs asynchronously, some time after its task has terminated:
+# starpu_task_wait() may return before it is run, only
+# starpu_task_wait_for_all() waits for the callbacks.
+callback_list = Dict{UInt, Tuple{Function, Any}}()
+callback_counter = UInt(0)
+callback_cond = Threads.Condition()
+callback_pending = 0
+callback_async = nothing
+
+function starpu_callback_start()
+    async = Base.AsyncCondition()
+    @starpucall(julia_callback_init, Cvoid, (Ptr{Cvoid}, Ptr{Cvoid}),
+                async.handle, cglobal(:uv_async_send))
+    global callback_async = async
+
+    Threads.@spawn while isopen(async)
+        try
+            wait(async)
+        catch
+            break
+        end
+        while (id = @starpucall(julia_callback_next, Csize_t, ())) != 0
+            lock(mutex)
+            (callback_function, callback_arg) = pop!(callback_list, id)
+            unlock(mutex)
+
+            try
+                callback_function(callback_arg)
+            catch e
+                @error "task callback failed" exception=(e, catch_backtrace())
+            end
+
+            lock(callback_cond)
+            global callback_pending -= 1
+            notify(callback_cond)
+            unlock(callback_cond)
+        end
+    end
+end
+
+function starpu_callback_stop()
+    if callback_async != nothing
+        close(callback_async)
+        global callback_async = nothing
+    end
+end
+
 """
             starpu_task(; cl :: jl_starpu_codelet, handles :: Vector{StarpuDataHandle}, cl_arg :: Ref)
 
@@ -120,7 +166,7 @@ function starpu_task(;
         error("\"cl\" field can't be empty when creating a StarpuTask")
     end
 
-    output = jl_starpu_task(cl, handles, map((x -> x.object), handles), false, nothing, Vector{Cint}(undef, 1), callback, callback_arg, starpu_task(zero))
+    output = jl_starpu_task(cl, handles, map((x -> x.object), handles), false, nothing, callback, callback_arg, starpu_task(zero))
 
     # handle scalar_parameters
     codelet_name = ""
@@ -156,13 +202,6 @@ function starpu_task(;
         output.c_task.cl_arg_size = sizeof(output.cl_arg)
     end
 
-    # callback
-    if output.callback_function != nothing
-        output.callback_signal[1] = 0
-        output.c_task.callback_arg = Base.unsafe_convert(Ptr{Cvoid}, output.callback_signal)
-        output.c_task.callback_func = load_wrapper_function_pointer("julia_callback_func")
-    end
-
     if tag != nothing
         output.c_task.tag_id = tag
         output.c_task.use_tag = 1
@@ -214,34 +253,51 @@ end
 
 """
     Launches task execution, if "synchronous" task field is set to "false", call
-    returns immediately
+    returns immediately. Returns the value of the C starpu_task_submit().
+
+    The callback of the task, if any, is run by a Julia task after the task
+    has terminated, and not by the worker which executed it.
 """
 function starpu_task_submit(task :: jl_starpu_task)
     if (length(task.handles) != length(task.cl.modes))
         error("Invalid number of handles for task : $(length(task.handles)) where given while codelet has $(task.cl.modes) modes")
     end
 
-    starpu_task_submit(Ref(task.c_task))
-
+    id = UInt(0)
     if task.callback_function != nothing
-        callback_arg = task.callback_arg
-        callback_signal = task.callback_signal
-        callback_function = task.callback_function
-
         lock(mutex)
-        put!(task_pool) do
+        global callback_counter += 1
+        id = callback_counter
+        callback_list[id] = (task.callback_function, task.callback_arg)
+        unlock(mutex)
+
+        lock(callback_cond)
+        global callback_pending += 1
+        unlock(callback_cond)
 
-            # Active waiting loop
-            @starpucall(julia_wait_signal, Cvoid, (Ptr{Cvoid},), Base.unsafe_convert(Ptr{Cvoid}, callback_signal))
+        task.c_task.callback_arg = @starpucall(julia_callback_new, Ptr{Cvoid}, (Csize_t,), id)
+        task.c_task.callback_func = load_wrapper_function_pointer("julia_callback_func")
+    end
 
-            # We've received the signal from the pthread, now execute the callback.
-            callback_function(callback_arg)
+    ret = starpu_task_submit(Ref(task.c_task))
 
-            # Tell the pthread that the callback is done.
-            callback_signal[1] = 0
-        end
+    if ret != 0 && id != 0
+        # The callback will never be triggered
+        @starpucall(julia_callback_delete, Cvoid, (Ptr{Cvoid},), task.c_task.callback_arg)
+        task.c_task.callback_arg = C_NULL
+        task.c_task.callback_func = C_NULL
+
+        lock(mutex)
+        delete!(callback_list, id)
         unlock(mutex)
+
+        lock(callback_cond)
+        global callback_pending -= 1
+        notify(callback_cond)
+        unlock(callback_cond)
     end
+
+    return ret
 end
 
 function starpu_modes(x :: Symbol)
@@ -357,6 +413,10 @@ macro starpu_async_cl(expr, modes, cl_arg=(), color ::UInt32=0x00000000)
     end
 end
 
+"""
+    Blocks until the task has terminated. Its callback may not have been run
+    yet, see starpu_task_wait_for_all().
+"""
 function starpu_task_wait(task :: jl_starpu_task)
     @threadcall(@starpufunc(:starpu_task_wait),
                 Cint, (Ptr{Cvoid},), Ref(task.c_task))
@@ -366,11 +426,26 @@ end
 
 
 """
-    Blocks until every submitted task has finished.
+    Blocks until every submitted task has finished, and their callbacks have
+    been run.
 """
 function starpu_task_wait_for_all()
-    @threadcall(@starpufunc(:starpu_task_wait_for_all),
-                Cint, ())
+    while true
+        @threadcall(@starpufunc(:starpu_task_wait_for_all),
+                    Cint, ())
+
+        # Callbacks run after their task has terminated, and may submit
+        # new tasks.
+        lock(callback_cond)
+        pending = callback_pending
+        while callback_pending > 0
+            wait(callback_cond)
+        end
+        unlock(callback_cond)
+        if pending == 0
+            break
+        end
+    end
 
     lock(mutex)
     empty!(task_list)
@@ -75,10 +75,18 @@ function load_starpu_function_pointer(func_name :: String)
         return C_NULL
     end
     #func_pointer = ccall(:dlsym,"libdl",Ptr{Cvoid});
-    func_pointer=Libdl.dlsym(starpu_tasks_library_handle, func_name)
+    handle = starpu_kernel_library_handle(func_name)
+    if (handle == C_NULL)
+        # Not generated in this session, it can only come from JULIA_TASK_LIB
+        handle = starpu_tasks_library_handle
+        if (handle == C_NULL)
+            error("Function $func_name was not generated, and no JULIA_TASK_LIB library was loaded")
+        end
+    end
+    func_pointer=Libdl.dlsym(handle, func_name)
 
     if (func_pointer == C_NULL)
-        error("Couldn't find function symbol $func_name into extern library file $starpu_tasks_library")
+        error("Couldn't find function symbol $func_name")
     end
 
     return func_pointer
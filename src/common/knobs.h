@@ -205,6 +205,7 @@ struct starpu_perf_counter_sample_cl_values
 		starpu_perf_counter_int64_t current_ready;
 		starpu_perf_counter_int64_t total_executed;
 		starpu_perf_counter_double cumul_execution_time;
+		starpu_perf_counter_double cumul_callback_time;
 	} task;
 };
 
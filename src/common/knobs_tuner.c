@@ -0,0 +1,502 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Online tuning of performance steering knobs.
+ *
+ * Each knob is given a range of values, and the tuner measures an objective
+ * computed from the performance counters over application phases. It
+ * hill-climbs over the grid of knob values: starting from the current values,
+ * it tries to move one knob by one step at a time, keeps the move if it
+ * improves the objective, and stops when no move improves it any more. The
+ * best configuration is then kept and saved, so that later runs of the
+ * application on the same machine directly use it.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <starpu.h>
+#include <common/config.h>
+#include <common/utils.h>
+#include <core/workers.h>
+#include <common/knobs.h>
+#include <core/perfmodel/perfmodel.h>
+
+/* Relative improvement needed to accept a move, to avoid following noise */
+#define TUNER_THRESHOLD 0.01
+
+#define TUNER_PATH_MAXLEN 512
+
+struct tuner_knob
+{
+	int id;
+	enum starpu_perf_knob_scope scope;
+	enum starpu_perf_knob_type type;
+	double min;
+	double step;
+	unsigned nvalues;
+};
+
+struct starpu_perf_knob_tuner
+{
+	char *name;
+	enum starpu_perf_knob_tuner_objective objective;
+
+	unsigned nknobs;
+	struct tuner_knob *knobs;
+
+	/* Indexes of the knob values in the best configuration found so far,
+	 * and in the configuration being measured */
+	unsigned *best;
+	unsigned *current;
+	double best_value;
+
+	/* Next move to try from the best configuration: knob and direction */
+	unsigned move_knob;
+	int move_dir;
+	/* Number of moves which did not improve in a row */
+	unsigned nfailed;
+
+	int started;
+	int converged;
+	unsigned nphases;
+
+	/* Counter values at the beginning of the phase */
+	double start_date;
+	int64_t start_executed;
+	double start_execution_time;
+};
+
+static const char *objective_name(enum starpu_perf_knob_tuner_objective objective)
+{
+	switch (objective)
+	{
+		case starpu_perf_knob_tuner_objective_tasks_per_second:
+			return "tasks_per_second";
+		case starpu_perf_knob_tuner_objective_busy_ratio:
+			return "busy_ratio";
+		default:
+			STARPU_ABORT();
+	}
+	return NULL;
+}
+
+static const char *sched_policy_name(void)
+{
+	return starpu_sched_get_sched_policy()->policy_name;
+}
+
+static double knob_get(const struct tuner_knob *knob)
+{
+#define KNOB_GET(SCOPE, ...) \
+	switch (knob->type) \
+	{ \
+		case starpu_perf_knob_type_int32: \
+			return starpu_perf_knob_get_##SCOPE##_int32_value(knob->id, ##__VA_ARGS__); \
+		case starpu_perf_knob_type_int64: \
+			return starpu_perf_knob_get_##SCOPE##_int64_value(knob->id, ##__VA_ARGS__); \
+		case starpu_perf_knob_type_float: \
+			return starpu_perf_knob_get_##SCOPE##_float_value(knob->id, ##__VA_ARGS__); \
+		case starpu_perf_knob_type_double: \
+			return starpu_perf_knob_get_##SCOPE##_double_value(knob->id, ##__VA_ARGS__); \
+		default: \
+			STARPU_ABORT(); \
+	}
+
+	switch (knob->scope)
+	{
+		case starpu_perf_knob_scope_global:
+			KNOB_GET(global);
+		case starpu_perf_knob_scope_per_worker:
+			/* All workers get the same value */
+			KNOB_GET(per_worker, 0);
+		case starpu_perf_knob_scope_per_scheduler:
+			KNOB_GET(per_scheduler, sched_policy_name());
+		default:
+			STARPU_ABORT();
+	}
+#undef KNOB_GET
+	return NAN;
+}
+
+static void knob_set(const struct tuner_knob *knob, double value)
+{
+#define KNOB_SET(SCOPE, ...) \
+	switch (knob->type) \
+	{ \
+		case starpu_perf_knob_type_int32: \
+			starpu_perf_knob_set_##SCOPE##_int32_value(knob->id, ##__VA_ARGS__, lround(value)); \
+			break; \
+		case starpu_perf_knob_type_int64: \
+			starpu_perf_knob_set_##SCOPE##_int64_value(knob->id, ##__VA_ARGS__, llround(value)); \
+			break; \
+		case starpu_perf_knob_type_float: \
+			starpu_perf_knob_set_##SCOPE##_float_value(knob->id, ##__VA_ARGS__, value); \
+			break; \
+		case starpu_perf_knob_type_double: \
+			starpu_perf_knob_set_##SCOPE##_double_value(knob->id, ##__VA_ARGS__, value); \
+			break; \
+		default: \
+			STARPU_ABORT(); \
+	}
+
+	switch (knob->scope)
+	{
+		case starpu_perf_knob_scope_global:
+			KNOB_SET(global);
+			break;
+		case starpu_perf_knob_scope_per_worker:
+		{
+			unsigned worker;
+			for (worker = 0; worker < starpu_worker_get_count(); worker++)
+				KNOB_SET(per_worker, worker);
+			break;
+		}
+		case starpu_perf_knob_scope_per_scheduler:
+			KNOB_SET(per_scheduler, sched_policy_name());
+			break;
+		default:
+			STARPU_ABORT();
+	}
+#undef KNOB_SET
+}
+
+static double knob_value(const struct tuner_knob *knob, unsigned index)
+{
+	return knob->min + index * knob->step;
+}
+
+/* Index of the closest value in the range */
+static unsigned knob_index(const struct tuner_knob *knob, double value)
+{
+	double index = round((value - knob->min) / knob->step);
+	if (!(index >= 0.))
+		return 0;
+	if (index >= knob->nvalues)
+		return knob->nvalues - 1;
+	return (unsigned) index;
+}
+
+static void apply(struct starpu_perf_knob_tuner *tuner, const unsigned *config)
+{
+	unsigned k;
+	for (k = 0; k < tuner->nknobs; k++)
+		knob_set(&tuner->knobs[k], knob_value(&tuner->knobs[k], config[k]));
+}
+
+static void get_path(struct starpu_perf_knob_tuner *tuner, char *path, size_t maxlen)
+{
+	char hostname[65];
+	char dir[TUNER_PATH_MAXLEN/2];
+
+	_starpu_gethostname(hostname, sizeof(hostname));
+	snprintf(dir, sizeof(dir), "%stuning/", _starpu_get_perf_model_dir_default());
+	_starpu_mkpath_and_check(dir, S_IRWXU);
+	snprintf(path, maxlen, "%s%s.%s", dir, tuner->name, hostname);
+}
+
+/* Load the best configuration found by a previous run, return 0 on success */
+static int load(struct starpu_perf_knob_tuner *tuner)
+{
+	char path[TUNER_PATH_MAXLEN];
+	char objective[32], name[256];
+	unsigned nknobs, k;
+	int locked, ret = -1;
+	double value;
+	FILE *f;
+
+	get_path(tuner, path, sizeof(path));
+	f = fopen(path, "r");
+	if (!f)
+		return -1;
+	locked = _starpu_frdlock(f) == 0;
+
+	_starpu_drop_comments(f);
+	if (fscanf(f, "%31s", objective) != 1 || strcmp(objective, objective_name(tuner->objective)))
+		goto out;
+	_starpu_drop_comments(f);
+	if (fscanf(f, "%le", &tuner->best_value) != 1)
+		goto out;
+	_starpu_drop_comments(f);
+	if (fscanf(f, "%u", &nknobs) != 1 || nknobs != tuner->nknobs)
+		goto out;
+	_starpu_drop_comments(f);
+	for (k = 0; k < nknobs; k++)
+	{
+		/* The knobs have to be the same as when saving */
+		if (fscanf(f, "%255s %le", name, &value) != 2 || strcmp(name, starpu_perf_knob_id_to_name(tuner->knobs[k].id)))
+			goto out;
+		tuner->best[k] = knob_index(&tuner->knobs[k], value);
+	}
+	ret = 0;
+
+out:
+	if (locked)
+		_starpu_frdunlock(f);
+	fclose(f);
+	if (ret)
+		_STARPU_DISP("Warning: ignoring tuning file %s which does not match the knobs of tuner %s\n", path, tuner->name);
+	return ret;
+}
+
+static void save(struct starpu_perf_knob_tuner *tuner)
+{
+	char path[TUNER_PATH_MAXLEN];
+	unsigned k;
+	int locked;
+	FILE *f;
+
+	get_path(tuner, path, sizeof(path));
+	f = fopen(path, "w");
+	if (!f)
+	{
+		_STARPU_DISP("Warning: could not save tuning file %s: %s\n", path, strerror(errno));
+		return;
+	}
+	locked = _starpu_fwrlock(f) == 0;
+	fprintf(f, "##################\n");
+	fprintf(f, "# Knob tuning\n");
+	fprintf(f, "# Objective\n");
+	fprintf(f, "%s\n", objective_name(tuner->objective));
+	fprintf(f, "# Best objective value\n");
+	fprintf(f, "%e\n", tuner->best_value);
+	fprintf(f, "# Number of knobs\n");
+	fprintf(f, "%u\n", tuner->nknobs);
+	fprintf(f, "# Knob name\tbest value\n");
+	for (k = 0; k < tuner->nknobs; k++)
+		fprintf(f, "%s\t%e\n", starpu_perf_knob_id_to_name(tuner->knobs[k].id), knob_value(&tuner->knobs[k], tuner->best[k]));
+	if (locked)
+		_starpu_fwrunlock(f);
+	fclose(f);
+}
+
+struct starpu_perf_knob_tuner *starpu_perf_knob_tuner_init(const char *name, enum starpu_perf_knob_tuner_objective objective)
+{
+	struct starpu_perf_knob_tuner *tuner;
+
+	STARPU_ASSERT_MSG(name && !strchr(name, '/'), "the tuner name is used as file name");
+	STARPU_ASSERT_MSG(objective == starpu_perf_knob_tuner_objective_tasks_per_second
+			  || objective == starpu_perf_knob_tuner_objective_busy_ratio, "unknown objective %d", objective);
+	_STARPU_CALLOC(tuner, 1, sizeof(*tuner));
+	tuner->name = strdup(name);
+	tuner->objective = objective;
+	tuner->best_value = NAN;
+	tuner->move_dir = 1;
+
+	/* We need the worker counters */
+	starpu_perf_counter_collection_start();
+
+	return tuner;
+}
+
+void starpu_perf_knob_tuner_add_knob(struct starpu_perf_knob_tuner *tuner, int knob_id, double min, double max, double step)
+{
+	struct tuner_knob *knob;
+
+	STARPU_ASSERT_MSG(!tuner->started, "knobs have to be added before the first phase");
+	STARPU_ASSERT_MSG(step > 0. && max >= min, "invalid range [%f, %f] with step %f", min, max, step);
+
+	tuner->nknobs++;
+	_STARPU_REALLOC(tuner->knobs, tuner->nknobs * sizeof(*tuner->knobs));
+	knob = &tuner->knobs[tuner->nknobs-1];
+	knob->id = knob_id;
+	knob->scope = _starpu_perf_knob_id_get_scope(knob_id);
+	knob->type = starpu_perf_knob_get_type_id(knob_id);
+	knob->min = min;
+	knob->step = step;
+	knob->nvalues = (unsigned) floor((max - min) / step + 1e-9) + 1;
+}
+
+/* Choose the next configuration to measure, or settle on the best one */
+static void next_move(struct starpu_perf_knob_tuner *tuner)
+{
+	while (tuner->nfailed < 2 * tuner->nknobs)
+	{
+		unsigned k = tuner->move_knob;
+		int index = (int) tuner->best[k] + tuner->move_dir;
+
+		if (index >= 0 && index < (int) tuner->knobs[k].nvalues)
+		{
+			memcpy(tuner->current, tuner->best, tuner->nknobs * sizeof(*tuner->current));
+			tuner->current[k] = index;
+			return;
+		}
+
+		/* Out of the range, try another move */
+		tuner->nfailed++;
+		if (tuner->move_dir > 0)
+			tuner->move_dir = -1;
+		else
+		{
+			tuner->move_dir = 1;
+			tuner->move_knob = (k + 1) % tuner->nknobs;
+		}
+	}
+
+	/* No move improves any more */
+	tuner->converged = 1;
+	apply(tuner, tuner->best);
+	save(tuner);
+	if (!_starpu_silent)
+	{
+		_STARPU_DISP("knob tuner %s converged after %u phases, %s %e with", tuner->name, tuner->nphases, objective_name(tuner->objective), tuner->best_value);
+		starpu_perf_knob_tuner_print(tuner, stderr);
+	}
+}
+
+void starpu_perf_knob_tuner_phase_start(struct starpu_perf_knob_tuner *tuner)
+{
+	unsigned worker, k;
+
+	if (!tuner->started)
+	{
+		tuner->started = 1;
+		STARPU_ASSERT_MSG(tuner->nknobs, "no knob to tune");
+		_STARPU_MALLOC(tuner->best, tuner->nknobs * sizeof(*tuner->best));
+		_STARPU_MALLOC(tuner->current, tuner->nknobs * sizeof(*tuner->current));
+
+		/* As for performance models, STARPU_CALIBRATE=2 discards
+		 * previous results */
+		if (_starpu_get_calibrate_flag() != 2 && !load(tuner))
+		{
+			tuner->converged = 1;
+			apply(tuner, tuner->best);
+			_STARPU_DEBUG("knob tuner %s uses the saved configuration\n", tuner->name);
+		}
+		else
+		{
+			/* Start from the current values */
+			for (k = 0; k < tuner->nknobs; k++)
+				tuner->current[k] = knob_index(&tuner->knobs[k], knob_get(&tuner->knobs[k]));
+			memcpy(tuner->best, tuner->current, tuner->nknobs * sizeof(*tuner->best));
+		}
+	}
+
+	if (!tuner->converged)
+		apply(tuner, tuner->current);
+
+	tuner->start_executed = 0;
+	tuner->start_execution_time = 0.;
+	for (worker = 0; worker < starpu_worker_get_count(); worker++)
+	{
+		struct _starpu_worker *w = _starpu_get_worker_struct(worker);
+		tuner->start_executed += w->__w_total_executed__value;
+		tuner->start_execution_time += w->__w_cumul_execution_time__value;
+	}
+	tuner->start_date = starpu_timing_now();
+}
+
+double starpu_perf_knob_tuner_phase_end(struct starpu_perf_knob_tuner *tuner)
+{
+	unsigned nworkers = starpu_worker_get_count(), worker;
+	double elapsed = starpu_timing_now() - tuner->start_date;
+	int64_t executed = 0;
+	double execution_time = 0., value;
+
+	STARPU_ASSERT_MSG(tuner->started, "starpu_perf_knob_tuner_phase_start was not called");
+	for (worker = 0; worker < nworkers; worker++)
+	{
+		struct _starpu_worker *w = _starpu_get_worker_struct(worker);
+		executed += w->__w_total_executed__value;
+		execution_time += w->__w_cumul_execution_time__value;
+	}
+	executed -= tuner->start_executed;
+	execution_time -= tuner->start_execution_time;
+
+	switch (tuner->objective)
+	{
+		case starpu_perf_knob_tuner_objective_tasks_per_second:
+			value = executed / (elapsed / 1000000.);
+			break;
+		case starpu_perf_knob_tuner_objective_busy_ratio:
+			value = execution_time / (elapsed * nworkers);
+			break;
+		default:
+			STARPU_ABORT();
+	}
+
+	tuner->nphases++;
+	if (tuner->converged)
+		return value;
+
+	if (isnan(tuner->best_value))
+	{
+		/* This was the starting point */
+		tuner->best_value = value;
+		_STARPU_DEBUG("knob tuner %s: initial %s %e\n", tuner->name, objective_name(tuner->objective), value);
+	}
+	else if (value > tuner->best_value * (1. + TUNER_THRESHOLD))
+	{
+		/* Keep moving in this direction */
+		_STARPU_DEBUG("knob tuner %s: moving knob %s to %f improves %s from %e to %e\n", tuner->name,
+			      starpu_perf_knob_id_to_name(tuner->knobs[tuner->move_knob].id),
+			      knob_value(&tuner->knobs[tuner->move_knob], tuner->current[tuner->move_knob]),
+			      objective_name(tuner->objective), tuner->best_value, value);
+		memcpy(tuner->best, tuner->current, tuner->nknobs * sizeof(*tuner->best));
+		tuner->best_value = value;
+		tuner->nfailed = 0;
+	}
+	else
+	{
+		_STARPU_DEBUG("knob tuner %s: moving knob %s to %f does not improve %s (%e)\n", tuner->name,
+			      starpu_perf_knob_id_to_name(tuner->knobs[tuner->move_knob].id),
+			      knob_value(&tuner->knobs[tuner->move_knob], tuner->current[tuner->move_knob]),
+			      objective_name(tuner->objective), value);
+		tuner->nfailed++;
+		if (tuner->move_dir > 0)
+			tuner->move_dir = -1;
+		else
+		{
+			tuner->move_dir = 1;
+			tuner->move_knob = (tuner->move_knob + 1) % tuner->nknobs;
+		}
+	}
+
+	next_move(tuner);
+	return value;
+}
+
+int starpu_perf_knob_tuner_converged(struct starpu_perf_knob_tuner *tuner)
+{
+	return tuner->converged;
+}
+
+void starpu_perf_knob_tuner_print(struct starpu_perf_knob_tuner *tuner, FILE *output)
+{
+	unsigned k;
+
+	if (!tuner->started)
+		return;
+	for (k = 0; k < tuner->nknobs; k++)
+		fprintf(output, " %s=%g", starpu_perf_knob_id_to_name(tuner->knobs[k].id), knob_value(&tuner->knobs[k], tuner->best[k]));
+	fprintf(output, "\n");
+}
+
+void starpu_perf_knob_tuner_exit(struct starpu_perf_knob_tuner *tuner)
+{
+	if (tuner->started && !tuner->converged)
+		/* Keep the best configuration found so far */
+		apply(tuner, tuner->best);
+
+	starpu_perf_counter_collection_stop();
+
+	free(tuner->best);
+	free(tuner->current);
+	free(tuner->knobs);
+	free(tuner->name);
+	free(tuner);
+}
@@ -48,6 +48,12 @@
  *
  * * Add a new cell at the beginning of the list of the priority of the cell (O(log2 p))
  * void FOO_prio_list_push_front(struct FOO_prio_list*, struct FOO*)
+ * * Add a new cell in the list of the priority of the cell, after the cells
+ * which compare lower or equal with cmp, i.e. keeping that list sorted
+ * (O(log2 p + n), but O(log2 p) when cells are added in increasing order.
+ * In the STARPU_DEBUG list version, O(n), but O(1) when cells are added in
+ * increasing order and with the lowest priority)
+ * void FOO_prio_list_push_sorted(struct FOO_prio_list*, struct FOO*, int (*cmp)(const struct FOO*, const struct FOO*))
  *
  * * Test whether the priority list is empty
  * void FOO_prio_list_empty(struct FOO_prio_list*)
@@ -217,6 +223,21 @@
 		ENAME##_list_push_front(&stage->list, e); \
 		priolist->empty = 0; \
 	} \
+	PRIO_LIST_INLINE void ENAME##_prio_list_push_sorted(struct ENAME##_prio_list *priolist, struct ENAME *e, int (*cmp)(const struct ENAME *, const struct ENAME *)) \
+	{ \
+		struct ENAME##_prio_list_stage *stage = ENAME##_prio_list_add(priolist, e->PRIOFIELD); \
+		struct ENAME *cur; \
+		for (cur  = ENAME##_list_last(&stage->list); \
+		     cur != ENAME##_list_alpha(&stage->list); \
+		     cur  = ENAME##_list_prev(cur)) \
+			if (cmp(cur, e) <= 0) \
+				break; \
+		if (cur == ENAME##_list_alpha(&stage->list)) \
+			ENAME##_list_push_front(&stage->list, e); \
+		else \
+			ENAME##_list_insert_after(&stage->list, e, cur); \
+		priolist->empty = 0; \
+	} \
 	PRIO_LIST_INLINE int ENAME##_prio_list_empty(const struct ENAME##_prio_list *priolist) \
 	{ \
 		return priolist->empty; \
@@ -542,6 +563,21 @@
 		else \
 			ENAME##_list_insert_before(&(priolist)->list, (e), cur); \
 	} \
+	PRIO_LIST_INLINE void ENAME##_prio_list_push_sorted(struct ENAME##_prio_list *priolist, struct ENAME *e, int (*cmp)(const struct ENAME *, const struct ENAME *)) \
+	{ \
+		struct ENAME *cur; \
+		/* Cells mostly come in increasing order, look from the end */ \
+		for (cur  = ENAME##_list_last(&(priolist)->list); \
+		     cur != ENAME##_list_alpha(&(priolist)->list); \
+		     cur  = ENAME##_list_prev(cur)) \
+			if ((e)->PRIOFIELD < cur->PRIOFIELD \
+			    || ((e)->PRIOFIELD == cur->PRIOFIELD && cmp(cur, (e)) <= 0)) \
+				break; \
+		if (cur == ENAME##_list_alpha(&(priolist)->list)) \
+			ENAME##_list_push_front(&(priolist)->list, (e)); \
+		else \
+			ENAME##_list_insert_after(&(priolist)->list, (e), cur); \
+	} \
 	PRIO_LIST_INLINE int ENAME##_prio_list_empty(const struct ENAME##_prio_list *priolist) \
 	{ return ENAME##_list_empty(&(priolist)->list); } \
 	PRIO_LIST_INLINE void ENAME##_prio_list_erase(struct ENAME##_prio_list *priolist, struct ENAME *e) \
@@ -0,0 +1,188 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2008-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <common/config.h>
+#include <common/utils.h>
+#include <core/jobs.h>
+#include <core/callback_threads.h>
+
+/*
+ * Pool of threads running the task callbacks which were asked to be offloaded
+ * from the workers (see starpu_task::callback_offload).
+ *
+ * Workers push jobs on a lock-free LIFO list. Callback threads grab the whole
+ * list at once, reverse it so as to run callbacks in termination order, and
+ * only take the mutex to go to sleep when the list is empty.
+ */
+
+/* Protects starting and stopping the threads, and sleeping */
+static starpu_pthread_mutex_t callback_threads_mutex = STARPU_PTHREAD_MUTEX_INITIALIZER;
+static starpu_pthread_cond_t callback_threads_cond = STARPU_PTHREAD_COND_INITIALIZER;
+
+static struct _starpu_job * volatile callback_threads_list;
+static volatile unsigned callback_threads_started;
+static unsigned callback_threads_running;
+static unsigned ncallback_threads;
+static starpu_pthread_t *callback_threads;
+/* Set in the callback threads, so that blocking calls can be detected */
+static starpu_pthread_key_t callback_threads_key;
+
+static struct _starpu_job *callback_threads_grab(void)
+{
+	struct _starpu_job *list;
+
+	do
+		list = callback_threads_list;
+	while (list && !STARPU_BOOL_COMPARE_AND_SWAP_PTR(&callback_threads_list, list, NULL));
+
+	/* Reverse it, to run callbacks in the order they were pushed */
+	struct _starpu_job *reversed = NULL;
+	while (list)
+	{
+		struct _starpu_job *next = list->offloaded_callback_next;
+		list->offloaded_callback_next = reversed;
+		reversed = list;
+		list = next;
+	}
+	return reversed;
+}
+
+static void *callback_thread_func(void *arg)
+{
+	unsigned id = (uintptr_t) arg;
+	char name[16];
+
+	snprintf(name, sizeof(name), "callback %u", id);
+#ifndef STARPU_SIMGRID
+	int bindid = starpu_get_next_bindid(0, NULL, 0);
+	if (bindid >= 0)
+		starpu_bind_thread_on(bindid, 0, name);
+	else
+#endif
+		starpu_pthread_setname(name);
+	STARPU_PTHREAD_SETSPECIFIC(callback_threads_key, (void*) 1);
+
+	while (1)
+	{
+		struct _starpu_job *j = callback_threads_grab();
+
+		if (!j)
+		{
+			STARPU_PTHREAD_MUTEX_LOCK(&callback_threads_mutex);
+			while (!callback_threads_list && callback_threads_running)
+				STARPU_PTHREAD_COND_WAIT(&callback_threads_cond, &callback_threads_mutex);
+			if (!callback_threads_list && !callback_threads_running)
+			{
+				STARPU_PTHREAD_MUTEX_UNLOCK(&callback_threads_mutex);
+				break;
+			}
+			STARPU_PTHREAD_MUTEX_UNLOCK(&callback_threads_mutex);
+			continue;
+		}
+
+		while (j)
+		{
+			/* The job may be freed by running its callback */
+			struct _starpu_job *next = j->offloaded_callback_next;
+			_starpu_job_run_offloaded_callback(j);
+			j = next;
+		}
+	}
+
+	return NULL;
+}
+
+static void callback_threads_start(void)
+{
+	unsigned i;
+
+	ncallback_threads = starpu_getenv_number_default("STARPU_NCALLBACK_THREADS", 1);
+	callback_threads_running = 1;
+	STARPU_PTHREAD_KEY_CREATE(&callback_threads_key, NULL);
+	if (ncallback_threads)
+	{
+		_STARPU_MALLOC(callback_threads, ncallback_threads * sizeof(*callback_threads));
+		for (i = 0; i < ncallback_threads; i++)
+			STARPU_PTHREAD_CREATE(&callback_threads[i], NULL, callback_thread_func, (void*) (uintptr_t) i);
+	}
+	STARPU_WMB();
+	callback_threads_started = 1;
+}
+
+int _starpu_callback_threads_push(struct _starpu_job *j)
+{
+	struct _starpu_job *head;
+
+	if (STARPU_UNLIKELY(!callback_threads_started))
+	{
+		STARPU_PTHREAD_MUTEX_LOCK(&callback_threads_mutex);
+		if (!callback_threads_started)
+			callback_threads_start();
+		STARPU_PTHREAD_MUTEX_UNLOCK(&callback_threads_mutex);
+	}
+	STARPU_RMB();
+
+	if (!ncallback_threads || !callback_threads_running)
+		return 0;
+
+	do
+	{
+		head = callback_threads_list;
+		j->offloaded_callback_next = head;
+	}
+	while (!STARPU_BOOL_COMPARE_AND_SWAP_PTR(&callback_threads_list, head, j));
+
+	if (!head)
+	{
+		/* The list was empty, threads may be sleeping */
+		STARPU_PTHREAD_MUTEX_LOCK(&callback_threads_mutex);
+		STARPU_PTHREAD_COND_SIGNAL(&callback_threads_cond);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&callback_threads_mutex);
+	}
+
+	return 1;
+}
+
+void _starpu_callback_threads_shutdown(void)
+{
+	unsigned i;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&callback_threads_mutex);
+	if (!callback_threads_started)
+	{
+		STARPU_PTHREAD_MUTEX_UNLOCK(&callback_threads_mutex);
+		return;
+	}
+	callback_threads_running = 0;
+	STARPU_PTHREAD_COND_BROADCAST(&callback_threads_cond);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&callback_threads_mutex);
+
+	for (i = 0; i < ncallback_threads; i++)
+		STARPU_PTHREAD_JOIN(callback_threads[i], NULL);
+	free(callback_threads);
+	callback_threads = NULL;
+	ncallback_threads = 0;
+	callback_threads_started = 0;
+	STARPU_PTHREAD_KEY_DELETE(callback_threads_key);
+}
+
+int _starpu_callback_threads_is_current(void)
+{
+	if (!callback_threads_started)
+		return 0;
+	return STARPU_PTHREAD_GETSPECIFIC(callback_threads_key) != NULL;
+}
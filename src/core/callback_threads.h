@@ -0,0 +1,41 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2008-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#ifndef __CALLBACK_THREADS_H__
+#define __CALLBACK_THREADS_H__
+
+/** @file */
+
+#include <core/jobs.h>
+
+#pragma GCC visibility push(hidden)
+
+/** Queue the callback of \p j to the callback threads, which will then call
+ * _starpu_job_run_offloaded_callback(). The threads are started on first use.
+ * Return 0 if the callback could not be queued (the callback threads are
+ * disabled or being shut down), in which case the caller has to run it. */
+int _starpu_callback_threads_push(struct _starpu_job *j);
+
+/** Wait for the queued callbacks to be run and stop the callback threads */
+void _starpu_callback_threads_shutdown(void);
+
+/** Whether the calling thread is a callback thread, which is thus running a
+ * callback */
+int _starpu_callback_threads_is_current(void);
+
+#pragma GCC visibility pop
+
+#endif // __CALLBACK_THREADS_H__
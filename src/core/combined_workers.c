@@ -102,6 +102,14 @@ int starpu_combined_worker_assign_workerid(int nworkers, int workerid_array[])
 	combined_worker->perf_arch.ndevices = 1;
 	combined_worker->perf_arch.devices[0].type = config->workers[workerid_array[0]].perf_arch.devices[0].type;
 	combined_worker->perf_arch.devices[0].devid = config->workers[workerid_array[0]].perf_arch.devices[0].devid;
+	for (i = 1; i < nworkers; i++)
+		if (config->workers[workerid_array[i]].perf_arch.devices[0].devid != combined_worker->perf_arch.devices[0].devid)
+		{
+			/* This spans several kinds of CPU cores, use a kind of
+			 * its own, after the real ones */
+			combined_worker->perf_arch.devices[0].devid = config->topology.ncpukinds;
+			break;
+		}
 	combined_worker->perf_arch.devices[0].ncores = nworkers;
 	combined_worker->worker_mask = config->workers[workerid_array[0]].worker_mask;
 
@@ -24,6 +24,7 @@
 #include <profiling/bound.h>
 #include <common/uthash.h>
 #include <core/debug.h>
+#include <core/task_fusion.h>
 
 #define STARPU_AYUDAME_OFFSET 4000000000000000000ULL
 
@@ -463,6 +464,8 @@ int starpu_tag_wait_array(unsigned ntags, starpu_tag_t *id)
 	/* It is forbidden to block within callbacks or codelets */
 	STARPU_ASSERT_MSG(_starpu_worker_may_perform_blocking_calls(), "starpu_tag_wait must not be called from a task or callback");
 
+	/* The tagged tasks may depend on a chain of tasks being merged */
+	_STARPU_TASK_FUSION_FLUSH();
 	starpu_do_schedule();
 	STARPU_PTHREAD_RWLOCK_WRLOCK(&tag_global_rwlock);
 	/* only wait the tags that are not done yet */
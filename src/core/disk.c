@@ -32,6 +32,7 @@
 #include <datawizard/memory_nodes.h>
 #include <datawizard/memory_manager.h>
 #include <datawizard/memalloc.h>
+#include <datawizard/dirty_tracking.h>
 
 #include <drivers/cuda/driver_cuda.h>
 #include <drivers/opencl/driver_opencl.h>
@@ -148,6 +149,7 @@ int starpu_disk_register(struct starpu_disk_ops *func, void *parameter, starpu_s
 		_starpu_memory_manager_set_global_memory_size(disk_memnode, size);
 
 	_starpu_mem_chunk_disk_register(disk_memnode);
+	_starpu_dirty_tracking_init();
 
 	return disk_memnode;
 }
@@ -177,6 +179,8 @@ void _starpu_disk_unregister(void)
 	/* no disk in the list -> delete the list */
 
 	STARPU_ASSERT_MSG(disk_number == 0, "Some disks are not unregistered !");
+
+	_starpu_dirty_tracking_deinit();
 }
 
 /* interface between user and disk memory */
@@ -219,10 +223,7 @@ int _starpu_disk_read(int src_dev, int dst_dev STARPU_ATTRIBUTE_UNUSED, void *ob
 	}
 	/* asynchronous request failed or synchronous request is asked */
 	if (channel == NULL || !event)
-	{
-		disk_register_list[src_dev]->functions->read(disk_register_list[src_dev]->base, obj, buf, offset, size);
-		return 0;
-	}
+		return disk_register_list[src_dev]->functions->read(disk_register_list[src_dev]->base, obj, buf, offset, size);
 	return -EAGAIN;
 }
 
@@ -251,11 +252,96 @@ int _starpu_disk_write(int src_dev STARPU_ATTRIBUTE_UNUSED, int dst_dev, void *o
 	}
 	/* asynchronous request failed or synchronous request is asked */
 	if (channel == NULL || !event)
+		return disk_register_list[dst_dev]->functions->write(disk_register_list[dst_dev]->base, obj, buf, offset, size);
+	return -EAGAIN;
+}
+
+/* src_dev == disk dev and dst_dev == STARPU_MAIN_RAM */
+int _starpu_disk_read2d(int src_dev, int dst_dev, void *obj, void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf, struct _starpu_async_channel *channel)
+{
+	struct starpu_disk_ops *functions;
+	void *event = NULL;
+	size_t i;
+	int ret = 0;
+
+	STARPU_ASSERT(src_dev < STARPU_NMAXDEVS);
+	functions = disk_register_list[src_dev]->functions;
+
+	if (channel != NULL && functions->async_read2d != NULL)
 	{
-		disk_register_list[dst_dev]->functions->write(disk_register_list[dst_dev]->base, obj, buf, offset, size);
-		return 0;
+		double start;
+		unsigned src_node = starpu_memory_devid_find_node(src_dev, STARPU_DISK_RAM);
+		_starpu_disk_get_event(&channel->event)->memory_node = src_node;
+
+		starpu_interface_start_driver_copy_async_devid(src_dev, STARPU_DISK_RAM, dst_dev, STARPU_CPU_RAM, &start);
+		event = functions->async_read2d(disk_register_list[src_dev]->base, obj, buf, offset, blocksize, numblocks, ld_obj, ld_buf);
+		starpu_interface_end_driver_copy_async_devid(src_dev, STARPU_DISK_RAM, dst_dev, STARPU_CPU_RAM, start);
+
+		if (event)
+		{
+			add_async_event(channel, event);
+			return -EAGAIN;
+		}
 	}
-	return -EAGAIN;
+
+	if (functions->read2d != NULL)
+		/* Synchronous, but still a single request */
+		return functions->read2d(disk_register_list[src_dev]->base, obj, buf, offset, blocksize, numblocks, ld_obj, ld_buf);
+
+	/* Read blocks one by one */
+	for (i = 0; i < numblocks; i++)
+	{
+		int err = _starpu_disk_read(src_dev, dst_dev, obj, (char *) buf + i*ld_buf, offset + i*ld_obj, blocksize, channel);
+		if (err == -EAGAIN)
+			ret = -EAGAIN;
+		else if (err)
+			return err;
+	}
+	return ret;
+}
+
+/* src_dev == STARPU_MAIN_RAM and dst_dev == disk dev */
+int _starpu_disk_write2d(int src_dev, int dst_dev, void *obj, void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf, struct _starpu_async_channel *channel)
+{
+	struct starpu_disk_ops *functions;
+	void *event = NULL;
+	size_t i;
+	int ret = 0;
+
+	STARPU_ASSERT(dst_dev < STARPU_NMAXDEVS);
+	functions = disk_register_list[dst_dev]->functions;
+
+	if (channel != NULL && functions->async_write2d != NULL)
+	{
+		double start;
+		unsigned dst_node = starpu_memory_devid_find_node(dst_dev, STARPU_DISK_RAM);
+		_starpu_disk_get_event(&channel->event)->memory_node = dst_node;
+
+		starpu_interface_start_driver_copy_async_devid(src_dev, STARPU_CPU_RAM, dst_dev, STARPU_DISK_RAM, &start);
+		event = functions->async_write2d(disk_register_list[dst_dev]->base, obj, buf, offset, blocksize, numblocks, ld_obj, ld_buf);
+		starpu_interface_end_driver_copy_async_devid(src_dev, STARPU_CPU_RAM, dst_dev, STARPU_DISK_RAM, start);
+
+		if (event)
+		{
+			add_async_event(channel, event);
+			return -EAGAIN;
+		}
+	}
+
+	if (functions->write2d != NULL)
+		/* Synchronous, but still a single request */
+		return functions->write2d(disk_register_list[dst_dev]->base, obj, buf, offset, blocksize, numblocks, ld_obj, ld_buf);
+
+	/* Write blocks one by one */
+	for (i = 0; i < numblocks; i++)
+	{
+		int err = _starpu_disk_write(src_dev, dst_dev, obj, (char *) buf + i*ld_buf, offset + i*ld_obj, blocksize, channel);
+		if (err == -EAGAIN)
+			ret = -EAGAIN;
+		else if (err)
+			return err;
+	}
+	return ret;
 }
 
 int _starpu_disk_copy(int src_dev, void *obj_src, off_t offset_src, int dst_dev, void *obj_dst, off_t offset_dst, size_t size, struct _starpu_async_channel *channel)
@@ -42,6 +42,15 @@ int _starpu_disk_read(int src_dev, int dst_dev, void *obj, void *buf, off_t offs
 /** src_dev is for the moment the STARU_MAIN_RAM, dst_dev is a disk device */
 int _starpu_disk_write(int src_dev, int dst_dev, void *obj, void *buf, off_t offset, size_t size, struct _starpu_async_channel * async_channel);
 
+/** Read \p numblocks blocks of \p blocksize bytes, \p ld_obj bytes apart on
+ * the disk and \p ld_buf bytes apart in \p buf, as one request if the disk
+ * backend supports it */
+int _starpu_disk_read2d(int src_dev, int dst_dev, void *obj, void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf, struct _starpu_async_channel *async_channel);
+/** Write \p numblocks blocks of \p blocksize bytes, \p ld_buf bytes apart in
+ * \p buf and \p ld_obj bytes apart on the disk, as one request if the disk
+ * backend supports it */
+int _starpu_disk_write2d(int src_dev, int dst_dev, void *obj, void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf, struct _starpu_async_channel *async_channel);
+
 int _starpu_disk_full_read(int src_dev, int dst_dev, void * obj, void ** ptr, size_t * size, struct _starpu_async_channel * async_channel);
 int _starpu_disk_full_write(int src_dev, int dst_dev, void * obj, void * ptr, size_t size, struct _starpu_async_channel * async_channel);
 
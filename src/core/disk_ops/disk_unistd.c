@@ -59,6 +59,8 @@ struct starpu_disk_ops starpu_disk_unistd_ops =
 	.close = starpu_unistd_global_close,
 	.read = starpu_unistd_global_read,
 	.write = starpu_unistd_global_write,
+	.read2d = starpu_unistd_global_read2d,
+	.write2d = starpu_unistd_global_write2d,
 	.plug = starpu_unistd_global_plug,
 	.unplug = starpu_unistd_global_unplug,
 #ifdef STARPU_UNISTD_USE_COPY
@@ -70,6 +72,8 @@ struct starpu_disk_ops starpu_disk_unistd_ops =
 #ifdef HAVE_AIO_H
 	.async_read = starpu_unistd_global_async_read,
 	.async_write = starpu_unistd_global_async_write,
+	.async_read2d = starpu_unistd_global_async_read2d,
+	.async_write2d = starpu_unistd_global_async_write2d,
 	.async_full_read = starpu_unistd_global_async_full_read,
 	.async_full_write = starpu_unistd_global_async_full_write,
 	.wait_request = starpu_unistd_global_wait_request,
@@ -30,6 +30,10 @@
 #ifdef HAVE_UNISTD_H
 #  include <unistd.h>
 #endif
+#include <limits.h>
+#if defined(HAVE_PREADV) && defined(HAVE_PWRITEV)
+#  include <sys/uio.h>
+#endif
 #include <starpu.h>
 #include <core/disk.h>
 #include <core/perfmodel/perfmodel.h>
@@ -54,6 +58,15 @@
 #define MAX_OPEN_FILES 64
 #define TEMP_HIERARCHY_DEPTH 2
 
+#if defined(HAVE_PREADV) && defined(HAVE_PWRITEV)
+#  define STARPU_UNISTD_USE_IOV 1
+#endif
+#ifdef IOV_MAX
+#  define STARPU_UNISTD_IOV_MAX IOV_MAX
+#else
+#  define STARPU_UNISTD_IOV_MAX 1024
+#endif
+
 #if !defined(HAVE_COPY_FILE_RANGE) && defined(__linux__) && defined(__NR_copy_file_range)
 static starpu_ssize_t copy_file_range(int fd_in, loff_t *off_in, int fd_out,
 				      loff_t *off_out, size_t len, unsigned int flags)
@@ -122,7 +135,14 @@ struct starpu_unistd_aiocb
 	struct iocb iocb;
 	struct starpu_unistd_global_obj *obj;
 	struct starpu_unistd_base *base;
+	/* length of each iocb */
 	size_t len;
+	/* memory blocks of a vectored request */
+	struct iovec *iov;
+	/* rows of a strided request, one iocb each, and how many of them
+	 * are not finished yet */
+	struct iocb *iocbs;
+	size_t pending;
 };
 #elif defined(HAVE_AIO_H)
 struct starpu_unistd_aiocb
@@ -130,9 +150,20 @@ struct starpu_unistd_aiocb
 	struct aiocb aiocb;
 	struct starpu_unistd_global_obj *obj;
 };
+/* Blocks of a 2D request, submitted together with lio_listio */
+struct starpu_unistd_aiocb_list
+{
+	struct aiocb *aiocbs;
+	struct aiocb **list;
+	size_t n;
+	/* number of blocks already known to be finished */
+	size_t done;
+	int fd;
+	struct starpu_unistd_global_obj *obj;
+};
 #endif
 
-enum starpu_unistd_wait_type { STARPU_UNISTD_AIOCB, STARPU_UNISTD_COPY };
+enum starpu_unistd_wait_type { STARPU_UNISTD_AIOCB, STARPU_UNISTD_AIOCB_LIST, STARPU_UNISTD_COPY };
 
 union starpu_unistd_wait_event
 {
@@ -140,6 +171,9 @@ union starpu_unistd_wait_event
 #if defined(HAVE_LIBAIO_H) || defined(HAVE_AIO_H)
 	struct starpu_unistd_aiocb event_aiocb;
 #endif
+#if !defined(HAVE_LIBAIO_H) && defined(HAVE_AIO_H)
+	struct starpu_unistd_aiocb_list event_aiocb_list;
+#endif
 };
 
 struct starpu_unistd_wait
@@ -329,6 +363,27 @@ int starpu_unistd_global_read(void *base STARPU_ATTRIBUTE_UNUSED, void *obj, voi
 }
 
 #if defined(HAVE_LIBAIO_H)
+/* Record the completion of an iocb, possibly submitted by another request */
+static void _starpu_unistd_aiocb_complete(struct starpu_unistd_base *fileBase, struct io_event *ev)
+{
+	struct starpu_unistd_aiocb_link *l = NULL;
+	struct starpu_unistd_aiocb *aiocb;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&fileBase->mutex);
+	HASH_FIND_PTR(fileBase->hashtable, &ev->obj, l);
+	STARPU_ASSERT(l != NULL);
+	HASH_DEL(fileBase->hashtable, l);
+
+	aiocb = l->starpu_aiocb;
+	STARPU_ASSERT_MSG(ev->res == aiocb->len, "Aio request was truncated");
+	if (aiocb->pending)
+		aiocb->pending--;
+	if (!aiocb->pending)
+		aiocb->finished = 1;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&fileBase->mutex);
+	free(l);
+}
+
 void *starpu_unistd_global_async_read(void *base, void *obj, void *buf, off_t offset, size_t size)
 {
 	struct starpu_unistd_base * fileBase = (struct starpu_unistd_base *) base;
@@ -630,6 +685,330 @@ void * starpu_unistd_global_async_full_write (void * base, void * obj, void * pt
 }
 #endif
 
+#ifdef STARPU_UNISTD_USE_IOV
+/* Build the list of the memory blocks of a 2D request */
+static struct iovec *_starpu_unistd_iov_2d(const void *buf, size_t blocksize, size_t numblocks, size_t ld_buf)
+{
+	struct iovec *iov;
+	size_t i;
+
+	_STARPU_MALLOC(iov, numblocks * sizeof(*iov));
+	for (i = 0; i < numblocks; i++)
+	{
+		iov[i].iov_base = (char *) buf + i*ld_buf;
+		iov[i].iov_len = blocksize;
+	}
+	return iov;
+}
+
+/* Transfer the memory blocks from/to a contiguous piece of file, with as few
+ * system calls as possible */
+static void _starpu_unistd_rwv(int fd, struct iovec *iov, size_t iovcnt, off_t offset, int is_write)
+{
+	while (iovcnt > 0)
+	{
+		int n = STARPU_MIN(iovcnt, (size_t) STARPU_UNISTD_IOV_MAX);
+		starpu_ssize_t nb;
+
+		if (is_write)
+			nb = pwritev(fd, iov, n, offset);
+		else
+			nb = preadv(fd, iov, n, offset);
+		STARPU_ASSERT_MSG(nb >= 0, "Starpu Disk unistd %s failed: offset %lu got errno %d", is_write ? "pwritev" : "preadv", (unsigned long) offset, errno);
+		offset += nb;
+
+		/* Skip what was transferred, possibly only part of a block */
+		while (iovcnt > 0 && (size_t) nb >= iov->iov_len)
+		{
+			nb -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		if (nb > 0)
+		{
+			iov->iov_base = (char *) iov->iov_base + nb;
+			iov->iov_len -= nb;
+		}
+	}
+}
+#endif
+
+int starpu_unistd_global_read2d(void *base, void *obj, void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf)
+{
+	size_t i;
+
+#ifdef STARPU_UNISTD_USE_IOV
+	if (ld_obj == blocksize)
+	{
+		/* Contiguous in the file, scatter in memory in one go */
+		struct starpu_unistd_global_obj *tmp = (struct starpu_unistd_global_obj *) obj;
+		struct iovec *iov = _starpu_unistd_iov_2d(buf, blocksize, numblocks, ld_buf);
+		int fd = tmp->descriptor;
+
+		if (fd < 0)
+			fd = _starpu_unistd_reopen(obj);
+		_starpu_unistd_rwv(fd, iov, numblocks, offset, 0);
+		if (tmp->descriptor < 0)
+			_starpu_unistd_reclose(fd);
+		free(iov);
+		return 0;
+	}
+#endif
+
+	for (i = 0; i < numblocks; i++)
+		starpu_unistd_global_read(base, obj, (char *) buf + i*ld_buf, offset + i*ld_obj, blocksize);
+	return 0;
+}
+
+int starpu_unistd_global_write2d(void *base, void *obj, const void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf)
+{
+	size_t i;
+
+#ifdef STARPU_UNISTD_USE_IOV
+	if (ld_obj == blocksize)
+	{
+		/* Contiguous in the file, gather from memory in one go */
+		struct starpu_unistd_global_obj *tmp = (struct starpu_unistd_global_obj *) obj;
+		struct iovec *iov = _starpu_unistd_iov_2d(buf, blocksize, numblocks, ld_buf);
+		int fd = tmp->descriptor;
+
+		if (fd < 0)
+			fd = _starpu_unistd_reopen(obj);
+		_starpu_unistd_rwv(fd, iov, numblocks, offset, 1);
+		if (tmp->descriptor < 0)
+			_starpu_unistd_reclose(fd);
+		free(iov);
+		return 0;
+	}
+#endif
+
+	for (i = 0; i < numblocks; i++)
+		starpu_unistd_global_write(base, obj, (const char *) buf + i*ld_buf, offset + i*ld_obj, blocksize);
+	return 0;
+}
+
+#if defined(HAVE_LIBAIO_H)
+/* A single vectored iocb when the blocks are contiguous in the file, one iocb
+ * per block otherwise, all submitted together */
+static void *starpu_unistd_global_async_rw2d(void *base, void *obj, void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf, int is_write)
+{
+	struct starpu_unistd_base * fileBase = (struct starpu_unistd_base *) base;
+	struct starpu_unistd_global_obj *tmp = obj;
+	struct starpu_unistd_wait * event;
+	struct iocb **iocbs;
+	struct starpu_unistd_aiocb_link *l;
+	int vectored = ld_obj == blocksize;
+	size_t niocbs = vectored ? 1 : numblocks;
+	int fd = tmp->descriptor;
+	long submitted;
+	size_t i;
+
+	if (vectored && numblocks > STARPU_UNISTD_IOV_MAX)
+		return NULL;
+
+	_STARPU_CALLOC(event, 1,sizeof(*event));
+	event->type = STARPU_UNISTD_AIOCB;
+	struct starpu_unistd_aiocb *starpu_aiocb = &event->event.event_aiocb;
+	starpu_aiocb->obj = obj;
+	starpu_aiocb->finished = 0;
+	starpu_aiocb->base = fileBase;
+	_STARPU_MALLOC(iocbs, niocbs * sizeof(*iocbs));
+
+	if (fd < 0)
+		fd = _starpu_unistd_reopen(obj);
+
+	if (vectored)
+	{
+		struct iocb *iocb = &starpu_aiocb->iocb;
+
+		_STARPU_MALLOC(starpu_aiocb->iov, numblocks * sizeof(*starpu_aiocb->iov));
+		for (i = 0; i < numblocks; i++)
+		{
+			starpu_aiocb->iov[i].iov_base = (char *) buf + i*ld_buf;
+			starpu_aiocb->iov[i].iov_len = blocksize;
+		}
+		starpu_aiocb->len = blocksize * numblocks;
+		if (is_write)
+			io_prep_pwritev(iocb, fd, starpu_aiocb->iov, numblocks, offset);
+		else
+			io_prep_preadv(iocb, fd, starpu_aiocb->iov, numblocks, offset);
+		iocbs[0] = iocb;
+	}
+	else
+	{
+		_STARPU_MALLOC(starpu_aiocb->iocbs, numblocks * sizeof(*starpu_aiocb->iocbs));
+		/* For starpu_unistd_global_free_request */
+		starpu_aiocb->iocb.aio_fildes = fd;
+		starpu_aiocb->len = blocksize;
+		starpu_aiocb->pending = numblocks;
+		for (i = 0; i < numblocks; i++)
+		{
+			struct iocb *iocb = &starpu_aiocb->iocbs[i];
+			if (is_write)
+				io_prep_pwrite(iocb, fd, (char *) buf + i*ld_buf, blocksize, offset + i*ld_obj);
+			else
+				io_prep_pread(iocb, fd, (char *) buf + i*ld_buf, blocksize, offset + i*ld_obj);
+			iocbs[i] = iocb;
+		}
+	}
+
+	/* Blocks may complete before io_submit returns, and be caught by any
+	 * thread, so register them first */
+	STARPU_PTHREAD_MUTEX_LOCK(&fileBase->mutex);
+	for (i = 0; i < niocbs; i++)
+	{
+		_STARPU_MALLOC(l, sizeof(*l));
+		l->aiocb = iocbs[i];
+		l->starpu_aiocb = starpu_aiocb;
+		HASH_ADD_PTR(fileBase->hashtable, aiocb, l);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&fileBase->mutex);
+
+	submitted = io_submit(fileBase->ctx, niocbs, iocbs);
+	if (submitted < 0)
+	{
+		_STARPU_DISP("Warning: io_submit returned %ld (%s)\n", submitted, strerror(-submitted));
+		submitted = 0;
+	}
+
+	if ((size_t) submitted < niocbs)
+	{
+		/* The context is full, transfer the remaining blocks right away */
+		STARPU_PTHREAD_MUTEX_LOCK(&fileBase->mutex);
+		for (i = submitted; i < niocbs; i++)
+		{
+			HASH_FIND_PTR(fileBase->hashtable, &iocbs[i], l);
+			STARPU_ASSERT(l != NULL);
+			HASH_DEL(fileBase->hashtable, l);
+			free(l);
+		}
+		STARPU_PTHREAD_MUTEX_UNLOCK(&fileBase->mutex);
+
+		if (!submitted)
+		{
+			/* Nothing was submitted, let the caller fall back */
+			if (tmp->descriptor < 0)
+				_starpu_unistd_reclose(fd);
+			free(starpu_aiocb->iov);
+			free(starpu_aiocb->iocbs);
+			free(event);
+			free(iocbs);
+			return NULL;
+		}
+
+		for (i = submitted; i < niocbs; i++)
+		{
+			if (is_write)
+				starpu_unistd_global_write(base, obj, (char *) buf + i*ld_buf, offset + i*ld_obj, blocksize);
+			else
+				starpu_unistd_global_read(base, obj, (char *) buf + i*ld_buf, offset + i*ld_obj, blocksize);
+		}
+
+		STARPU_PTHREAD_MUTEX_LOCK(&fileBase->mutex);
+		starpu_aiocb->pending -= niocbs - submitted;
+		STARPU_PTHREAD_MUTEX_UNLOCK(&fileBase->mutex);
+	}
+
+	free(iocbs);
+	return event;
+}
+#elif defined(HAVE_AIO_H)
+/* Return whether all blocks of the list are finished */
+static int _starpu_unistd_aiocb_list_test(struct starpu_unistd_aiocb_list *aiocb_list)
+{
+	while (aiocb_list->done < aiocb_list->n)
+	{
+		struct aiocb *aiocb = &aiocb_list->aiocbs[aiocb_list->done];
+		starpu_ssize_t size;
+		int ret = aio_error(aiocb);
+
+		if (ret == EINTR || ret == EINPROGRESS || ret == EAGAIN)
+			return 0;
+		STARPU_ASSERT_MSG(!ret, "aio_error returned %d", ret);
+		size = aio_return(aiocb);
+		STARPU_ASSERT_MSG(size == (starpu_ssize_t) aiocb->aio_nbytes, "AIO op got %ld bytes instead of %ld bytes\n", (long) size, (long) aiocb->aio_nbytes);
+		aiocb_list->done++;
+	}
+	return 1;
+}
+
+/* One aiocb per block, all submitted with a single lio_listio call */
+static void *starpu_unistd_global_async_rw2d(void *base STARPU_ATTRIBUTE_UNUSED, void *obj, void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf, int is_write)
+{
+	struct starpu_unistd_global_obj *tmp = obj;
+	struct starpu_unistd_wait * event;
+	struct starpu_unistd_aiocb_list *aiocb_list;
+	int fd = tmp->descriptor;
+	size_t i;
+
+#ifdef STARPU_UNISTD_USE_IOV
+	if (ld_obj == blocksize)
+		/* POSIX aio has no vectored requests, and e.g. glibc emulates
+		 * it with one pread per block anyway: a single synchronous
+		 * preadv/pwritev is much faster */
+		return NULL;
+#endif
+
+	_STARPU_CALLOC(event, 1,sizeof(*event));
+	event->type = STARPU_UNISTD_AIOCB_LIST;
+	aiocb_list = &event->event.event_aiocb_list;
+	aiocb_list->obj = obj;
+	aiocb_list->n = numblocks;
+	_STARPU_CALLOC(aiocb_list->aiocbs, numblocks, sizeof(*aiocb_list->aiocbs));
+	_STARPU_MALLOC(aiocb_list->list, numblocks * sizeof(*aiocb_list->list));
+
+	if (fd < 0)
+		fd = _starpu_unistd_reopen(obj);
+	aiocb_list->fd = fd;
+
+	for (i = 0; i < numblocks; i++)
+	{
+		struct aiocb *aiocb = &aiocb_list->aiocbs[i];
+		aiocb->aio_fildes = fd;
+		aiocb->aio_offset = offset + i*ld_obj;
+		aiocb->aio_nbytes = blocksize;
+		aiocb->aio_buf = (char *) buf + i*ld_buf;
+		aiocb->aio_reqprio = 0;
+		aiocb->aio_lio_opcode = is_write ? LIO_WRITE : LIO_READ;
+		aiocb->aio_sigevent.sigev_notify = SIGEV_NONE;
+		aiocb_list->list[i] = aiocb;
+	}
+
+	if (lio_listio(LIO_NOWAIT, aiocb_list->list, numblocks, NULL) < 0)
+	{
+		_STARPU_DISP("Warning: lio_listio returned %d (%s)\n", errno, strerror(errno));
+		/* Some blocks may have been submitted, let them finish before
+		 * the caller falls back to synchronous transfers */
+		for (i = 0; i < numblocks; i++)
+		{
+			struct aiocb *aiocb = &aiocb_list->aiocbs[i];
+			while (aio_error(aiocb) == EINPROGRESS)
+				aio_suspend((const struct aiocb **) &aiocb, 1, NULL);
+		}
+		if (tmp->descriptor < 0)
+			_starpu_unistd_reclose(fd);
+		free(aiocb_list->list);
+		free(aiocb_list->aiocbs);
+		free(event);
+		return NULL;
+	}
+
+	return event;
+}
+#endif
+
+#if defined(HAVE_AIO_H)
+void *starpu_unistd_global_async_read2d(void *base, void *obj, void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf)
+{
+	return starpu_unistd_global_async_rw2d(base, obj, buf, offset, blocksize, numblocks, ld_obj, ld_buf, 0);
+}
+
+void *starpu_unistd_global_async_write2d(void *base, void *obj, void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf)
+{
+	return starpu_unistd_global_async_rw2d(base, obj, buf, offset, blocksize, numblocks, ld_obj, ld_buf, 1);
+}
+#endif
+
 #ifdef STARPU_UNISTD_USE_COPY
 static void * starpu_unistd_internal_thread(void * arg)
 {
@@ -888,21 +1267,8 @@ void starpu_unistd_global_wait_request(void *async_channel)
 				if (values < 0)
 					myerrno = -values;
 				if (values > 0)
-				{
 					//we may catch an other request...
-					STARPU_PTHREAD_MUTEX_LOCK(&starpu_aiocb->base->mutex);
-
-					struct starpu_unistd_aiocb_link *l = NULL;
-					HASH_FIND_PTR(starpu_aiocb->base->hashtable, &ev.obj, l);
-					STARPU_ASSERT(l != NULL);
-
-					HASH_DEL(starpu_aiocb->base->hashtable, l);
-					STARPU_PTHREAD_MUTEX_UNLOCK(&starpu_aiocb->base->mutex);
-					struct starpu_unistd_aiocb *aiocb = l->starpu_aiocb;
-					STARPU_ASSERT_MSG(ev.res == aiocb->len, "Aio request was truncated");
-					aiocb->finished = 1;
-					free(l);
-				}
+					_starpu_unistd_aiocb_complete(starpu_aiocb->base, &ev);
 			}
 #elif defined(HAVE_AIO_H)
 			struct starpu_unistd_aiocb *starpu_aiocb = &event->event.event_aiocb;
@@ -924,6 +1290,17 @@ void starpu_unistd_global_wait_request(void *async_channel)
 			break;
 		}
 
+#if !defined(HAVE_LIBAIO_H) && defined(HAVE_AIO_H)
+		case STARPU_UNISTD_AIOCB_LIST :
+		{
+			struct starpu_unistd_aiocb_list *aiocb_list = &event->event.event_aiocb_list;
+			while (!_starpu_unistd_aiocb_list_test(aiocb_list))
+				/* Wait for any of the remaining blocks */
+				aio_suspend((const struct aiocb **) &aiocb_list->list[aiocb_list->done], aiocb_list->n - aiocb_list->done, NULL);
+			break;
+		}
+#endif
+
 #ifdef STARPU_UNISTD_USE_COPY
 		case STARPU_UNISTD_COPY :
 		{
@@ -962,18 +1339,7 @@ int starpu_unistd_global_test_request(void *async_channel)
 			if (ret == 1)
 			{
 				//we may catch an other request...
-				STARPU_PTHREAD_MUTEX_LOCK(&starpu_aiocb->base->mutex);
-
-				struct starpu_unistd_aiocb_link *l = NULL;
-				HASH_FIND_PTR(starpu_aiocb->base->hashtable, &ev.obj, l);
-				STARPU_ASSERT(l != NULL);
-
-				HASH_DEL(starpu_aiocb->base->hashtable, l);
-				STARPU_PTHREAD_MUTEX_UNLOCK(&starpu_aiocb->base->mutex);
-				struct starpu_unistd_aiocb *aiocb = l->starpu_aiocb;
-				STARPU_ASSERT_MSG(ev.res == aiocb->len, "Aio request was truncated");
-				aiocb->finished = 1;
-				free(l);
+				_starpu_unistd_aiocb_complete(starpu_aiocb->base, &ev);
 
 				if (starpu_aiocb->finished)
 					return 1;
@@ -1011,6 +1377,13 @@ int starpu_unistd_global_test_request(void *async_channel)
 			break;
 		}
 
+#if !defined(HAVE_LIBAIO_H) && defined(HAVE_AIO_H)
+		case STARPU_UNISTD_AIOCB_LIST :
+		{
+			return _starpu_unistd_aiocb_list_test(&event->event.event_aiocb_list);
+		}
+#endif
+
 #ifdef STARPU_UNISTD_USE_COPY
 		case STARPU_UNISTD_COPY :
 		{
@@ -1038,6 +1411,8 @@ void starpu_unistd_global_free_request(void *async_channel)
 			struct iocb *iocb = &starpu_aiocb->iocb;
 			if (starpu_aiocb->obj->descriptor < 0)
 				_starpu_unistd_reclose(iocb->aio_fildes);
+			free(starpu_aiocb->iov);
+			free(starpu_aiocb->iocbs);
 			free(event);
 #elif defined(HAVE_AIO_H)
 			struct starpu_unistd_aiocb *starpu_aiocb = &event->event.event_aiocb;
@@ -1049,6 +1424,19 @@ void starpu_unistd_global_free_request(void *async_channel)
 			break;
 		}
 
+#if !defined(HAVE_LIBAIO_H) && defined(HAVE_AIO_H)
+		case STARPU_UNISTD_AIOCB_LIST :
+		{
+			struct starpu_unistd_aiocb_list *aiocb_list = &event->event.event_aiocb_list;
+			if (aiocb_list->obj->descriptor < 0)
+				_starpu_unistd_reclose(aiocb_list->fd);
+			free(aiocb_list->list);
+			free(aiocb_list->aiocbs);
+			free(event);
+			break;
+		}
+#endif
+
 #ifdef STARPU_UNISTD_USE_COPY
 		case STARPU_UNISTD_COPY :
 		{
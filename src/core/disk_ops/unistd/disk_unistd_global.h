@@ -57,11 +57,15 @@ void * starpu_unistd_global_open (struct starpu_unistd_global_obj * obj, void *b
 void starpu_unistd_global_close (void *base, void *obj, size_t size);
 int starpu_unistd_global_read (void *base, void *obj, void *buf, off_t offset, size_t size);
 int starpu_unistd_global_write (void *base, void *obj, const void *buf, off_t offset, size_t size);
+int starpu_unistd_global_read2d (void *base, void *obj, void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf);
+int starpu_unistd_global_write2d (void *base, void *obj, const void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf);
 void * starpu_unistd_global_plug (void *parameter, starpu_ssize_t size);
 void starpu_unistd_global_unplug (void *base);
 int _starpu_get_unistd_global_bandwidth_between_disk_and_main_ram(unsigned node, void *base);
 void* starpu_unistd_global_async_read (void *base, void *obj, void *buf, off_t offset, size_t size);
 void* starpu_unistd_global_async_write (void *base, void *obj, void *buf, off_t offset, size_t size);
+void* starpu_unistd_global_async_read2d (void *base, void *obj, void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf);
+void* starpu_unistd_global_async_write2d (void *base, void *obj, void *buf, off_t offset, size_t blocksize, size_t numblocks, size_t ld_obj, size_t ld_buf);
 void * starpu_unistd_global_async_full_write (void * base, void * obj, void * ptr, size_t size);
 void * starpu_unistd_global_async_full_read (void * base, void * obj, void ** ptr, size_t * size, unsigned dst_node);
 void starpu_unistd_global_wait_request(void * async_channel);
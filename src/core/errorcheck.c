@@ -16,6 +16,7 @@
 
 #include <core/errorcheck.h>
 #include <core/workers.h>
+#include <core/callback_threads.h>
 
 void _starpu_add_worker_status(struct _starpu_worker *worker, enum _starpu_worker_status_index st, struct timespec *time)
 {
@@ -89,5 +90,10 @@ unsigned _starpu_worker_may_perform_blocking_calls(void)
 	const int blocking_call_check_override = 0;
 #endif /* STARPU_OPENMP */
 
-	return blocking_call_check_override || (st == STATUS_INVALID) || (!(st & STATUS_CALLBACK) && !(st & STATUS_EXECUTING));
+	if (st == STATUS_INVALID)
+		/* Not a worker, but offloaded callbacks are not allowed to
+		 * block either */
+		return blocking_call_check_override || !_starpu_callback_threads_is_current();
+
+	return blocking_call_check_override || (!(st & STATUS_CALLBACK) && !(st & STATUS_EXECUTING));
 }
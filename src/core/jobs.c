@@ -28,6 +28,8 @@
 #include <profiling/profiling.h>
 #include <profiling/bound.h>
 #include <core/debug.h>
+#include <core/callback_threads.h>
+#include <util/starpu_data_cpy.h>
 #include <limits.h>
 #include <core/workers.h>
 
@@ -202,6 +204,8 @@ void _starpu_job_destroy(struct _starpu_job *j)
 		free(j->dyn_dep_slots);
 		j->dyn_dep_slots = NULL;
 	}
+	free(j->cow_handles);
+	j->cow_handles = NULL;
 
 	if (_starpu_graph_record && j->graph_node)
 		_starpu_graph_drop_job(j);
@@ -340,6 +344,159 @@ void starpu_task_end_dep_add(struct starpu_task *t, int nb_deps)
 	STARPU_PTHREAD_MUTEX_UNLOCK(&j->sync_mutex);
 }
 
+/* Run the callback of the task. This is called after the dependencies release,
+ * either from the worker which executed the task, or from a callback thread. */
+static void _starpu_job_run_callback(struct _starpu_job *j, void (*callback)(void *), struct starpu_perf_counter_sample_cl_values *pcv)
+{
+	struct starpu_task *task = j->task;
+	/* The callback may change these */
+	struct starpu_codelet *cl = task->cl;
+	struct starpu_profiling_task_info *profiling_info = task->profiling_info;
+	struct timespec *time = NULL;
+	int profiling = starpu_profiling_status_get();
+	if (profiling && profiling_info)
+	{
+		time = &profiling_info->callback_start_time;
+		_starpu_clock_gettime(time);
+	}
+	enum _starpu_worker_status old_status = _starpu_get_local_worker_status();
+
+	/* so that we can check whether we are doing blocking calls
+	 * within the callback */
+	if (!(old_status & STATUS_CALLBACK))
+		_starpu_add_local_worker_status(STATUS_INDEX_CALLBACK, time);
+
+	/* Perhaps we have nested callbacks (eg. with chains of empty
+	 * tasks). So we store the current task and we will restore it
+	 * later. */
+	struct starpu_task *current_task = starpu_task_get_current();
+
+	_starpu_set_current_task(task);
+
+	double start = 0.;
+	if (pcv && !_starpu_perf_counter_paused())
+		start = starpu_timing_now();
+
+	_STARPU_TRACE_START_CALLBACK(j);
+	callback(task->callback_arg);
+	_STARPU_TRACE_END_CALLBACK(j);
+
+	if (start != 0.)
+	{
+		_starpu_perf_counter_update_acc_double(&pcv->task.cumul_callback_time, starpu_timing_now() - start);
+		_starpu_perf_counter_update_per_codelet_sample(cl);
+	}
+
+	_starpu_set_current_task(current_task);
+
+	if (profiling && profiling_info)
+	{
+		time = &profiling_info->callback_end_time;
+		_starpu_clock_gettime(time);
+	}
+
+	if (!(old_status & STATUS_CALLBACK))
+		_starpu_clear_local_worker_status(STATUS_INDEX_CALLBACK, time);
+}
+
+/* Mark the job as terminated, and destroy or resubmit the task if needed. This
+ * must be called after the callback, since the task may be waited for. */
+static void _starpu_job_finish(struct _starpu_job *j, unsigned sched_ctx, double flops, unsigned continuation)
+{
+	struct starpu_task *task = j->task;
+
+	/* Note: For now, we keep the TASK_DONE trace event for continuation,
+	 * however we could add a specific event for stopped tasks if needed.
+	 */
+	_STARPU_TRACE_TASK_DONE(j);
+
+	STARPU_PTHREAD_MUTEX_LOCK(&j->sync_mutex);
+
+	/* NB: we do not save those values before the callback, in case the
+	 * application changes some parameters eventually (eg. a task may not
+	 * be generated if the application is terminated). */
+	unsigned destroy = task->destroy;
+	unsigned detach = task->detach;
+	unsigned regenerate = task->regenerate;
+	unsigned synchronous = task->synchronous;
+
+	if (!continuation)
+	{
+#ifdef STARPU_OPENMP
+		if (j->omp_cleanup_callback)
+		{
+			j->omp_cleanup_callback(j->omp_cleanup_callback_arg);
+			j->omp_cleanup_callback = NULL;
+			j->omp_cleanup_callback_arg = NULL;
+		}
+#endif
+		/* A value of 2 is put to specify that not only the codelet but
+		 * also the callback were executed. */
+		j->terminated = 2;
+	}
+	task->prefetched = 0;
+	STARPU_PTHREAD_COND_BROADCAST(&j->sync_cond);
+	STARPU_AYU_REMOVETASK(j->job_id);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&j->sync_mutex);
+
+	/* we do not deallocate the job structure if some is going to
+	 * wait after the task */
+	if (detach && !continuation)
+	{
+		/* no one is going to synchronize with that task so we release
+		 * the data structures now. In case the job was already locked
+		 * by the caller, it is its responsibility to destroy the task.
+		 * */
+		if (destroy)
+			_starpu_task_destroy(task);
+	}
+
+	/* A continuation is not much different from a regenerated task. */
+	if (regenerate || continuation)
+	{
+		STARPU_ASSERT_MSG((detach && !destroy && !synchronous)
+				|| continuation
+				, "Regenerated task must be detached (was %u), and not have destroy=1 (was %u) or synchronous=1 (was %u)", detach, destroy, synchronous);
+		STARPU_AYU_ADDTASK(j->job_id, j->exclude_from_dag?NULL:task);
+
+		{
+#ifdef STARPU_OPENMP
+			unsigned continuation_resubmit = j->continuation_resubmit;
+			void (*continuation_callback_on_sleep)(void *arg) = j->continuation_callback_on_sleep;
+			void *continuation_callback_on_sleep_arg = j->continuation_callback_on_sleep_arg;
+			j->continuation_resubmit = 1;
+			j->continuation_callback_on_sleep = NULL;
+			j->continuation_callback_on_sleep_arg = NULL;
+			if (!continuation || continuation_resubmit)
+#endif
+			{
+				/* We reuse the same job structure */
+				task->status = STARPU_TASK_BLOCKED;
+				int ret = _starpu_submit_job(j, 0);
+				STARPU_ASSERT(!ret);
+			}
+#ifdef STARPU_OPENMP
+			if (continuation && continuation_callback_on_sleep != NULL)
+			{
+				continuation_callback_on_sleep(continuation_callback_on_sleep_arg);
+			}
+#endif
+		}
+	}
+
+	_starpu_decrement_nready_tasks_of_sched_ctx(sched_ctx, flops);
+	_starpu_decrement_nsubmitted_tasks_of_sched_ctx(sched_ctx);
+}
+
+void _starpu_job_run_offloaded_callback(struct _starpu_job *j)
+{
+	unsigned sched_ctx = j->offloaded_callback_sched_ctx;
+	double flops = j->offloaded_callback_flops;
+
+	_starpu_job_run_callback(j, j->offloaded_callback, j->offloaded_callback_pcv);
+	_starpu_job_finish(j, sched_ctx, flops, 0);
+}
+
 void _starpu_handle_job_termination(struct _starpu_job *j)
 {
 	if (j->task->nb_termination_call_required != 0)
@@ -503,6 +660,9 @@ void _starpu_handle_job_termination(struct _starpu_job *j)
 	void (*callback)(void *) = task->callback_func;
 	if (!callback && task->cl)
 		callback = task->cl->callback_func;
+	struct starpu_perf_counter_sample_cl_values *pcv = task->cl ? task->cl->perf_counter_values : NULL;
+	unsigned offload_callback = task->callback_offload || (task->cl && (task->cl->flags & STARPU_CODELET_CALLBACK_OFFLOAD));
+	unsigned offloaded = 0;
 
 	/* If this is a continuation, we do not release task dependencies now.
 	 * Task dependencies will be released only when the continued task
@@ -512,6 +672,10 @@ void _starpu_handle_job_termination(struct _starpu_job *j)
 		/* Tell other tasks that we don't exist any more, thus no need for
 		 * implicit dependencies any more.  */
 		_starpu_release_task_enforce_sequential_consistency(j);
+
+		if (STARPU_UNLIKELY(j->cow_handles))
+			/* Give the application its handles back */
+			_starpu_data_cow_task_terminated(j);
 	}
 
 	/* Task does not have a cl, but has explicit data dependencies, we need
@@ -548,125 +712,24 @@ void _starpu_handle_job_termination(struct _starpu_job *j)
 		 * of the task itself */
 		if (callback)
 		{
-			struct timespec *time = NULL;
-			int profiling = starpu_profiling_status_get();
-			if (profiling && task->profiling_info)
+			if (offload_callback)
 			{
-				time = &task->profiling_info->callback_start_time;
-				_starpu_clock_gettime(time);
+				j->offloaded_callback = callback;
+				j->offloaded_callback_pcv = pcv;
+				j->offloaded_callback_sched_ctx = sched_ctx;
+				j->offloaded_callback_flops = flops;
+				/* The callback thread will finish the job, we
+				 * must not touch it any more */
+				offloaded = _starpu_callback_threads_push(j);
 			}
-			enum _starpu_worker_status old_status = _starpu_get_local_worker_status();
-
-			/* so that we can check whether we are doing blocking calls
-			 * within the callback */
-			if (!(old_status & STATUS_CALLBACK))
-				_starpu_add_local_worker_status(STATUS_INDEX_CALLBACK, time);
-
-			/* Perhaps we have nested callbacks (eg. with chains of empty
-			 * tasks). So we store the current task and we will restore it
-			 * later. */
-			struct starpu_task *current_task = starpu_task_get_current();
-
-			_starpu_set_current_task(task);
-
-			_STARPU_TRACE_START_CALLBACK(j);
-			callback(task->callback_arg);
-			_STARPU_TRACE_END_CALLBACK(j);
-
-			_starpu_set_current_task(current_task);
-
-			if (profiling && task->profiling_info)
-			{
-				time = &task->profiling_info->callback_end_time;
-				_starpu_clock_gettime(time);
-			}
-
-			if (!(old_status & STATUS_CALLBACK))
-				_starpu_clear_local_worker_status(STATUS_INDEX_CALLBACK, time);
+			if (!offloaded)
+				_starpu_job_run_callback(j, callback, pcv);
 		}
 	}
 
-	/* Note: For now, we keep the TASK_DONE trace event for continuation,
-	 * however we could add a specific event for stopped tasks if needed.
-	 */
-	_STARPU_TRACE_TASK_DONE(j);
-
-	STARPU_PTHREAD_MUTEX_LOCK(&j->sync_mutex);
-
-	/* NB: we do not save those values before the callback, in case the
-	 * application changes some parameters eventually (eg. a task may not
-	 * be generated if the application is terminated). */
-	unsigned destroy = task->destroy;
-	unsigned detach = task->detach;
-	unsigned regenerate = task->regenerate;
-	unsigned synchronous = task->synchronous;
-
-	if (!continuation)
-	{
-#ifdef STARPU_OPENMP
-		if (j->omp_cleanup_callback)
-		{
-			j->omp_cleanup_callback(j->omp_cleanup_callback_arg);
-			j->omp_cleanup_callback = NULL;
-			j->omp_cleanup_callback_arg = NULL;
-		}
-#endif
-		/* A value of 2 is put to specify that not only the codelet but
-		 * also the callback were executed. */
-		j->terminated = 2;
-	}
-	task->prefetched = 0;
-	STARPU_PTHREAD_COND_BROADCAST(&j->sync_cond);
-	STARPU_AYU_REMOVETASK(j->job_id);
-	STARPU_PTHREAD_MUTEX_UNLOCK(&j->sync_mutex);
-
-	/* we do not deallocate the job structure if some is going to
-	 * wait after the task */
-	if (detach && !continuation)
-	{
-		/* no one is going to synchronize with that task so we release
-		 * the data structures now. In case the job was already locked
-		 * by the caller, it is its responsibility to destroy the task.
-		 * */
-		if (destroy)
-			_starpu_task_destroy(task);
-	}
+	if (!offloaded)
+		_starpu_job_finish(j, sched_ctx, flops, continuation);
 
-	/* A continuation is not much different from a regenerated task. */
-	if (regenerate || continuation)
-	{
-		STARPU_ASSERT_MSG((detach && !destroy && !synchronous)
-				|| continuation
-				, "Regenerated task must be detached (was %u), and not have destroy=1 (was %u) or synchronous=1 (was %u)", detach, destroy, synchronous);
-		STARPU_AYU_ADDTASK(j->job_id, j->exclude_from_dag?NULL:task);
-
-		{
-#ifdef STARPU_OPENMP
-			unsigned continuation_resubmit = j->continuation_resubmit;
-			void (*continuation_callback_on_sleep)(void *arg) = j->continuation_callback_on_sleep;
-			void *continuation_callback_on_sleep_arg = j->continuation_callback_on_sleep_arg;
-			j->continuation_resubmit = 1;
-			j->continuation_callback_on_sleep = NULL;
-			j->continuation_callback_on_sleep_arg = NULL;
-			if (!continuation || continuation_resubmit)
-#endif
-			{
-				/* We reuse the same job structure */
-				task->status = STARPU_TASK_BLOCKED;
-				int ret = _starpu_submit_job(j, 0);
-				STARPU_ASSERT(!ret);
-			}
-#ifdef STARPU_OPENMP
-			if (continuation && continuation_callback_on_sleep != NULL)
-			{
-				continuation_callback_on_sleep(continuation_callback_on_sleep_arg);
-			}
-#endif
-		}
-	}
-
-	_starpu_decrement_nready_tasks_of_sched_ctx(sched_ctx, flops);
-	_starpu_decrement_nsubmitted_tasks_of_sched_ctx(sched_ctx);
 	struct _starpu_worker *worker;
 	worker = _starpu_get_local_worker_key();
 	if (worker)
@@ -112,12 +112,28 @@ struct _starpu_job
 	/** Task whose termination depends on this task */
 	struct starpu_task *end_rdep;
 
+	/** When the callback of the task is run by a callback thread, the
+	 * callback function and the values needed to finish the job, which
+	 * are saved before releasing the dependencies, and the link in the
+	 * callback threads queue. */
+	void (*offloaded_callback)(void *);
+	struct starpu_perf_counter_sample_cl_values *offloaded_callback_pcv;
+	unsigned offloaded_callback_sched_ctx;
+	double offloaded_callback_flops;
+	struct _starpu_job *offloaded_callback_next;
+
 	/** For tasks with cl==NULL but submitted with explicit data dependency,
 	 * the handle for this dependency, so as to remove the task from the
 	 * last_writer/readers */
 	starpu_data_handle_t implicit_dep_handle;
 	struct _starpu_task_wrapper_dlist implicit_dep_slot;
 
+	/** For tasks reading pending data copies, the original handles of the
+	 * buffers which were redirected to the source of the copy, to be put
+	 * back on termination, NULL when there is none. See
+	 * _starpu_data_cow_task_submit */
+	starpu_data_handle_t *cow_handles;
+
 	/** Indicates whether the task associated to that job has already been
 	 * submitted to StarPU (1) or not (0) (using starpu_task_submit).
 	 * Becomes and stays 2 when the task is submitted several times.
@@ -284,6 +300,11 @@ void _starpu_handle_job_submission(struct _starpu_job *j);
  * job's dependencies and perform the callback function if any. */
 void _starpu_handle_job_termination(struct _starpu_job *j);
 
+/** Run the callback of a job whose termination was handled by
+ * _starpu_handle_job_termination, but whose callback was offloaded to a
+ * callback thread, and finish the job. */
+void _starpu_job_run_offloaded_callback(struct _starpu_job *j);
+
 /** Get the sum of the size of the data accessed by the job. */
 size_t _starpu_job_get_data_size(struct starpu_perfmodel *model, struct starpu_perfmodel_arch* arch, unsigned nimpl, struct _starpu_job *j);
 
@@ -54,6 +54,10 @@ struct _starpu_perfmodel_state
 {
 	struct starpu_perfmodel_per_arch** per_arch; /*STARPU_MAXIMPLEMENTATIONS*/
 	int** per_arch_is_set; /*STARPU_MAXIMPLEMENTATIONS*/
+	/** Accumulators of the regressions when last loaded from or saved to
+	 * the model file, so that only the samples measured since then are
+	 * merged with the model file on save. Allocated on first use. */
+	struct starpu_perfmodel_regression_model** disk_regression; /*STARPU_MAXIMPLEMENTATIONS*/
 
 	starpu_pthread_rwlock_t model_rwlock;
 	int *nimpls;
@@ -115,6 +119,8 @@ void _starpu_save_bandwidth_and_latency_disk(double bandwidth_write, double band
 void _starpu_write_double(FILE *f, const char *format, double val) STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
 int _starpu_read_double(FILE *f, char *format, double *val) STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
 void _starpu_simgrid_get_platform_path(int version, char *path, size_t maxlen);
+/** Path of the cache of the hwloc topology, along the bus calibration files */
+void _starpu_get_hwloc_cache_path(char *path, size_t maxlen);
 
 void _starpu_perfmodel_realloc(struct starpu_perfmodel *model, int nb);
 
@@ -1870,6 +1870,11 @@ static void generate_bus_config_file(void)
 }
 #endif /* !SIMGRID */
 
+void _starpu_get_hwloc_cache_path(char *path, size_t maxlen)
+{
+	get_bus_path("hwloc.xml", path, maxlen);
+}
+
 void _starpu_simgrid_get_platform_path(int version, char *path, size_t maxlen)
 {
 	if (version == 3)
@@ -32,6 +32,7 @@
 #include <datawizard/datawizard.h>
 #include <core/perfmodel/regression.h>
 #include <core/perfmodel/multiple_regression.h>
+#include <drivers/cpu/driver_cpu.h>
 #include <common/config.h>
 #include <common/uthash.h>
 #include <limits.h>
@@ -60,6 +61,16 @@ struct starpu_perfmodel_history_table
 	UT_hash_handle hh;
 	uint32_t footprint;
 	struct starpu_perfmodel_history_entry *history_entry;
+
+	/* Values of history_entry when last loaded from or saved to the model
+	 * file, so that only the samples measured since then are merged with
+	 * the model file on save */
+	unsigned disk_nsample;
+	double disk_sum;
+	double disk_sum2;
+	/* Whether the entry was flushed since then, in which case it
+	 * overwrites the file entry */
+	unsigned flushed;
 };
 
 /* We want more than 10% variance on X to trust regression */
@@ -124,6 +135,9 @@ void _starpu_initialize_registered_performance_models(void)
 		snprintf(name, sizeof(name), "STARPU_PERF_MODEL_HOMOGENEOUS_%s", arch);
 		ignore_devid[archtype] = starpu_getenv_number_default(name, def);
 	}
+	if (_starpu_cpu_perf_model_cpukinds())
+		/* CPU device ids are then kinds of cores, which we have to distinguish */
+		ignore_devid[STARPU_CPU_WORKER] = 0;
 }
 
 void _starpu_perfmodel_malloc_per_arch(struct starpu_perfmodel *model, int comb, int nb_impl)
@@ -293,7 +307,7 @@ size_t _starpu_job_get_data_size(struct starpu_perfmodel *model, struct starpu_p
 /*
  * History based model
  */
-static void insert_history_entry(struct starpu_perfmodel_history_entry *entry, struct starpu_perfmodel_history_list **list, struct starpu_perfmodel_history_table **history_ptr)
+static struct starpu_perfmodel_history_table *insert_history_entry(struct starpu_perfmodel_history_entry *entry, struct starpu_perfmodel_history_list **list, struct starpu_perfmodel_history_table **history_ptr)
 {
 	struct starpu_perfmodel_history_list *link;
 	struct starpu_perfmodel_history_table *table;
@@ -307,10 +321,20 @@ static void insert_history_entry(struct starpu_perfmodel_history_entry *entry, s
 	//HASH_FIND_UINT32_T(*history_ptr, &entry->footprint, table);
 	//STARPU_ASSERT(table == NULL);
 
-	_STARPU_MALLOC(table, sizeof(*table));
+	_STARPU_CALLOC(table, 1, sizeof(*table));
 	table->footprint = entry->footprint;
 	table->history_entry = entry;
 	HASH_ADD_UINT32_T(*history_ptr, footprint, table);
+	return table;
+}
+
+/* The model file now contains exactly this entry */
+static void set_disk_entry(struct starpu_perfmodel_history_table *table)
+{
+	table->disk_sum = table->history_entry->sum;
+	table->disk_sum2 = table->history_entry->sum2;
+	table->disk_nsample = table->history_entry->nsample;
+	table->flushed = 0;
 }
 
 #ifndef STARPU_SIMGRID
@@ -624,7 +648,27 @@ static void scan_history_entry(FILE *f, const char *path, struct starpu_perfmode
 	}
 }
 
-static void parse_per_arch_model_file(FILE *f, const char *path, struct starpu_perfmodel_per_arch *per_arch_model, unsigned scan_history, struct starpu_perfmodel *model)
+static struct starpu_perfmodel_regression_model *get_disk_reg_model(struct starpu_perfmodel *model, int comb, unsigned impl)
+{
+	if (!model->state->disk_regression[comb])
+		_STARPU_CALLOC(model->state->disk_regression[comb], STARPU_MAXIMPLEMENTATIONS, sizeof(struct starpu_perfmodel_regression_model));
+	return &model->state->disk_regression[comb][impl];
+}
+
+/* Remember the accumulators of the regression as they are in the model file */
+static void set_disk_reg_model(struct starpu_perfmodel *model, int comb, unsigned impl)
+{
+	struct starpu_perfmodel_regression_model *reg_model = &model->state->per_arch[comb][impl].regression;
+	struct starpu_perfmodel_regression_model *disk_reg_model = get_disk_reg_model(model, comb, impl);
+
+	disk_reg_model->sumlnx = reg_model->sumlnx;
+	disk_reg_model->sumlnx2 = reg_model->sumlnx2;
+	disk_reg_model->sumlny = reg_model->sumlny;
+	disk_reg_model->sumlnxlny = reg_model->sumlnxlny;
+	disk_reg_model->nsample = reg_model->nsample;
+}
+
+static void parse_per_arch_model_file(FILE *f, const char *path, struct starpu_perfmodel_per_arch *per_arch_model, unsigned scan_history, struct starpu_perfmodel *model, int comb, unsigned impl)
 {
 	unsigned nentries;
 	struct starpu_perfmodel_regression_model *reg_model = &per_arch_model->regression;
@@ -635,6 +679,8 @@ static void parse_per_arch_model_file(FILE *f, const char *path, struct starpu_p
 	STARPU_ASSERT_MSG(res == 1, "Incorrect performance model file %s", path);
 
 	scan_reg_model(f, path, reg_model);
+	if (model)
+		set_disk_reg_model(model, comb, impl);
 
 	/* parse entries */
 	unsigned i;
@@ -659,7 +705,7 @@ static void parse_per_arch_model_file(FILE *f, const char *path, struct starpu_p
 		/* TODO: Insert it at the end of the list, to avoid reversing
 		 * the order... But efficiently! We may have a lot of entries */
 		if (scan_history)
-			insert_history_entry(entry, &per_arch_model->list, &per_arch_model->history);
+			set_disk_entry(insert_history_entry(entry, &per_arch_model->list, &per_arch_model->history));
 	}
 
 	if (model && model->type == STARPU_PERFMODEL_INVALID)
@@ -706,7 +752,7 @@ static void parse_arch(FILE *f, const char *path, struct starpu_perfmodel *model
 		{
 			struct starpu_perfmodel_per_arch *per_arch_model = &model->state->per_arch[comb][impl];
 			model->state->per_arch_is_set[comb][impl] = 1;
-			parse_per_arch_model_file(f, path, per_arch_model, scan_history, model);
+			parse_per_arch_model_file(f, path, per_arch_model, scan_history, model, comb, impl);
 		}
 	}
 	else
@@ -717,7 +763,7 @@ static void parse_arch(FILE *f, const char *path, struct starpu_perfmodel *model
 	/* if the number of implementation is greater than STARPU_MAXIMPLEMENTATIONS
 	 * we skip the last implementation */
 	for (i = impl; i < nimpls; i++)
-		parse_per_arch_model_file(f, path, &dummy, 0, NULL);
+		parse_per_arch_model_file(f, path, &dummy, 0, NULL, comb, i);
 }
 
 static void parse_comb(FILE *f, const char *path, struct starpu_perfmodel *model, unsigned scan_history, int comb)
@@ -1142,6 +1188,7 @@ void _starpu_perfmodel_realloc(struct starpu_perfmodel *model, int nb)
 #endif
 	_STARPU_REALLOC(model->state->per_arch, nb*sizeof(struct starpu_perfmodel_per_arch*));
 	_STARPU_REALLOC(model->state->per_arch_is_set, nb*sizeof(int*));
+	_STARPU_REALLOC(model->state->disk_regression, nb*sizeof(struct starpu_perfmodel_regression_model*));
 	_STARPU_REALLOC(model->state->nimpls, nb*sizeof(int));
 	_STARPU_REALLOC(model->state->nimpls_set, nb*sizeof(int));
 	_STARPU_REALLOC(model->state->combs, nb*sizeof(int));
@@ -1149,16 +1196,35 @@ void _starpu_perfmodel_realloc(struct starpu_perfmodel *model, int nb)
 	{
 		model->state->per_arch[i] = NULL;
 		model->state->per_arch_is_set[i] = NULL;
+		model->state->disk_regression[i] = NULL;
 		model->state->nimpls[i] = 0;
 		model->state->nimpls_set[i] = 0;
 	}
 	model->state->ncombs_set = nb;
 }
 
+static void perfmodel_state_init(struct starpu_perfmodel *model)
+{
+	int ncombs;
+
+	_STARPU_MALLOC(model->state, sizeof(struct _starpu_perfmodel_state));
+	STARPU_PTHREAD_RWLOCK_INIT(&model->state->model_rwlock, NULL);
+
+	STARPU_PTHREAD_RWLOCK_RDLOCK(&arch_combs_mutex);
+	model->state->ncombs_set = ncombs = nb_arch_combs;
+	STARPU_PTHREAD_RWLOCK_UNLOCK(&arch_combs_mutex);
+	_STARPU_CALLOC(model->state->per_arch, ncombs, sizeof(struct starpu_perfmodel_per_arch*));
+	_STARPU_CALLOC(model->state->per_arch_is_set, ncombs, sizeof(int*));
+	_STARPU_CALLOC(model->state->disk_regression, ncombs, sizeof(struct starpu_perfmodel_regression_model*));
+	_STARPU_CALLOC(model->state->nimpls, ncombs, sizeof(int));
+	_STARPU_CALLOC(model->state->nimpls_set, ncombs, sizeof(int));
+	_STARPU_MALLOC(model->state->combs, ncombs*sizeof(int));
+	model->state->ncombs = 0;
+}
+
 void starpu_perfmodel_init(struct starpu_perfmodel *model)
 {
 	int already_init;
-	int ncombs;
 
 	STARPU_ASSERT(model);
 
@@ -1181,18 +1247,7 @@ void starpu_perfmodel_init(struct starpu_perfmodel *model)
 	}
 
 	model->path = NULL;
-	_STARPU_MALLOC(model->state, sizeof(struct _starpu_perfmodel_state));
-	STARPU_PTHREAD_RWLOCK_INIT(&model->state->model_rwlock, NULL);
-
-	STARPU_PTHREAD_RWLOCK_RDLOCK(&arch_combs_mutex);
-	model->state->ncombs_set = ncombs = nb_arch_combs;
-	STARPU_PTHREAD_RWLOCK_UNLOCK(&arch_combs_mutex);
-	_STARPU_CALLOC(model->state->per_arch, ncombs, sizeof(struct starpu_perfmodel_per_arch*));
-	_STARPU_CALLOC(model->state->per_arch_is_set, ncombs, sizeof(int*));
-	_STARPU_CALLOC(model->state->nimpls, ncombs, sizeof(int));
-	_STARPU_CALLOC(model->state->nimpls_set, ncombs, sizeof(int));
-	_STARPU_MALLOC(model->state->combs, ncombs*sizeof(int));
-	model->state->ncombs = 0;
+	perfmodel_state_init(model);
 
 	/* add the model to a linked list */
 	struct _starpu_perfmodel *node = _starpu_perfmodel_new();
@@ -1223,7 +1278,197 @@ void starpu_perfmodel_get_model_path_default_location(const char *symbol, char *
 	_starpu_set_default_perf_model_codelet(symbol, _starpu_perfmodel_hostname, path, maxlen);
 }
 
+/* Return the per-arch model of \p model for \p comb and \p impl, adding them
+ * to the model if needed. Must be called with model_rwlock held in write mode. */
+static struct starpu_perfmodel_per_arch *get_per_arch_model(struct starpu_perfmodel *model, int comb, unsigned impl)
+{
+	int c;
+	unsigned found = 0;
+
+	for(c = 0; c < model->state->ncombs; c++)
+	{
+		if(model->state->combs[c] == comb)
+		{
+			found = 1;
+			break;
+		}
+	}
+
+	if(!found)
+	{
+		if (model->state->ncombs + 1 >= model->state->ncombs_set)
+		{
+			// The number of combinations is bigger than the one which was initially allocated, we need to reallocate,
+			// do not only reallocate 1 extra comb, rather reallocate 5 to avoid too frequent calls to _starpu_perfmodel_realloc
+			_starpu_perfmodel_realloc(model, model->state->ncombs_set+5);
+		}
+		model->state->combs[model->state->ncombs++] = comb;
+	}
+
+	if (comb >= model->state->ncombs_set)
+		_starpu_perfmodel_realloc(model, comb+1);
+
+	if(!model->state->per_arch[comb])
+	{
+		_starpu_perfmodel_malloc_per_arch(model, comb, STARPU_MAXIMPLEMENTATIONS);
+		_starpu_perfmodel_malloc_per_arch_is_set(model, comb, STARPU_MAXIMPLEMENTATIONS);
+		model->state->nimpls[comb] = 0;
+	}
+
+	if (model->state->per_arch_is_set[comb][impl] == 0)
+	{
+		// We are adding a new implementation for the given comb and the given impl
+		model->state->nimpls[comb]++;
+		model->state->per_arch_is_set[comb][impl] = 1;
+	}
+
+	return &model->state->per_arch[comb][impl];
+}
+
+static void compute_regression(struct starpu_perfmodel_regression_model *reg_model)
+{
+	unsigned n = reg_model->nsample;
+
+	double num = (n*reg_model->sumlnxlny - reg_model->sumlnx*reg_model->sumlny);
+	double denom = (n*reg_model->sumlnx2 - reg_model->sumlnx*reg_model->sumlnx);
+
+	reg_model->beta = num/denom;
+	reg_model->alpha = exp((reg_model->sumlny - reg_model->beta*reg_model->sumlnx)/n);
+	reg_model->valid = 1;
+}
+
 #ifndef STARPU_SIMGRID
+/* Add to the file entry the samples measured since the entry was last loaded
+ * from or saved to the model file */
+static void merge_history_entry(struct starpu_perfmodel_history_table *elt, struct starpu_perfmodel_history_entry *file_entry)
+{
+	struct starpu_perfmodel_history_entry *entry = elt->history_entry;
+
+	if (elt->flushed)
+		/* We have flushed this entry because of too many errors, overwrite the file entry */
+		return;
+
+	entry->sum = file_entry->sum + (entry->sum - elt->disk_sum);
+	entry->sum2 = file_entry->sum2 + (entry->sum2 - elt->disk_sum2);
+	entry->nsample = file_entry->nsample + (entry->nsample - elt->disk_nsample);
+	if (entry->nsample)
+	{
+		unsigned n = entry->nsample;
+		entry->mean = entry->sum / n;
+		entry->deviation = sqrt((fabs(entry->sum2 - (entry->sum*entry->sum)/n))/n);
+	}
+	if (entry->flops == 0.)
+		entry->flops = file_entry->flops;
+}
+
+/* Same for the regression accumulators */
+static void merge_reg_model(struct starpu_perfmodel *model, int comb, unsigned impl, struct starpu_perfmodel_regression_model *file_reg_model)
+{
+	struct starpu_perfmodel_regression_model *reg_model = &model->state->per_arch[comb][impl].regression;
+	struct starpu_perfmodel_regression_model *disk_reg_model = get_disk_reg_model(model, comb, impl);
+
+	reg_model->sumlnx = file_reg_model->sumlnx + (reg_model->sumlnx - disk_reg_model->sumlnx);
+	reg_model->sumlnx2 = file_reg_model->sumlnx2 + (reg_model->sumlnx2 - disk_reg_model->sumlnx2);
+	reg_model->sumlny = file_reg_model->sumlny + (reg_model->sumlny - disk_reg_model->sumlny);
+	reg_model->sumlnxlny = file_reg_model->sumlnxlny + (reg_model->sumlnxlny - disk_reg_model->sumlnxlny);
+	reg_model->nsample = file_reg_model->nsample + (reg_model->nsample - disk_reg_model->nsample);
+	if (file_reg_model->minx && (reg_model->minx == 0 || file_reg_model->minx < reg_model->minx))
+		reg_model->minx = file_reg_model->minx;
+	if (file_reg_model->maxx > reg_model->maxx)
+		reg_model->maxx = file_reg_model->maxx;
+
+	if (VALID_REGRESSION(reg_model))
+		compute_regression(reg_model);
+}
+
+/* Other processes may have saved samples in the model file since we loaded
+ * it. Read it again and add them to ours, so that saving the model does not
+ * lose them. Must be called with the file locked and model_rwlock held in
+ * write mode. */
+static void merge_model_file(FILE *f, const char *path, struct starpu_perfmodel *model)
+{
+	struct starpu_perfmodel file_model;
+	int i;
+
+	fseek(f, 0, SEEK_END);
+	if (ftell(f) == 0)
+		/* We have just created it */
+		return;
+
+	memset(&file_model, 0, sizeof(file_model));
+	file_model.type = model->type;
+	file_model.symbol = model->symbol;
+	perfmodel_state_init(&file_model);
+	file_model.is_init = 1;
+
+	if (parse_model_file(f, path, &file_model, 1) == 0)
+	{
+		for (i = 0; i < file_model.state->ncombs; i++)
+		{
+			int comb = file_model.state->combs[i];
+			int impl;
+
+			for (impl = 0; impl < file_model.state->nimpls[comb]; impl++)
+			{
+				struct starpu_perfmodel_per_arch *file_per_arch_model = &file_model.state->per_arch[comb][impl];
+				struct starpu_perfmodel_per_arch *per_arch_model = get_per_arch_model(model, comb, impl);
+				struct starpu_perfmodel_history_list *ptr;
+
+				for (ptr = file_per_arch_model->list; ptr; ptr = ptr->next)
+				{
+					struct starpu_perfmodel_history_entry *file_entry = ptr->entry;
+					struct starpu_perfmodel_history_table *elt;
+
+					HASH_FIND_UINT32_T(per_arch_model->history, &file_entry->footprint, elt);
+					if (elt)
+						merge_history_entry(elt, file_entry);
+					else
+					{
+						/* Entry only known by other processes, take it */
+						struct starpu_perfmodel_history_entry *entry;
+						_STARPU_MALLOC(entry, sizeof(*entry));
+						*entry = *file_entry;
+						STARPU_HG_DISABLE_CHECKING(entry->nsample);
+						STARPU_HG_DISABLE_CHECKING(entry->mean);
+						insert_history_entry(entry, &per_arch_model->list, &per_arch_model->history);
+					}
+				}
+
+				merge_reg_model(model, comb, impl, &file_per_arch_model->regression);
+			}
+		}
+	}
+
+	_starpu_deinitialize_performance_model(&file_model);
+	STARPU_PTHREAD_RWLOCK_DESTROY(&file_model.state->model_rwlock);
+	free(file_model.state);
+}
+
+/* The model file now contains exactly our model */
+static void set_disk_model(struct starpu_perfmodel *model)
+{
+	int i;
+
+	for (i = 0; i < model->state->ncombs; i++)
+	{
+		int comb = model->state->combs[i];
+		int impl;
+
+		if (!model->state->per_arch[comb])
+			continue;
+
+		for (impl = 0; impl < model->state->nimpls_set[comb]; impl++)
+		{
+			struct starpu_perfmodel_per_arch *per_arch_model = &model->state->per_arch[comb][impl];
+			struct starpu_perfmodel_history_table *elt, *tmp;
+
+			HASH_ITER(hh, per_arch_model->history, elt, tmp)
+				set_disk_entry(elt);
+			set_disk_reg_model(model, comb, impl);
+		}
+	}
+}
+
 void starpu_save_history_based_model(struct starpu_perfmodel *model)
 {
 	STARPU_ASSERT(model);
@@ -1245,16 +1490,22 @@ void starpu_save_history_based_model(struct starpu_perfmodel *model)
 	model->path = strdup(path);
 	_STARPU_DEBUG("Going to write performance model in file <%s> for model <%s>\n", path, model->symbol);
 
-	/* overwrite existing file, or create it */
+	/* merge with existing file and overwrite it, or create it */
 	FILE *f;
 	f = fopen(path, "a+");
 	STARPU_ASSERT_MSG(f, "Could not save performance model %s\n", path);
 
 	locked = _starpu_fwrlock(f) == 0;
+	STARPU_PTHREAD_RWLOCK_WRLOCK(&model->state->model_rwlock);
+	if (_starpu_get_calibrate_flag() != 2 && model->type != STARPU_MULTIPLE_REGRESSION_BASED)
+		/* Unless the user asked to overwrite the models */
+		merge_model_file(f, path, model);
 	check_model(model);
 	fseek(f, 0, SEEK_SET);
 	_starpu_fftruncate(f, 0);
 	dump_model_file(f, model);
+	set_disk_model(model);
+	STARPU_PTHREAD_RWLOCK_UNLOCK(&model->state->model_rwlock);
 	if (locked)
 		_starpu_fwrunlock(f);
 
@@ -1326,6 +1577,8 @@ void _starpu_deinitialize_performance_model(struct starpu_perfmodel *model)
 				free(model->state->per_arch_is_set[i]);
 				model->state->per_arch_is_set[i] = NULL;
 			}
+			free(model->state->disk_regression[i]);
+			model->state->disk_regression[i] = NULL;
 		}
 		free(model->state->per_arch);
 		model->state->per_arch = NULL;
@@ -1333,6 +1586,9 @@ void _starpu_deinitialize_performance_model(struct starpu_perfmodel *model)
 		free(model->state->per_arch_is_set);
 		model->state->per_arch_is_set = NULL;
 
+		free(model->state->disk_regression);
+		model->state->disk_regression = NULL;
+
 		free(model->state->nimpls);
 		model->state->nimpls = NULL;
 
@@ -1868,46 +2124,11 @@ void _starpu_update_perfmodel_history(struct _starpu_job *j, struct starpu_perfm
 	STARPU_ASSERT_MSG(measured >= 0, "measured=%lf\n", measured);
 	if (model)
 	{
-		int c;
-		unsigned found = 0;
 		int comb = _starpu_perfmodel_create_comb_if_needed(arch);
 
 		STARPU_PTHREAD_RWLOCK_WRLOCK(&model->state->model_rwlock);
 
-		for(c = 0; c < model->state->ncombs; c++)
-		{
-			if(model->state->combs[c] == comb)
-			{
-				found = 1;
-				break;
-			}
-		}
-
-		if(!found)
-		{
-			if (model->state->ncombs + 1 >= model->state->ncombs_set)
-			{
-				// The number of combinations is bigger than the one which was initially allocated, we need to reallocate,
-				// do not only reallocate 1 extra comb, rather reallocate 5 to avoid too frequent calls to _starpu_perfmodel_realloc
-				_starpu_perfmodel_realloc(model, model->state->ncombs_set+5);
-			}
-			model->state->combs[model->state->ncombs++] = comb;
-		}
-
-		if(!model->state->per_arch[comb])
-		{
-			_starpu_perfmodel_malloc_per_arch(model, comb, STARPU_MAXIMPLEMENTATIONS);
-			_starpu_perfmodel_malloc_per_arch_is_set(model, comb, STARPU_MAXIMPLEMENTATIONS);
-			model->state->nimpls[comb] = 0;
-		}
-
-		struct starpu_perfmodel_per_arch *per_arch_model = &model->state->per_arch[comb][impl];
-		if (model->state->per_arch_is_set[comb][impl] == 0)
-		{
-			// We are adding a new implementation for the given comb and the given impl
-			model->state->nimpls[comb]++;
-			model->state->per_arch_is_set[comb][impl] = 1;
-		}
+		struct starpu_perfmodel_per_arch *per_arch_model = get_per_arch_model(model, comb, impl);
 
 		if (model->type == STARPU_HISTORY_BASED || model->type == STARPU_NL_REGRESSION_BASED || model->type == STARPU_REGRESSION_BASED)
 		{
@@ -1973,6 +2194,7 @@ void _starpu_update_perfmodel_history(struct _starpu_job *j, struct starpu_perfm
 						entry->nerror = 0;
 						entry->mean = 0.0;
 						entry->deviation = 0.0;
+						elt->flushed = 1;
 					}
 				}
 				else
@@ -2024,16 +2246,7 @@ void _starpu_update_perfmodel_history(struct _starpu_job *j, struct starpu_perfm
 			reg_model->nsample++;
 
 			if (VALID_REGRESSION(reg_model))
-			{
-				unsigned n = reg_model->nsample;
-
-				double num = (n*reg_model->sumlnxlny - reg_model->sumlnx*reg_model->sumlny);
-				double denom = (n*reg_model->sumlnx2 - reg_model->sumlnx*reg_model->sumlnx);
-
-				reg_model->beta = num/denom;
-				reg_model->alpha = exp((reg_model->sumlny - reg_model->beta*reg_model->sumlnx)/n);
-				reg_model->valid = 1;
-			}
+				compute_regression(reg_model);
 		}
 
 		if (model->type == STARPU_MULTIPLE_REGRESSION_BASED)
@@ -2168,7 +2381,7 @@ static struct starpu_perfmodel_per_arch *_starpu_perfmodel_get_model_per_devices
 		if (arg_type == STARPU_CPU_WORKER)
 		{
 			STARPU_ASSERT_MSG(is_cpu_set == 0, "STARPU_CPU_WORKER can only be specified once\n");
-			STARPU_ASSERT_MSG(devid==0, "STARPU_CPU_WORKER must be followed by a value 0 for the device id");
+			STARPU_ASSERT_MSG(devid>=0, "STARPU_CPU_WORKER must be followed by the kind of CPU core for the device id, i.e. 0 unless there are several kinds of CPU cores");
 			is_cpu_set = 1;
 		}
 		else
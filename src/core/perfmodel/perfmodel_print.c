@@ -195,13 +195,20 @@ int starpu_perfmodel_print_all(struct starpu_perfmodel *model, char *arch, char
 			perf_arch.ndevices = 1;
 			_STARPU_MALLOC(perf_arch.devices, sizeof(struct starpu_perfmodel_device));
 			perf_arch.devices[0].type = STARPU_CPU_WORKER;
-			perf_arch.devices[0].devid = 0;
 			perf_arch.devices[0].ncores = 1;
-			int comb = starpu_perfmodel_arch_comb_get(perf_arch.ndevices, perf_arch.devices);
-			STARPU_ASSERT(comb != -1);
-			int nimpls = model->state->nimpls[comb];
-			for (implid = 0; implid < nimpls; implid++)
-				starpu_perfmodel_print(model, &perf_arch,implid, parameter, footprint, output); /* Display all codelets on cpu */
+			int comb;
+			/* There is one CPU arch per kind of core */
+			for(comb = 0; comb < starpu_perfmodel_get_narch_combs(); comb++)
+			{
+				struct starpu_perfmodel_arch *arch_comb = starpu_perfmodel_arch_comb_fetch(comb);
+				if(arch_comb->ndevices == 1 && arch_comb->devices[0].type == STARPU_CPU_WORKER && arch_comb->devices[0].ncores == 1)
+				{
+					perf_arch.devices[0].devid = arch_comb->devices[0].devid;
+					int nimpls = model->state->nimpls[comb];
+					for (implid = 0; implid < nimpls; implid++)
+						starpu_perfmodel_print(model, &perf_arch,implid, parameter, footprint, output); /* Display all codelets on cpu */
+				}
+			}
 			free(perf_arch.devices);
 			return 0;
 		}
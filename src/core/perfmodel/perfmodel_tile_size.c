@@ -0,0 +1,218 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Selection of the tile size of an algorithm, from the regression
+ * performance models of its codelets.
+ *
+ * For each candidate tile size, the tasks of the algorithm are list-scheduled
+ * on the workers, each of them going to the worker which would finish it
+ * first. Since tasks counts grow quickly when tiles get small, tasks of the
+ * same kind are scheduled by batches, so that the simulation remains cheap.
+ * The result is bounded by the critical path when the application provides
+ * it, and every task pays a fixed runtime overhead, which is what makes small
+ * tiles expensive.
+ */
+
+#include <math.h>
+#include <starpu.h>
+#include <common/config.h>
+#include <common/utils.h>
+#include <core/perfmodel/perfmodel.h>
+#include <core/task.h>
+#include <core/workers.h>
+
+/* Number of batches per worker for each kind of task */
+#define TILE_SIZE_NBATCHES 32
+
+/* Expected duration of a task of the given size, NAN if the model is not
+ * calibrated for it. Also tell whether the model was calibrated with sizes
+ * around this one */
+static double tile_size_expected_perf(struct starpu_perfmodel *model, struct starpu_perfmodel_arch *arch, unsigned nimpl, size_t size, int *in_range)
+{
+	struct starpu_perfmodel_regression_model *regmodel;
+	double exp = NAN;
+	int comb;
+
+	comb = starpu_perfmodel_arch_comb_get(arch->ndevices, arch->devices);
+	if (comb == -1)
+		return NAN;
+
+	STARPU_PTHREAD_RWLOCK_RDLOCK(&model->state->model_rwlock);
+	if (comb < model->state->ncombs_set && model->state->per_arch[comb])
+	{
+		regmodel = &model->state->per_arch[comb][nimpl].regression;
+		/* Same range as _starpu_regression_based_job_expected_perf */
+		if (size >= regmodel->minx * 0.9 && size <= regmodel->maxx * 1.1)
+		{
+			*in_range = 1;
+			if (model->type == STARPU_NL_REGRESSION_BASED && regmodel->nl_valid)
+				exp = regmodel->a*pow((double)size, regmodel->b) + regmodel->c;
+			else if (regmodel->valid)
+				exp = regmodel->alpha*pow((double)size, regmodel->beta);
+		}
+	}
+	STARPU_PTHREAD_RWLOCK_UNLOCK(&model->state->model_rwlock);
+
+	return exp;
+}
+
+/* Predicted makespan for the given tile size, NAN if it cannot be predicted,
+ * in which case covered tells whether the models already have measurements
+ * around the sizes of its tasks */
+static double tile_size_predict(const struct starpu_tile_size_kernel *kernels, unsigned nkernels, unsigned tile_size, double overhead, int *covered)
+{
+	unsigned nworkers = starpu_worker_get_count();
+	double (*durations)[STARPU_NMAXWORKERS];
+	double ends[STARPU_NMAXWORKERS];
+	double critical = 0., makespan = NAN;
+	unsigned k, w, impl;
+
+	_STARPU_MALLOC(durations, nkernels * sizeof(*durations));
+	*covered = 1;
+
+	for (k = 0; k < nkernels; k++)
+	{
+		struct starpu_codelet *cl = kernels[k].cl;
+		size_t size = kernels[k].size(tile_size, kernels[k].arg);
+		double best = INFINITY;
+
+		for (w = 0; w < nworkers; w++)
+		{
+			struct starpu_perfmodel_arch *arch = starpu_worker_get_perf_archtype(w, STARPU_NMAX_SCHED_CTXS);
+			int in_range = 0;
+
+			durations[k][w] = INFINITY;
+			if (!(cl->where & STARPU_WORKER_TO_MASK(starpu_worker_get_type(w))))
+				continue;
+
+			for (impl = 0; impl < STARPU_MAXIMPLEMENTATIONS; impl++)
+			{
+				double exp = tile_size_expected_perf(cl->model, arch, impl, size, &in_range);
+				if (!isnan(exp) && exp < durations[k][w])
+					durations[k][w] = exp;
+			}
+			if (isinf(durations[k][w]))
+			{
+				/* This worker could run it, but we do not know how fast */
+				*covered = in_range;
+				goto out;
+			}
+			durations[k][w] += overhead;
+			if (durations[k][w] < best)
+				best = durations[k][w];
+		}
+		if (isinf(best))
+			/* Nobody can run it */
+			goto out;
+
+		if (kernels[k].ncritical)
+			critical += kernels[k].ncritical(tile_size, kernels[k].arg) * best;
+	}
+
+	for (w = 0; w < nworkers; w++)
+		ends[w] = 0.;
+
+	for (k = 0; k < nkernels; k++)
+	{
+		double ntasks = kernels[k].ntasks(tile_size, kernels[k].arg);
+		double batch = ntasks / (TILE_SIZE_NBATCHES * nworkers);
+
+		if (batch < 1.)
+			batch = 1.;
+
+		while (ntasks > 0.)
+		{
+			double n = STARPU_MIN(batch, ntasks);
+			double best_end = INFINITY;
+			unsigned best_worker = 0;
+
+			for (w = 0; w < nworkers; w++)
+			{
+				double end = ends[w] + n * durations[k][w];
+				if (end < best_end)
+				{
+					best_end = end;
+					best_worker = w;
+				}
+			}
+			ends[best_worker] = best_end;
+			ntasks -= n;
+		}
+	}
+
+	makespan = critical;
+	for (w = 0; w < nworkers; w++)
+		if (ends[w] > makespan)
+			makespan = ends[w];
+
+out:
+	free(durations);
+	return makespan;
+}
+
+unsigned starpu_perfmodel_select_tile_size(const struct starpu_tile_size_kernel *kernels, unsigned nkernels, const unsigned *tile_sizes, unsigned ntile_sizes, double *makespan)
+{
+	double overhead = starpu_getenv_float_default("STARPU_TILE_SIZE_TASK_OVERHEAD", 2.);
+	double best_makespan = INFINITY;
+	unsigned best = 0;
+	int explore = -1;
+	unsigned k, i;
+
+	STARPU_ASSERT_MSG(ntile_sizes > 0, "at least one tile size must be proposed");
+	for (k = 0; k < nkernels; k++)
+	{
+		struct starpu_codelet *cl = kernels[k].cl;
+
+		STARPU_ASSERT_MSG(cl->model && (cl->model->type == STARPU_REGRESSION_BASED || cl->model->type == STARPU_NL_REGRESSION_BASED), "tile size selection needs regression-based performance models");
+		STARPU_ASSERT_MSG(kernels[k].ntasks && kernels[k].size, "tile size selection needs the number of tasks and their size");
+		_starpu_codelet_check_deprecated_fields(cl);
+		_starpu_init_and_load_perfmodel(cl->model);
+	}
+
+	for (i = 0; i < ntile_sizes; i++)
+	{
+		int covered;
+		double predicted = tile_size_predict(kernels, nkernels, tile_sizes[i], overhead, &covered);
+
+		_STARPU_DEBUG("tile size %u: predicted makespan %f us\n", tile_sizes[i], predicted);
+		if (isnan(predicted))
+		{
+			/* Prefer exploring sizes which were never measured, so
+			 * that the regressions get a range of sizes */
+			if (explore == -1 || !covered)
+				explore = i;
+			if (!covered)
+				break;
+		}
+		else if (predicted < best_makespan)
+		{
+			best_makespan = predicted;
+			best = i;
+		}
+	}
+
+	if (explore != -1)
+	{
+		/* Run with this one, to calibrate the models for it */
+		best = explore;
+		best_makespan = NAN;
+	}
+
+	if (makespan)
+		*makespan = best_makespan;
+	return tile_sizes[best];
+}
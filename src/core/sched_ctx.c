@@ -1491,7 +1491,10 @@ int _starpu_wait_for_all_tasks_of_sched_ctx(unsigned sched_ctx_id)
 
 	STARPU_ASSERT_MSG(_starpu_worker_may_perform_blocking_calls(), "starpu_task_wait_for_all must not be called from a task or callback");
 
+	int help = _starpu_main_thread_help_start(sched_ctx_id);
 	_starpu_barrier_counter_wait_for_empty_counter(&sched_ctx->tasks_barrier);
+	if (help)
+		_starpu_main_thread_help_end();
 	return 0;
 }
 
@@ -2171,6 +2174,58 @@ unsigned starpu_sched_ctx_get_priority(int workerid, unsigned sched_ctx_id)
 	return _starpu_sched_ctx_elt_get_priority(worker->sched_ctx_list, sched_ctx_id);
 }
 
+void starpu_sched_ctx_share_workers(unsigned *sched_ctx_ids, unsigned nsched_ctxs, unsigned max_lent)
+{
+	int *workerids[STARPU_NMAX_SCHED_CTXS];
+	unsigned nworkers[STARPU_NMAX_SCHED_CTXS];
+	unsigned i, j;
+
+	STARPU_ASSERT(nsched_ctxs <= STARPU_NMAX_SCHED_CTXS);
+
+	/* Get the workers of all contexts first, since we will add to
+	 * each context the workers borrowed from the others */
+	for (i = 0; i < nsched_ctxs; i++)
+		nworkers[i] = starpu_sched_ctx_get_workers_list(sched_ctx_ids[i], &workerids[i]);
+
+	for (i = 0; i < nsched_ctxs; i++)
+	{
+		unsigned nlent = STARPU_MIN(nworkers[i], max_lent);
+		/* Lend the last workers of the list, the list being sorted
+		 * according to the machine hierarchy, this keeps the workers
+		 * left to the context close to each other */
+		int *lent = workerids[i] + nworkers[i] - nlent;
+
+		if (!nlent)
+			continue;
+
+		/* Make the lent workers prefer their own context */
+		starpu_sched_ctx_set_priority(lent, nlent, sched_ctx_ids[i], 1);
+
+		for (j = 0; j < nsched_ctxs; j++)
+		{
+			int borrowed[STARPU_NMAXWORKERS];
+			unsigned nborrowed = 0;
+			unsigned w;
+
+			if (j == i)
+				continue;
+
+			for (w = 0; w < nlent; w++)
+				if (!starpu_sched_ctx_contains_worker(lent[w], sched_ctx_ids[j]))
+					borrowed[nborrowed++] = lent[w];
+
+			if (!nborrowed)
+				continue;
+
+			starpu_sched_ctx_add_workers(borrowed, nborrowed, sched_ctx_ids[j]);
+			starpu_sched_ctx_set_priority(borrowed, nborrowed, sched_ctx_ids[j], 0);
+		}
+	}
+
+	for (i = 0; i < nsched_ctxs; i++)
+		free(workerids[i]);
+}
+
 unsigned _starpu_sched_ctx_last_worker_awake(struct _starpu_worker *worker)
 {
 	/* The worker being checked must have its status set to sleeping during
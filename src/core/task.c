@@ -25,6 +25,7 @@
 #include <core/jobs.h>
 #include <core/task.h>
 #include <core/task_bundle.h>
+#include <core/task_fusion.h>
 #include <core/dependencies/data_concurrency.h>
 #include <common/config.h>
 #include <common/utils.h>
@@ -40,6 +41,7 @@
 #include <time.h>
 #include <signal.h>
 #include <core/simgrid.h>
+#include <util/starpu_data_cpy.h>
 #ifdef STARPU_HAVE_WINDOWS
 #include <windows.h>
 #endif
@@ -66,6 +68,7 @@ static int __c_peak_submitted;
 static int __c_peak_ready;
 static int __c_total_executed;
 static int __c_cumul_execution_time;
+static int __c_cumul_callback_time;
 
 /* - */
 
@@ -113,6 +116,7 @@ static void per_codelet_sample_updater(struct starpu_perf_counter_sample *sample
 	_starpu_perf_counter_sample_set_int64_value(sample, __c_peak_ready, cl->perf_counter_values->task.peak_ready);
 	_starpu_perf_counter_sample_set_int64_value(sample, __c_total_executed, cl->perf_counter_values->task.total_executed);
 	_starpu_perf_counter_sample_set_double_value(sample, __c_cumul_execution_time, cl->perf_counter_values->task.cumul_execution_time);
+	_starpu_perf_counter_sample_set_double_value(sample, __c_cumul_callback_time, cl->perf_counter_values->task.cumul_callback_time);
 }
 
 void _starpu__task_c__register_counters(void)
@@ -141,6 +145,7 @@ void _starpu__task_c__register_counters(void)
 		__STARPU_PERF_COUNTER_REG("starpu.task", scope, c_peak_ready, int64, "maximum simultaneous number of codelet's task instances ready and not yet executing (since enabled)");
 		__STARPU_PERF_COUNTER_REG("starpu.task", scope, c_total_executed, int64, "number of codelet's task instances executed using this codelet (since enabled)");
 		__STARPU_PERF_COUNTER_REG("starpu.task", scope, c_cumul_execution_time, double, "cumulated execution time of codelet's task instances (since enabled)");
+		__STARPU_PERF_COUNTER_REG("starpu.task", scope, c_cumul_callback_time, double, "cumulated execution time of the callbacks of codelet's task instances (microseconds, since enabled)");
 
 		_starpu_perf_counter_register_updater(scope, per_codelet_sample_updater);
 	}
@@ -272,6 +277,7 @@ void _starpu_task_init(void)
 	limit_max_submitted_tasks = starpu_getenv_number("STARPU_LIMIT_MAX_SUBMITTED_TASKS");
 	watchdog_crash = starpu_getenv_number_default("STARPU_WATCHDOG_CRASH", 0);
 	watchdog_delay = starpu_getenv_number_default("STARPU_WATCHDOG_DELAY", 0);
+	_starpu_task_fusion_init();
 #ifdef STARPU_NOSV
 	_starpu_spin_init(&nosv_task_types_lock);
 #endif
@@ -298,6 +304,7 @@ void _starpu_task_deinit(void)
 	_starpu_spin_destroy(&nosv_task_types_lock);
 #endif
 	STARPU_PTHREAD_KEY_DELETE(current_task_key);
+	_starpu_task_fusion_deinit();
 }
 
 #ifdef STARPU_NOSV
@@ -634,6 +641,10 @@ int _starpu_submit_job(struct _starpu_job *j, int nodeps)
 	/* notify bound computation of a new task */
 	_starpu_bound_record(j);
 
+	/* A regenerated or resubmitted task will start at another time, the
+	 * scheduler will predict it again if it can */
+	task->predicted_start = NAN;
+
 #ifdef STARPU_NOSV
 	if (!j->nosv_task_type)
 	{
@@ -1115,12 +1126,17 @@ int _starpu_task_submit(struct starpu_task *task, int nodeps)
 
 	if (task->cl && !continuation)
 	{
+		if (STARPU_UNLIKELY(_starpu_data_cow_npending))
+			/* Some data copies were deferred */
+			_starpu_data_cow_task_submit(task);
 		_starpu_job_set_ordered_buffers(j);
 	}
 
 	ret = _starpu_task_submit_head(task);
 	if (ret)
 	{
+		if (STARPU_UNLIKELY(j->cow_handles))
+			_starpu_data_cow_task_terminated(j);
 		_STARPU_TRACE_TASK_SUBMIT_END();
 		return ret;
 	}
@@ -1228,6 +1244,8 @@ int starpu_task_submit(struct starpu_task *task)
 	unsigned long long timestamp = 1000000000ULL*tp.tv_sec + tp.tv_nsec;
 	_STARPU_DEBUG("{%llu} [%s(%p)] Submission | id %lu\n", timestamp, starpu_task_get_name(task), task, starpu_task_get_job_id(task));
 #endif
+	if (STARPU_UNLIKELY(_starpu_task_fusion_max) && _starpu_task_fusion_defer(task))
+		return 0;
 	return _starpu_task_submit(task, 0);
 }
 
@@ -1249,6 +1267,7 @@ int starpu_task_submit_to_ctx(struct starpu_task *task, unsigned sched_ctx_id)
  * skipping dependencies completely (when it knows what it is doing).  */
 int starpu_task_submit_nodeps(struct starpu_task *task)
 {
+	_STARPU_TASK_FUSION_FLUSH();
 	return _starpu_task_submit(task, 1);
 }
 
@@ -1381,6 +1400,7 @@ int _starpu_task_wait_for_all_in_nested_ctx_and_return_nb_waited_tasks(unsigned
  */
 int _starpu_task_wait_for_all_and_return_nb_waited_tasks(void)
 {
+	_STARPU_TASK_FUSION_FLUSH();
 	unsigned nsched_ctxs = _starpu_get_nsched_ctxs();
 	unsigned sched_ctx_id = nsched_ctxs == 1 ? 0 : starpu_sched_ctx_get_context();
 
@@ -1448,6 +1468,7 @@ int _starpu_task_wait_for_all_in_ctx_and_return_nb_waited_tasks(unsigned sched_c
 
 int starpu_task_wait_for_all_in_ctx(unsigned sched_ctx)
 {
+	_STARPU_TASK_FUSION_FLUSH();
 	_starpu_task_wait_for_all_in_ctx_and_return_nb_waited_tasks(sched_ctx);
 	if (!_starpu_perf_counter_paused())
 		_starpu_perf_counter_update_global_sample();
@@ -1461,6 +1482,7 @@ int starpu_task_wait_for_all_in_ctx(unsigned sched_ctx)
  */
 int starpu_task_wait_for_n_submitted(unsigned n)
 {
+	_STARPU_TASK_FUSION_FLUSH();
 	unsigned nsched_ctxs = _starpu_get_nsched_ctxs();
 	unsigned sched_ctx_id = nsched_ctxs == 1 ? 0 : starpu_sched_ctx_get_context();
 
@@ -1499,6 +1521,7 @@ int starpu_task_wait_for_n_submitted(unsigned n)
 
 int starpu_task_wait_for_n_submitted_in_ctx(unsigned sched_ctx, unsigned n)
 {
+	_STARPU_TASK_FUSION_FLUSH();
 	_starpu_wait_for_n_submitted_tasks_of_sched_ctx(sched_ctx, n);
 
 	if (!_starpu_perf_counter_paused())
@@ -1511,6 +1534,7 @@ int starpu_task_wait_for_n_submitted_in_ctx(unsigned sched_ctx, unsigned n)
  */
 int starpu_task_wait_for_no_ready(void)
 {
+	_STARPU_TASK_FUSION_FLUSH();
 	STARPU_ASSERT_MSG(_starpu_worker_may_perform_blocking_calls(), "starpu_task_wait_for_no_ready must not be called from a task or callback");
 
 	struct _starpu_machine_config *config = _starpu_get_machine_config();
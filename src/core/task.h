@@ -71,6 +71,9 @@ static inline struct _starpu_job *_starpu_get_job_associated_to_task(struct star
 	return _starpu_get_job_associated_to_task_slow(task, job);
 }
 
+/** Submits the task, without trying to merge it with other tasks */
+int _starpu_task_submit(struct starpu_task *task, int nodeps);
+
 /** Submits starpu internal tasks to the initial context */
 int _starpu_task_submit_internally(struct starpu_task *task);
 
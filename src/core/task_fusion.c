@@ -0,0 +1,505 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Fusion of chains of elementwise tasks.
+ *
+ * When STARPU_TASK_FUSION is set, the submission of tasks whose codelet has
+ * the STARPU_CODELET_FUSABLE flag is deferred, as long as the next submitted
+ * tasks are fusable too and work on some of the same vectors. Such a task
+ * then only depends on the previous tasks of the chain, and the chain only
+ * has one consumer for its data: the next task of the chain. Any other task
+ * submission or synchronization submits the chain as one task, which runs
+ * the CPU implementations of the tasks back to back on blocks of the vectors
+ * small enough to stay in the cache, instead of going through the whole
+ * vectors for each of them. Only codelets which only have CPU
+ * implementations are merged, so that no task loses its other
+ * implementations. A flusher thread also submits the chain when nothing was
+ * appended to it for FUSION_IDLE_DELAY, in case the application waits for it
+ * in a way we do not notice, e.g. for a callback of the chain. This is not
+ * done by idle workers, since submitting may block on submission throttling.
+ *
+ * Chains are taken out of fusion_mutex and submitted without holding it.
+ * Each of them gets a ticket, and they are submitted in the ticket order.
+ * Before submitting another task, a thread waits for the chains being
+ * submitted, so that the data dependencies still follow the submission
+ * order.
+ */
+
+#include <starpu.h>
+#include <common/config.h>
+#include <common/utils.h>
+#include <core/jobs.h>
+#include <core/task.h>
+#include <core/task_fusion.h>
+#include <core/workers.h>
+
+/* Amount of data processed by all the tasks of a chain in a row */
+#define FUSION_BLOCK_SIZE (256*1024)
+/* Time after which the flusher thread submits a chain which stopped growing (us) */
+#define FUSION_IDLE_DELAY 100.
+
+int _starpu_task_fusion_max;
+
+struct fused_task
+{
+	struct starpu_task *task;
+	/* Index of the buffers of the task among the buffers of the fused task */
+	unsigned buffers[STARPU_NMAXBUFS];
+};
+
+struct fusion
+{
+	unsigned ntasks;
+	struct fused_task *tasks;
+	unsigned nbuffers;
+	starpu_data_handle_t handles[STARPU_NMAXBUFS];
+	enum starpu_data_access_mode modes[STARPU_NMAXBUFS];
+	size_t nx;
+	unsigned sched_ctx;
+	int priority;
+};
+
+static starpu_pthread_mutex_t fusion_mutex = STARPU_PTHREAD_MUTEX_INITIALIZER;
+static starpu_pthread_cond_t fusion_cond = STARPU_PTHREAD_COND_INITIALIZER;
+static struct fusion *pending;
+/* Date of the last task appended to the pending chain */
+static double last_append;
+/* Tickets of the chains being submitted: from flush_done to flush_ticket-1 */
+static unsigned long flush_ticket, flush_done;
+/* Set in the threads submitting a chain, which must neither flush again nor
+ * wait for themselves */
+static starpu_pthread_key_t submitting_key;
+/* Submits the chains which stopped growing, signaled on new chains */
+static starpu_pthread_t flusher_thread;
+static starpu_pthread_cond_t flusher_cond = STARPU_PTHREAD_COND_INITIALIZER;
+static int flusher_stop;
+
+static void fused_cpu_func(void *descr[], void *arg);
+
+static struct starpu_codelet fused_cl =
+{
+	.where = STARPU_CPU,
+	.cpu_funcs = {fused_cpu_func},
+	.nbuffers = STARPU_VARIABLE_NBUFFERS,
+	.name = "fused",
+};
+
+static void *flusher_func(void *arg);
+
+void _starpu_task_fusion_init(void)
+{
+	_starpu_task_fusion_max = starpu_getenv_number_default("STARPU_TASK_FUSION", 0);
+	if (_starpu_task_fusion_max == 1)
+		_starpu_task_fusion_max = 0;
+	STARPU_PTHREAD_KEY_CREATE(&submitting_key, NULL);
+	if (_starpu_task_fusion_max)
+	{
+		flusher_stop = 0;
+		STARPU_PTHREAD_CREATE(&flusher_thread, NULL, flusher_func, NULL);
+	}
+}
+
+void _starpu_task_fusion_deinit(void)
+{
+	if (_starpu_task_fusion_max)
+	{
+		STARPU_PTHREAD_MUTEX_LOCK(&fusion_mutex);
+		flusher_stop = 1;
+		STARPU_PTHREAD_COND_SIGNAL(&flusher_cond);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&fusion_mutex);
+		STARPU_PTHREAD_JOIN(flusher_thread, NULL);
+	}
+	STARPU_PTHREAD_KEY_DELETE(submitting_key);
+}
+
+static void fused_cpu_func(void *descr[], void *arg)
+{
+	struct fusion *fusion = arg;
+	struct starpu_vector_interface blocks[STARPU_NMAXBUFS];
+	void *block_descr[STARPU_NMAXBUFS];
+	size_t elemsize = 0, block, start;
+	unsigned i, t;
+
+	for (i = 0; i < fusion->nbuffers; i++)
+		elemsize += STARPU_VECTOR_GET_ELEMSIZE(descr[i]);
+	block = FUSION_BLOCK_SIZE / elemsize;
+	if (block == 0)
+		block = 1;
+
+	for (start = 0; start < fusion->nx; start += block)
+	{
+		size_t n = STARPU_MIN(block, fusion->nx - start);
+
+		for (i = 0; i < fusion->nbuffers; i++)
+		{
+			struct starpu_vector_interface *vector = descr[i];
+			size_t offset = start * vector->elemsize;
+
+			blocks[i] = *vector;
+			if (blocks[i].ptr)
+				blocks[i].ptr += offset;
+			blocks[i].offset += offset;
+			blocks[i].nx = n;
+			blocks[i].allocsize = n * vector->elemsize;
+		}
+
+		for (t = 0; t < fusion->ntasks; t++)
+		{
+			struct starpu_task *task = fusion->tasks[t].task;
+			unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+
+			for (i = 0; i < nbuffers; i++)
+				block_descr[i] = &blocks[fusion->tasks[t].buffers[i]];
+			task->cl->cpu_funcs[0](block_descr, task->cl_arg);
+		}
+	}
+}
+
+static void fused_callback(void *arg)
+{
+	struct fusion *fusion = arg;
+	unsigned t;
+
+	for (t = 0; t < fusion->ntasks; t++)
+	{
+		struct starpu_task *task = fusion->tasks[t].task;
+		if (task->callback_func)
+			task->callback_func(task->callback_arg);
+		else if (task->cl->callback_func)
+			task->cl->callback_func(task->callback_arg);
+		if (task->destroy)
+			_starpu_task_destroy(task);
+	}
+	free(fusion->tasks);
+	free(fusion);
+}
+
+static unsigned fusion_buffer(struct fusion *fusion, starpu_data_handle_t handle)
+{
+	unsigned i;
+
+	for (i = 0; i < fusion->nbuffers; i++)
+		if (fusion->handles[i] == handle)
+			break;
+	return i;
+}
+
+static int task_is_fusable(struct starpu_task *task)
+{
+	struct starpu_codelet *cl = task->cl;
+	unsigned nbuffers, i;
+
+	if (!cl || !(cl->flags & STARPU_CODELET_FUSABLE) || !cl->cpu_funcs[0])
+		return 0;
+	/* The fused task only runs the CPU implementations */
+	_starpu_codelet_check_deprecated_fields(cl);
+	if (cl->where != STARPU_CPU)
+		return 0;
+	if (task->where != -1 && !(task->where & STARPU_CPU))
+		return 0;
+	/* Nobody must be able to wait for the task or depend on it explicitly */
+	if (!task->detach || task->synchronous || task->use_tag || task->regenerate
+	    || task->bundle || task->transaction || task->starpu_private)
+		return 0;
+	if (!task->sequential_consistency || task->handles_sequential_consistency
+	    || task->execute_on_a_specific_worker || task->workerids_len)
+		return 0;
+	if (task->prologue_callback_func || task->prologue_callback_pop_func
+	    || task->epilogue_callback_func || task->soon_callback_func)
+		return 0;
+
+	nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+	if (nbuffers == 0)
+		return 0;
+	for (i = 0; i < nbuffers; i++)
+	{
+		starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, i);
+		enum starpu_data_access_mode mode = STARPU_TASK_GET_MODE(task, i);
+
+		if (starpu_data_get_interface_id(handle) != STARPU_VECTOR_INTERFACE_ID)
+			return 0;
+		if (!(mode & STARPU_RW) || (mode & ~STARPU_RW))
+			return 0;
+		if (starpu_vector_get_nx(handle) != starpu_vector_get_nx(STARPU_TASK_GET_HANDLE(task, 0)))
+			return 0;
+	}
+	return 1;
+}
+
+/* Whether a CPU worker of the context can run the task, since once deferred
+ * the task cannot report a submission error any more */
+static int cpu_worker_can_execute(struct starpu_task *task, unsigned sched_ctx)
+{
+	struct starpu_worker_collection *workers = starpu_sched_ctx_get_worker_collection(sched_ctx);
+	struct starpu_sched_ctx_iterator it;
+
+	workers->init_iterator(workers, &it);
+	while (workers->has_next(workers, &it))
+	{
+		unsigned worker = workers->get_next(workers, &it);
+		if (starpu_worker_get_type(worker) == STARPU_CPU_WORKER
+		    && starpu_worker_can_execute_task(worker, task, 0))
+			return 1;
+	}
+	return 0;
+}
+
+/* Whether the task can be appended to the chain */
+static int fusion_accepts(struct fusion *fusion, struct starpu_task *task)
+{
+	unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+	unsigned nnew = 0, shared = 0, i;
+
+	if (fusion->ntasks >= (unsigned) _starpu_task_fusion_max)
+		return 0;
+	if (task->sched_ctx != fusion->sched_ctx)
+		return 0;
+	if (starpu_vector_get_nx(STARPU_TASK_GET_HANDLE(task, 0)) != fusion->nx)
+		return 0;
+
+	for (i = 0; i < nbuffers; i++)
+	{
+		if (fusion_buffer(fusion, STARPU_TASK_GET_HANDLE(task, i)) < fusion->nbuffers)
+			shared = 1;
+		else
+			nnew++;
+	}
+	return shared && fusion->nbuffers + nnew <= STARPU_NMAXBUFS;
+}
+
+static void fusion_append(struct fusion *fusion, struct starpu_task *task)
+{
+	unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+	struct fused_task *fused;
+	unsigned i;
+
+	_STARPU_REALLOC(fusion->tasks, (fusion->ntasks + 1) * sizeof(*fusion->tasks));
+	fused = &fusion->tasks[fusion->ntasks++];
+	fused->task = task;
+
+	for (i = 0; i < nbuffers; i++)
+	{
+		starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, i);
+		enum starpu_data_access_mode mode = STARPU_TASK_GET_MODE(task, i);
+		unsigned buffer = fusion_buffer(fusion, handle);
+
+		if (buffer == fusion->nbuffers)
+		{
+			fusion->handles[buffer] = handle;
+			fusion->modes[buffer] = mode;
+			fusion->nbuffers++;
+		}
+		else
+			/* A buffer first written by the chain is then only
+			 * read from what the chain wrote */
+			fusion->modes[buffer] |= mode & STARPU_W;
+		fused->buffers[i] = buffer;
+	}
+
+	if (task->priority > fusion->priority)
+		fusion->priority = task->priority;
+}
+
+static int is_submitting(void)
+{
+	return STARPU_PTHREAD_GETSPECIFIC(submitting_key) != NULL;
+}
+
+/* Take the pending chain out, fusion_mutex must be held */
+static struct fusion *fusion_take(unsigned long *ticket)
+{
+	struct fusion *fusion = pending;
+
+	pending = NULL;
+	*ticket = flush_ticket++;
+	return fusion;
+}
+
+/* Wait for the chains taken before TICKET to be submitted, fusion_mutex must
+ * be held */
+static void fusion_wait(unsigned long ticket)
+{
+	while (flush_done != ticket)
+		STARPU_PTHREAD_COND_WAIT(&fusion_cond, &fusion_mutex);
+}
+
+/* Submit the chain taken with TICKET, fusion_mutex must not be held */
+static void fusion_submit(struct fusion *fusion, unsigned long ticket)
+{
+	struct starpu_task *task;
+	unsigned i;
+	int ret;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&fusion_mutex);
+	fusion_wait(ticket);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&fusion_mutex);
+
+	STARPU_PTHREAD_SETSPECIFIC(submitting_key, (void*) 1);
+	if (fusion->ntasks > 1)
+	{
+		task = starpu_task_create();
+		task->cl = &fused_cl;
+		task->nbuffers = fusion->nbuffers;
+		for (i = 0; i < fusion->nbuffers; i++)
+		{
+			task->handles[i] = fusion->handles[i];
+			task->modes[i] = fusion->modes[i];
+		}
+		task->cl_arg = fusion;
+		task->callback_func = fused_callback;
+		task->callback_arg = fusion;
+		task->sched_ctx = fusion->sched_ctx;
+		task->priority = fusion->priority;
+		task->name = fusion->tasks[0].task->name;
+
+		ret = _starpu_task_submit(task, 0);
+		if (ret == 0)
+			fusion = NULL;
+		else
+		{
+			/* Try the tasks one by one */
+			_STARPU_DEBUG("fused task submission failed (%d), submitting the tasks separately\n", ret);
+			task->destroy = 0;
+			starpu_task_destroy(task);
+		}
+	}
+	if (fusion)
+	{
+		/* Nothing to merge with, or the merged task could not be submitted */
+		for (i = 0; i < fusion->ntasks; i++)
+		{
+			ret = _starpu_task_submit(fusion->tasks[i].task, 0);
+			STARPU_ASSERT_MSG(ret == 0, "deferred task submission failed: %d", ret);
+		}
+		free(fusion->tasks);
+		free(fusion);
+	}
+	STARPU_PTHREAD_SETSPECIFIC(submitting_key, NULL);
+
+	STARPU_PTHREAD_MUTEX_LOCK(&fusion_mutex);
+	flush_done++;
+	STARPU_PTHREAD_COND_BROADCAST(&fusion_cond);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&fusion_mutex);
+}
+
+/* Submit the pending chain, and wait for all the chains to be submitted, so
+ * that whatever the caller submits next comes after them */
+void _starpu_task_fusion_flush(void)
+{
+	struct fusion *fusion = NULL;
+	unsigned long ticket;
+
+	if (is_submitting())
+		return;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&fusion_mutex);
+	if (pending)
+		fusion = fusion_take(&ticket);
+	else
+		fusion_wait(flush_ticket);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&fusion_mutex);
+
+	if (fusion)
+		fusion_submit(fusion, ticket);
+}
+
+static void *flusher_func(void *arg)
+{
+	(void) arg;
+
+	starpu_pthread_setname("fusion_flusher");
+
+	STARPU_PTHREAD_MUTEX_LOCK(&fusion_mutex);
+	while (!flusher_stop)
+	{
+		struct fusion *fusion = NULL;
+		unsigned long ticket;
+
+		if (!pending)
+		{
+			STARPU_PTHREAD_COND_WAIT(&flusher_cond, &fusion_mutex);
+			continue;
+		}
+
+		/* Do not wait behind other submissions, we will come back */
+		if (flush_done == flush_ticket
+		    && starpu_timing_now() - last_append >= FUSION_IDLE_DELAY)
+			fusion = fusion_take(&ticket);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&fusion_mutex);
+
+		if (fusion)
+			fusion_submit(fusion, ticket);
+		else
+			starpu_usleep(FUSION_IDLE_DELAY);
+
+		STARPU_PTHREAD_MUTEX_LOCK(&fusion_mutex);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&fusion_mutex);
+	return NULL;
+}
+
+int _starpu_task_fusion_defer(struct starpu_task *task)
+{
+	struct fusion *fusion = NULL;
+	unsigned long ticket;
+	unsigned sched_ctx;
+
+	if (is_submitting() || (task->starpu_private && _starpu_get_job_associated_to_task(task)->internal))
+		/* Submitted by StarPU itself, possibly while submitting a
+		 * chain, or in the middle of the submission of another task,
+		 * or from a worker: flushing here could deadlock or
+		 * reorder the dependencies. The API functions which submit
+		 * internal tasks on behalf of the application flush
+		 * beforehand. */
+		return 0;
+
+	/* The chain may be submitted by another thread, which may have
+	 * another current context */
+	sched_ctx = task->sched_ctx;
+	if (sched_ctx == STARPU_NMAX_SCHED_CTXS)
+		sched_ctx = _starpu_sched_ctx_get_current_context();
+
+	if (!task_is_fusable(task) || !cpu_worker_can_execute(task, sched_ctx))
+	{
+		_starpu_task_fusion_flush();
+		return 0;
+	}
+	task->sched_ctx = sched_ctx;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&fusion_mutex);
+	if (pending && !fusion_accepts(pending, task))
+		fusion = fusion_take(&ticket);
+	if (!pending)
+	{
+		struct fusion *chain;
+		_STARPU_CALLOC(chain, 1, sizeof(*chain));
+		chain->nx = starpu_vector_get_nx(STARPU_TASK_GET_HANDLE(task, 0));
+		chain->sched_ctx = task->sched_ctx;
+		chain->priority = task->priority;
+		pending = chain;
+		/* Let the flusher watch whether it gets stale */
+		STARPU_PTHREAD_COND_SIGNAL(&flusher_cond);
+	}
+	fusion_append(pending, task);
+	last_append = starpu_timing_now();
+	STARPU_PTHREAD_MUTEX_UNLOCK(&fusion_mutex);
+
+	if (fusion)
+		fusion_submit(fusion, ticket);
+
+	return 1;
+}
@@ -0,0 +1,47 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#ifndef __TASK_FUSION_H__
+#define __TASK_FUSION_H__
+
+#include <starpu.h>
+
+#pragma GCC visibility push(hidden)
+
+/** @file */
+
+/** Maximum number of tasks merged into one, 0 when fusion is disabled */
+extern int _starpu_task_fusion_max;
+
+void _starpu_task_fusion_init(void);
+void _starpu_task_fusion_deinit(void);
+
+/** Try to append the task to the chain of tasks being merged. Return 1 if
+ * it was, in which case it must not be submitted. Otherwise the chain was
+ * submitted before the task, which now has to be submitted as usual. */
+int _starpu_task_fusion_defer(struct starpu_task *task);
+
+/** Submit the chain of tasks being merged, if any */
+void _starpu_task_fusion_flush(void);
+
+#define _STARPU_TASK_FUSION_FLUSH() do { \
+	if (STARPU_UNLIKELY(_starpu_task_fusion_max)) \
+		_starpu_task_fusion_flush(); \
+} while (0)
+
+#pragma GCC visibility pop
+
+#endif /* !__TASK_FUSION_H__ */
@@ -519,6 +519,185 @@ static void _starpu_deallocate_topology_userdata(hwloc_obj_t obj)
 #endif
 #endif
 
+#if !defined(STARPU_SIMGRID) && defined(STARPU_HAVE_HWLOC)
+#ifdef HAVE_HWLOC_TOPOLOGY_DUP
+/* Topology loaded by the first starpu_init() of the process, kept over
+ * starpu_shutdown() so that the next starpu_init() calls just duplicate it
+ * instead of discovering the machine again */
+static hwloc_topology_t cached_hwtopology;
+
+#ifdef __GNUC__
+/* Release it when the library gets unloaded */
+static void _starpu_destroy_cached_hwtopology(void) __attribute__((destructor));
+static void _starpu_destroy_cached_hwtopology(void)
+{
+	if (cached_hwtopology)
+	{
+		hwloc_topology_destroy(cached_hwtopology);
+		cached_hwtopology = NULL;
+	}
+}
+#endif
+#endif
+
+#if HWLOC_API_VERSION >= 0x00020100
+/* Name of the root info attribute recording the version of hwloc which
+ * produced the cache */
+#define HWTOPOLOGY_CACHE_VERSION "StarPUHwlocVersion"
+
+/* Load the topology from the XML file saved along the bus calibration files,
+ * with the resources currently allowed for this process */
+static int _starpu_load_hwtopology_cache(hwloc_topology_t *hwtopology, const char *path)
+{
+	char version[16];
+	const char *cache_version;
+	hwloc_bitmap_t binding;
+
+	if (access(path, R_OK) < 0)
+		return -1;
+
+	if (hwloc_topology_init(hwtopology) < 0)
+		return -1;
+	if (hwloc_topology_set_xml(*hwtopology, path) < 0)
+		goto err;
+	_starpu_topology_filter(*hwtopology);
+	/* This is really this machine, so that binding works, and the
+	 * resources allowed for this process have to be read from the system */
+	hwloc_topology_set_flags(*hwtopology, hwloc_topology_get_flags(*hwtopology) | HWLOC_TOPOLOGY_FLAG_IS_THISSYSTEM | HWLOC_TOPOLOGY_FLAG_THISSYSTEM_ALLOWED_RESOURCES);
+	if (hwloc_topology_load(*hwtopology) < 0)
+		goto err;
+
+	/* Check that it was produced by the same hwloc */
+	snprintf(version, sizeof(version), "%x", hwloc_get_api_version());
+	cache_version = hwloc_obj_get_info_by_name(hwloc_get_root_obj(*hwtopology), HWTOPOLOGY_CACHE_VERSION);
+	if (!cache_version || strcmp(cache_version, version))
+	{
+		_STARPU_DEBUG("hwloc topology cache %s was produced by hwloc %s instead of %s, ignoring it\n", path, cache_version ? cache_version : "unknown", version);
+		goto err;
+	}
+
+	/* Check that it is still the same machine */
+#ifdef _SC_NPROCESSORS_CONF
+	long ncpus = sysconf(_SC_NPROCESSORS_CONF);
+	if (ncpus > 0 && hwloc_bitmap_weight(hwloc_topology_get_complete_cpuset(*hwtopology)) != ncpus)
+		goto mismatch;
+#endif
+	if (hwloc_bitmap_iszero(hwloc_topology_get_allowed_cpuset(*hwtopology))
+	 || !hwloc_bitmap_isincluded(hwloc_topology_get_allowed_cpuset(*hwtopology), hwloc_topology_get_complete_cpuset(*hwtopology))
+	 || hwloc_bitmap_iszero(hwloc_topology_get_allowed_nodeset(*hwtopology))
+	 || !hwloc_bitmap_isincluded(hwloc_topology_get_allowed_nodeset(*hwtopology), hwloc_topology_get_complete_nodeset(*hwtopology)))
+		goto mismatch;
+	binding = hwloc_bitmap_alloc();
+	if (hwloc_get_cpubind(*hwtopology, binding, HWLOC_CPUBIND_PROCESS) == 0
+	 && !hwloc_bitmap_isincluded(binding, hwloc_topology_get_complete_cpuset(*hwtopology)))
+	{
+		hwloc_bitmap_free(binding);
+		goto mismatch;
+	}
+	hwloc_bitmap_free(binding);
+
+	_STARPU_DEBUG("loaded hwloc topology from cache %s\n", path);
+	return 0;
+
+mismatch:
+	_STARPU_DEBUG("hwloc topology cache %s does not match this machine, ignoring it\n", path);
+err:
+	hwloc_topology_destroy(*hwtopology);
+	return -1;
+}
+
+static void _starpu_save_hwtopology_cache(hwloc_topology_t hwtopology, const char *path)
+{
+	char tmp[PATH_LENGTH+16];
+	char version[16];
+	char *slash;
+
+	/* Only cache the whole machine, not what e.g. a job scheduler
+	 * allowed this process to use */
+	if (!hwloc_bitmap_isequal(hwloc_topology_get_allowed_cpuset(hwtopology), hwloc_topology_get_complete_cpuset(hwtopology))
+	 || !hwloc_bitmap_isequal(hwloc_topology_get_allowed_nodeset(hwtopology), hwloc_topology_get_complete_nodeset(hwtopology)))
+		return;
+
+	snprintf(tmp, sizeof(tmp), "%s", path);
+	slash = strrchr(tmp, '/');
+	if (slash)
+	{
+		*slash = 0;
+		if (_starpu_mkpath(tmp, S_IRWXU) < 0)
+		{
+			_STARPU_DISP("Warning: could not create directory %s to cache the hwloc topology: %s\n", tmp, strerror(errno));
+			return;
+		}
+	}
+
+	snprintf(version, sizeof(version), "%x", hwloc_get_api_version());
+	if (!hwloc_obj_get_info_by_name(hwloc_get_root_obj(hwtopology), HWTOPOLOGY_CACHE_VERSION))
+		hwloc_obj_add_info(hwloc_get_root_obj(hwtopology), HWTOPOLOGY_CACHE_VERSION, version);
+
+	/* Concurrent processes may be doing the same */
+	snprintf(tmp, sizeof(tmp), "%s.%d", path, (int) getpid());
+	if (hwloc_topology_export_xml(hwtopology, tmp, 0) < 0 || rename(tmp, path) < 0)
+	{
+		_STARPU_DISP("Warning: could not save the hwloc topology cache %s: %s\n", path, strerror(errno));
+		unlink(tmp);
+	}
+}
+#endif
+
+static void _starpu_load_hwtopology(struct _starpu_machine_config *config)
+{
+	struct _starpu_machine_topology *topology = &config->topology;
+	char *hwloc_input = starpu_getenv("STARPU_HWLOC_INPUT");
+	int use_cache = !(hwloc_input && hwloc_input[0]) && starpu_getenv_number_default("STARPU_HWLOC_CACHE", 1);
+	int err;
+
+#ifdef HAVE_HWLOC_TOPOLOGY_DUP
+	if (use_cache && cached_hwtopology && hwloc_topology_dup(&topology->hwtopology, cached_hwtopology) == 0)
+		return;
+#endif
+
+#if HWLOC_API_VERSION >= 0x00020100
+	char path[PATH_LENGTH];
+	int use_file_cache = use_cache;
+	if (use_file_cache && !_starpu_get_perf_model_dir_bus())
+	{
+		_STARPU_DEBUG("no directory to store bus calibration files, not caching the hwloc topology\n");
+		use_file_cache = 0;
+	}
+	if (use_file_cache)
+	{
+		_starpu_get_hwloc_cache_path(path, sizeof(path));
+		if (config->conf.bus_calibrate <= 0 && _starpu_load_hwtopology_cache(&topology->hwtopology, path) == 0)
+			goto loaded;
+	}
+#endif
+
+	err = hwloc_topology_init(&topology->hwtopology);
+	STARPU_ASSERT_MSG(err == 0, "Could not initialize Hwloc topology (%s)\n", strerror(errno));
+	if (hwloc_input && hwloc_input[0])
+	{
+		err = hwloc_topology_set_xml(topology->hwtopology, hwloc_input);
+		if (err < 0) _STARPU_DISP("Could not load hwloc input %s\n", hwloc_input);
+	}
+
+	_starpu_topology_filter(topology->hwtopology);
+	err = hwloc_topology_load(topology->hwtopology);
+	STARPU_ASSERT_MSG(err == 0, "Could not load Hwloc topology (%s)%s%s%s\n", strerror(errno), hwloc_input ? " (input " : "", hwloc_input ? hwloc_input : "", hwloc_input ? ")" : "");
+
+#if HWLOC_API_VERSION >= 0x00020100
+	if (use_file_cache)
+		_starpu_save_hwtopology_cache(topology->hwtopology, path);
+
+loaded:
+#endif
+#ifdef HAVE_HWLOC_TOPOLOGY_DUP
+	if (use_cache && !cached_hwtopology)
+		hwloc_topology_dup(&cached_hwtopology, topology->hwtopology);
+#endif
+	return;
+}
+#endif
+
 static void _starpu_init_topology(struct _starpu_machine_config *config)
 {
 	/* Discover the topology, meaning finding all the available PUs for
@@ -553,30 +732,20 @@ static void _starpu_init_topology(struct _starpu_machine_config *config)
 
 	topology->nhwdevices[STARPU_CPU_WORKER] = 1;
 	topology->nhwworker[STARPU_CPU_WORKER][0] = 0;
+	topology->ncpukinds = 1;
 	topology->nhwpus = 0;
 	topology->nusedpus = 0;
 	topology->firstusedpu = 0;
 
 #ifndef STARPU_SIMGRID
 #ifdef STARPU_HAVE_HWLOC
-	int err;
-	err = hwloc_topology_init(&topology->hwtopology);
-	STARPU_ASSERT_MSG(err == 0, "Could not initialize Hwloc topology (%s)\n", strerror(errno));
-	char *hwloc_input = starpu_getenv("STARPU_HWLOC_INPUT");
-	if (hwloc_input && hwloc_input[0])
-	{
-		err = hwloc_topology_set_xml(topology->hwtopology, hwloc_input);
-		if (err < 0) _STARPU_DISP("Could not load hwloc input %s\n", hwloc_input);
-	}
-
-	_starpu_topology_filter(topology->hwtopology);
-	err = hwloc_topology_load(topology->hwtopology);
-	STARPU_ASSERT_MSG(err == 0, "Could not load Hwloc topology (%s)%s%s%s\n", strerror(errno), hwloc_input ? " (input " : "", hwloc_input ? hwloc_input : "", hwloc_input ? ")" : "");
+	_starpu_load_hwtopology(config);
 
 #ifdef HAVE_HWLOC_CPUKINDS_GET_NR
 	int nr_kinds = hwloc_cpukinds_get_nr(topology->hwtopology, 0);
+	topology->ncpukinds = nr_kinds > 1 ? nr_kinds : 1;
 	if (nr_kinds > 1)
-		_STARPU_DISP("Warning: there are several kinds of CPU on this system. For now StarPU assumes all CPU are equal\n");
+		_STARPU_DEBUG("there are %d kinds of CPU on this system\n", nr_kinds);
 #endif
 
 	_starpu_allocate_topology_userdata(hwloc_get_root_obj(topology->hwtopology));
@@ -1009,6 +1178,31 @@ unsigned starpu_get_next_bindid(unsigned flags, unsigned *preferred, unsigned np
 	return _starpu_get_next_bindid(_starpu_get_machine_config(), flags, preferred, npreferred);
 }
 
+int _starpu_get_cpukind(struct _starpu_machine_config *config, int bindid)
+{
+#if defined(STARPU_HAVE_HWLOC) && defined(HAVE_HWLOC_CPUKINDS_GET_NR) && !defined(STARPU_SIMGRID)
+	struct _starpu_machine_topology *topology = &config->topology;
+	if (topology->ncpukinds <= 1 || bindid < 0)
+		return 0;
+
+	hwloc_obj_t pu = hwloc_get_obj_by_depth(topology->hwtopology, config->pu_depth, bindid);
+	if (!pu)
+		return 0;
+
+	int kind = hwloc_cpukinds_get_by_cpuset(topology->hwtopology, pu->cpuset, 0);
+	if (kind < 0)
+		return 0;
+
+	/* hwloc sorts kinds by increasing efficiency, we rather put the most
+	 * efficient first, so that kind 0 is the usual performance core */
+	return topology->ncpukinds - 1 - kind;
+#else
+	(void) config;
+	(void) bindid;
+	return 0;
+#endif
+}
+
 unsigned _starpu_topology_get_nhwcpu(struct _starpu_machine_config *config)
 {
 	_starpu_init_topology(config);
@@ -1629,6 +1823,17 @@ void _starpu_bind_thread_on_cpus(struct _starpu_combined_worker *combined_worker
 #endif
 }
 
+int _starpu_bind_main_thread_on_worker(struct _starpu_worker *worker)
+{
+	if (main_thread_cpuid >= 0)
+		return -1;
+
+	main_thread_cpuid = worker->bindid;
+	/* Sharing the PU with that worker is on purpose */
+	_starpu_bind_thread_on_cpu(main_thread_cpuid, worker->workerid, "main");
+	return 0;
+}
+
 void starpu_bind_thread_on_main(void)
 {
 	_starpu_do_bind_thread_on_cpu(main_thread_cpuid);
@@ -70,6 +70,10 @@ void _starpu_initialize_workers_deviceid(int *explicit_workers_gpuid,
 /** Get the next devid for architecture \p type */
 int _starpu_get_next_devid(struct _starpu_machine_topology *topology, struct _starpu_machine_config *config, enum starpu_worker_archtype arch);
 
+/** Return the kind of CPU core of the PU \p bindid, 0 being the most
+ * efficient kind (e.g. performance cores), or 0 if all cores are the same. */
+int _starpu_get_cpukind(struct _starpu_machine_config *config, int bindid);
+
 /** Check that \p *ndevices is not larger than \p nhwdevices (unless \p overflow is 1), and is not larger than \p max.
  * Cap it otherwise, and advise using the \p configurename ./configure option in the \p max case. */
 void _starpu_topology_check_ndevices(int *ndevices, unsigned nhwdevices, int overflow, unsigned max, int reserved, const char *nname, const char *dname, const char *configurename);
@@ -155,6 +159,11 @@ void _starpu_topology_filter(hwloc_topology_t topology);
  * or the ordering exposed by the OS. */
 int _starpu_bind_thread_on_cpu(int cpuid, int workerid, const char *name);
 
+struct _starpu_worker;
+/** Bind the current thread, which is the main thread, on the CPU of the
+ * given worker. Return -1 if the main thread already has its own CPU. */
+int _starpu_bind_main_thread_on_worker(struct _starpu_worker *worker);
+
 struct _starpu_combined_worker;
 /** Bind the current thread on the set of CPUs for the given combined worker. */
 void _starpu_bind_thread_on_cpus(struct _starpu_combined_worker *combined_worker);
@@ -29,10 +29,12 @@
 #include <common/graph.h>
 #include <core/progress_hook.h>
 #include <core/idle_hook.h>
+#include <core/callback_threads.h>
 #include <core/workers.h>
 #include <core/debug.h>
 #include <core/disk.h>
 #include <core/task.h>
+#include <core/task_fusion.h>
 #include <core/detect_combined_workers.h>
 #include <datawizard/malloc.h>
 #include <profiling/profiling.h>
@@ -55,6 +57,7 @@
 #include <drivers/mpi/driver_mpi_source.h>
 #include <drivers/tcpip/driver_tcpip_source.h>
 #include <drivers/disk/driver_disk.h>
+#include <util/starpu_data_cpy.h>
 
 #ifdef STARPU_SIMGRID
 #include <core/simgrid.h>
@@ -582,6 +585,12 @@ static inline int _starpu_can_execute_task_any_impl(unsigned workerid, struct st
 	if (!_starpu_config.workers[workerid].enable_knob)
 		return 0;
 
+	/* Tasks explicitly targeting the worker, e.g. from
+	 * starpu_execute_on_each_worker(), are still run */
+	if (_starpu_config.workers[workerid].parked
+		&& !(task->execute_on_a_specific_worker && task->workerid == workerid))
+		return 0;
+
 	if (task->workerids_len)
 	{
 		size_t div = sizeof(*task->workerids) * 8;
@@ -851,6 +860,7 @@ void _starpu_worker_init(struct _starpu_worker *workerarg, struct _starpu_machin
 	/* set initialized by topology.c */
 	workerarg->pipeline_length = 0;
 	workerarg->pipeline_stuck = 0;
+	workerarg->pipeline_fetch_ahead = 0;
 	workerarg->worker_is_running = 0;
 	workerarg->worker_is_initialized = 0;
 	workerarg->wait_for_worker_initialization = 0;
@@ -906,6 +916,7 @@ void _starpu_worker_init(struct _starpu_worker *workerarg, struct _starpu_machin
 	_starpu_perf_counter_sample_init(&workerarg->perf_counter_sample, starpu_perf_counter_scope_per_worker);
 	workerarg->enable_knob = 1;
 	workerarg->bindid_requested = -1;
+	workerarg->parked = 0;
 
 	/* cpu_set/hwloc_cpu_set/hwloc_obj initialized in topology.c */
 }
@@ -1559,6 +1570,63 @@ int _starpu_get_catch_signals(void)
 	return _starpu_config.conf.catch_signals;
 }
 
+/* CPU worker sharing the PU of the main thread, which only runs tasks while
+ * the main thread waits for them, or -1 */
+static int main_thread_helper = -1;
+static starpu_pthread_t main_thread;
+
+static void _starpu_init_main_thread_helper(void)
+{
+	int workerid;
+
+	main_thread_helper = -1;
+	if (!starpu_getenv_number_default("STARPU_MAIN_THREAD_HELP", 0))
+		return;
+
+	if (starpu_cpu_worker_get_count() < 2)
+	{
+		/* The other workers would not be able to run CPU tasks
+		 * while the main thread does not wait */
+		_STARPU_DISP("Warning: STARPU_MAIN_THREAD_HELP needs at least two CPU workers, ignoring it\n");
+		return;
+	}
+
+	for (workerid = _starpu_config.topology.nworkers - 1; workerid >= 0; workerid--)
+		if (_starpu_config.workers[workerid].arch == STARPU_CPU_WORKER)
+			break;
+
+	if (_starpu_bind_main_thread_on_worker(&_starpu_config.workers[workerid]) < 0)
+	{
+		_STARPU_DISP("Warning: STARPU_MAIN_THREAD_HELP cannot be used along STARPU_MAIN_THREAD_BIND or STARPU_MAIN_THREAD_CPUID, ignoring it\n");
+		return;
+	}
+
+	main_thread = starpu_pthread_self();
+	_starpu_config.workers[workerid].parked = 1;
+	main_thread_helper = workerid;
+}
+
+int _starpu_main_thread_help_start(unsigned sched_ctx_id)
+{
+	if (main_thread_helper == -1
+		|| !starpu_pthread_equal(starpu_pthread_self(), main_thread)
+		|| !starpu_sched_ctx_contains_worker(main_thread_helper, sched_ctx_id))
+		return 0;
+
+	_starpu_config.workers[main_thread_helper].parked = 0;
+	STARPU_WMB();
+	/* Let it look for tasks which were already pushed */
+	_starpu_wake_worker_relax(main_thread_helper);
+	return 1;
+}
+
+void _starpu_main_thread_help_end(void)
+{
+	/* It will still run the tasks which were already pushed to it, if any */
+	_starpu_config.workers[main_thread_helper].parked = 1;
+	STARPU_WMB();
+}
+
 void starpu_drivers_preinit(void)
 {
 	_starpu_cpu_preinit();
@@ -1835,6 +1903,7 @@ int starpu_initialize(struct starpu_conf *user_conf, int *argc, char ***argv)
 	_starpu_open_debug_logfile();
 
 	_starpu_data_interface_init();
+	_starpu_data_cpy_init();
 
 	_starpu_timing_init();
 
@@ -1922,6 +1991,7 @@ int starpu_initialize(struct starpu_conf *user_conf, int *argc, char ***argv)
 #endif
 	if (!is_a_sink)
 	{
+		_starpu_init_main_thread_helper();
 		/* Launch "basic" workers (ie. non-combined workers) */
 		_starpu_launch_drivers(&_starpu_config);
 		/* Allocate swap, if any */
@@ -2159,6 +2229,8 @@ void starpu_display_stats()
 void starpu_shutdown(void)
 {
 	unsigned worker;
+
+	_STARPU_TASK_FUSION_FLUSH();
 	STARPU_PTHREAD_MUTEX_LOCK(&init_mutex);
 	init_count--;
 	STARPU_ASSERT_MSG(init_count >= 0, "Number of calls to starpu_shutdown() can not be higher than the number of calls to starpu_init()\n");
@@ -2210,6 +2282,8 @@ void starpu_shutdown(void)
 	/* wait for their termination */
 	_starpu_terminate_workers(&_starpu_config);
 
+	_starpu_callback_threads_shutdown();
+
 	{
 	     int stats = starpu_getenv_number("STARPU_MEMORY_STATS");
 	     if (stats != 0)
@@ -81,7 +81,9 @@ struct _starpu_node
 
 	/** Potentially in use memory chunks. The beginning of the list is clean (home
 	 * node has a copy of the data, or the data is being transferred there), the
-	 * remainder of the list may not be clean. */
+	 * remainder of the list may not be clean. Recency is tracked by the
+	 * reference bit of the chunks, which the eviction, reuse and write-back
+	 * sweeps use to move them to the end of the list. */
 	struct _starpu_mem_chunk_list mc_list;
 	/** This is a shortcut inside the mc_list to the first potentially dirty MC. All
 	 * MC before this are clean, MC before this only *may* be clean. */
@@ -237,6 +239,7 @@ LIST_TYPE(_starpu_worker,
 	unsigned char ntasks; /**< number of tasks in the pipeline */
 	unsigned char pipeline_length; /**< number of tasks to be put in the pipeline */
 	unsigned char pipeline_stuck; /**< whether a task prevents us from pipelining */
+	unsigned char pipeline_fetch_ahead; /**< whether the driver pops and prefetches pipelined tasks while the input of another one is being transferred */
 	struct _starpu_worker_set *set; /**< in case this worker belongs to a worker set */
 	struct _starpu_worker_set *driver_worker_set; /**< in case this worker belongs to a driver worker set */
 	unsigned worker_is_running;
@@ -309,6 +312,11 @@ LIST_TYPE(_starpu_worker,
 	int enable_knob;
 	int bindid_requested;
 
+	/** Whether the worker must not be given tasks, because it only runs
+	 * some while the main thread waits for them, see STARPU_MAIN_THREAD_HELP.
+	 * Tasks submitted to this very worker are still accepted. */
+	int parked;
+
 	  /** Keep this last, to make sure to separate worker data in separate
 	  cache lines. */
 	char padding[STARPU_CACHELINE_SIZE];
@@ -374,6 +382,10 @@ struct _starpu_machine_topology
 	/** custom hwloc tree*/
 	struct starpu_tree *tree;
 
+	/** Number of kinds of CPU cores (e.g. performance and efficiency
+	 * cores), as detected by hwloc. */
+	unsigned ncpukinds;
+
 	/** Total number of PUs (i.e. threads), as detected by the topology code. May
 	 * be different from the actual number of CPU workers.
 	 */
@@ -582,6 +594,12 @@ void _starpu_conf_check_environment(struct starpu_conf *conf);
 /** Called by the driver when it is ready to pause  */
 void _starpu_may_pause(void);
 
+/** Let the helper worker of the main thread run tasks while the calling
+ * thread waits for the tasks of the given context, see STARPU_MAIN_THREAD_HELP.
+ * Return whether _starpu_main_thread_help_end() has to be called afterwards. */
+int _starpu_main_thread_help_start(unsigned sched_ctx_id);
+void _starpu_main_thread_help_end(void);
+
 /** Has starpu_shutdown already been called ? */
 static inline unsigned _starpu_machine_is_running(void)
 {
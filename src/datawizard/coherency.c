@@ -24,6 +24,7 @@
 #include <datawizard/write_back.h>
 #include <datawizard/memory_nodes.h>
 #include <datawizard/sort_data_handles.h>
+#include <datawizard/dirty_tracking.h>
 #include <core/dependencies/data_concurrency.h>
 #include <core/disk.h>
 #include <profiling/profiling.h>
@@ -176,6 +177,7 @@ void _starpu_update_data_state(starpu_data_handle_t handle,
 	if (mode == STARPU_UNMAP)
 	{
 		/* Unmap request, invalidate */
+		_starpu_dirty_track_invalidate(handle, requesting_replicate->memory_node);
 		requesting_replicate->state = STARPU_INVALID;
 		return;
 	}
@@ -205,7 +207,11 @@ void _starpu_update_data_state(starpu_data_handle_t handle,
 				/* The mapping node will be kept up to date */
 				continue;
 			if (handle->per_node[node].state != STARPU_INVALID)
-			       _STARPU_TRACE_DATA_STATE_INVALID(handle, node);
+			{
+				_STARPU_TRACE_DATA_STATE_INVALID(handle, node);
+				if (node != requesting_node)
+					_starpu_dirty_track_invalidate(handle, node);
+			}
 			handle->per_node[node].state = STARPU_INVALID;
 		}
 		if (requesting_replicate->state != STARPU_OWNER)
@@ -461,10 +467,14 @@ static struct _starpu_data_request *_starpu_search_existing_data_request(struct
 	/* Make sure we don't have anything else than R/W */
 	STARPU_ASSERT(mode != STARPU_UNMAP);
 
-	for (r = replicate->request[node]; r; r = r->next_same_req)
+	for (r = replicate->request; r; r = r->next_same_req)
 	{
 		_starpu_spin_checklocked(&r->handle->header_lock);
 
+		if (r->request_node != node)
+			/* Not from the same node */
+			continue;
+
 		if (r->canceled)
 			/* Do not reuse a cancelled request */
 			continue;
@@ -476,6 +486,7 @@ static struct _starpu_data_request *_starpu_search_existing_data_request(struct
 		_starpu_spin_lock(&r->lock);
 
 		/* perhaps we need to "upgrade" the request */
+		_starpu_update_request_deadline(r, _starpu_data_request_deadline(task, is_prefetch));
 		if (is_prefetch < r->prefetch)
 			_starpu_update_prefetch_status(r, is_prefetch);
 
@@ -557,15 +568,14 @@ struct _starpu_data_request *_starpu_create_request_to_fetch_data(starpu_data_ha
 		 * invalidate all their results (which were possibly spurious,
 		 * e.g. too aggressive eviction).
 		 */
-		unsigned i, j;
+		unsigned i;
 		unsigned nnodes = starpu_memory_nodes_get_count();
 		for (i = 0; i < nnodes; i++)
-			for (j = 0; j < nnodes; j++)
-			{
-				struct _starpu_data_request *r;
-				for (r = handle->per_node[i].request[j]; r; r = r->next_same_req)
-					nwait++;
-			}
+		{
+			struct _starpu_data_request *r;
+			for (r = handle->per_node[i].request; r; r = r->next_same_req)
+				nwait++;
+		}
 		/* If the request is not detached (i.e. the caller really wants
 		 * proper ownership), no new requests will appear because a
 		 * reference will be kept on the dst replicate, which will
@@ -605,20 +615,12 @@ struct _starpu_data_request *_starpu_create_request_to_fetch_data(starpu_data_ha
 
 			if (task)
 			{
-				unsigned j;
-				unsigned nnodes = starpu_memory_nodes_get_count();
 				/* Cancel any existing (prefetch) request */
 				struct _starpu_data_request *r2;
-				for (j = 0; j < nnodes; j++)
+				for (r2 = dst_replicate->request; r2; r2 = r2->next_same_req)
 				{
-					for (r2 = dst_replicate->request[j]; r2; r2 = r2->next_same_req)
-					{
-						if (r2->task && r2->task == task)
-						{
-							r2->canceled = 1;
-							break;
-						}
-					}
+					if (r2->task && r2->task == task)
+						r2->canceled = 1;
 				}
 			}
 		}
@@ -799,24 +801,24 @@ struct _starpu_data_request *_starpu_create_request_to_fetch_data(starpu_data_ha
 		 * invalidate all their results (which were possibly spurious,
 		 * e.g. too aggressive eviction).
 		 */
-		unsigned i, j;
+		unsigned i;
 		unsigned nnodes = starpu_memory_nodes_get_count();
 		for (i = 0; i < nnodes; i++)
-			for (j = 0; j < nnodes; j++)
+		{
+			struct _starpu_data_request *r2;
+			for (r2 = handle->per_node[i].request; r2; r2 = r2->next_same_req)
 			{
-				struct _starpu_data_request *r2;
-				for (r2 = handle->per_node[i].request[j]; r2; r2 = r2->next_same_req)
-				{
-					_starpu_spin_lock(&r2->lock);
-					if (is_prefetch < r2->prefetch)
-						/* Hasten the request we will have to wait for */
-						_starpu_update_prefetch_status(r2, is_prefetch);
-					r2->next_req[r2->next_req_count++] = r;
-					STARPU_ASSERT(r2->next_req_count <= STARPU_MAXNODES + 1);
-					_starpu_spin_unlock(&r2->lock);
-					nwait--;
-				}
+				_starpu_spin_lock(&r2->lock);
+				/* Hasten the request we will have to wait for */
+				_starpu_update_request_deadline(r2, r->deadline);
+				if (is_prefetch < r2->prefetch)
+					_starpu_update_prefetch_status(r2, is_prefetch);
+				r2->next_req[r2->next_req_count++] = r;
+				STARPU_ASSERT(r2->next_req_count <= STARPU_MAXNODES + 1);
+				_starpu_spin_unlock(&r2->lock);
+				nwait--;
 			}
+		}
 		STARPU_ASSERT(nwait == 0);
 
 		nhops++;
@@ -1331,6 +1333,9 @@ void _starpu_fetch_task_input_tail(struct starpu_task *task, struct _starpu_job
 				if (local_replicate->nb_tasks_prefetch > 0)
 					local_replicate->nb_tasks_prefetch--;
 			}
+			/* Also when the data had to be transferred, which
+			 * _starpu_fetch_data_on_node does not record */
+			_starpu_memchunk_recently_used(local_replicate->mc, node);
 		}
 		if (!(mode & STARPU_R) && (mode & STARPU_W))
 		{
@@ -1547,20 +1552,9 @@ unsigned starpu_data_is_on_node(starpu_data_handle_t handle, unsigned node)
 	{
 		ret  = 1;
 	}
-	else
+	else if (handle->per_node[node].request)
 	{
-		unsigned i;
-		unsigned nnodes = starpu_memory_nodes_get_count();
-
-		for (i = 0; i < nnodes; i++)
-		{
-			if (handle->per_node[node].request[i])
-			{
-				ret = 1;
-				break;
-			}
-		}
-
+		ret = 1;
 	}
 
 //	STARPU_PTHREAD_SPIN_UNLOCK(&handle->header_lock);
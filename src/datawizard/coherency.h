@@ -95,10 +95,13 @@ struct _starpu_data_replicate
 	 */
 	uint32_t requested;
 
-	/** This tracks the list of requests to provide the value */
-	struct _starpu_data_request *request[STARPU_MAXNODES];
+	/** This tracks the list of requests to provide the value, from
+	 * whichever node, see request_node in struct _starpu_data_request.
+	 * Keeping a single list rather than one per source node keeps the
+	 * replicate small, which matters when registering many handles. */
+	struct _starpu_data_request *request;
 	/** This points to the last entry of request, to easily append to the list */
-	struct _starpu_data_request *last_request[STARPU_MAXNODES];
+	struct _starpu_data_request *last_request;
 
 	/* Which request is loading data here */
 	struct _starpu_data_request *load_request;
@@ -257,6 +260,21 @@ struct _starpu_data_state
 	    is in its readonly_dup field. */
 	starpu_data_handle_t readonly_dup_of;
 
+	/** for a handle whose starpu_data_cpy() was deferred, the handle it is
+	    a copy of. Protected by the copy-on-write mutex of starpu_data_cpy.c */
+	starpu_data_handle_t cow_src;
+	/** for the source of deferred copies, the list of its pending
+	    duplicates, linked through their cow_next field */
+	starpu_data_handle_t cow_dups;
+	starpu_data_handle_t cow_next;
+	/** priority to be used for the deferred copy */
+	int cow_prio;
+
+	/** page-granular tracking of the modifications of the RAM replica
+	    since it was last identical to a disk replica, see
+	    datawizard/dirty_tracking.c */
+	struct _starpu_dirty_track *dirty_track;
+
 	/* The following bitfields are set from the application submission thread */
 
 	/** Is the data initialized, or a task is already submitted to initialize it
@@ -285,6 +285,17 @@ int STARPU_ATTRIBUTE_WARN_UNUSED_RESULT _starpu_driver_copy_data_1_to_1(starpu_d
 		}
 	}
 
+	/* When the source is going to be invalidated by our write anyway,
+	 * rather move its buffer between NUMA nodes */
+	if (!donotread && req && (req->mode & STARPU_W)
+			&& !dst_replicate->allocated && dst_replicate->mapped == STARPU_UNMAPPED
+			&& src_replicate->allocated
+			&& !_starpu_migrate_memory_on_node(handle, src_replicate, dst_replicate))
+	{
+		_starpu_bus_update_profiling_info((int)src_node, (int)dst_node, _starpu_data_get_size(handle));
+		return 0;
+	}
+
 	/* first make sure the destination has an allocated buffer */
 	if (!dst_replicate->allocated && dst_replicate->mapped == STARPU_UNMAPPED)
 	{
@@ -564,6 +575,8 @@ int starpu_interface_copy3d(uintptr_t src, size_t src_offset, unsigned src_node,
 	enum starpu_node_kind dst_kind = starpu_node_get_kind(dst_node);
 	const struct _starpu_node_ops *src_node_ops = _starpu_memory_node_get_node_ops(src_node);
 	const struct _starpu_node_ops *dst_node_ops = _starpu_memory_node_get_node_ops(dst_node);
+	int src_devid = starpu_memory_node_get_devid(src_node);
+	int dst_devid = starpu_memory_node_get_devid(dst_node);
 
 	STARPU_ASSERT_MSG(ld1_src >= blocksize, "block size %lu is bigger than ld %lu in source", (unsigned long) blocksize, (unsigned long) ld1_src);
 	STARPU_ASSERT_MSG(ld1_dst >= blocksize, "block size %lu is bigger than ld %lu in destination", (unsigned long) blocksize, (unsigned long) ld1_dst);
@@ -581,8 +594,8 @@ int starpu_interface_copy3d(uintptr_t src, size_t src_offset, unsigned src_node,
 
 	if (src_node_ops && src_node_ops->copy3d_data_to[dst_kind])
 		/* Hardware-optimized non-contiguous case */
-		return src_node_ops->copy3d_data_to[dst_kind](src, src_offset, src_node,
-							     dst, dst_offset, dst_node,
+		return src_node_ops->copy3d_data_to[dst_kind](src, src_offset, src_devid,
+							     dst, dst_offset, dst_devid,
 							     blocksize,
 							     numblocks_1, ld1_src, ld1_dst,
 							     numblocks_2, ld2_src, ld2_dst,
@@ -590,8 +603,8 @@ int starpu_interface_copy3d(uintptr_t src, size_t src_offset, unsigned src_node,
 
 	if (dst_node_ops && dst_node_ops->copy3d_data_from[src_kind])
 		/* Hardware-optimized non-contiguous case */
-		return dst_node_ops->copy3d_data_from[src_kind](src, src_offset, src_node,
-							     dst, dst_offset, dst_node,
+		return dst_node_ops->copy3d_data_from[src_kind](src, src_offset, src_devid,
+							     dst, dst_offset, dst_devid,
 							     blocksize,
 							     numblocks_1, ld1_src, ld1_dst,
 							     numblocks_2, ld2_src, ld2_dst,
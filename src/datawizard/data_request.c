@@ -21,6 +21,7 @@
 #include <common/utils.h>
 #include <datawizard/datawizard.h>
 #include <datawizard/memory_nodes.h>
+#include <datawizard/dirty_tracking.h>
 #include <core/disk.h>
 #include <core/simgrid.h>
 
@@ -95,20 +96,10 @@ static void _starpu_data_request_unlink(struct _starpu_data_request *r)
 	}
 	else
 	{
-		unsigned node;
 		struct _starpu_data_request **prevp, *prev;
 
-		if (r->mode & STARPU_R)
-			/* If this is a read request, we store the pending requests
-			 * between src and dst. */
-			node = r->src_replicate->memory_node;
-		else
-			/* If this is a write only request, then there is no source and
-			 * we use the destination node to cache the request. */
-			node = r->dst_replicate->memory_node;
-
 		/* Look for ourself in the list, we should be not very far. */
-		for (prevp = &r->dst_replicate->request[node], prev = NULL;
+		for (prevp = &r->dst_replicate->request, prev = NULL;
 		     *prevp && *prevp != r;
 		     prev = *prevp, prevp = &prev->next_same_req)
 			;
@@ -119,11 +110,8 @@ static void _starpu_data_request_unlink(struct _starpu_data_request *r)
 		if (!r->next_same_req)
 		{
 			/* I was last */
-			STARPU_ASSERT(r->dst_replicate->last_request[node] == r);
-			if (prev)
-				r->dst_replicate->last_request[node] = prev;
-			else
-				r->dst_replicate->last_request[node] = NULL;
+			STARPU_ASSERT(r->dst_replicate->last_request == r);
+			r->dst_replicate->last_request = prev;
 		}
 	}
 }
@@ -195,9 +183,11 @@ struct _starpu_data_request *_starpu_create_data_request(starpu_data_handle_t ha
 	r->task = task;
 	r->nb_tasks_prefetch = 0;
 	r->prio = prio;
+	r->deadline = _starpu_data_request_deadline(task, is_prefetch);
 	r->retval = -1;
 	r->ndeps = ndeps;
 	r->next_same_req = NULL;
+	r->request_node = 0;
 	r->next_req_count = 0;
 	r->callbacks = NULL;
 	r->com_id = 0;
@@ -220,18 +210,20 @@ struct _starpu_data_request *_starpu_create_data_request(starpu_data_handle_t ha
 	}
 	else
 	{
-		unsigned node;
-
 		if (mode & STARPU_R)
-			node = src_replicate->memory_node;
+			/* If this is a read request, we record the pending
+			 * requests between src and dst. */
+			r->request_node = src_replicate->memory_node;
 		else
-			node = dst_replicate->memory_node;
+			/* If this is a write only request, then there is no source and
+			 * we use the destination node to record the request. */
+			r->request_node = dst_replicate->memory_node;
 
-		if (!dst_replicate->request[node])
-			dst_replicate->request[node] = r;
+		if (!dst_replicate->request)
+			dst_replicate->request = r;
 		else
-			dst_replicate->last_request[node]->next_same_req = r;
-		dst_replicate->last_request[node] = r;
+			dst_replicate->last_request->next_same_req = r;
+		dst_replicate->last_request = r;
 
 		if (mode & STARPU_R)
 		{
@@ -343,6 +335,35 @@ int _starpu_wait_data_request_completion(struct _starpu_data_request *r, enum _s
 	return retval;
 }
 
+/* Return when the data of a request made for this task will be needed */
+double _starpu_data_request_deadline(struct starpu_task *task, enum starpu_is_prefetch is_prefetch)
+{
+	double deadline = INFINITY;
+
+	if (task && !isnan(task->predicted_start))
+		deadline = task->predicted_start;
+	if (is_prefetch == STARPU_FETCH)
+		/* This is needed right now */
+		deadline = STARPU_MIN(deadline, starpu_timing_now());
+	return deadline;
+}
+
+static int _starpu_data_request_cmp_deadline(const struct _starpu_data_request *r1, const struct _starpu_data_request *r2)
+{
+	return (r1->deadline > r2->deadline) - (r1->deadline < r2->deadline);
+}
+
+/* Return the queue where the request is to be put, data_requests_list_mutex has to be held */
+static struct _starpu_data_request_prio_list *_starpu_data_request_queue(struct _starpu_node *node_struct, struct _starpu_data_request *r)
+{
+	if (r->prefetch >= STARPU_IDLEFETCH)
+		return &node_struct->idle_requests[r->peer_node][r->inout];
+	else if (r->prefetch > STARPU_FETCH)
+		return &node_struct->prefetch_requests[r->peer_node][r->inout];
+	else
+		return &node_struct->data_requests[r->peer_node][r->inout];
+}
+
 /* this is non blocking */
 void _starpu_post_data_request(struct _starpu_data_request *r)
 {
@@ -365,12 +386,7 @@ void _starpu_post_data_request(struct _starpu_data_request *r)
 
 	/* insert the request in the proper list */
 	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->data_requests_list_mutex[r->peer_node][r->inout]);
-	if (r->prefetch >= STARPU_IDLEFETCH)
-		_starpu_data_request_prio_list_push_back(&node_struct->idle_requests[r->peer_node][r->inout], r);
-	else if (r->prefetch > STARPU_FETCH)
-		_starpu_data_request_prio_list_push_back(&node_struct->prefetch_requests[r->peer_node][r->inout], r);
-	else
-		_starpu_data_request_prio_list_push_back(&node_struct->data_requests[r->peer_node][r->inout], r);
+	_starpu_data_request_prio_list_push_sorted(_starpu_data_request_queue(node_struct, r), r, _starpu_data_request_cmp_deadline);
 	STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->data_requests_list_mutex[r->peer_node][r->inout]);
 
 #ifndef STARPU_NON_BLOCKING_DRIVERS
@@ -415,6 +431,8 @@ static void starpu_handle_data_request_completion(struct _starpu_data_request *r
 		_starpu_spin_checklocked(&handle->header_lock);
 		_starpu_update_data_state(handle, r->dst_replicate, mode);
 		dst_replicate->load_request = NULL;
+		if (mode & STARPU_R)
+			_starpu_dirty_track_transfer(handle, src_replicate, dst_replicate);
 
 #ifdef STARPU_MEMORY_STATS
 		if (src_replicate->state == STARPU_INVALID)
@@ -575,8 +593,9 @@ static int starpu_handle_data_request(struct _starpu_data_request *r, enum _star
 			r->canceled = 2;
 			_starpu_spin_unlock(&r->lock);
 			_starpu_spin_lock(&r2->lock);
+			/* Upgrade the existing request */
+			_starpu_update_request_deadline(r2, r->deadline);
 			if (r->prefetch < r2->prefetch)
-				/* Upgrade the existing request */
 				_starpu_update_prefetch_status(r2, r->prefetch);
 			_starpu_data_request_append_callback(r2, _starpu_data_request_complete_wait, r);
 			_starpu_spin_unlock(&r2->lock);
@@ -1019,15 +1038,37 @@ void _starpu_update_prefetch_status(struct _starpu_data_request *r, enum starpu_
 		found = 0;
 
 	if (found)
-	{
-		if (prefetch > STARPU_FETCH)
-			_starpu_data_request_prio_list_push_back(&node_struct->prefetch_requests[r->peer_node][r->inout],r);
-		else
-			_starpu_data_request_prio_list_push_back(&node_struct->data_requests[r->peer_node][r->inout],r);
-	}
+		_starpu_data_request_prio_list_push_sorted(_starpu_data_request_queue(node_struct, r), r, _starpu_data_request_cmp_deadline);
 	STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->data_requests_list_mutex[r->peer_node][r->inout]);
 
 #ifndef STARPU_NON_BLOCKING_DRIVERS
 	_starpu_wake_all_blocked_workers_on_node(r->handling_node);
 #endif
 }
+
+/* The data of the request is needed earlier than expected, move the request
+ * forward in its queue */
+void _starpu_update_request_deadline(struct _starpu_data_request *r, double deadline)
+{
+	struct _starpu_node *node_struct = _starpu_get_node_struct(r->handling_node);
+	_starpu_spin_checklocked(&r->handle->header_lock);
+
+	if (!(deadline < r->deadline))
+		return;
+
+	r->deadline = deadline;
+
+	if (r->ndeps > 0)
+		/* Not queued yet */
+		return;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->data_requests_list_mutex[r->peer_node][r->inout]);
+	struct _starpu_data_request_prio_list *queue = _starpu_data_request_queue(node_struct, r);
+	/* The request can be in a different list (handling request or the temp list) */
+	if (_starpu_data_request_prio_list_ismember(queue, r))
+	{
+		_starpu_data_request_prio_list_erase(queue, r);
+		_starpu_data_request_prio_list_push_sorted(queue, r, _starpu_data_request_cmp_deadline);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->data_requests_list_mutex[r->peer_node][r->inout]);
+}
@@ -107,6 +107,10 @@ LIST_TYPE(_starpu_data_request,
 
 	/** Priority of the request. Default is 0 */
 	int prio;
+	/** Expected start time of the earliest task which will use the data,
+	 * INFINITY if unknown. Requests of the same priority are processed
+	 * in increasing deadline order. */
+	double deadline;
 
 	/** The value returned by the transfer function */
 	int retval;
@@ -118,6 +122,10 @@ LIST_TYPE(_starpu_data_request,
 	/** Some further tasks may have requested prefetches for the same data
 	 * much later on, link with them */
 	struct _starpu_data_request *next_same_req;
+	/** The node this request is recorded for in the request list of
+	 * dst_replicate: the source node for a read request, the destination
+	 * node for a write-only request. */
+	unsigned request_node;
 
 	/** in case we have a chain of request (eg. for nvidia multi-GPU), this
 	 * is the list of requests which are waiting for this one. */
@@ -187,6 +195,8 @@ void _starpu_data_request_append_callback(struct _starpu_data_request *r,
 					  void *callback_arg);
 
 void _starpu_update_prefetch_status(struct _starpu_data_request *r, enum starpu_is_prefetch prefetch);
+void _starpu_update_request_deadline(struct _starpu_data_request *r, double deadline);
+double _starpu_data_request_deadline(struct starpu_task *task, enum starpu_is_prefetch is_prefetch);
 
 #pragma GCC visibility pop
 
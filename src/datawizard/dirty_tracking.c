@@ -0,0 +1,605 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Page-granular tracking of the modifications of RAM replicas.
+ *
+ * When a RAM replica and a disk replica of a handle get the same content (the
+ * data was fetched from the disk or written back to it), the pages of the RAM
+ * replica are write-protected through userfaultfd. The first write to a page
+ * then gets reported to a handler thread, which records the page as dirty and
+ * lifts the protection. The disk replica is kept allocated when it gets
+ * invalidated, so that writing the data back to it again (eviction or
+ * write-through) only needs to transfer the dirty pages. The protection is
+ * lifted as soon as the RAM replica stops matching the disk replica, e.g.
+ * when it gets invalidated, so that overwriting it does not fault.
+ *
+ * Only whole vector and variable handles are tracked, and any transfer which
+ * may modify either replica behind our back (from another node, from another
+ * disk, through a mapping) drops the relation between them.
+ */
+
+#include <common/config.h>
+#include <common/utils.h>
+#include <common/rbtree.h>
+#include <datawizard/dirty_tracking.h>
+#include <datawizard/memory_nodes.h>
+
+#if defined(HAVE_LINUX_USERFAULTFD_H) && !defined(STARPU_SIMGRID)
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/userfaultfd.h>
+#if defined(SYS_userfaultfd) && defined(UFFDIO_WRITEPROTECT_MODE_WP)
+#define STARPU_DIRTY_TRACKING
+#endif
+#endif
+
+int _starpu_dirty_tracking_enabled;
+
+#ifdef STARPU_DIRTY_TRACKING
+
+/* Below that, partial transfers are not worth tracking */
+#define DIRTY_TRACK_MIN_PAGES 4
+/* Clean gaps shorter than that between dirty pages are written along, rather
+ * than issuing one more request */
+#define DIRTY_TRACK_MERGE_PAGES 4
+
+#define BITS_PER_LONG (8 * sizeof(unsigned long))
+
+struct _starpu_dirty_track
+{
+	/* Keep this first so that track_entry can work */
+	struct starpu_rbtree_node node;
+	starpu_data_handle_t handle;
+	/* RAM node of the tracked replica */
+	unsigned ram_node;
+	/* Disk node whose replica has the same content as the RAM replica,
+	 * except for the dirty pages, or -1 */
+	int clean_node;
+	/* The tracked buffer */
+	uintptr_t ptr;
+	size_t size;
+	/* The pages which are completely inside the buffer, the rest is always
+	 * considered dirty */
+	uintptr_t start;
+	uintptr_t end;
+	/* One bit per page of [start, end) */
+	unsigned long *dirty;
+};
+
+static int uffd = -1;
+static int stop_pipe[2];
+static starpu_pthread_t handler_thread;
+/* Protects the tree of tracked buffers, their bitmaps, and the dirty_track
+ * fields of the handles */
+static starpu_pthread_mutex_t dirty_mutex;
+static struct starpu_rbtree tracks = STARPU_RBTREE_INITIALIZER;
+static uintptr_t page_size;
+
+static unsigned long nbytes_total;
+static unsigned long nbytes_written;
+
+static inline struct _starpu_dirty_track *track_entry(struct starpu_rbtree_node *node)
+{
+	return (struct _starpu_dirty_track *) node;
+}
+
+static inline int track_cmp_insert(struct starpu_rbtree_node *a, struct starpu_rbtree_node *b)
+{
+	return track_entry(a)->start < track_entry(b)->start ? -1 : 1;
+}
+
+/* Never matches, so that starpu_rbtree_lookup_nearest returns the last track
+ * starting at or before ADDR */
+static inline int track_cmp_lookup(uintptr_t addr, struct starpu_rbtree_node *node)
+{
+	return addr < track_entry(node)->start ? -1 : 1;
+}
+
+/* Return the track containing ADDR, if any */
+static struct _starpu_dirty_track *track_lookup(uintptr_t addr)
+{
+	struct starpu_rbtree_node *node;
+	node = starpu_rbtree_lookup_nearest(&tracks, addr, track_cmp_lookup, STARPU_RBTREE_LEFT);
+	if (node && addr >= track_entry(node)->start && addr < track_entry(node)->end)
+		return track_entry(node);
+	return NULL;
+}
+
+static int write_protect(uintptr_t start, size_t len, int protect)
+{
+	struct uffdio_writeprotect wp =
+	{
+		.range = { .start = start, .len = len },
+		.mode = protect ? UFFDIO_WRITEPROTECT_MODE_WP : 0,
+	};
+	return ioctl(uffd, UFFDIO_WRITEPROTECT, &wp);
+}
+
+static void *handler_func(void *arg)
+{
+	(void) arg;
+	struct pollfd fds[2] =
+	{
+		{ .fd = uffd, .events = POLLIN },
+		{ .fd = stop_pipe[0], .events = POLLIN },
+	};
+
+	starpu_pthread_setname("dirty_tracking");
+
+	while (1)
+	{
+		struct uffd_msg msg;
+		struct _starpu_dirty_track *track;
+		uintptr_t addr;
+
+		if (poll(fds, 2, -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			_STARPU_DISP("Warning: dirty tracking poll failed: %s\n", strerror(errno));
+			break;
+		}
+		if (fds[1].revents)
+			/* Termination */
+			break;
+		if (read(uffd, &msg, sizeof(msg)) != sizeof(msg))
+			continue;
+		if (msg.event != UFFD_EVENT_PAGEFAULT)
+			continue;
+
+		addr = msg.arg.pagefault.address & ~(page_size - 1);
+		STARPU_PTHREAD_MUTEX_LOCK(&dirty_mutex);
+		track = track_lookup(addr);
+		if (track)
+		{
+			uintptr_t page = (addr - track->start) / page_size;
+			track->dirty[page / BITS_PER_LONG] |= 1UL << (page % BITS_PER_LONG);
+		}
+		/* This also wakes the writer up. Keep the mutex so that a
+		 * concurrent re-protection of the track does not get undone. */
+		if (write_protect(addr, page_size, 0) < 0)
+		{
+			/* The range was unregistered meanwhile, the writer
+			 * may just need to be woken up */
+			struct uffdio_range range = { .start = addr, .len = page_size };
+			(void) ioctl(uffd, UFFDIO_WAKE, &range);
+		}
+		STARPU_PTHREAD_MUTEX_UNLOCK(&dirty_mutex);
+	}
+	return NULL;
+}
+
+/* Open a userfaultfd with the given features, or return -1 */
+static int open_uffd(uint64_t features)
+{
+	struct uffdio_api api;
+	int fd;
+
+	fd = syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+	if (fd < 0)
+		return -1;
+
+	memset(&api, 0, sizeof(api));
+	api.api = UFFD_API;
+	api.features = features;
+	if (ioctl(fd, UFFDIO_API, &api) < 0 || !(api.features & UFFD_FEATURE_PAGEFAULT_FLAG_WP))
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+void _starpu_dirty_tracking_init(void)
+{
+	if (uffd >= 0 || !starpu_getenv_number_default("STARPU_DISK_DIRTY_TRACKING", 0))
+		return;
+
+#ifdef UFFD_FEATURE_WP_UNPOPULATED
+	/* Also catch the first writes to pages which were never touched */
+	uffd = open_uffd(UFFD_FEATURE_WP_UNPOPULATED);
+	if (uffd < 0)
+#endif
+		uffd = open_uffd(0);
+	if (uffd < 0)
+	{
+		_STARPU_DISP("Warning: userfaultfd write protection is not available, STARPU_DISK_DIRTY_TRACKING is ignored\n");
+		return;
+	}
+
+	if (pipe(stop_pipe) < 0)
+	{
+		_STARPU_DISP("Warning: could not create pipe (%s), STARPU_DISK_DIRTY_TRACKING is ignored\n", strerror(errno));
+		close(uffd);
+		uffd = -1;
+		return;
+	}
+
+	page_size = sysconf(_SC_PAGESIZE);
+	nbytes_total = 0;
+	nbytes_written = 0;
+	STARPU_PTHREAD_MUTEX_INIT(&dirty_mutex, NULL);
+	starpu_rbtree_init(&tracks);
+	STARPU_PTHREAD_CREATE(&handler_thread, NULL, handler_func, NULL);
+	_starpu_dirty_tracking_enabled = 1;
+}
+
+static void track_destroy(struct _starpu_dirty_track *track)
+{
+	struct uffdio_range range = { .start = track->start, .len = track->end - track->start };
+
+	if (ioctl(uffd, UFFDIO_UNREGISTER, &range) < 0)
+		_STARPU_DISP("Warning: could not unregister range from userfaultfd: %s\n", strerror(errno));
+	starpu_rbtree_remove(&tracks, &track->node);
+	track->handle->dirty_track = NULL;
+	free(track->dirty);
+	free(track);
+}
+
+void _starpu_dirty_tracking_deinit(void)
+{
+	struct starpu_rbtree_node *node, *tmp;
+	char c = 0;
+
+	if (!_starpu_dirty_tracking_enabled)
+		return;
+
+	if (write(stop_pipe[1], &c, 1) != 1)
+		STARPU_ABORT_MSG("could not stop dirty tracking thread: %s\n", strerror(errno));
+	STARPU_PTHREAD_JOIN(handler_thread, NULL);
+
+	STARPU_PTHREAD_MUTEX_LOCK(&dirty_mutex);
+	starpu_rbtree_for_each_remove(&tracks, node, tmp)
+	{
+		struct _starpu_dirty_track *track = track_entry(node);
+		struct uffdio_range range = { .start = track->start, .len = track->end - track->start };
+		(void) ioctl(uffd, UFFDIO_UNREGISTER, &range);
+		track->handle->dirty_track = NULL;
+		free(track->dirty);
+		free(track);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&dirty_mutex);
+	STARPU_PTHREAD_MUTEX_DESTROY(&dirty_mutex);
+
+	_STARPU_DEBUG("dirty tracking wrote back %lu bytes out of %lu\n", nbytes_written, nbytes_total);
+
+	close(stop_pipe[0]);
+	close(stop_pipe[1]);
+	close(uffd);
+	uffd = -1;
+	_starpu_dirty_tracking_enabled = 0;
+}
+
+/* Get the buffer of the replica, or return -1 if the interface is not
+ * supported */
+static int get_buffer(starpu_data_handle_t handle, void *data_interface, uintptr_t *dev_handle, size_t *offset, size_t *size)
+{
+	switch (handle->ops->interfaceid)
+	{
+		case STARPU_VECTOR_INTERFACE_ID:
+		{
+			struct starpu_vector_interface *vector = data_interface;
+			*dev_handle = vector->dev_handle;
+			*offset = vector->offset;
+			*size = vector->nx * vector->elemsize;
+			return 0;
+		}
+		case STARPU_VARIABLE_INTERFACE_ID:
+		{
+			struct starpu_variable_interface *variable = data_interface;
+			*dev_handle = variable->dev_handle;
+			*offset = variable->offset;
+			*size = variable->elemsize;
+			return 0;
+		}
+		default:
+			return -1;
+	}
+}
+
+static int replicates_mapped(starpu_data_handle_t handle)
+{
+	unsigned node;
+	for (node = 0; node < STARPU_MAXNODES; node++)
+		if (handle->per_node[node].mapped != STARPU_UNMAPPED)
+			return 1;
+	return 0;
+}
+
+/* Start tracking the RAM replica */
+static struct _starpu_dirty_track *track_create(starpu_data_handle_t handle, struct _starpu_data_replicate *replicate)
+{
+	struct _starpu_dirty_track *track;
+	struct starpu_rbtree_node *node;
+	uintptr_t dev_handle, start, end;
+	size_t offset, size, npages;
+
+	/* Sub-data share their buffer with their parent, leave them alone */
+	if (handle->parent_handle || handle->nchildren)
+		return NULL;
+	if (get_buffer(handle, replicate->data_interface, &dev_handle, &offset, &size))
+		return NULL;
+
+	start = (dev_handle + offset + page_size - 1) & ~(page_size - 1);
+	end = (dev_handle + offset + size) & ~(page_size - 1);
+	if (end <= start || (end - start) / page_size < DIRTY_TRACK_MIN_PAGES)
+		return NULL;
+
+	/* Check that the buffer is not already tracked through another handle */
+	node = starpu_rbtree_lookup_nearest(&tracks, end - 1, track_cmp_lookup, STARPU_RBTREE_LEFT);
+	if (node && track_entry(node)->end > start)
+		return NULL;
+
+	struct uffdio_register reg =
+	{
+		.range = { .start = start, .len = end - start },
+		.mode = UFFDIO_REGISTER_MODE_WP,
+	};
+	if (ioctl(uffd, UFFDIO_REGISTER, &reg) < 0)
+	{
+		/* E.g. not anonymous memory */
+		_STARPU_DEBUG("could not track %p: %s\n", (void *) start, strerror(errno));
+		return NULL;
+	}
+
+	npages = (end - start) / page_size;
+	_STARPU_CALLOC(track, 1, sizeof(*track));
+	_STARPU_CALLOC(track->dirty, (npages + BITS_PER_LONG - 1) / BITS_PER_LONG, sizeof(*track->dirty));
+	track->handle = handle;
+	track->ram_node = replicate->memory_node;
+	track->clean_node = -1;
+	track->ptr = dev_handle + offset;
+	track->size = size;
+	track->start = start;
+	track->end = end;
+	starpu_rbtree_node_init(&track->node);
+	starpu_rbtree_insert(&tracks, &track->node, track_cmp_insert);
+	handle->dirty_track = track;
+	return track;
+}
+
+/* The RAM replica now has the same content as the replica on DISK_NODE */
+static void track_sync(struct _starpu_dirty_track *track, unsigned disk_node)
+{
+	size_t npages = (track->end - track->start) / page_size;
+
+	if (write_protect(track->start, track->end - track->start, 1) < 0)
+	{
+		_STARPU_DISP("Warning: could not write-protect %p: %s\n", (void *) track->start, strerror(errno));
+		track->clean_node = -1;
+		return;
+	}
+	memset(track->dirty, 0, (npages + BITS_PER_LONG - 1) / BITS_PER_LONG * sizeof(*track->dirty));
+	track->clean_node = disk_node;
+}
+
+/* The RAM replica does not match any disk replica any more, stop catching
+ * the writes to it */
+static void track_unsync(struct _starpu_dirty_track *track)
+{
+	if (track->clean_node == -1)
+		return;
+	if (write_protect(track->start, track->end - track->start, 0) < 0)
+		_STARPU_DISP("Warning: could not lift write protection of %p: %s\n", (void *) track->start, strerror(errno));
+	track->clean_node = -1;
+}
+
+void _starpu_dirty_track_transfer_done(starpu_data_handle_t handle, struct _starpu_data_replicate *src_replicate, struct _starpu_data_replicate *dst_replicate)
+{
+	unsigned src_node = src_replicate->memory_node;
+	unsigned dst_node = dst_replicate->memory_node;
+	enum starpu_node_kind src_kind = starpu_node_get_kind(src_node);
+	enum starpu_node_kind dst_kind = starpu_node_get_kind(dst_node);
+	struct _starpu_data_replicate *ram_replicate = NULL;
+	unsigned disk_node = 0;
+	struct _starpu_dirty_track *track;
+
+	if (!_starpu_dirty_tracking_enabled)
+		return;
+
+	if (src_kind == STARPU_DISK_RAM && dst_kind == STARPU_CPU_RAM)
+	{
+		ram_replicate = dst_replicate;
+		disk_node = src_node;
+	}
+	else if (src_kind == STARPU_CPU_RAM && dst_kind == STARPU_DISK_RAM)
+	{
+		ram_replicate = src_replicate;
+		disk_node = dst_node;
+	}
+
+	STARPU_PTHREAD_MUTEX_LOCK(&dirty_mutex);
+	track = handle->dirty_track;
+	if (ram_replicate && (!track || track->ram_node == (unsigned) ram_replicate->memory_node) && !replicates_mapped(handle))
+	{
+		/* The RAM and disk replicas are now the same */
+		if (!track)
+			track = track_create(handle, ram_replicate);
+		if (track)
+			track_sync(track, disk_node);
+	}
+	else if (track && (track->ram_node == dst_node || track->clean_node == (int) dst_node))
+		/* Either side was overwritten from elsewhere */
+		track_unsync(track);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&dirty_mutex);
+}
+
+void _starpu_dirty_track_drop_node(starpu_data_handle_t handle, unsigned node)
+{
+	struct _starpu_dirty_track *track;
+
+	if (!_starpu_dirty_tracking_enabled)
+		return;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&dirty_mutex);
+	track = handle->dirty_track;
+	if (track)
+	{
+		if (track->ram_node == node)
+			/* The buffer is going away */
+			track_destroy(track);
+		else if (track->clean_node == (int) node)
+			track_unsync(track);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&dirty_mutex);
+}
+
+void _starpu_dirty_track_invalidate_node(starpu_data_handle_t handle, unsigned node)
+{
+	struct _starpu_dirty_track *track;
+
+	if (!_starpu_dirty_tracking_enabled)
+		return;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&dirty_mutex);
+	track = handle->dirty_track;
+	/* The disk replica getting invalidated is the whole point, but the
+	 * content of the RAM replica is going to be replaced */
+	if (track && track->ram_node == node)
+		track_unsync(track);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&dirty_mutex);
+}
+
+void _starpu_dirty_track_destroy(starpu_data_handle_t handle)
+{
+	if (!handle->dirty_track)
+		return;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&dirty_mutex);
+	if (handle->dirty_track)
+		track_destroy(handle->dirty_track);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&dirty_mutex);
+}
+
+static int write_range(uintptr_t src, size_t src_offset, unsigned src_node, uintptr_t dst, size_t dst_offset, unsigned dst_node, size_t from, size_t to, struct _starpu_async_channel *async_channel)
+{
+	int ret;
+
+	if (to <= from)
+		return 0;
+	ret = starpu_interface_copy(src, src_offset + from, src_node, dst, dst_offset + from, dst_node, to - from, async_channel);
+	STARPU_ASSERT(ret == 0 || ret == -EAGAIN);
+	(void) STARPU_ATOMIC_ADDL(&nbytes_written, to - from);
+	return ret;
+}
+
+int _starpu_dirty_track_write_back(starpu_data_handle_t handle, void *src_interface, unsigned src_node, void *dst_interface, unsigned dst_node, struct _starpu_async_channel *async_channel)
+{
+	struct _starpu_dirty_track *track;
+	uintptr_t src, dst;
+	size_t src_offset, dst_offset, size, dst_size;
+	size_t npages, page, nlongs, head, tail;
+	unsigned long *dirty;
+	int ret = 0;
+
+	if (!_starpu_dirty_tracking_enabled)
+		return -ENOTSUP;
+
+	if (get_buffer(handle, src_interface, &src, &src_offset, &size)
+	 || get_buffer(handle, dst_interface, &dst, &dst_offset, &dst_size))
+		return -ENOTSUP;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&dirty_mutex);
+	track = handle->dirty_track;
+	if (!track || track->ram_node != src_node || track->clean_node != (int) dst_node
+	    || track->ptr != src + src_offset || track->size != size || dst_size != size
+	    || replicates_mapped(handle))
+	{
+		STARPU_PTHREAD_MUTEX_UNLOCK(&dirty_mutex);
+		return -ENOTSUP;
+	}
+
+	/* The RAM replica is being read, so nobody can dirty it meanwhile,
+	 * take a copy to avoid holding the mutex during the transfers */
+	npages = (track->end - track->start) / page_size;
+	nlongs = (npages + BITS_PER_LONG - 1) / BITS_PER_LONG;
+	_STARPU_MALLOC(dirty, nlongs * sizeof(*dirty));
+	memcpy(dirty, track->dirty, nlongs * sizeof(*dirty));
+	head = track->start - track->ptr;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&dirty_mutex);
+
+	(void) STARPU_ATOMIC_ADDL(&nbytes_total, size);
+
+	/* Write the dirty ranges, merged when they are close to each other.
+	 * The partial pages at the beginning and the end are always written.
+	 * The writes all go to the same channel, which completes when they
+	 * are all over */
+	size_t from = 0, to = head;
+	for (page = 0; page < npages; page++)
+	{
+		size_t page_from = head + page * page_size;
+		if (!(dirty[page / BITS_PER_LONG] & (1UL << (page % BITS_PER_LONG))))
+			continue;
+		if (page_from - to >= DIRTY_TRACK_MERGE_PAGES * page_size)
+		{
+			if (write_range(src, src_offset, src_node, dst, dst_offset, dst_node, from, to, async_channel))
+				ret = -EAGAIN;
+			from = page_from;
+		}
+		to = page_from + page_size;
+	}
+	tail = head + npages * page_size;
+	if (tail - to >= DIRTY_TRACK_MERGE_PAGES * page_size)
+	{
+		if (write_range(src, src_offset, src_node, dst, dst_offset, dst_node, from, to, async_channel))
+			ret = -EAGAIN;
+		from = tail;
+	}
+	if (write_range(src, src_offset, src_node, dst, dst_offset, dst_node, from, size, async_channel))
+		ret = -EAGAIN;
+
+	free(dirty);
+	return ret;
+}
+
+#else /* !STARPU_DIRTY_TRACKING */
+
+void _starpu_dirty_tracking_init(void)
+{
+	if (starpu_getenv_number_default("STARPU_DISK_DIRTY_TRACKING", 0))
+		_STARPU_DISP("Warning: STARPU_DISK_DIRTY_TRACKING needs userfaultfd support, it is ignored\n");
+}
+
+void _starpu_dirty_tracking_deinit(void)
+{
+}
+
+void _starpu_dirty_track_transfer_done(starpu_data_handle_t handle STARPU_ATTRIBUTE_UNUSED, struct _starpu_data_replicate *src_replicate STARPU_ATTRIBUTE_UNUSED, struct _starpu_data_replicate *dst_replicate STARPU_ATTRIBUTE_UNUSED)
+{
+}
+
+void _starpu_dirty_track_drop_node(starpu_data_handle_t handle STARPU_ATTRIBUTE_UNUSED, unsigned node STARPU_ATTRIBUTE_UNUSED)
+{
+}
+
+void _starpu_dirty_track_invalidate_node(starpu_data_handle_t handle STARPU_ATTRIBUTE_UNUSED, unsigned node STARPU_ATTRIBUTE_UNUSED)
+{
+}
+
+void _starpu_dirty_track_destroy(starpu_data_handle_t handle STARPU_ATTRIBUTE_UNUSED)
+{
+}
+
+int _starpu_dirty_track_write_back(starpu_data_handle_t handle STARPU_ATTRIBUTE_UNUSED, void *src_interface STARPU_ATTRIBUTE_UNUSED, unsigned src_node STARPU_ATTRIBUTE_UNUSED, void *dst_interface STARPU_ATTRIBUTE_UNUSED, unsigned dst_node STARPU_ATTRIBUTE_UNUSED, struct _starpu_async_channel *async_channel STARPU_ATTRIBUTE_UNUSED)
+{
+	return -ENOTSUP;
+}
+
+#endif /* !STARPU_DIRTY_TRACKING */
@@ -0,0 +1,78 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#ifndef __DW_DIRTY_TRACKING_H__
+#define __DW_DIRTY_TRACKING_H__
+
+/** @file */
+
+#include <starpu.h>
+#include <datawizard/coherency.h>
+
+#pragma GCC visibility push(hidden)
+
+/** Whether page-granular dirty tracking of RAM replicas against their disk
+ * replicas is enabled (STARPU_DISK_DIRTY_TRACKING) */
+extern int _starpu_dirty_tracking_enabled;
+
+/** Start tracking, called when a disk gets registered */
+void _starpu_dirty_tracking_init(void);
+/** Stop tracking, called when disks get unregistered */
+void _starpu_dirty_tracking_deinit(void);
+
+void _starpu_dirty_track_transfer_done(starpu_data_handle_t handle, struct _starpu_data_replicate *src_replicate, struct _starpu_data_replicate *dst_replicate);
+
+/** Record that a transfer from \p src_replicate to \p dst_replicate has
+ * completed: if it is between the tracked RAM replica and a disk, they now
+ * have the same content, otherwise the tracking for that disk is lost. Called
+ * with the header lock held. */
+static inline void _starpu_dirty_track_transfer(starpu_data_handle_t handle, struct _starpu_data_replicate *src_replicate, struct _starpu_data_replicate *dst_replicate)
+{
+	if (handle->dirty_track || _starpu_dirty_tracking_enabled)
+		_starpu_dirty_track_transfer_done(handle, src_replicate, dst_replicate);
+}
+
+void _starpu_dirty_track_drop_node(starpu_data_handle_t handle, unsigned node);
+
+/** Record that the replica of \p handle on \p node lost its buffer */
+static inline void _starpu_dirty_track_drop(starpu_data_handle_t handle, unsigned node)
+{
+	if (handle->dirty_track)
+		_starpu_dirty_track_drop_node(handle, node);
+}
+
+void _starpu_dirty_track_invalidate_node(starpu_data_handle_t handle, unsigned node);
+
+/** Record that the replica of \p handle on \p node is getting invalidated.
+ * Called with the header lock held. */
+static inline void _starpu_dirty_track_invalidate(starpu_data_handle_t handle, unsigned node)
+{
+	if (handle->dirty_track)
+		_starpu_dirty_track_invalidate_node(handle, node);
+}
+
+/** Stop tracking \p handle, which is getting unregistered */
+void _starpu_dirty_track_destroy(starpu_data_handle_t handle);
+
+/** Write back to the disk replica only the pages of the RAM replica which were
+ * modified since they were last identical. Return 0 if this was done
+ * synchronously, -EAGAIN if the writes were queued on \p async_channel, and
+ * -ENOTSUP if the whole data has to be transferred. */
+int _starpu_dirty_track_write_back(starpu_data_handle_t handle, void *src_interface, unsigned src_node, void *dst_interface, unsigned dst_node, struct _starpu_async_channel *async_channel);
+
+#pragma GCC visibility pop
+
+#endif // __DW_DIRTY_TRACKING_H__
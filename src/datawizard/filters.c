@@ -23,7 +23,9 @@
 #include <datawizard/footprint.h>
 #include <datawizard/interfaces/data_interface.h>
 #include <datawizard/memory_nodes.h>
+#include <datawizard/dirty_tracking.h>
 #include <core/task.h>
+#include <util/starpu_data_cpy.h>
 
 void starpu_data_set_gathering_node(starpu_data_handle_t handle, unsigned node)
 {
@@ -186,9 +188,16 @@ static void _starpu_data_partition(starpu_data_handle_t initial_handle, starpu_d
 	unsigned i;
 	unsigned node;
 
+	if (STARPU_UNLIKELY(_starpu_data_cow_npending))
+		/* Accesses through the children are not tracked */
+		_starpu_data_cow_materialize(initial_handle);
+
 	for (node = 0; node < STARPU_MAXNODES; node++)
 		_starpu_data_unmap(initial_handle, node);
 
+	/* Transfers of the children are not tracked */
+	_starpu_dirty_track_destroy(initial_handle);
+
 	/* first take care to properly lock the data header */
 	_starpu_spin_lock(&initial_handle->header_lock);
 
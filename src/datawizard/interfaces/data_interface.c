@@ -21,11 +21,14 @@
 #include <datawizard/memory_nodes.h>
 #include <datawizard/memstats.h>
 #include <datawizard/malloc.h>
+#include <datawizard/dirty_tracking.h>
 #include <core/dependencies/data_concurrency.h>
 #include <common/knobs.h>
 #include <common/starpu_spinlock.h>
 #include <core/task.h>
+#include <core/task_fusion.h>
 #include <core/workers.h>
+#include <util/starpu_data_cpy.h>
 #ifdef STARPU_OPENMP
 #include <util/openmp_runtime_support.h>
 #endif
@@ -200,6 +203,19 @@ static void _starpu_register_new_data(starpu_data_handle_t handle, int home_node
 	_starpu_perf_counter_update_max_int32(&maxnregistered, nregistered);
 }
 
+/* Interfaces of the different replicates of a handle are allocated as one
+ * block rather than one malloc each, to save both the malloc overhead and
+ * registration time when the application registers many small pieces of data.
+ * This returns the distance between two interfaces in the block. */
+static size_t _starpu_data_interface_stride(size_t interfacesize)
+{
+	/* Keep the interfaces aligned like malloc would */
+	size_t align = 2 * sizeof(void*);
+	if (!interfacesize)
+		interfacesize = 1;
+	return (interfacesize + align - 1) & ~(align - 1);
+}
+
 void _starpu_data_initialize_per_worker(starpu_data_handle_t handle)
 {
 	unsigned worker;
@@ -210,6 +226,10 @@ void _starpu_data_initialize_per_worker(starpu_data_handle_t handle)
 	_STARPU_CALLOC(handle->per_worker, nworkers, sizeof(*handle->per_worker));
 
 	size_t interfacesize = handle->ops->interface_size;
+	size_t stride = _starpu_data_interface_stride(interfacesize);
+	char *interfaces;
+
+	_STARPU_MALLOC(interfaces, nworkers * stride);
 
 	for (worker = 0; worker < nworkers; worker++)
 	{
@@ -223,11 +243,8 @@ void _starpu_data_initialize_per_worker(starpu_data_handle_t handle)
 		replicate->handle = handle;
 		//replicate->nb_tasks_prefetch = 0;
 
-		//for (node = 0; node < STARPU_MAXNODES; node++)
-		//{
-		//	replicate->request[node] = NULL;
-		//	replicate->last_request[node] = NULL;
-		//}
+		//replicate->request = NULL;
+		//replicate->last_request = NULL;
 		//replicate->load_request = NULL;
 
 		/* Assuming being used for SCRATCH for now, patched when entering REDUX mode */
@@ -236,7 +253,7 @@ void _starpu_data_initialize_per_worker(starpu_data_handle_t handle)
 		replicate->memory_node = starpu_worker_get_memory_node(worker);
 		replicate->mapped = STARPU_UNMAPPED;
 
-		_STARPU_CALLOC(replicate->data_interface, 1, interfacesize);
+		replicate->data_interface = interfaces + worker * stride;
 		/* duplicate  the content of the interface on node 0 */
 		memcpy(replicate->data_interface, handle->per_node[STARPU_MAIN_RAM].data_interface, interfacesize);
 	}
@@ -307,6 +324,10 @@ int _starpu_data_handle_init(starpu_data_handle_t handle, struct starpu_data_int
 
 	handle->ops = interface_ops;
 	size_t interfacesize = interface_ops->interface_size;
+	size_t stride = _starpu_data_interface_stride(interfacesize);
+	char *interfaces;
+
+	_STARPU_CALLOC(interfaces, STARPU_MAXNODES, stride);
 
 	for (node = 0; node < STARPU_MAXNODES; node++)
 	{
@@ -318,7 +339,7 @@ int _starpu_data_handle_init(starpu_data_handle_t handle, struct starpu_data_int
 
 		replicate->handle = handle;
 
-		_STARPU_CALLOC(replicate->data_interface, 1, interfacesize);
+		replicate->data_interface = interfaces + node * stride;
 		if (handle->ops->init) handle->ops->init(replicate->data_interface);
 	}
 
@@ -499,20 +520,18 @@ struct starpu_data_interface_ops* starpu_data_get_interface_ops(starpu_data_hand
 
 void _starpu_data_free_interfaces(starpu_data_handle_t handle)
 {
-	unsigned node;
 	unsigned nworkers = starpu_worker_get_count();
 
 	if (handle->ops->unregister_data_handle)
 		handle->ops->unregister_data_handle(handle);
 
-	for (node = 0; node < STARPU_MAXNODES; node++)
-		free(handle->per_node[node].data_interface);
+	/* The interfaces of all nodes were allocated as one block */
+	free(handle->per_node[0].data_interface);
 
 	if (handle->per_worker)
 	{
-		unsigned worker;
-		for (worker = 0; worker < nworkers; worker++)
-			free(handle->per_worker[worker].data_interface);
+		if (nworkers)
+			free(handle->per_worker[0].data_interface);
 		free(handle->per_worker);
 	}
 }
@@ -660,6 +679,7 @@ static int _starpu_ro_data_detach(starpu_data_handle_t handle)
  */
 static void _starpu_data_unregister(starpu_data_handle_t handle, unsigned coherent, unsigned nowait)
 {
+	_STARPU_TASK_FUSION_FLUSH();
 	STARPU_ASSERT(handle);
 	STARPU_ASSERT_MSG(handle->nchildren == 0, "data %p needs to be unpartitioned before unregistration", handle);
 	STARPU_ASSERT_MSG(handle->nplans == 0, "data %p needs its partition plans to be cleaned before unregistration", handle);
@@ -670,6 +690,9 @@ static void _starpu_data_unregister(starpu_data_handle_t handle, unsigned cohere
 	if (!_starpu_ro_data_detach(handle))
 		return;
 
+	if (STARPU_UNLIKELY(_starpu_data_cow_npending))
+		_starpu_data_cow_unregister(handle, coherent);
+
 	int sequential_consistency = handle->sequential_consistency;
 	if (sequential_consistency && !nowait)
 	{
@@ -838,6 +861,8 @@ retry_busy:
 
 	size_t size = _starpu_data_get_alloc_size(handle);
 
+	_starpu_dirty_track_destroy(handle);
+
 	/* Destroy the data now */
 	for (node = 0; node < STARPU_MAXNODES; node++)
 	{
@@ -935,6 +960,9 @@ void starpu_data_unregister_submit(starpu_data_handle_t handle)
 	if (!_starpu_ro_data_detach(handle))
 		return;
 
+	if (STARPU_UNLIKELY(_starpu_data_cow_npending))
+		_starpu_data_cow_unregister(handle, 1);
+
 	/* Wait for all task dependencies on this handle before putting it for free */
 	starpu_data_acquire_on_node_cb(handle, STARPU_ACQUIRE_NO_NODE_LOCK_ALL, handle->initialized?STARPU_RW:STARPU_W, _starpu_data_unregister_submit_cb, handle);
 }
@@ -944,10 +972,9 @@ static void __starpu_data_deinitialize(starpu_data_handle_t handle)
 #ifdef STARPU_DEBUG
 	{
 		/* There shouldn't be any pending request since we acquired the data in W mode */
-		unsigned i, j, nnodes = starpu_memory_nodes_get_count();
+		unsigned i, nnodes = starpu_memory_nodes_get_count();
 		for (i = 0; i < nnodes; i++)
-			for (j = 0; j < nnodes; j++)
-				STARPU_ASSERT_MSG(!handle->per_node[i].request[j], "request for handle %p pending from %u to %u while invalidating data!", handle, j, i);
+			STARPU_ASSERT_MSG(!handle->per_node[i].request, "request for handle %p pending to %u while invalidating data!", handle, i);
 	}
 #endif
 
@@ -958,7 +985,10 @@ static void __starpu_data_deinitialize(starpu_data_handle_t handle)
 		struct _starpu_data_replicate *local = &handle->per_node[node];
 
 		if (local->state != STARPU_INVALID)
+		{
 			_STARPU_TRACE_DATA_STATE_INVALID(handle, node);
+			_starpu_dirty_track_invalidate(handle, node);
+		}
 		local->state = STARPU_INVALID;
 		local->initialized = 0;
 	}
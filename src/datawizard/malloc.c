@@ -752,6 +752,55 @@ int starpu_free_noflag(void *A, size_t dim)
 	return starpu_free_flags(A, dim, STARPU_MALLOC_PINNED);
 }
 
+int _starpu_malloc_migrate_on_node(unsigned src_node, unsigned dst_node, void *A, size_t dim)
+{
+#if defined(STARPU_HAVE_HWLOC) && !defined(STARPU_SIMGRID) && HWLOC_API_VERSION >= 0x00020000
+	int src_flags = _starpu_get_node_struct(src_node)->malloc_on_node_default_flags;
+	int dst_flags = _starpu_get_node_struct(dst_node)->malloc_on_node_default_flags;
+
+	/* We can only migrate the plain NUMA allocations made by _starpu_malloc_flags_on_node */
+	if (malloc_hook
+		|| starpu_memory_nodes_get_numa_count() <= 1
+		|| _starpu_malloc_willpin_on_node(src_node)
+		|| _starpu_malloc_willpin_on_node(dst_node))
+		return -EINVAL;
+#ifdef STARPU_USE_MP
+	if (_starpu_can_submit_ms_task())
+		return -EINVAL;
+#endif
+
+	if (dim == 0)
+		dim = 1;
+
+	if (dst_flags & STARPU_MALLOC_COUNT)
+		if (starpu_memory_allocate(dst_node, dim, dst_flags) != 0)
+			return -ENOMEM;
+
+	struct _starpu_machine_config *config = _starpu_get_machine_config();
+	hwloc_topology_t hwtopology = config->topology.hwtopology;
+	hwloc_obj_t numa_node_obj = hwloc_get_obj_by_type(hwtopology, HWLOC_OBJ_NUMANODE, starpu_memory_nodes_numa_id_to_hwloclogid(dst_node));
+	if (!numa_node_obj
+		|| hwloc_set_area_membind(hwtopology, A, dim, numa_node_obj->nodeset, HWLOC_MEMBIND_BIND,
+					  HWLOC_MEMBIND_BYNODESET | HWLOC_MEMBIND_MIGRATE | HWLOC_MEMBIND_NOCPUBIND))
+	{
+		_STARPU_DEBUG("Could not migrate %lu bytes to NUMA node %u: %s\n", (unsigned long) dim, dst_node, strerror(errno));
+		if (dst_flags & STARPU_MALLOC_COUNT)
+			starpu_memory_deallocate(dst_node, dim);
+		return -EIO;
+	}
+
+	if (src_flags & STARPU_MALLOC_COUNT)
+		starpu_memory_deallocate(src_node, dim);
+	return 0;
+#else
+	(void) src_node;
+	(void) dst_node;
+	(void) A;
+	(void) dim;
+	return -ENOSYS;
+#endif
+}
+
 static uintptr_t _starpu_malloc_on_node(unsigned dst_node, size_t size, int flags)
 {
 	uintptr_t addr = 0;
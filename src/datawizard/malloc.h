@@ -38,6 +38,15 @@ int _starpu_free_flags_on_node(unsigned dst_node, void *A, size_t dim, int flags
  */
 int _starpu_malloc_willpin_on_node(unsigned dst_node) STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
 
+/**
+ * Move the pages of the buffer \p A of size \p dim, allocated on the CPU
+ * NUMA node \p src_node, to the CPU NUMA node \p dst_node, and move its
+ * memory accounting along. Returns 0 on success, or a negative error if the
+ * buffer was not allocated in a way which permits migration, or if the
+ * system refused to migrate it.
+ */
+int _starpu_malloc_migrate_on_node(unsigned src_node, unsigned dst_node, void *A, size_t dim);
+
 /**
  * On CUDA which has very expensive malloc, for small sizes, allocate big
  * chunks divided in blocks, and we actually allocate segments of consecutive
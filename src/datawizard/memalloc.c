@@ -19,6 +19,7 @@
 #include <datawizard/memory_nodes.h>
 #include <datawizard/memalloc.h>
 #include <datawizard/footprint.h>
+#include <datawizard/dirty_tracking.h>
 #include <core/disk.h>
 #include <core/topology.h>
 #include <starpu.h>
@@ -35,6 +36,8 @@ static unsigned minimum_clean_p;
 static unsigned target_clean_p;
 /* Whether CPU memory has been explicitly limited by user */
 static int limit_cpu_mem;
+/* Whether we may migrate pages between NUMA nodes instead of copying */
+static int numa_migrate;
 
 
 /* TODO: no home doesn't mean always clean, should push to larger memory nodes */
@@ -97,6 +100,26 @@ static int can_evict(unsigned node)
 	return _starpu_get_node_struct(node)->evictable;
 }
 
+/* The CLOCK reference bit is set without holding the mc_lock, only a relaxed
+ * ordering is needed since it is just a hint for the eviction sweep */
+static inline unsigned mc_referenced(struct _starpu_mem_chunk *mc)
+{
+#ifdef STARPU_HAVE_ATOMIC_FETCH_ADD
+	return __atomic_load_n(&mc->referenced, __ATOMIC_RELAXED);
+#else
+	return *(volatile unsigned *) &mc->referenced;
+#endif
+}
+
+static inline void mc_set_referenced(struct _starpu_mem_chunk *mc, unsigned referenced)
+{
+#ifdef STARPU_HAVE_ATOMIC_FETCH_ADD
+	__atomic_store_n(&mc->referenced, referenced, __ATOMIC_RELAXED);
+#else
+	*(volatile unsigned *) &mc->referenced = referenced;
+#endif
+}
+
 /* Called after initializing the set of memory nodes */
 /* We use an accelerator -> CPU RAM -> disk storage hierarchy */
 void _starpu_mem_chunk_init_last(void)
@@ -171,6 +194,7 @@ void _starpu_init_mem_chunk_lists(void)
 	minimum_clean_p = starpu_getenv_number_default("STARPU_MINIMUM_CLEAN_BUFFERS", 5);
 	target_clean_p = starpu_getenv_number_default("STARPU_TARGET_CLEAN_BUFFERS", 10);
 	limit_cpu_mem = starpu_getenv_number("STARPU_LIMIT_CPU_MEM");
+	numa_migrate = starpu_getenv_number_default("STARPU_NUMA_MIGRATE", 1);
 }
 
 void _starpu_deinit_mem_chunk_lists(void)
@@ -390,6 +414,7 @@ static void notify_handle_children(starpu_data_handle_t handle, struct _starpu_d
 {
 	unsigned child;
 
+	_starpu_dirty_track_drop(handle, node);
 	replicate->allocated = 0;
 
 	/* XXX why do we need that ? */
@@ -495,6 +520,7 @@ static void reuse_mem_chunk(unsigned node, struct _starpu_data_replicate *new_re
 	struct _starpu_data_replicate *old_replicate = mc->replicate;
 	if (old_replicate)
 	{
+		_starpu_dirty_track_drop(mc->data, old_replicate->memory_node);
 		old_replicate->mc = NULL;
 		old_replicate->allocated = 0;
 		old_replicate->automatically_allocated = 0;
@@ -875,6 +901,8 @@ static int try_to_reuse_potentially_in_use_mc(unsigned node, starpu_data_handle_
 	starpu_data_handle_t victim = NULL;
 	int success = 0;
 	struct _starpu_node *node_struct = _starpu_get_node_struct(node);
+	/* Number of chunks which may still get a second chance */
+	unsigned second_chances;
 
 	if (is_prefetch >= STARPU_IDLEFETCH)
 		/* Do not evict a MC just for an idle fetch */
@@ -914,9 +942,13 @@ static int try_to_reuse_potentially_in_use_mc(unsigned node, starpu_data_handle_
 	 * remembering the next mc to be tried. If it gets dropped, we restart
 	 * from zero. So we continue until we go through the whole list without
 	 * finding anything to free.
+	 *
+	 * Recently used chunks get a second chance, as in
+	 * free_potentially_in_use_mc.
 	 */
 
 	_starpu_spin_lock(&node_struct->mc_lock);
+	second_chances = node_struct->mc_nb;
 
 restart:
 	for (mc = _starpu_mem_chunk_list_begin(&node_struct->mc_list);
@@ -936,6 +968,18 @@ restart:
 		if (mc->footprint != footprint || _starpu_data_interface_compare(handle->per_node[node].data_interface, handle->ops, mc->data->per_node[node].data_interface, mc->ops) != 1)
 			/* Not the right type of interface, skip */
 			continue;
+		if (!victim && mc_referenced(mc) && second_chances)
+		{
+			/* Recently used, give it a second chance */
+			second_chances--;
+			mc_set_referenced(mc, 0);
+			if (next_mc)
+			{
+				MC_LIST_ERASE(node_struct, mc);
+				MC_LIST_PUSH_BACK(node_struct, mc);
+			}
+			continue;
+		}
 		if (next_mc)
 		{
 			if (next_mc->remove_notify)
@@ -1030,6 +1074,8 @@ static size_t free_potentially_in_use_mc(unsigned node, unsigned force, size_t r
 	struct _starpu_node *node_struct = _starpu_get_node_struct(node);
 
 	struct _starpu_mem_chunk *mc, *next_mc;
+	/* Number of chunks which may still get a second chance */
+	unsigned second_chances;
 
 	if (!force && victim_selector)
 	{
@@ -1052,10 +1098,20 @@ static size_t free_potentially_in_use_mc(unsigned node, unsigned force, size_t r
 	 * remembering the next mc to be tried. If it gets dropped, we restart
 	 * from zero. So we continue until we go through the whole list without
 	 * finding anything to free.
+	 *
+	 * The head of the list acts as the hand of a CLOCK: chunks which were
+	 * used since the hand last passed them get their reference bit
+	 * cleared and are moved to the tail instead of being evicted. This is
+	 * bounded to one lap over the list, after which reference bits are
+	 * ignored, so that concurrent accesses cannot keep us spinning.
 	 */
 
 restart:
 	_starpu_spin_lock(&node_struct->mc_lock);
+	/* Only the force path jumps back to restart, and it does not give
+	 * second chances, so this is set once per sweep. The non-force path
+	 * restarts from restart2 and keeps the remaining budget. */
+	second_chances = node_struct->mc_nb;
 
 restart2:
 	for (mc = _starpu_mem_chunk_list_begin(&node_struct->mc_list);
@@ -1075,6 +1131,18 @@ restart2:
 			if (victim && mc->data != victim)
 				/* We were advised some precise data */
 				continue;
+			if (!victim && mc_referenced(mc) && second_chances)
+			{
+				/* Recently used, give it a second chance */
+				second_chances--;
+				mc_set_referenced(mc, 0);
+				if (next_mc)
+				{
+					MC_LIST_ERASE(node_struct, mc);
+					MC_LIST_PUSH_BACK(node_struct, mc);
+				}
+				continue;
+			}
 			if (next_mc)
 			{
 				if (next_mc->remove_notify)
@@ -1230,11 +1298,13 @@ void starpu_memchunk_tidy(unsigned node)
 	{
 		struct _starpu_mem_chunk *mc, *orig_next_mc, *next_mc;
 		int skipped = 0;	/* Whether we skipped a dirty MC, and we should thus stop updating mc_dirty_head. */
+		unsigned second_chances;	/* Number of MCs which may still get a second chance */
 
 		/* _STARPU_DEBUG("%d not clean: %d %d\n", node, node_struct->mc_clean_nb, node_struct->mc_nb); */
 
 		_STARPU_TRACE_START_WRITEBACK_ASYNC(node);
 		_starpu_spin_lock(&node_struct->mc_lock);
+		second_chances = node_struct->mc_nb;
 
 		for (mc = node_struct->mc_dirty_head;
 			mc && node_struct->mc_clean_nb < (node_struct->mc_nb * target_clean_p) / 100;
@@ -1252,6 +1322,20 @@ void starpu_memchunk_tidy(unsigned node)
 			if (mc->clean)
 				/* already clean */
 				continue;
+			if (mc_referenced(mc) && second_chances)
+			{
+				/* Recently used, it would probably get dirty
+				 * again, give it a second chance as in
+				 * free_potentially_in_use_mc. */
+				second_chances--;
+				mc_set_referenced(mc, 0);
+				if (next_mc && !mc->remove_notify)
+				{
+					MC_LIST_ERASE(node_struct, mc);
+					MC_LIST_PUSH_BACK(node_struct, mc);
+				}
+				continue;
+			}
 			if (next_mc && next_mc->remove_notify)
 			{
 				/* Somebody already working here, skip */
@@ -1446,6 +1530,7 @@ static struct _starpu_mem_chunk *_starpu_memchunk_init(struct _starpu_data_repli
 	mc->size_interface = interface_size;
 	mc->remove_notify = NULL;
 	mc->wontuse = 0;
+	mc->referenced = 0;
 
 	return mc;
 }
@@ -1487,6 +1572,8 @@ void _starpu_request_mem_chunk_removal(starpu_data_handle_t handle, struct _star
 	 * by freeing this.  */
 	mc->size = size;
 
+	_starpu_dirty_track_drop(handle, node);
+
 	/* This memchunk doesn't have to do with the data any more. */
 	replicate->mc = NULL;
 	mc->replicate = NULL;
@@ -1828,6 +1915,92 @@ int _starpu_allocate_memory_on_node(starpu_data_handle_t handle, struct _starpu_
 	return 0;
 }
 
+/* The source replicate is about to be invalidated by a write on the
+ * destination node: instead of allocating a buffer there and copying, try to
+ * migrate the pages of the source buffer to the destination NUMA node, and
+ * hand the buffer over to the destination replicate. */
+int _starpu_migrate_memory_on_node(starpu_data_handle_t handle, struct _starpu_data_replicate *src_replicate, struct _starpu_data_replicate *dst_replicate)
+{
+	unsigned src_node = src_replicate->memory_node;
+	unsigned dst_node = dst_replicate->memory_node;
+	struct _starpu_mem_chunk *mc = src_replicate->mc;
+	unsigned node;
+	int ret;
+
+	_starpu_spin_checklocked(&handle->header_lock);
+
+	if (!numa_migrate
+		|| src_node == dst_node
+		|| starpu_node_get_kind(src_node) != STARPU_CPU_RAM
+		|| starpu_node_get_kind(dst_node) != STARPU_CPU_RAM)
+		return -EINVAL;
+
+	switch (handle->ops->interfaceid)
+	{
+		/* These are allocated as only one buffer of the alloc size */
+		case STARPU_MATRIX_INTERFACE_ID:
+		case STARPU_BLOCK_INTERFACE_ID:
+		case STARPU_VECTOR_INTERFACE_ID:
+		case STARPU_VARIABLE_INTERFACE_ID:
+		case STARPU_TENSOR_INTERFACE_ID:
+		case STARPU_NDIM_INTERFACE_ID:
+			break;
+		default:
+			return -EINVAL;
+	}
+
+	/* We have to be the only user of a buffer allocated by StarPU */
+	if (!mc || !src_replicate->automatically_allocated
+		|| src_replicate->mapped != STARPU_UNMAPPED
+		|| src_replicate->refcnt != 1
+		|| src_replicate->relaxed_coherency
+		|| (int) src_node == handle->home_node
+		|| (int) dst_node == handle->home_node
+		|| handle->nchildren || handle->parent_handle
+		|| (src_node < sizeof(handle->wt_mask) * 8 && handle->wt_mask & (1<<src_node)))
+		return -EINVAL;
+	for (node = 0; node < STARPU_MAXNODES; node++)
+		if (handle->per_node[node].mapped == (int) src_node)
+			return -EINVAL;
+
+	ret = _starpu_malloc_migrate_on_node(src_node, dst_node,
+					     handle->ops->to_pointer(src_replicate->data_interface, src_node),
+					     _starpu_data_get_alloc_size(handle));
+	if (ret)
+		return ret;
+
+	if (handle->ops->reuse_data_on_node)
+		handle->ops->reuse_data_on_node(dst_replicate->data_interface, src_replicate->data_interface, dst_node);
+	else
+		memcpy(dst_replicate->data_interface, src_replicate->data_interface, handle->ops->interface_size);
+
+	struct _starpu_node *src_node_struct = _starpu_get_node_struct(src_node);
+	struct _starpu_node *dst_node_struct = _starpu_get_node_struct(dst_node);
+
+	_starpu_spin_lock(&src_node_struct->mc_lock);
+	MC_LIST_ERASE(src_node_struct, mc);
+	_starpu_spin_unlock(&src_node_struct->mc_lock);
+
+	mc->replicate = dst_replicate;
+	mc->wontuse = 0;
+	dst_replicate->mc = mc;
+	dst_replicate->allocated = 1;
+	dst_replicate->automatically_allocated = 1;
+	dst_replicate->initialized = src_replicate->initialized;
+
+	_starpu_dirty_track_drop(handle, src_node);
+	src_replicate->mc = NULL;
+	src_replicate->allocated = 0;
+	src_replicate->automatically_allocated = 0;
+	src_replicate->initialized = 0;
+
+	_starpu_spin_lock(&dst_node_struct->mc_lock);
+	MC_LIST_PUSH_BACK(dst_node_struct, mc);
+	_starpu_spin_unlock(&dst_node_struct->mc_lock);
+
+	return 0;
+}
+
 unsigned starpu_data_test_if_allocated_on_node(starpu_data_handle_t handle, unsigned memory_node)
 {
 	return handle->per_node[memory_node].allocated || handle->per_node[memory_node].mapped != STARPU_UNMAPPED;
@@ -1839,8 +2012,9 @@ unsigned starpu_data_test_if_mapped_on_node(starpu_data_handle_t handle, unsigne
 	return handle->per_node[memory_node].allocated;
 }
 
-/* This memchunk has been recently used, put it last on the mc_list, so we will
- * try to evict it as late as possible */
+/* This memchunk has been recently used, mark it so that the eviction sweep
+ * gives it a second chance. This is called on every access, so it does not
+ * take the mc_lock */
 void _starpu_memchunk_recently_used(struct _starpu_mem_chunk *mc, unsigned node)
 {
 	if (!mc)
@@ -1850,12 +2024,18 @@ void _starpu_memchunk_recently_used(struct _starpu_mem_chunk *mc, unsigned node)
 	if (!can_evict(node))
 		/* Don't bother */
 		return;
-	struct _starpu_node *node_struct = _starpu_get_node_struct(node);
-	_starpu_spin_lock(&node_struct->mc_lock);
-	MC_LIST_ERASE(node_struct, mc);
-	mc->wontuse = 0;
-	MC_LIST_PUSH_BACK(node_struct, mc);
-	_starpu_spin_unlock(&node_struct->mc_lock);
+	/* Just set the reference bit, free_potentially_in_use_mc will move
+	 * the chunk away from the eviction side of the list when it comes
+	 * across it. Avoid dirtying the cache line when it is already set. */
+	if (!mc_referenced(mc))
+		mc_set_referenced(mc, 1);
+	if (STARPU_UNLIKELY(mc->wontuse))
+	{
+		struct _starpu_node *node_struct = _starpu_get_node_struct(node);
+		_starpu_spin_lock(&node_struct->mc_lock);
+		mc->wontuse = 0;
+		_starpu_spin_unlock(&node_struct->mc_lock);
+	}
 }
 
 /* This memchunk will not be used in the close future, put it on the clean
@@ -1872,6 +2052,7 @@ void _starpu_memchunk_wont_use(struct _starpu_mem_chunk *mc, unsigned node)
 	struct _starpu_node *node_struct = _starpu_get_node_struct(node);
 	_starpu_spin_lock(&node_struct->mc_lock);
 	mc->wontuse = 1;
+	mc_set_referenced(mc, 0);
 	if (mc->data && mc->data->home_node != -1)
 	{
 		MC_LIST_ERASE(node_struct, mc);
@@ -64,6 +64,11 @@ LIST_TYPE(_starpu_mem_chunk,
 	unsigned clean:1;
 	/** Was this chunk marked as "won't use"? */
 	unsigned wontuse:1;
+	/** CLOCK reference bit: set without holding the mc_lock when the chunk
+	 * gets used, cleared by the eviction sweep which then gives the chunk a
+	 * second chance. Not a bitfield so that it can be accessed with relaxed
+	 * atomic loads and stores. */
+	unsigned referenced;
 
 	/** the size of the data is only set when calling _starpu_request_mem_chunk_removal(),
 	 * it is needed to estimate how much memory is in mc_cache, and by
@@ -87,6 +92,7 @@ void _starpu_deinit_mem_chunk_lists(void);
 void _starpu_mem_chunk_init_last(void);
 void _starpu_request_mem_chunk_removal(starpu_data_handle_t handle, struct _starpu_data_replicate *replicate, unsigned node, size_t size);
 int _starpu_allocate_memory_on_node(starpu_data_handle_t handle, struct _starpu_data_replicate *replicate, enum starpu_is_prefetch is_prefetch, int only_fast_alloc);
+int _starpu_migrate_memory_on_node(starpu_data_handle_t handle, struct _starpu_data_replicate *src_replicate, struct _starpu_data_replicate *dst_replicate);
 size_t _starpu_free_all_automatically_allocated_buffers(unsigned node);
 void _starpu_memchunk_recently_used(struct _starpu_mem_chunk *mc, unsigned node);
 void _starpu_memchunk_wont_use(struct _starpu_mem_chunk *m, unsigned nodec);
@@ -18,12 +18,14 @@
 #include <common/config.h>
 #include <common/utils.h>
 #include <core/task.h>
+#include <core/task_fusion.h>
 #include <datawizard/coherency.h>
 #include <datawizard/copy_driver.h>
 #include <datawizard/write_back.h>
 #include <core/dependencies/data_concurrency.h>
 #include <core/sched_policy.h>
 #include <datawizard/memory_nodes.h>
+#include <util/starpu_data_cpy.h>
 
 static void _starpu_data_check_initialized(starpu_data_handle_t handle, enum starpu_data_access_mode mode)
 {
@@ -198,10 +200,14 @@ int starpu_data_acquire_on_node_cb_sequential_consistency_sync_jobids(starpu_dat
 							  int sequential_consistency, int quick,
 							  long *pre_sync_jobid, long *post_sync_jobid, int prio)
 {
+	_STARPU_TASK_FUSION_FLUSH();
 	STARPU_ASSERT(handle);
 	STARPU_ASSERT_MSG(handle->nchildren == 0, "Acquiring a partitioned data (%p) is not possible", handle);
 	_STARPU_LOG_IN();
 
+	/* Get the value of deferred copies */
+	_starpu_data_cow_check(handle, mode);
+
 	/* Check that previous tasks have set a value if needed */
 	_starpu_data_check_initialized(handle, mode);
 
@@ -345,6 +351,7 @@ static inline void _starpu_data_acquire_continuation(void *arg)
 /* The data must be released by calling starpu_data_release later on */
 int starpu_data_acquire_on_node(starpu_data_handle_t handle, int node, enum starpu_data_access_mode mode)
 {
+	_STARPU_TASK_FUSION_FLUSH();
 	STARPU_ASSERT(handle);
 	STARPU_ASSERT_MSG(handle->nchildren == 0, "Acquiring a partitioned data is not possible");
 	_STARPU_LOG_IN();
@@ -352,6 +359,9 @@ int starpu_data_acquire_on_node(starpu_data_handle_t handle, int node, enum star
 	/* unless asynchronous, it is forbidden to call this function from a callback or a codelet */
 	STARPU_ASSERT_MSG(_starpu_worker_may_perform_blocking_calls(), "Acquiring a data synchronously is not possible from a codelet or from a task callback, use starpu_data_acquire_cb instead.");
 
+	/* Get the value of deferred copies */
+	_starpu_data_cow_check(handle, mode);
+
 	/* Check that previous tasks have set a value if needed */
 	_starpu_data_check_initialized(handle, mode);
 
@@ -454,11 +464,15 @@ int starpu_data_acquire(starpu_data_handle_t handle, enum starpu_data_access_mod
 
 int starpu_data_acquire_on_node_try(starpu_data_handle_t handle, int node, enum starpu_data_access_mode mode)
 {
+	_STARPU_TASK_FUSION_FLUSH();
 	STARPU_ASSERT(handle);
 	STARPU_ASSERT_MSG(handle->nchildren == 0, "Acquiring a partitioned data is not possible");
 	/* it is forbidden to call this function from a callback or a codelet */
 	STARPU_ASSERT_MSG(_starpu_worker_may_perform_blocking_calls(), "Acquiring a data synchronously is not possible from a codelet or from a task callback, use starpu_data_acquire_cb instead.");
 
+	/* Get the value of deferred copies */
+	_starpu_data_cow_check(handle, mode);
+
 	/* Check that previous tasks have set a value if needed */
 	_starpu_data_check_initialized(handle, mode);
 
@@ -777,6 +791,10 @@ void starpu_data_advise_as_important(starpu_data_handle_t handle, unsigned is_im
 
 void starpu_data_set_sequential_consistency_flag(starpu_data_handle_t handle, unsigned flag)
 {
+	if (!flag && STARPU_UNLIKELY(_starpu_data_cow_npending))
+		/* Deferred copies rely on implicit dependencies */
+		_starpu_data_cow_materialize(handle);
+
 	_starpu_spin_lock(&handle->header_lock);
 
 	unsigned child;
@@ -839,21 +857,7 @@ void starpu_data_query_status2(starpu_data_handle_t handle, int memory_node, int
 		*is_loading = handle->per_node[memory_node].load_request != NULL;
 
 	if (is_requested)
-	{
-		int requested = 0;
-
-		unsigned node;
-		for (node = 0; node < STARPU_MAXNODES; node++)
-		{
-			if (handle->per_node[memory_node].request[node])
-			{
-				requested = 1;
-				break;
-			}
-		}
-
-		*is_requested = requested;
-	}
+		*is_requested = handle->per_node[memory_node].request != NULL;
 
 //	_starpu_spin_unlock(&handle->header_lock);
 }
@@ -101,6 +101,14 @@ void _starpu_cpu_preinit(void)
 	already_busy_cpus = 0;
 }
 
+/* Whether CPU workers get one performance model arch per kind of core */
+static unsigned perf_model_cpukinds;
+
+unsigned _starpu_cpu_perf_model_cpukinds(void)
+{
+	return perf_model_cpukinds;
+}
+
 void _starpu_cpu_busy_cpu(unsigned num)
 {
 	already_busy_cpus += num;
@@ -128,6 +136,9 @@ void _starpu_init_cpu_config(struct _starpu_machine_topology *topology, struct _
 
 	topology->ndevices[STARPU_CPU_WORKER] = 1;
 	unsigned homogeneous = starpu_getenv_number_default("STARPU_PERF_MODEL_HOMOGENEOUS_CPU", 1);
+	/* The kind of core is only known once workers are bound */
+	perf_model_cpukinds = homogeneous && topology->ncpukinds > 1
+		&& starpu_getenv_number_default("STARPU_PERF_MODEL_CPU_KINDS", 1);
 
 	_starpu_topology_configure_workers(topology, config,
 					   STARPU_CPU_WORKER,
@@ -141,6 +152,10 @@ void _starpu_cpu_init_worker_binding(struct _starpu_machine_config *config STARP
 {
 	/* Dedicate a cpu core to that worker */
 	workerarg->bindid = _starpu_get_next_bindid(config, STARPU_THREAD_ACTIVE, NULL, 0);;
+
+	if (perf_model_cpukinds)
+		/* Distinguish performance models between kinds of cores */
+		workerarg->perf_arch.devices[0].devid = _starpu_get_cpukind(config, workerarg->bindid);
 }
 
 /* Set up memory and buses */
@@ -186,6 +201,22 @@ int _starpu_cpu_driver_init(struct _starpu_worker *cpu_worker)
 	snprintf(cpu_worker->short_name, sizeof(cpu_worker->short_name), "CPU %d", devid);
 	starpu_pthread_setname(cpu_worker->short_name);
 
+	int pipeline_length = starpu_getenv_number_default("STARPU_CPU_PIPELINE", 0);
+	if (pipeline_length < 0)
+	{
+		_STARPU_DISP("Warning: STARPU_CPU_PIPELINE is %d, using 0\n", pipeline_length);
+		pipeline_length = 0;
+	}
+	else if (pipeline_length > STARPU_MAX_PIPELINE)
+	{
+		_STARPU_DISP("Warning: STARPU_CPU_PIPELINE is %d, but STARPU_MAX_PIPELINE is only %d\n", pipeline_length, STARPU_MAX_PIPELINE);
+		pipeline_length = STARPU_MAX_PIPELINE;
+	}
+	cpu_worker->pipeline_length = pipeline_length;
+	/* CPU kernels are synchronous, what we can overlap is only the input
+	 * transfers of the next tasks with the execution of the current one */
+	cpu_worker->pipeline_fetch_ahead = cpu_worker->pipeline_length > 1;
+
 #ifdef STARPU_NOSV
 	{
 		_STARPU_DISP("nOS-V: nosv_attach to %s\n", cpu_worker->short_name);
@@ -629,6 +660,35 @@ static int _starpu_cpu_driver_execute_task(struct _starpu_worker *cpu_worker, st
 	return 0;
 }
 
+/* The task at the head of the pipeline was executed, drop it */
+static void _starpu_cpu_driver_pipeline_pop(struct _starpu_worker *cpu_worker)
+{
+	STARPU_ASSERT(cpu_worker->ntasks > 0);
+	cpu_worker->current_tasks[cpu_worker->first_task] = NULL;
+	cpu_worker->first_task = (cpu_worker->first_task + 1) % STARPU_MAX_PIPELINE;
+	cpu_worker->ntasks--;
+}
+
+/* Queue a task at the tail of the pipeline. If it is not going to be started
+ * right away, start fetching its input so that it overlaps with the transfers
+ * and execution of the tasks ahead of it. */
+static void _starpu_cpu_driver_pipeline_push(struct _starpu_worker *cpu_worker, struct starpu_task *task, struct _starpu_job *j)
+{
+	STARPU_ASSERT(cpu_worker->ntasks < cpu_worker->pipeline_length);
+	cpu_worker->current_tasks[(cpu_worker->first_task + cpu_worker->ntasks) % STARPU_MAX_PIPELINE] = task;
+	cpu_worker->ntasks++;
+
+	if (cpu_worker->ntasks > 1
+		/* Parallel tasks and OpenMP continuations do not fetch their input through us */
+		&& j->task_size == 1
+#ifdef STARPU_OPENMP
+		&& !j->discontinuous
+#endif
+		/* The scheduler may have already prefetched it */
+		&& !task->prefetched)
+		starpu_prefetch_task_input_for(task, cpu_worker->workerid);
+}
+
 /* One iteration of the main driver loop */
 int _starpu_cpu_driver_run_once(struct _starpu_worker *cpu_worker)
 {
@@ -664,6 +724,8 @@ int _starpu_cpu_driver_run_once(struct _starpu_worker *cpu_worker)
 		cpu_worker->task_transferring = NULL;
 
 		ret = _starpu_cpu_driver_execute_task(cpu_worker, pending_task, j);
+		if (cpu_worker->pipeline_length)
+			_starpu_cpu_driver_pipeline_pop(cpu_worker);
 		_STARPU_TRACE_START_PROGRESS(memnode);
 #ifdef STARPU_PROF_TOOL
 		pi = _starpu_prof_tool_get_info_d(starpu_prof_tool_event_start_transfer, workerid, workerid, starpu_prof_tool_driver_cpu, memnode, cpu_worker->nb_buffers_totransfer, cpu_worker->nb_buffers_transferred);
@@ -674,9 +736,29 @@ int _starpu_cpu_driver_run_once(struct _starpu_worker *cpu_worker)
 
 	res = __starpu_datawizard_progress(_STARPU_DATAWIZARD_DO_ALLOC, 1);
 
-	if (!pending_task)
+	if (!pending_task || (cpu_worker->pipeline_fetch_ahead && cpu_worker->ntasks < cpu_worker->pipeline_length))
 		task = _starpu_get_worker_task(cpu_worker, workerid, memnode);
 
+	if (cpu_worker->pipeline_length)
+	{
+		if (task)
+		{
+			j = _starpu_get_job_associated_to_task(task);
+			if (!_STARPU_MAY_PERFORM(j, CPU))
+			{
+				_starpu_push_task_to_workers(task);
+				return 0;
+			}
+			_starpu_cpu_driver_pipeline_push(cpu_worker, task, j);
+		}
+
+		/* Start the task at the head of the pipeline, if not already */
+		if (!cpu_worker->task_transferring && cpu_worker->ntasks)
+			task = cpu_worker->current_tasks[cpu_worker->first_task];
+		else
+			task = NULL;
+	}
+
 #ifdef STARPU_SIMGRID
 #ifndef STARPU_OPENMP
 	if (!res && !task)
@@ -712,9 +794,9 @@ int _starpu_cpu_driver_run_once(struct _starpu_worker *cpu_worker)
 	 * job. */
 
 	/* can a cpu perform that task ? */
-	if (!_STARPU_MAY_PERFORM(j, CPU))
+	if (!cpu_worker->pipeline_length && !_STARPU_MAY_PERFORM(j, CPU))
 	{
-		/* put it and the end of the queue ... XXX */
+		/* put it at the end of the queue ... XXX */
 		_starpu_push_task_to_workers(task);
 		return 0;
 	}
@@ -754,6 +836,8 @@ int _starpu_cpu_driver_run_once(struct _starpu_worker *cpu_worker)
 	else
 	{
 		int ret = _starpu_cpu_driver_execute_task(cpu_worker, task, j);
+		if (cpu_worker->pipeline_length)
+			_starpu_cpu_driver_pipeline_pop(cpu_worker);
 #ifdef STARPU_PROF_TOOL
 		pi = _starpu_prof_tool_get_info(starpu_prof_tool_event_end_transfer, workerid, cpu_worker->workerid, starpu_prof_tool_driver_cpu, memnode, NULL);
 		/* pi.model_name = _starpu_job_get_model_name(j);
@@ -32,6 +32,9 @@ extern struct _starpu_node_ops _starpu_driver_cpu_node_ops;
 
 /* Reserve one CPU core as busy for starting a driver thread */
 void _starpu_cpu_busy_cpu(unsigned num);
+/** Whether CPU workers get one performance model arch per kind of core, their
+ * device id being the kind */
+unsigned _starpu_cpu_perf_model_cpukinds(void);
 
 void _starpu_init_cpu_config(struct _starpu_machine_topology *topology, struct _starpu_machine_config *config);
 void _starpu_cpu_init_worker_binding(struct _starpu_machine_config *config, int no_mp_config STARPU_ATTRIBUTE_UNUSED, struct _starpu_worker *workerarg);
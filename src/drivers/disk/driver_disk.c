@@ -22,6 +22,7 @@
 #include <drivers/cpu/driver_cpu.h>
 #include <datawizard/coherency.h>
 #include <datawizard/memory_nodes.h>
+#include <datawizard/dirty_tracking.h>
 
 static struct _starpu_memory_driver_info memory_driver_info =
 {
@@ -188,6 +189,12 @@ int _starpu_disk_copy_interface_from_cpu_to_disk(starpu_data_handle_t handle, vo
 		disk_event->handle = NULL;
 	}
 
+	/* Only write what was modified since the disk copy was up to date */
+	ret = _starpu_dirty_track_write_back(handle, src_interface, src_node, dst_interface, dst_node, req && !starpu_asynchronous_copy_disabled() ? &req->async_channel : NULL);
+	if (ret != -ENOTSUP)
+		return ret;
+	ret = 0;
+
 	if(copy_methods->any_to_any)
 		ret = copy_methods->any_to_any(src_interface, src_node, dst_interface, dst_node, req && !starpu_asynchronous_copy_disabled() ? &req->async_channel : NULL);
 	else
@@ -238,6 +245,62 @@ int _starpu_disk_copy_data_from_cpu_to_disk(uintptr_t src, size_t src_offset, in
 					     size, async_channel);
 }
 
+int _starpu_disk_copy2d_data_from_disk_to_cpu(uintptr_t src, size_t src_offset, int src_dev, uintptr_t dst, size_t dst_offset, int dst_dev, size_t blocksize, size_t numblocks, size_t ld_src, size_t ld_dst, struct _starpu_async_channel *async_channel)
+{
+	return _starpu_disk_read2d(src_dev, dst_dev, (void*) src, (void*) (dst + dst_offset), src_offset,
+				   blocksize, numblocks, ld_src, ld_dst, async_channel);
+}
+
+int _starpu_disk_copy2d_data_from_cpu_to_disk(uintptr_t src, size_t src_offset, int src_dev, uintptr_t dst, size_t dst_offset, int dst_dev, size_t blocksize, size_t numblocks, size_t ld_src, size_t ld_dst, struct _starpu_async_channel *async_channel)
+{
+	return _starpu_disk_write2d(src_dev, dst_dev, (void*) dst, (void*) (src + src_offset), dst_offset,
+				    blocksize, numblocks, ld_dst, ld_src, async_channel);
+}
+
+/* The disk backends only know about 2D requests, so issue one per 2D layer,
+ * or only one if the layers are themselves made of contiguous blocks */
+int _starpu_disk_copy3d_data_from_disk_to_cpu(uintptr_t src, size_t src_offset, int src_dev, uintptr_t dst, size_t dst_offset, int dst_dev, size_t blocksize, size_t numblocks_1, size_t ld1_src, size_t ld1_dst, size_t numblocks_2, size_t ld2_src, size_t ld2_dst, struct _starpu_async_channel *async_channel)
+{
+	size_t i;
+	int ret = 0;
+
+	if (ld1_src == blocksize && ld1_dst == blocksize)
+		return _starpu_disk_read2d(src_dev, dst_dev, (void*) src, (void*) (dst + dst_offset), src_offset,
+					   blocksize * numblocks_1, numblocks_2, ld2_src, ld2_dst, async_channel);
+
+	for (i = 0; i < numblocks_2; i++)
+	{
+		int err = _starpu_disk_read2d(src_dev, dst_dev, (void*) src, (void*) (dst + dst_offset + i*ld2_dst), src_offset + i*ld2_src,
+					      blocksize, numblocks_1, ld1_src, ld1_dst, async_channel);
+		if (err == -EAGAIN)
+			ret = -EAGAIN;
+		else if (err)
+			return err;
+	}
+	return ret;
+}
+
+int _starpu_disk_copy3d_data_from_cpu_to_disk(uintptr_t src, size_t src_offset, int src_dev, uintptr_t dst, size_t dst_offset, int dst_dev, size_t blocksize, size_t numblocks_1, size_t ld1_src, size_t ld1_dst, size_t numblocks_2, size_t ld2_src, size_t ld2_dst, struct _starpu_async_channel *async_channel)
+{
+	size_t i;
+	int ret = 0;
+
+	if (ld1_src == blocksize && ld1_dst == blocksize)
+		return _starpu_disk_write2d(src_dev, dst_dev, (void*) dst, (void*) (src + src_offset), dst_offset,
+					    blocksize * numblocks_1, numblocks_2, ld2_dst, ld2_src, async_channel);
+
+	for (i = 0; i < numblocks_2; i++)
+	{
+		int err = _starpu_disk_write2d(src_dev, dst_dev, (void*) dst, (void*) (src + src_offset + i*ld2_src), dst_offset + i*ld2_dst,
+					       blocksize, numblocks_1, ld1_dst, ld1_src, async_channel);
+		if (err == -EAGAIN)
+			ret = -EAGAIN;
+		else if (err)
+			return err;
+	}
+	return ret;
+}
+
 int _starpu_disk_is_direct_access_supported(unsigned node, unsigned handling_node)
 {
 	/* Each worker can manage disks but disk <-> disk is not always allowed */
@@ -277,7 +340,11 @@ struct _starpu_node_ops _starpu_driver_disk_node_ops =
 	.copy_data_from[STARPU_CPU_RAM] = _starpu_disk_copy_data_from_cpu_to_disk,
 	.copy_data_from[STARPU_DISK_RAM] = _starpu_disk_copy_data_from_disk_to_disk,
 
-	/* TODO: copy2D/3D? */
+	.copy2d_data_to[STARPU_CPU_RAM] = _starpu_disk_copy2d_data_from_disk_to_cpu,
+	.copy2d_data_from[STARPU_CPU_RAM] = _starpu_disk_copy2d_data_from_cpu_to_disk,
+
+	.copy3d_data_to[STARPU_CPU_RAM] = _starpu_disk_copy3d_data_from_disk_to_cpu,
+	.copy3d_data_from[STARPU_CPU_RAM] = _starpu_disk_copy3d_data_from_cpu_to_disk,
 
 	.wait_request_completion = _starpu_disk_wait_request_completion,
 	.test_request_completion = _starpu_disk_test_request_completion,
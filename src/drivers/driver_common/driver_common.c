@@ -446,8 +446,9 @@ struct starpu_task *_starpu_get_worker_task(struct _starpu_worker *worker, int w
 	/*if the worker is already executing a task then */
 	if (worker->pipeline_length && (worker->ntasks == worker->pipeline_length || worker->pipeline_stuck))
 		task = NULL;
-	/* don't push a task if we are already transferring one */
-	else if (worker->task_transferring != NULL)
+	/* don't push a task if we are already transferring one, unless the
+	 * driver can start fetching its input ahead */
+	else if (worker->task_transferring != NULL && !worker->pipeline_fetch_ahead)
 		task = NULL;
 	/*else try to pop a task*/
 	else
@@ -253,6 +253,9 @@ static inline void _starpu_worker_task_list_add(struct _starpu_worker_task_list
 	if(!isnan(predicted_transfer))
 		l->exp_len += predicted_transfer;
 
+	/* The task will start after the previous ones and its transfers */
+	task->predicted_start = l->exp_start + l->exp_len;
+
 	if(!isnan(predicted))
 		l->exp_len += predicted;
 
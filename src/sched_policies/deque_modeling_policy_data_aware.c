@@ -349,6 +349,9 @@ static int push_task_on_best_worker(struct starpu_task *task, int best_workerid,
 
 	}
 
+	/* The task will start after the previous ones and its transfers */
+	double predicted_start = fifo->exp_start + fifo->exp_len;
+
 	if(!isnan(predicted))
 	{
 		fifo->exp_len += predicted;
@@ -367,6 +370,7 @@ static int push_task_on_best_worker(struct starpu_task *task, int best_workerid,
 
 	task->predicted = predicted;
 	task->predicted_transfer = predicted_transfer;
+	task->predicted_start = predicted_start;
 
 	if (starpu_get_prefetch_flag())
 		starpu_prefetch_task_input_for(task, best_workerid);
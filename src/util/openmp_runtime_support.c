@@ -43,16 +43,19 @@ starpu_pthread_key_t _starpu_omp_task_key;
 struct starpu_omp_global *_starpu_omp_global_state = NULL;
 double _starpu_omp_clock_ref = 0.0; /* clock reference for starpu_omp_get_wtick */
 
-/* Entry in the `registered_handles' hash table.  */
+/* Entry in the `registered_handles' hash table and `registered_ranges' tree.  */
 struct handle_entry
 {
+	struct starpu_rbtree_node node; /* Keep this first so range_entry can work.  */
 	UT_hash_handle hh;
 	void *pointer;
+	size_t size;
 	starpu_data_handle_t handle;
 };
 
 
 static struct handle_entry *registered_handles;
+static struct starpu_omp_ranges registered_ranges;
 static struct _starpu_spinlock    registered_handles_lock;
 
 static struct starpu_omp_critical *create_omp_critical_struct(void);
@@ -393,20 +396,129 @@ static struct starpu_omp_thread *create_omp_thread_struct(struct starpu_omp_regi
 
 static void destroy_omp_thread_struct(struct starpu_omp_thread *thread)
 {
+	unsigned i;
 	STARPU_ASSERT(thread->current_task == NULL);
+	for (i = 0; i < thread->ncached_stacks; i++)
+		free(thread->cached_stacks[i]);
 	memset(thread, 0, sizeof(*thread));
 	starpu_omp_thread_delete(thread);
 }
 
+static inline struct handle_entry *range_entry(struct starpu_rbtree_node *node)
+{
+	return (struct handle_entry *) node;
+}
+
+static inline int range_cmp_insert(struct starpu_rbtree_node *a, struct starpu_rbtree_node *b)
+{
+	struct handle_entry *entry_a = range_entry(a);
+	struct handle_entry *entry_b = range_entry(b);
+
+	if (entry_a->pointer != entry_b->pointer)
+		return (uintptr_t) entry_a->pointer < (uintptr_t) entry_b->pointer ? -1 : 1;
+	/* Shadowed mappings have the same pointer */
+	return (uintptr_t) entry_a < (uintptr_t) entry_b ? -1 : 1;
+}
+
+/* Never matches, so that starpu_rbtree_lookup_nearest returns the first entry
+ * starting at or after PTR */
+static inline int range_cmp_lookup(uintptr_t ptr, struct starpu_rbtree_node *node)
+{
+	return ptr <= (uintptr_t) range_entry(node)->pointer ? -1 : 1;
+}
+
+static void ranges_add(struct starpu_omp_ranges *ranges, struct handle_entry *entry)
+{
+	starpu_rbtree_node_init(&entry->node);
+	starpu_rbtree_insert(&ranges->tree, &entry->node, range_cmp_insert);
+	if (entry->size > ranges->max_size)
+		ranges->max_size = entry->size;
+}
+
+static void ranges_del(struct starpu_omp_ranges *ranges, struct handle_entry *entry)
+{
+	starpu_rbtree_remove(&ranges->tree, &entry->node);
+}
+
+/* Fill HANDLES with at most MAX handles whose range overlaps [PTR, PTR+SIZE),
+ * and return the total number of such handles */
+static int ranges_lookup(struct starpu_omp_ranges *ranges, const void *ptr, size_t size, starpu_data_handle_t *handles, int max)
+{
+	uintptr_t start = (uintptr_t) ptr;
+	uintptr_t end = start + size;
+	uintptr_t from = start > ranges->max_size ? start - ranges->max_size : 0;
+	struct starpu_rbtree_node *node;
+	int n = 0;
+
+	node = starpu_rbtree_lookup_nearest(&ranges->tree, from, range_cmp_lookup, STARPU_RBTREE_RIGHT);
+	for ( ; node && (uintptr_t) range_entry(node)->pointer < end; node = starpu_rbtree_next(node))
+	{
+		struct handle_entry *entry = range_entry(node);
+		if ((uintptr_t) entry->pointer + entry->size <= start)
+			continue;
+		if (n < max)
+			handles[n] = entry->handle;
+		n++;
+	}
+	return n;
+}
+
+/* Return the extent of the addresses covered by HANDLE on NODE, which is
+ * larger than the packed size when the data is padded (ld > nx) */
+static size_t handle_span(starpu_data_handle_t handle, unsigned node)
+{
+	void *interface = starpu_data_get_interface_on_node(handle, node);
+
+	switch (starpu_data_get_interface_id(handle))
+	{
+		case STARPU_MATRIX_INTERFACE_ID:
+		{
+			size_t nx = STARPU_MATRIX_GET_NX(interface);
+			size_t ny = STARPU_MATRIX_GET_NY(interface);
+			size_t ld = STARPU_MATRIX_GET_LD(interface);
+			if (nx == 0 || ny == 0)
+				return 0;
+			return (ld * (ny - 1) + nx) * STARPU_MATRIX_GET_ELEMSIZE(interface);
+		}
+		case STARPU_BLOCK_INTERFACE_ID:
+		{
+			size_t nx = STARPU_BLOCK_GET_NX(interface);
+			size_t ny = STARPU_BLOCK_GET_NY(interface);
+			size_t nz = STARPU_BLOCK_GET_NZ(interface);
+			if (nx == 0 || ny == 0 || nz == 0)
+				return 0;
+			return (STARPU_BLOCK_GET_LDZ(interface) * (nz - 1)
+				+ STARPU_BLOCK_GET_LDY(interface) * (ny - 1)
+				+ nx) * STARPU_BLOCK_GET_ELEMSIZE(interface);
+		}
+		case STARPU_TENSOR_INTERFACE_ID:
+		{
+			size_t nx = STARPU_TENSOR_GET_NX(interface);
+			size_t ny = STARPU_TENSOR_GET_NY(interface);
+			size_t nz = STARPU_TENSOR_GET_NZ(interface);
+			size_t nt = STARPU_TENSOR_GET_NT(interface);
+			if (nx == 0 || ny == 0 || nz == 0 || nt == 0)
+				return 0;
+			return (STARPU_TENSOR_GET_LDT(interface) * (nt - 1)
+				+ STARPU_TENSOR_GET_LDZ(interface) * (nz - 1)
+				+ STARPU_TENSOR_GET_LDY(interface) * (ny - 1)
+				+ nx) * STARPU_TENSOR_GET_ELEMSIZE(interface);
+		}
+		default:
+			return starpu_data_get_size(handle);
+	}
+}
+
 /* Register the mapping from PTR to HANDLE.  If PTR is already mapped to
  * some handle, the new mapping shadows the previous one.   */
-static void register_ram_pointer(starpu_data_handle_t handle, void *ptr)
+static void register_ram_pointer(starpu_data_handle_t handle, unsigned node, void *ptr)
 {
 	struct handle_entry *entry;
 
 	_STARPU_MALLOC(entry, sizeof(*entry));
 
 	entry->pointer = ptr;
+	entry->size = handle_span(handle, node);
 	entry->handle = handle;
 
 	struct starpu_omp_task *task = _starpu_omp_get_task();
@@ -417,11 +529,13 @@ static void register_ram_pointer(starpu_data_handle_t handle, void *ptr)
 			struct starpu_omp_region *parallel_region = task->owner_region;
 			_starpu_spin_lock(&parallel_region->registered_handles_lock);
 			HASH_ADD_PTR(parallel_region->registered_handles, pointer, entry);
+			ranges_add(&parallel_region->registered_ranges, entry);
 			_starpu_spin_unlock(&parallel_region->registered_handles_lock);
 		}
 		else
 		{
 			HASH_ADD_PTR(task->registered_handles, pointer, entry);
+			ranges_add(&task->registered_ranges, entry);
 		}
 	}
 	else
@@ -440,6 +554,7 @@ static void register_ram_pointer(starpu_data_handle_t handle, void *ptr)
 		else
 		{
 			HASH_ADD_PTR(registered_handles, pointer, entry);
+			ranges_add(&registered_ranges, entry);
 			_starpu_spin_unlock(&registered_handles_lock);
 		}
 	}
@@ -455,7 +570,7 @@ void starpu_omp_handle_register(starpu_data_handle_t handle)
 
 		void *ptr = starpu_data_handle_to_pointer(handle, node);
 		if (ptr != NULL)
-			register_ram_pointer(handle, ptr);
+			register_ram_pointer(handle, node, ptr);
 	}
 }
 
@@ -486,7 +601,8 @@ static void unregister_ram_pointer(starpu_data_handle_t handle, unsigned node)
 				_starpu_spin_lock(&parallel_region->registered_handles_lock);
 				HASH_FIND_PTR(parallel_region->registered_handles, &ram_ptr, entry);
 				STARPU_ASSERT(entry != NULL);
-				HASH_DEL(registered_handles, entry);
+				HASH_DEL(parallel_region->registered_handles, entry);
+				ranges_del(&parallel_region->registered_ranges, entry);
 				_starpu_spin_unlock(&parallel_region->registered_handles_lock);
 			}
 			else
@@ -494,6 +610,7 @@ static void unregister_ram_pointer(starpu_data_handle_t handle, unsigned node)
 				HASH_FIND_PTR(task->registered_handles, &ram_ptr, entry);
 				STARPU_ASSERT(entry != NULL);
 				HASH_DEL(task->registered_handles, entry);
+				ranges_del(&task->registered_ranges, entry);
 			}
 		}
 		else
@@ -506,6 +623,7 @@ static void unregister_ram_pointer(starpu_data_handle_t handle, unsigned node)
 				if (entry->handle == handle)
 				{
 					HASH_DEL(registered_handles, entry);
+					ranges_del(&registered_ranges, entry);
 				}
 				else
 					/* don't free it, it's not ours */
@@ -542,6 +660,8 @@ static void unregister_region_handles(struct starpu_omp_region *region)
 		starpu_data_unregister(entry->handle);
 		free(entry);
 	}
+	starpu_rbtree_init(&region->registered_ranges.tree);
+	region->registered_ranges.max_size = 0;
 	_starpu_spin_unlock(&region->registered_handles_lock);
 }
 
@@ -555,6 +675,8 @@ static void unregister_task_handles(struct starpu_omp_task *task)
 		starpu_data_unregister(entry->handle);
 		free(entry);
 	}
+	starpu_rbtree_init(&task->registered_ranges.tree);
+	task->registered_ranges.max_size = 0;
 }
 
 starpu_data_handle_t starpu_omp_data_lookup(const void *ptr)
@@ -608,6 +730,35 @@ starpu_data_handle_t starpu_omp_data_lookup(const void *ptr)
 	return result;
 }
 
+int starpu_omp_data_lookup_overlaps(const void *ptr, size_t size, starpu_data_handle_t *handles, int max)
+{
+	int n;
+
+	struct starpu_omp_task *task = _starpu_omp_get_task();
+	if (task)
+	{
+		if (task->flags & STARPU_OMP_TASK_FLAGS_IMPLICIT)
+		{
+			struct starpu_omp_region *parallel_region = task->owner_region;
+			_starpu_spin_lock(&parallel_region->registered_handles_lock);
+			n = ranges_lookup(&parallel_region->registered_ranges, ptr, size, handles, max);
+			_starpu_spin_unlock(&parallel_region->registered_handles_lock);
+		}
+		else
+		{
+			n = ranges_lookup(&task->registered_ranges, ptr, size, handles, max);
+		}
+	}
+	else
+	{
+		_starpu_spin_lock(&registered_handles_lock);
+		n = ranges_lookup(&registered_ranges, ptr, size, handles, max);
+		_starpu_spin_unlock(&registered_handles_lock);
+	}
+
+	return n;
+}
+
 static void starpu_omp_explicit_task_entry(struct starpu_omp_task *task)
 {
 	STARPU_ASSERT(!(task->flags & STARPU_OMP_TASK_FLAGS_IMPLICIT));
@@ -671,6 +822,51 @@ static void starpu_omp_implicit_task_entry(struct starpu_omp_task *task)
 	STARPU_ASSERT(0); /* unreachable code */
 }
 
+/*
+ * get a stack for a task about to start on the thread, reusing the stack of
+ * a task which terminated on this thread if possible: stacks are large and
+ * thus usually mmaped by malloc, which makes allocating and freeing them for
+ * each task expensive.
+ *
+ * The stack cache is only ever accessed by the thread itself, on its worker
+ * stack, so no locking is needed.
+ */
+static void *omp_task_stack_alloc(struct starpu_omp_thread *thread, size_t stacksize)
+{
+	void *stack;
+	unsigned i;
+
+	for (i = thread->ncached_stacks; i > 0; i--)
+	{
+		if (thread->cached_stacksizes[i-1] == stacksize)
+		{
+			stack = thread->cached_stacks[i-1];
+			thread->ncached_stacks--;
+			thread->cached_stacks[i-1] = thread->cached_stacks[thread->ncached_stacks];
+			thread->cached_stacksizes[i-1] = thread->cached_stacksizes[thread->ncached_stacks];
+			return stack;
+		}
+	}
+
+	_STARPU_MALLOC(stack, stacksize);
+	return stack;
+}
+
+/*
+ * give back the stack of a task which terminated on the thread
+ */
+static void omp_task_stack_free(struct starpu_omp_thread *thread, void *stack, size_t stacksize)
+{
+	if (thread->ncached_stacks < _STARPU_OMP_STACK_CACHE_SIZE)
+	{
+		thread->cached_stacks[thread->ncached_stacks] = stack;
+		thread->cached_stacksizes[thread->ncached_stacks] = stacksize;
+		thread->ncached_stacks++;
+	}
+	else
+		free(stack);
+}
+
 /*
  * stop executing a task that is about to block
  * and give hand back to the thread
@@ -709,7 +905,7 @@ static void starpu_omp_implicit_task_exec(void *buffers[], void *cl_arg)
 		task->starpu_cl_arg = cl_arg;
 		STARPU_ASSERT(task->stack == NULL);
 		STARPU_ASSERT(task->stacksize > 0);
-		_STARPU_MALLOC(task->stack, task->stacksize);
+		task->stack = omp_task_stack_alloc(thread, task->stacksize);
 		getcontext(&task->ctx);
 		/*
 		 * we do not use uc_link, starpu_omp_task_entry will handle
@@ -742,7 +938,7 @@ static void starpu_omp_implicit_task_exec(void *buffers[], void *cl_arg)
 		task->starpu_task = NULL;
 		VALGRIND_STACK_DEREGISTER(task->stack_vg_id);
 		task->stack_vg_id = 0;
-		free(task->stack);
+		omp_task_stack_free(thread, task->stack, task->stacksize);
 		task->stack = NULL;
 		memset(&task->ctx, 0, sizeof(task->ctx));
 	}
@@ -883,7 +1079,7 @@ static void starpu_omp_explicit_task_exec(void *buffers[], void *cl_arg)
 		task->starpu_cl_arg = cl_arg;
 		STARPU_ASSERT(task->stack == NULL);
 		STARPU_ASSERT(task->stacksize > 0);
-		_STARPU_MALLOC(task->stack, task->stacksize);
+		task->stack = omp_task_stack_alloc(thread, task->stacksize);
 		getcontext(&task->ctx);
 		/*
 		 * we do not use uc_link, starpu_omp_task_entry will handle
@@ -909,7 +1105,7 @@ static void starpu_omp_explicit_task_exec(void *buffers[], void *cl_arg)
 	/* TODO: analyse the cause of the return and take appropriate steps */
 	if (task->state == starpu_omp_task_state_terminated)
 	{
-		free(task->stack);
+		omp_task_stack_free(thread, task->stack, task->stacksize);
 		task->stack = NULL;
 		memset(&task->ctx, 0, sizeof(task->ctx));
 
@@ -1270,6 +1466,8 @@ void starpu_omp_shutdown(void)
 		}
 
 		registered_handles = NULL;
+		starpu_rbtree_init(&registered_ranges.tree);
+		registered_ranges.max_size = 0;
 		}
 	_starpu_spin_lock(&_global_state.hash_workers_lock);
 	{
@@ -1818,6 +2016,30 @@ static void explicit_task__destroy_callback(void *_task)
 	destroy_omp_task_struct(task);
 }
 
+/*
+ * Whether a new explicit task should rather be executed right away as an
+ * included task, because the region already has plenty of pending tasks to
+ * keep its threads busy: recursive codes would otherwise be dominated by the
+ * overhead of submitting a lot of tiny tasks.
+ *
+ * This is similar to what other OpenMP runtimes do, and is only done for
+ * tasks which have no data dependencies, since executing them right away
+ * would require acquiring the data.
+ */
+static int omp_task_cutoff(struct starpu_omp_region *parallel_region, const struct starpu_omp_task_region_attr *attr)
+{
+	int cutoff = _starpu_omp_initial_icv_values->task_cutoff_var;
+
+	if (cutoff <= 0)
+		return 0;
+	if (attr->cl.nbuffers != 0 || attr->is_loop || !attr->cl.cpu_funcs[0] || (attr->cl.where && !(attr->cl.where & STARPU_CPU)))
+		return 0;
+	if (starpu_worker_get_type(starpu_worker_get_id()) != STARPU_CPU_WORKER)
+		return 0;
+
+	return parallel_region->bound_explicit_task_count >= cutoff * parallel_region->nb_threads;
+}
+
 void starpu_omp_task_region(const struct starpu_omp_task_region_attr *attr)
 {
 	struct starpu_omp_task *generating_task = _starpu_omp_get_task();
@@ -1857,6 +2079,10 @@ void starpu_omp_task_region(const struct starpu_omp_task_region_attr *attr)
 		{
 			is_merged = 1;
 		}
+		if (!is_included && omp_task_cutoff(parallel_region, attr))
+		{
+			is_included = 1;
+		}
 	}
 	if (is_merged || is_included)
 	{
@@ -1872,7 +2098,7 @@ void starpu_omp_task_region(const struct starpu_omp_task_region_attr *attr)
 		for (i = 0; i < attr->cl.nbuffers; i++)
 		{
 			starpu_data_handle_t handle = attr->handles[i];
-			ret = starpu_data_acquire(handle, attr->cl.modes[i]);
+			ret = starpu_data_acquire(handle, STARPU_CODELET_GET_MODE(&attr->cl, i));
 			STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire");
 			data_interfaces[i] = starpu_data_get_interface_on_node(handle, handle->home_node);
 		}
@@ -1973,6 +2199,18 @@ void starpu_omp_task_region(const struct starpu_omp_task_region_attr *attr)
 		generated_task->starpu_task->cl_arg_size = attr->cl_arg_size;
 		generated_task->starpu_task->cl_arg_free = attr->cl_arg_free;
 		generated_task->starpu_task->priority = attr->priority;
+		if (generated_task->cl.dyn_modes)
+		{
+			/* the attribute struct may become out of scope, the task keeps its own copy */
+			size_t size = generated_task->cl.nbuffers * sizeof(starpu_data_handle_t);
+			_STARPU_MALLOC(generated_task->starpu_task->dyn_handles, size);
+			memcpy(generated_task->starpu_task->dyn_handles, attr->handles, size);
+			size = generated_task->cl.nbuffers * sizeof(enum starpu_data_access_mode);
+			_STARPU_MALLOC(generated_task->starpu_task->dyn_modes, size);
+			memcpy(generated_task->starpu_task->dyn_modes, attr->cl.dyn_modes, size);
+			generated_task->cl.dyn_modes = NULL;
+		}
+		else
 		{
 			int i;
 			for (i = 0; i < generated_task->cl.nbuffers; i++)
@@ -25,6 +25,7 @@
 #include <common/list.h>
 #include <common/starpu_spinlock.h>
 #include <common/uthash.h>
+#include <common/rbtree.h>
 
 /** ucontexts have been deprecated as of POSIX 1-2004
  * _XOPEN_SOURCE required at least on OS/X
@@ -46,6 +47,11 @@ extern starpu_pthread_key_t omp_task_key;
  */
 #define STARPU_OMP_MAX_ACTIVE_LEVELS 1
 
+/**
+ * Number of task stacks that each thread keeps for reuse
+ */
+#define _STARPU_OMP_STACK_CACHE_SIZE 4
+
 /**
  * Possible abstract names for OpenMP places
  */
@@ -153,6 +159,11 @@ struct starpu_omp_initial_icv_values
 
 	/** not a real ICV, but needed to store the contents of OMP_PLACES */
 	struct starpu_omp_place places;
+
+	/** not a real ICV, number of pending explicit tasks per thread above
+	 * which new explicit tasks are executed as included tasks, from
+	 * STARPU_OMP_TASK_CUTOFF */
+	int task_cutoff_var;
 };
 
 struct starpu_omp_task_group
@@ -168,6 +179,30 @@ struct starpu_omp_task_link
 	struct starpu_omp_task_link *next;
 };
 
+/** address ranges of the handles registered for ptr->handle data lookup,
+ * sorted by start address */
+struct starpu_omp_ranges
+{
+	struct starpu_rbtree tree;
+	/** size of the largest range, which bounds how far before a piece of
+	 * memory the ranges overlapping it can start */
+	size_t max_size;
+};
+
+/** state of a worksharing loop run through the LLVM OpenMP dispatch
+ * interface, which only gives the loop parameters at init time */
+struct starpu_omp_dispatch
+{
+	unsigned long long lb;
+	long long st;
+	unsigned long long nb_iterations;
+	unsigned long long chunk;
+	unsigned long long first_i;
+	int schedule;
+	int ordered;
+	int started;
+};
+
 struct starpu_omp_condition
 {
 	struct starpu_omp_task_link *contention_list_head;
@@ -231,10 +266,17 @@ LIST_TYPE(starpu_omp_task,
 	int loop_id;
 	unsigned long long ordered_first_i;
 	unsigned long long ordered_nb_i;
+	struct starpu_omp_dispatch dispatch;
+	/** num_threads clause given through the LLVM OpenMP interface for the next parallel region */
+	int pending_num_threads;
+	/** number of nested serialized parallel regions the task is running
+	 * through the LLVM OpenMP interface, as a team of one thread */
+	int serialized_level;
 	int sections_id;
 	struct starpu_omp_data_environment_icvs data_env_icvs;
 	struct starpu_omp_implicit_task_icvs implicit_task_icvs;
 	struct handle_entry *registered_handles;
+	struct starpu_omp_ranges registered_ranges;
 
 	struct starpu_task *starpu_task;
 	struct starpu_codelet cl;
@@ -304,6 +346,15 @@ LIST_TYPE(starpu_omp_thread,
 	 */
 	ucontext_t ctx;
 
+	/*
+	 * stacks of tasks which terminated on this thread, kept to be
+	 * reused by the next tasks, instead of allocating and freeing
+	 * a stack for each task
+	 */
+	void *cached_stacks[_STARPU_OMP_STACK_CACHE_SIZE];
+	size_t cached_stacksizes[_STARPU_OMP_STACK_CACHE_SIZE];
+	unsigned ncached_stacks;
+
 	struct starpu_driver starpu_driver;
 	struct _starpu_worker *worker;
 )
@@ -366,6 +417,7 @@ struct starpu_omp_region
 	struct starpu_omp_sections *sections_list;
 	struct starpu_task *continuation_starpu_task;
 	struct handle_entry *registered_handles;
+	struct starpu_omp_ranges registered_ranges;
 	struct _starpu_spinlock registered_handles_lock;
 };
 
@@ -412,7 +464,7 @@ void _starpu_omp_environment_exit(void);
 int _starpu_omp_environment_check(void);
 struct starpu_omp_thread *_starpu_omp_get_thread(void);
 struct starpu_omp_region *_starpu_omp_get_region_at_level(int level) STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
-struct starpu_omp_task *_starpu_omp_get_task(void);
+struct starpu_omp_task *_starpu_omp_get_task(void) STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
 int _starpu_omp_get_region_thread_num(const struct starpu_omp_region *const region) STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
 void _starpu_omp_dummy_init(void);
 void _starpu_omp_dummy_shutdown(void);
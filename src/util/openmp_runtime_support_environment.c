@@ -26,6 +26,7 @@
 #define _STARPU_INITIAL_PLACES_LIST_SIZE      4
 #define _STARPU_INITIAL_PLACE_ITEMS_LIST_SIZE 4
 #define _STARPU_DEFAULT_STACKSIZE 2097152
+#define _STARPU_DEFAULT_TASK_CUTOFF 64
 
 static struct starpu_omp_initial_icv_values _initial_icv_values =
 {
@@ -38,6 +39,7 @@ static struct starpu_omp_initial_icv_values _initial_icv_values =
 	.def_sched_chunk_var = 0,
 	.bind_var = NULL,
 	.stacksize_var = _STARPU_DEFAULT_STACKSIZE,
+	.task_cutoff_var = _STARPU_DEFAULT_TASK_CUTOFF,
 	.wait_policy_var = 0,
 	.max_active_levels_var = STARPU_OMP_MAX_ACTIVE_LEVELS,
 	.active_levels_var = 0,
@@ -545,6 +547,7 @@ static void read_omp_environment(void)
 	_initial_icv_values.cancel_var = starpu_getenv_string_var_default("OMP_CANCELLATION", boolean_strings, _initial_icv_values.cancel_var);
 	_initial_icv_values.default_device_var = starpu_getenv_number_default("OMP_DEFAULT_DEVICE", _initial_icv_values.default_device_var);
 	_initial_icv_values.max_task_priority_var = starpu_getenv_number_default("OMP_MAX_TASK_PRIORITY", _initial_icv_values.max_task_priority_var);
+	_initial_icv_values.task_cutoff_var = starpu_getenv_number_default("STARPU_OMP_TASK_CUTOFF", _initial_icv_values.task_cutoff_var);
 
 	/* Avoid overflow e.g. in num_threads_list allocation */
 	STARPU_ASSERT_MSG(_initial_icv_values.max_active_levels_var > 0 && _initial_icv_values.max_active_levels_var < 1000000, "OMP_MAX_ACTIVE_LEVELS should have a reasonable value");
@@ -630,6 +633,7 @@ static void display_omp_environment(int verbosity_level)
 		printf("  [host] OMP_CANCELLATION = '%s'\n", _starpu_omp_initial_icv_values->cancel_var?"TRUE":"FALSE");
 		printf("  [host] OMP_DEFAULT_DEVICE = '%d'\n", _starpu_omp_initial_icv_values->default_device_var);
 		printf("  [host] OMP_MAX_TASK_PRIORITY = '%d'\n", _starpu_omp_initial_icv_values->max_task_priority_var);
+		printf("  [host] STARPU_OMP_TASK_CUTOFF = '%d'\n", _starpu_omp_initial_icv_values->task_cutoff_var);
 		printf("  [host] OMP_PROC_BIND = '");
 		{
 			int level;
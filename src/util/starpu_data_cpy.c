@@ -19,6 +19,7 @@
 #include <common/config.h>
 #include <core/task.h>
 #include <core/workers.h>
+#include <core/task_fusion.h>
 #include <datawizard/datawizard.h>
 #include <util/starpu_data_cpy.h>
 #include <datawizard/memory_nodes.h>
@@ -165,21 +166,280 @@ int _starpu_data_cpy(starpu_data_handle_t dst_handle, starpu_data_handle_t src_h
 	return 0;
 }
 
+/*
+ * Copy on write
+ *
+ * When possible, starpu_data_cpy() and starpu_data_dup_ro() do not submit the
+ * copy task, but only record that dst_handle is a pending copy of src_handle:
+ * dst_handle->cow_src points to src_handle, and dst_handle is queued in
+ * src_handle->cow_dups. Tasks reading the pending copy then actually read the
+ * source, and the copy is only submitted when either side is about to be
+ * modified, or when the copy is acquired by the application. If the copy is
+ * overwritten first, the copy is just forgotten.
+ *
+ * A handle is never both a pending copy and the source of pending copies:
+ * copying a pending copy records a copy of its source, and overwriting a
+ * source first submits the copies of its duplicates.
+ */
+
+static starpu_pthread_mutex_t cow_mutex = STARPU_PTHREAD_MUTEX_INITIALIZER;
+static int cow_enabled;
+/* Number of pending copies, to quickly skip checks when there is none */
+int _starpu_data_cow_npending;
+
+void _starpu_data_cpy_init(void)
+{
+	cow_enabled = starpu_getenv_number_default("STARPU_DATA_CPY_COW", 1);
+	STARPU_HG_DISABLE_CHECKING(_starpu_data_cow_npending);
+}
+
+/* Whether the copy of src_handle into dst_handle can be deferred */
+static int cow_possible(starpu_data_handle_t dst_handle, starpu_data_handle_t src_handle)
+{
+	/* We rely on implicit dependencies to order the deferred copy, and
+	 * do not track accesses through partitioning */
+	return cow_enabled
+		&& dst_handle->sequential_consistency && src_handle->sequential_consistency
+		&& !dst_handle->readonly
+		&& !dst_handle->parent_handle && !src_handle->parent_handle
+		&& !dst_handle->nchildren && !src_handle->nchildren
+		&& !dst_handle->nplans && !src_handle->nplans
+		&& !_starpu_data_is_multiformat_handle(dst_handle);
+}
+
+/* Detach dst_handle from its source, cow_mutex must be held */
+static void cow_unlink(starpu_data_handle_t dst_handle)
+{
+	starpu_data_handle_t *prev = &dst_handle->cow_src->cow_dups;
+
+	while (*prev != dst_handle)
+	{
+		STARPU_ASSERT(*prev);
+		prev = &(*prev)->cow_next;
+	}
+	*prev = dst_handle->cow_next;
+	dst_handle->cow_next = NULL;
+	dst_handle->cow_src = NULL;
+	_starpu_data_cow_npending--;
+}
+
+/* Record that dst_handle is a copy of src_handle, cow_mutex must be held */
+static void cow_link(starpu_data_handle_t dst_handle, starpu_data_handle_t src_handle, int priority)
+{
+	STARPU_ASSERT(!dst_handle->cow_src && !dst_handle->cow_dups && !src_handle->cow_src);
+	dst_handle->cow_src = src_handle;
+	dst_handle->cow_next = src_handle->cow_dups;
+	dst_handle->cow_prio = priority;
+	src_handle->cow_dups = dst_handle;
+	_starpu_data_cow_npending++;
+}
+
+/* Actually submit a deferred copy, once detached */
+static void cow_copy(starpu_data_handle_t dst_handle, starpu_data_handle_t src_handle, int priority)
+{
+	unsigned readonly = dst_handle->readonly;
+
+	/* Read-only duplicates still have to receive their value */
+	dst_handle->readonly = 0;
+	_starpu_data_cpy(dst_handle, src_handle, 1, NULL, NULL, 0, NULL, priority);
+	dst_handle->readonly = readonly;
+}
+
+void _starpu_data_cow_materialize(starpu_data_handle_t handle)
+{
+	starpu_data_handle_t src_handle, dup, *dups = NULL;
+	int priority = STARPU_DEFAULT_PRIO;
+	unsigned ndups = 0, i;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&cow_mutex);
+	src_handle = handle->cow_src;
+	if (src_handle)
+	{
+		priority = handle->cow_prio;
+		cow_unlink(handle);
+	}
+	for (dup = handle->cow_dups; dup; dup = dup->cow_next)
+		ndups++;
+	if (ndups)
+	{
+		_STARPU_MALLOC(dups, ndups * sizeof(*dups));
+		for (i = 0; i < ndups; i++)
+		{
+			dups[i] = handle->cow_dups;
+			cow_unlink(dups[i]);
+		}
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&cow_mutex);
+
+	if (src_handle)
+		cow_copy(handle, src_handle, priority);
+	for (i = 0; i < ndups; i++)
+		cow_copy(dups[i], handle, dups[i]->cow_prio);
+	free(dups);
+}
+
+starpu_data_handle_t _starpu_data_cow_access(starpu_data_handle_t handle, enum starpu_data_access_mode mode, int redirect)
+{
+	enum starpu_data_access_mode access = mode & (STARPU_RW|STARPU_SCRATCH|STARPU_REDUX|STARPU_MPI_REDUX);
+	starpu_data_handle_t src_handle;
+	int materialize = 0;
+
+	if (access == STARPU_NONE || access == STARPU_SCRATCH)
+		/* The content is not used */
+		return handle;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&cow_mutex);
+	src_handle = handle->cow_src;
+	if (src_handle)
+	{
+		if (access == STARPU_R && redirect)
+			/* Just read the source */
+			handle = src_handle;
+		else if (access == STARPU_W)
+			/* Overwritten anyway */
+			cow_unlink(handle);
+		else
+			materialize = 1;
+	}
+	else if (handle->cow_dups && access != STARPU_R)
+		/* Our duplicates have to get the current value first */
+		materialize = 1;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&cow_mutex);
+
+	if (materialize)
+		_starpu_data_cow_materialize(handle);
+	return handle;
+}
+
+void _starpu_data_cow_task_submit(struct starpu_task *task)
+{
+	unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+	unsigned i;
+
+	/* First process modifications, so that the copies of the data
+	 * written by the task are submitted before it */
+	for (i = 0; i < nbuffers; i++)
+	{
+		enum starpu_data_access_mode mode = STARPU_TASK_GET_MODE(task, i);
+		if ((mode & (STARPU_RW|STARPU_SCRATCH|STARPU_REDUX|STARPU_MPI_REDUX)) != STARPU_R)
+			_starpu_data_cow_access(STARPU_TASK_GET_HANDLE(task, i), mode, 0);
+	}
+
+	/* And make read-only accesses to pending copies read the source, the
+	 * handles of the application are put back on termination. Regenerated
+	 * tasks would keep reading the source, so give them the copy */
+	for (i = 0; i < nbuffers; i++)
+	{
+		enum starpu_data_access_mode mode = STARPU_TASK_GET_MODE(task, i);
+		starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, i);
+		if ((mode & (STARPU_RW|STARPU_SCRATCH|STARPU_REDUX|STARPU_MPI_REDUX)) == STARPU_R)
+		{
+			starpu_data_handle_t access_handle = _starpu_data_cow_access(handle, mode, !task->regenerate);
+			if (access_handle != handle)
+			{
+				struct _starpu_job *j = _starpu_get_job_associated_to_task(task);
+				if (!j->cow_handles)
+					_STARPU_CALLOC(j->cow_handles, nbuffers, sizeof(*j->cow_handles));
+				j->cow_handles[i] = handle;
+				STARPU_TASK_SET_HANDLE(task, access_handle, i);
+			}
+		}
+	}
+}
+
+void _starpu_data_cow_task_terminated(struct _starpu_job *j)
+{
+	struct starpu_task *task = j->task;
+	unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+	unsigned i;
+
+	for (i = 0; i < nbuffers; i++)
+		if (j->cow_handles[i])
+			STARPU_TASK_SET_HANDLE(task, j->cow_handles[i], i);
+	free(j->cow_handles);
+	j->cow_handles = NULL;
+}
+
+void _starpu_data_cow_unregister(starpu_data_handle_t handle, unsigned coherent)
+{
+	STARPU_PTHREAD_MUTEX_LOCK(&cow_mutex);
+	if (handle->cow_src && !(coherent && handle->home_node >= 0))
+		/* Nobody will ever see the value */
+		cow_unlink(handle);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&cow_mutex);
+
+	_starpu_data_cow_materialize(handle);
+}
+
+/* Try to defer the copy, return 0 if it was possible */
+static int cow_data_cpy(starpu_data_handle_t dst_handle, starpu_data_handle_t src_handle, int priority)
+{
+	if (!cow_possible(dst_handle, src_handle))
+		return -EINVAL;
+
+	STARPU_ASSERT(dst_handle->ops->interfaceid == src_handle->ops->interfaceid);
+	STARPU_ASSERT_MSG(src_handle->initialized || src_handle->init_cl, "handle %p is not initialized while trying to copy it\n", src_handle);
+
+	STARPU_PTHREAD_MUTEX_LOCK(&cow_mutex);
+	if (dst_handle->cow_src)
+	{
+		if (dst_handle->cow_src == src_handle)
+		{
+			/* Already a copy of it */
+			STARPU_PTHREAD_MUTEX_UNLOCK(&cow_mutex);
+			return 0;
+		}
+		/* The previous copy gets overwritten */
+		cow_unlink(dst_handle);
+	}
+	if (src_handle->cow_src == dst_handle)
+	{
+		/* The source is a copy of the destination, nothing changes */
+		STARPU_PTHREAD_MUTEX_UNLOCK(&cow_mutex);
+		return 0;
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&cow_mutex);
+
+	/* The duplicates of the destination have to get its current value */
+	_starpu_data_cow_materialize(dst_handle);
+
+	STARPU_PTHREAD_MUTEX_LOCK(&cow_mutex);
+	if (src_handle->cow_src)
+		/* Copy of a copy, copy the original instead */
+		src_handle = src_handle->cow_src;
+	cow_link(dst_handle, src_handle, priority);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&cow_mutex);
+
+	/* As if the copy task had been submitted */
+	dst_handle->initialized = 1;
+
+	return 0;
+}
+
 int starpu_data_cpy(starpu_data_handle_t dst_handle, starpu_data_handle_t src_handle,
 		    int asynchronous, void (*callback_func)(void*), void *callback_arg)
 {
-	return _starpu_data_cpy(dst_handle, src_handle, asynchronous, callback_func, callback_arg, 0, NULL, STARPU_DEFAULT_PRIO);
+	return starpu_data_cpy_priority(dst_handle, src_handle, asynchronous, callback_func, callback_arg, STARPU_DEFAULT_PRIO);
 }
 
 int starpu_data_cpy_priority(starpu_data_handle_t dst_handle, starpu_data_handle_t src_handle,
 			     int asynchronous, void (*callback_func)(void*), void *callback_arg, int priority)
 {
+	/* Tasks held for fusion were submitted before the copy, which is
+	 * submitted as an internal task */
+	_STARPU_TASK_FUSION_FLUSH();
+
+	/* The callback has to be called after an actual copy */
+	if (dst_handle != src_handle && !callback_func && !cow_data_cpy(dst_handle, src_handle, priority))
+		return 0;
 	return _starpu_data_cpy(dst_handle, src_handle, asynchronous, callback_func, callback_arg, 0, NULL, priority);
 }
 
-/* TODO: implement copy on write, and introduce starpu_data_dup as well */
+/* TODO: introduce starpu_data_dup as well */
 int starpu_data_dup_ro(starpu_data_handle_t *dst_handle, starpu_data_handle_t src_handle, int asynchronous)
 {
+	_STARPU_TASK_FUSION_FLUSH();
+
 	_starpu_spin_lock(&src_handle->header_lock);
 	if (src_handle->readonly_dup)
 	{
@@ -201,7 +461,8 @@ int starpu_data_dup_ro(starpu_data_handle_t *dst_handle, starpu_data_handle_t sr
 	_starpu_spin_unlock(&src_handle->header_lock);
 
 	starpu_data_register_same(dst_handle, src_handle);
-	_starpu_data_cpy(*dst_handle, src_handle, asynchronous, NULL, NULL, 0, NULL, STARPU_DEFAULT_PRIO);
+	if (cow_data_cpy(*dst_handle, src_handle, STARPU_DEFAULT_PRIO))
+		_starpu_data_cpy(*dst_handle, src_handle, asynchronous, NULL, NULL, 0, NULL, STARPU_DEFAULT_PRIO);
 	(*dst_handle)->readonly = 1;
 
 	_starpu_spin_lock(&src_handle->header_lock);
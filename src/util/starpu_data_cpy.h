@@ -27,6 +27,34 @@ int _starpu_data_cpy(starpu_data_handle_t dst_handle, starpu_data_handle_t src_h
 		     int asynchronous, void (*callback_func)(void*), void *callback_arg,
 		     int reduction, struct starpu_task *reduction_dep_task, int priority);
 
+void _starpu_data_cpy_init(void);
+
+extern int _starpu_data_cow_npending;
+
+/** Submit the deferred copies involving \p handle, either as pending copy or
+ * as source of pending copies */
+void _starpu_data_cow_materialize(starpu_data_handle_t handle);
+/** \p handle is about to be accessed in \p mode, submit the deferred copies
+ * which need it, and return the handle to be actually accessed, which is the
+ * source of the pending copy \p handle when \p redirect is set and the
+ * access is read-only */
+starpu_data_handle_t _starpu_data_cow_access(starpu_data_handle_t handle, enum starpu_data_access_mode mode, int redirect);
+/** Process the deferred copies involving the data accessed by \p task */
+void _starpu_data_cow_task_submit(struct starpu_task *task);
+struct _starpu_job;
+/** The task of \p j is over, give it back the handles which
+ * _starpu_data_cow_task_submit redirected */
+void _starpu_data_cow_task_terminated(struct _starpu_job *j);
+/** \p handle is getting unregistered, forget its pending copy if its value
+ * will not be seen, and submit the copies of its duplicates */
+void _starpu_data_cow_unregister(starpu_data_handle_t handle, unsigned coherent);
+
+static inline void _starpu_data_cow_check(starpu_data_handle_t handle, enum starpu_data_access_mode mode)
+{
+	if (STARPU_UNLIKELY(_starpu_data_cow_npending))
+		_starpu_data_cow_access(handle, mode, 0);
+}
+
 #pragma GCC visibility pop
 
 #endif // __STARPU_DATA_CPY_H__
@@ -0,0 +1,130 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2019-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+/*
+ * Check the loop schedules, ordered loops, reductions and critical sections,
+ * which clang compiles into the static init and dispatch entry points of
+ * the OpenMP runtime
+ */
+
+#define N 1000
+
+int hits[N];
+int order[N];
+
+#define FPRINTF(ofile, fmt, ...) do { if (!getenv("STARPU_SSILENT")) {fprintf(ofile, fmt, ## __VA_ARGS__); }} while(0)
+
+static int check_hits(const char *name)
+{
+	int i;
+	for (i = 0; i < N; i++)
+	{
+		if (hits[i] != 1)
+		{
+			FPRINTF(stderr, "%s: iteration %d executed %d times\n", name, i, hits[i]);
+			return 1;
+		}
+	}
+	memset(hits, 0, sizeof(hits));
+	return 0;
+}
+
+int main()
+{
+	int res = 0;
+	int norder = 0;
+	long sum = 0;
+	int counter = 0;
+	int nthreads = 0;
+	int i;
+
+#pragma omp parallel
+	{
+#pragma omp for schedule(static)
+		for (i = 0; i < N; i++)
+			hits[i]++;
+#pragma omp single
+		res |= check_hits("static");
+
+#pragma omp for schedule(static, 7)
+		for (i = 0; i < N; i++)
+			hits[i]++;
+#pragma omp single
+		res |= check_hits("static,7");
+
+#pragma omp for schedule(dynamic, 5)
+		for (i = 0; i < N; i++)
+			hits[i]++;
+#pragma omp single
+		res |= check_hits("dynamic,5");
+
+#pragma omp for schedule(guided, 3)
+		for (i = N-1; i >= 0; i--)
+			hits[i]++;
+#pragma omp single
+		res |= check_hits("guided,3");
+
+#pragma omp for schedule(runtime)
+		for (i = 0; i < N; i++)
+			hits[i]++;
+#pragma omp single
+		res |= check_hits("runtime");
+
+#pragma omp for schedule(dynamic, 3) ordered
+		for (i = 0; i < N; i++)
+		{
+#pragma omp ordered
+			order[norder++] = i;
+		}
+
+#pragma omp for reduction(+:sum)
+		for (i = 0; i < N; i++)
+			sum += i;
+
+#pragma omp critical
+		counter++;
+
+#pragma omp master
+		nthreads = omp_get_num_threads();
+	}
+
+	for (i = 0; i < N; i++)
+	{
+		if (order[i] != i)
+		{
+			FPRINTF(stderr, "ordered: iteration %d executed at position %d\n", order[i], i);
+			res = 1;
+			break;
+		}
+	}
+	if (sum != (long)N*(N-1)/2)
+	{
+		FPRINTF(stderr, "reduction: %ld instead of %ld\n", sum, (long)N*(N-1)/2);
+		res = 1;
+	}
+	if (counter != nthreads)
+	{
+		FPRINTF(stderr, "critical: %d instead of %d\n", counter, nthreads);
+		res = 1;
+	}
+	FPRINTF(stderr, "%d threads, %s\n", nthreads, res ? "failed" : "success");
+	return res;
+}
@@ -28,6 +28,9 @@
 
 typedef struct ident ident_t;
 typedef int32_t kmp_int32;
+typedef uint32_t kmp_uint32;
+typedef int64_t kmp_int64;
+typedef uint64_t kmp_uint64;
 typedef void * kmp_intptr_t;
 
 typedef void(* kmpc_micro) (kmp_int32 *global_tid, kmp_int32 *bound_tid,...);
@@ -42,6 +45,8 @@ typedef struct kmp_depend_info
 	{
 		bool in : 1;
 		bool out : 1;
+		bool mtx : 1;
+		bool set : 1;
 	} flags;
 	size_t elem_size;
 } kmp_depend_info_t;
@@ -164,6 +169,25 @@ enum sched_type /* : kmp_int32 */
 
 typedef kmp_int32 kmp_critical_name[8];
 
+/* The compiler runs serialized parallel regions by calling the microtask
+ * directly from the encountering thread, without StarPU creating a region:
+ * the thread then has to behave as the only thread of a new team */
+static int in_serialized(void)
+{
+	struct starpu_omp_task *task = _starpu_omp_get_task();
+	return task && task->serialized_level > 0;
+}
+
+static int team_thread_num(void)
+{
+	return in_serialized() ? 0 : starpu_omp_get_thread_num();
+}
+
+static int team_num_threads(void)
+{
+	return in_serialized() ? 1 : starpu_omp_get_num_threads();
+}
+
 kmp_int32 __kmpc_global_thread_num(ident_t *loc);
 kmp_int32 __kmpc_global_num_threads(ident_t *loc);
 kmp_int32 __kmpc_bound_thread_num(ident_t *loc);
@@ -272,12 +296,21 @@ void __kmpc_end(ident_t *loc)
 }
 
 /* Parallel (fork/join) */
+static void fork_region(struct starpu_omp_parallel_region_attr *attr)
+{
+	struct starpu_omp_task *task = _starpu_omp_get_task();
+	attr->num_threads = task->pending_num_threads;
+	task->pending_num_threads = 0;
+	starpu_omp_parallel_region(attr);
+	free((void *)attr);
+}
+
 void __kmpc_push_num_threads(ident_t *loc, kmp_int32 global_tid, kmp_int32 num_threads)
 {
 	(void) loc;
 	(void) global_tid;
-	(void) num_threads;
-	abort();
+	/* applies to the next parallel region encountered by this task */
+	_starpu_omp_get_task()->pending_num_threads = num_threads;
 }
 
 void __kmpc_fork_call(ident_t *loc, kmp_int32 argc, kmpc_micro microtask, ...)
@@ -306,12 +339,35 @@ void __kmpc_fork_call(ident_t *loc, kmp_int32 argc, kmpc_micro microtask, ...)
 	attr->cl_arg_free     = 0;
 	attr->cl_arg          = arg_ptrs;
 	attr->if_clause       = 1;
-	starpu_omp_parallel_region(attr);
-	free((void *)attr);
+	fork_region(attr);
 
 	va_end(vargs);
 }
 
+void __kmpc_fork_call_if(ident_t *loc, kmp_int32 argc, kmpc_micro microtask, kmp_int32 cond, void *args)
+{
+	(void) loc;
+	void *arg_ptrs[3];
+	arg_ptrs[0] = microtask;
+	arg_ptrs[1] = (void*)(intptr_t)(args ? 1 : 0);
+	arg_ptrs[2] = args;
+	/* the compiler gathers all the shared variables in args */
+	STARPU_ASSERT(argc <= 1);
+
+	struct starpu_omp_parallel_region_attr *attr = calloc(1, sizeof(struct starpu_omp_parallel_region_attr));
+#ifdef STARPU_SIMGRID
+	attr->cl.model        = &starpu_perfmodel_nop;
+	attr->cl.flags        = STARPU_CODELET_SIMGRID_EXECUTE;
+#endif
+	attr->cl.cpu_funcs[0] = parallel_call;
+	attr->cl.where        = STARPU_CPU;
+	attr->cl_arg_size     = 3*sizeof(void *);
+	attr->cl_arg_free     = 0;
+	attr->cl_arg          = arg_ptrs;
+	attr->if_clause       = cond != 0;
+	fork_region(attr);
+}
+
 static void task_call(void *buffers[], void *args)
 {
 	(void) buffers;
@@ -429,6 +485,85 @@ kmp_int32 __kmpc_omp_taskwait(ident_t *loc_ref, kmp_int32 gtid)
 	return 0;
 }
 
+/* Size of the memory covered by a depend item, as registered in dep_add */
+static size_t dep_size(const kmp_depend_info_t *dep)
+{
+	return dep->len == 1 ? sizeof(kmp_intptr_t) : dep->len * dep->elem_size;
+}
+
+static enum starpu_data_access_mode dep_mode(const kmp_depend_info_t *dep)
+{
+	if (dep->flags.mtx || dep->flags.set)
+		/* mutually exclusive accesses, in any order */
+		return STARPU_RW | STARPU_COMMUTE;
+	else if (dep->flags.in && dep->flags.out)
+		return STARPU_RW;
+	else if (dep->flags.in)
+		return STARPU_R;
+	else
+		return STARPU_W;
+}
+
+struct dep_handles
+{
+	starpu_data_handle_t *handles;
+	enum starpu_data_access_mode *modes;
+	int n;
+	int size;
+};
+
+static void dep_push(struct dep_handles *deps, starpu_data_handle_t handle, enum starpu_data_access_mode mode)
+{
+	if (deps->n == deps->size)
+	{
+		deps->size = deps->size ? 2*deps->size : STARPU_NMAXBUFS;
+		_STARPU_REALLOC(deps->handles, deps->size * sizeof(*deps->handles));
+		_STARPU_REALLOC(deps->modes, deps->size * sizeof(*deps->modes));
+	}
+	deps->handles[deps->n] = handle;
+	deps->modes[deps->n] = mode;
+	deps->n++;
+}
+
+/* Resolve a depend item to the handle registered for exactly the memory it
+ * covers, registering it if needed, and to the handles registered for memory
+ * which overlaps it, so that the task depends on all the previous tasks
+ * accessing any part of it */
+static void dep_add(struct dep_handles *owns, struct dep_handles *overlaps, const kmp_depend_info_t *dep)
+{
+	void *ptr = dep->base_addr;
+	size_t size = dep_size(dep);
+	enum starpu_data_access_mode mode = dep_mode(dep);
+	starpu_data_handle_t own = NULL;
+	starpu_data_handle_t *found;
+	int nfound, i;
+
+	nfound = starpu_omp_data_lookup_overlaps(ptr, size, NULL, 0);
+	if (nfound)
+	{
+		_STARPU_MALLOC(found, nfound * sizeof(*found));
+		nfound = STARPU_MIN(nfound, starpu_omp_data_lookup_overlaps(ptr, size, found, nfound));
+		for (i = 0; i < nfound; i++)
+		{
+			if (!own && starpu_data_handle_to_pointer(found[i], STARPU_MAIN_RAM) == ptr && starpu_data_get_size(found[i]) == size)
+				own = found[i];
+			else
+				dep_push(overlaps, found[i], mode);
+		}
+		free(found);
+	}
+
+	if (!own)
+	{
+		if (dep->len == 1)
+			starpu_variable_data_register(&own, STARPU_MAIN_RAM, (uintptr_t)ptr, sizeof(kmp_intptr_t));
+		else
+			starpu_vector_data_register(&own, STARPU_MAIN_RAM, (uintptr_t)ptr, dep->len, dep->elem_size);
+		starpu_omp_handle_register(own);
+	}
+	dep_push(owns, own, mode);
+}
+
 kmp_int32 __kmpc_omp_task_with_deps(ident_t *loc_ref, kmp_int32 gtid,
 				    kmp_task_t * new_task, kmp_int32 ndeps,
 				    kmp_depend_info_t *dep_list,
@@ -494,88 +629,54 @@ kmp_int32 __kmpc_omp_task_with_deps(ident_t *loc_ref, kmp_int32 gtid,
 	attr->final_clause     = 0;
 	attr->untied_clause    = 1;
 	attr->mergeable_clause = 0;
-	attr->cl.nbuffers = ndeps + ndeps_noalias;
-	starpu_data_handle_t *handles = calloc(attr->cl.nbuffers, sizeof(starpu_data_handle_t));
-	int current_buffer = 0;
-	starpu_data_handle_t current_handler = 0;
+	/* The handles of the depend items come first, in order, as the variants
+	 * get them as arguments, then the handles overlapping them */
+	struct dep_handles owns = { NULL, NULL, 0, 0 };
+	struct dep_handles overlaps = { NULL, NULL, 0, 0 };
 	for (int i = 0; i < ndeps; i++)
-	{
-		if (dep_list[i].flags.in && dep_list[i].flags.out)
-		{
-			attr->cl.modes[current_buffer] = STARPU_RW;
-		}
-		else if (dep_list[i].flags.in)
-		{
-			attr->cl.modes[current_buffer] = STARPU_R;
-		}
-		else
-		{
-			attr->cl.modes[current_buffer] = STARPU_W;
-		}
-		current_handler = starpu_omp_data_lookup(dep_list[i].base_addr);
-		if (current_handler)
-		{
-			handles[current_buffer] = current_handler;
-		}
-		else
-		{
-			if (dep_list[i].len == 1)
-			{
-				starpu_variable_data_register(&handles[current_buffer], STARPU_MAIN_RAM, (uintptr_t)dep_list[i].base_addr, sizeof(kmp_intptr_t));
-				starpu_omp_handle_register(handles[current_buffer]);
-			}
-			else
-			{
-				starpu_vector_data_register(&handles[current_buffer], STARPU_MAIN_RAM, (uintptr_t)dep_list[i].base_addr, dep_list[i].len, dep_list[i].elem_size);
-				starpu_omp_handle_register(handles[current_buffer]);
-			}
-		}
-		current_buffer++;
-	}
+		dep_add(&owns, &overlaps, &dep_list[i]);
 	for (int i = 0; i < ndeps_noalias; i++)
+		dep_add(&owns, &overlaps, &noalias_dep_list[i]);
+	for (int i = 0; i < overlaps.n; i++)
 	{
-		if (noalias_dep_list[i].flags.in && noalias_dep_list[i].flags.out)
-		{
-			attr->cl.modes[current_buffer] = STARPU_RW;
-		}
-		else if (noalias_dep_list[i].flags.in)
-		{
-			attr->cl.modes[current_buffer] = STARPU_R;
-		}
-		else
-		{
-			attr->cl.modes[current_buffer] = STARPU_W;
-		}
-		current_handler = starpu_omp_data_lookup(noalias_dep_list[i].base_addr);
-		if (current_handler)
-		{
-			handles[current_buffer] = current_handler;
-		}
-		else
-		{
-			if (dep_list[i].len == 1)
-			{
-				starpu_variable_data_register(&handles[current_buffer], STARPU_MAIN_RAM, (uintptr_t)dep_list[i].base_addr, sizeof(kmp_intptr_t));
-				starpu_omp_handle_register(handles[current_buffer]);
-			}
-			else
-			{
-				starpu_vector_data_register(&handles[current_buffer], STARPU_MAIN_RAM, (uintptr_t)dep_list[i].base_addr, dep_list[i].len, dep_list[i].elem_size);
-				starpu_omp_handle_register(handles[current_buffer]);
-			}
-		}
-		current_buffer++;
+		/* Only access each handle once, with the union of the modes */
+		int j;
+		for (j = 0; j < owns.n; j++)
+			if (owns.handles[j] == overlaps.handles[i])
+				break;
+		if (j == owns.n)
+			dep_push(&owns, overlaps.handles[i], overlaps.modes[i]);
+		else if (owns.modes[j] != overlaps.modes[i])
+			/* Keep the mutual exclusion asked for by mutexinoutset
+			 * and inoutset items */
+			owns.modes[j] = STARPU_RW | ((owns.modes[j] | overlaps.modes[i]) & STARPU_COMMUTE);
 	}
-
-	if (current_buffer)
+#ifdef _STARPU_OPENMP_LLVM_VARIANT
+	if (overlaps.n && attr->cl.where != STARPU_CPU)
 	{
-		// If we have any deps
-		attr->handles = &handles[0];
+		/* The overlapping handles are separate buffers, which only
+		 * share their memory in the main RAM where they are
+		 * registered: the other variants would work on separate
+		 * copies */
+		STARPU_ASSERT_MSG(attr->cl.where & STARPU_CPU, "tasks with depend items overlapping the ones of other tasks need a CPU variant\n");
+		attr->cl.where = STARPU_CPU;
 	}
+#endif
+	free(overlaps.handles);
+	free(overlaps.modes);
+
+	attr->cl.nbuffers = owns.n;
+	if (owns.n > STARPU_NMAXBUFS)
+		attr->cl.dyn_modes = owns.modes;
+	else if (owns.n)
+		memcpy(attr->cl.modes, owns.modes, owns.n * sizeof(*owns.modes));
+	attr->handles = owns.handles;
 
 	// thoughts : create starpu_omp_task_region_attr here, fill it with kmp_taskdata
 	// keep an arg to the wrapper with the kmp_task_t
 	starpu_omp_task_region(attr);
+	free(owns.handles);
+	free(owns.modes);
 	free(attr);
 	return 0;
 }
@@ -586,35 +687,51 @@ kmp_int32 __kmpc_omp_task(ident_t *loc_ref, kmp_int32 gtid, kmp_task_t *new_task
 	return retval;
 }
 
+/* Teams: StarPU only provides a single team, see starpu_omp_get_num_teams() */
 void __kmpc_push_num_teams(ident_t *loc, kmp_int32 global_tid, kmp_int32 num_teams, kmp_int32 num_threads)
 {
 	(void) loc;
 	(void) global_tid;
+	/* the runtime may create fewer teams than requested */
 	(void) num_teams;
 	(void) num_threads;
-	abort();
 }
 
 void __kmpc_fork_teams(ident_t *loc, kmp_int32 argc, kmpc_micro microtask, ...)
 {
 	(void) loc;
-	(void) argc;
-	(void) microtask;
-	abort();
+	va_list vargs;
+	va_start(vargs, microtask);
+	void *arg_ptrs[2+argc];
+	arg_ptrs[0] = microtask;
+	arg_ptrs[1] = (void*)(intptr_t)argc;
+
+	int i;
+	for (i=0; i<argc; i++)
+	{
+		arg_ptrs[i+2] = va_arg(vargs, void*);
+	}
+
+	/* the initial thread of the only team runs the teams region */
+	parallel_call(NULL, arg_ptrs);
+
+	va_end(vargs);
 }
 
 void __kmpc_serialized_parallel(ident_t *loc, kmp_int32 global_tid)
 {
 	(void) loc;
 	(void) global_tid;
-	abort();
+	_starpu_omp_get_task()->serialized_level++;
 }
 
 void __kmpc_end_serialized_parallel(ident_t *loc, kmp_int32 global_tid)
 {
 	(void) loc;
 	(void) global_tid;
-	abort();
+	struct starpu_omp_task *task = _starpu_omp_get_task();
+	STARPU_ASSERT(task->serialized_level > 0);
+	task->serialized_level--;
 }
 
 /* Thread Information */
@@ -641,13 +758,13 @@ kmp_int32 __kmpc_global_num_threads(ident_t *loc)
 kmp_int32 __kmpc_bound_thread_num(ident_t *loc)
 {
 	(void) loc;
-	return starpu_omp_get_thread_num();
+	return team_thread_num();
 }
 
 kmp_int32 __kmpc_bound_num_threads(ident_t *loc)
 {
 	(void) loc;
-	return starpu_omp_get_num_threads();
+	return team_num_threads();
 }
 
 kmp_int32 __kmpc_in_parallel(ident_t *loc)
@@ -661,6 +778,8 @@ kmp_int32 __kmpc_master(ident_t *loc, kmp_int32 global_tid)
 {
 	(void) loc;
 	(void) global_tid;
+	if (in_serialized())
+		return 1;
 	return starpu_omp_master_inline();
 }
 
@@ -675,20 +794,25 @@ void __kmpc_ordered(ident_t *loc, kmp_int32 global_tid)
 {
 	(void) loc;
 	(void) global_tid;
-	starpu_omp_ordered_inline_begin();
+	/* a single thread runs the iterations in order anyway */
+	if (!in_serialized())
+		starpu_omp_ordered_inline_begin();
 }
 
 void __kmpc_end_ordered(ident_t *loc, kmp_int32 global_tid)
 {
 	(void) loc;
 	(void) global_tid;
-	starpu_omp_ordered_inline_end();
+	if (!in_serialized())
+		starpu_omp_ordered_inline_end();
 }
 
 kmp_int32 __kmpc_single(ident_t *loc, kmp_int32 global_tid)
 {
 	(void) loc;
 	(void) global_tid;
+	if (in_serialized())
+		return 1;
 	return starpu_omp_single_inline();
 }
 
@@ -699,54 +823,424 @@ void __kmpc_end_single(ident_t *loc, kmp_int32 global_tid)
 	/* nothing */
 }
 
-void __kmpc_dispatch_init_4(ident_t *loc)
+/* Loops: the compiler gives inclusive bounds and a stride, while StarPU
+ * distributes iterations numbered from 0 to nb_iterations-1 */
+static unsigned long long loop_trip_count(long long lb, long long ub, long long st)
+{
+	STARPU_ASSERT(st != 0);
+	if (st > 0)
+		return ub < lb ? 0 : ((unsigned long long)ub - (unsigned long long)lb) / (unsigned long long)st + 1;
+	else
+		return lb < ub ? 0 : ((unsigned long long)lb - (unsigned long long)ub) / -(unsigned long long)st + 1;
+}
+
+static unsigned long long loop_trip_count_u(unsigned long long lb, unsigned long long ub, long long st)
+{
+	STARPU_ASSERT(st != 0);
+	if (st > 0)
+		return ub < lb ? 0 : (ub - lb) / (unsigned long long)st + 1;
+	else
+		return lb < ub ? 0 : (lb - ub) / -(unsigned long long)st + 1;
+}
+
+/* Bound of iteration i, computed modulo 2^64 so that it can be converted back
+ * to any of the signed or unsigned loop variable types */
+#define LOOP_BOUND(lb, st, i) ((lb) + (unsigned long long)(st) * (unsigned long long)(i))
+
+/* Translate a libomp schedule into a StarPU one */
+static int loop_schedule(kmp_int32 kind, int *ordered, int *chunked)
+{
+	kind &= ~(kmp_sch_modifier_monotonic | kmp_sch_modifier_nonmonotonic);
+	if (kind >= kmp_nm_lower && kind < kmp_nm_upper)
+		kind = kind - kmp_nm_lower + kmp_sch_lower;
+	*ordered = kind >= kmp_ord_lower && kind < kmp_ord_upper;
+	if (*ordered)
+		kind = kind - kmp_ord_lower + kmp_sch_lower;
+	/* unchunked static loops get one balanced block per thread */
+	*chunked = kind != kmp_sch_static && kind != kmp_sch_static_greedy && kind != kmp_sch_static_balanced;
+
+	switch (kind)
+	{
+	case kmp_sch_static_chunked:
+	case kmp_sch_static:
+	case kmp_sch_static_greedy:
+	case kmp_sch_static_balanced:
+	case kmp_sch_static_balanced_chunked:
+		return starpu_omp_sched_static;
+	case kmp_sch_dynamic_chunked:
+	case kmp_sch_static_steal:
+		return starpu_omp_sched_dynamic;
+	case kmp_sch_guided_chunked:
+	case kmp_sch_guided_iterative_chunked:
+	case kmp_sch_guided_analytical_chunked:
+	case kmp_sch_guided_simd:
+	case kmp_sch_trapezoidal:
+		return starpu_omp_sched_guided;
+	case kmp_sch_runtime:
+	case kmp_sch_runtime_simd:
+		return starpu_omp_sched_runtime;
+	case kmp_sch_auto:
+		return starpu_omp_sched_auto;
+	default:
+		return starpu_omp_sched_undefined;
+	}
+}
+
+/* Static loops are scheduled without any shared state: only compute the
+ * first chunk of the calling thread, the compiler then moves from a chunk to
+ * the next one by itself with the returned stride */
+static void for_static_init(kmp_int32 schedtype, unsigned long long nb_iterations, long long chunk,
+			    kmp_int32 *plastiter, unsigned long long *first_i, unsigned long long *nb_i, unsigned long long *stride)
+{
+	unsigned long long rank = team_thread_num();
+	unsigned long long nb_threads = team_num_threads();
+	int chunked = schedtype == kmp_sch_static_chunked
+		|| schedtype == kmp_sch_static_balanced_chunked
+		|| schedtype == kmp_distribute_static_chunked;
+
+	if (chunked)
+	{
+		if (chunk < 1)
+			chunk = 1;
+		*first_i = rank * chunk;
+		*nb_i = chunk;
+		*stride = nb_threads * chunk;
+		if (plastiter)
+			*plastiter = nb_iterations > 0 && ((nb_iterations - 1) / chunk) % nb_threads == rank;
+	}
+	else
+	{
+		unsigned long long remainder = nb_iterations % nb_threads;
+		*nb_i = nb_iterations / nb_threads;
+		*first_i = rank * (*nb_i);
+		if (rank < remainder)
+		{
+			(*nb_i)++;
+			*first_i += rank;
+		}
+		else
+		{
+			*first_i += remainder;
+		}
+		*stride = nb_iterations;
+		if (plastiter)
+			*plastiter = *nb_i > 0 && *first_i + *nb_i == nb_iterations;
+	}
+}
+
+void __kmpc_for_static_init_4(ident_t *loc, kmp_int32 gtid, kmp_int32 schedtype, kmp_int32 *plastiter,
+			      kmp_int32 *plower, kmp_int32 *pupper, kmp_int32 *pstride, kmp_int32 incr, kmp_int32 chunk)
+{
+	(void) loc;
+	(void) gtid;
+	unsigned long long first_i, nb_i, stride;
+	unsigned long long lb = (long long)*plower;
+	for_static_init(schedtype, loop_trip_count(*plower, *pupper, incr), chunk, plastiter, &first_i, &nb_i, &stride);
+	*plower = LOOP_BOUND(lb, incr, first_i);
+	*pupper = LOOP_BOUND(lb, incr, first_i + nb_i - 1);
+	*pstride = stride * incr;
+}
+
+void __kmpc_for_static_init_4u(ident_t *loc, kmp_int32 gtid, kmp_int32 schedtype, kmp_int32 *plastiter,
+			       kmp_uint32 *plower, kmp_uint32 *pupper, kmp_int32 *pstride, kmp_int32 incr, kmp_int32 chunk)
+{
+	(void) loc;
+	(void) gtid;
+	unsigned long long first_i, nb_i, stride;
+	unsigned long long lb = *plower;
+	for_static_init(schedtype, loop_trip_count_u(*plower, *pupper, incr), chunk, plastiter, &first_i, &nb_i, &stride);
+	*plower = LOOP_BOUND(lb, incr, first_i);
+	*pupper = LOOP_BOUND(lb, incr, first_i + nb_i - 1);
+	*pstride = stride * incr;
+}
+
+void __kmpc_for_static_init_8(ident_t *loc, kmp_int32 gtid, kmp_int32 schedtype, kmp_int32 *plastiter,
+			      kmp_int64 *plower, kmp_int64 *pupper, kmp_int64 *pstride, kmp_int64 incr, kmp_int64 chunk)
+{
+	(void) loc;
+	(void) gtid;
+	unsigned long long first_i, nb_i, stride;
+	unsigned long long lb = (long long)*plower;
+	for_static_init(schedtype, loop_trip_count(*plower, *pupper, incr), chunk, plastiter, &first_i, &nb_i, &stride);
+	*plower = LOOP_BOUND(lb, incr, first_i);
+	*pupper = LOOP_BOUND(lb, incr, first_i + nb_i - 1);
+	*pstride = stride * incr;
+}
+
+void __kmpc_for_static_init_8u(ident_t *loc, kmp_int32 gtid, kmp_int32 schedtype, kmp_int32 *plastiter,
+			       kmp_uint64 *plower, kmp_uint64 *pupper, kmp_int64 *pstride, kmp_int64 incr, kmp_int64 chunk)
+{
+	(void) loc;
+	(void) gtid;
+	unsigned long long first_i, nb_i, stride;
+	unsigned long long lb = *plower;
+	for_static_init(schedtype, loop_trip_count_u(*plower, *pupper, incr), chunk, plastiter, &first_i, &nb_i, &stride);
+	*plower = LOOP_BOUND(lb, incr, first_i);
+	*pupper = LOOP_BOUND(lb, incr, first_i + nb_i - 1);
+	*pstride = stride * incr;
+}
+
+void __kmpc_for_static_fini(ident_t *loc, kmp_int32 global_tid)
+{
+	(void) loc;
+	(void) global_tid;
+	/* nothing */
+}
+
+/* Dynamically scheduled loops go through the shared loop state of StarPU,
+ * the loop parameters are kept in the task until all chunks are consumed */
+static void dispatch_init(kmp_int32 schedule, unsigned long long lb, long long st, unsigned long long nb_iterations, long long chunk)
+{
+	struct starpu_omp_dispatch *dispatch = &_starpu_omp_get_task()->dispatch;
+	int chunked;
+	dispatch->lb = lb;
+	dispatch->st = st;
+	dispatch->nb_iterations = nb_iterations;
+	dispatch->schedule = loop_schedule(schedule, &dispatch->ordered, &chunked);
+	dispatch->chunk = chunked && chunk > 0 ? chunk : 0;
+	dispatch->started = 0;
+}
+
+static int dispatch_next(kmp_int32 *p_last, unsigned long long *p_lb, unsigned long long *p_ub)
+{
+	struct starpu_omp_dispatch *dispatch = &_starpu_omp_get_task()->dispatch;
+	unsigned long long nb_i;
+	int ret;
+
+	if (in_serialized())
+	{
+		/* the only thread of the team gets all the iterations at once */
+		if (dispatch->started || dispatch->nb_iterations == 0)
+			return 0;
+		dispatch->started = 1;
+		dispatch->first_i = 0;
+		nb_i = dispatch->nb_iterations;
+		ret = 1;
+	}
+	else if (!dispatch->started)
+	{
+		dispatch->started = 1;
+		ret = starpu_omp_for_inline_first(dispatch->nb_iterations, dispatch->chunk, dispatch->schedule, dispatch->ordered, &dispatch->first_i, &nb_i);
+	}
+	else
+	{
+		ret = starpu_omp_for_inline_next(dispatch->nb_iterations, dispatch->chunk, dispatch->schedule, dispatch->ordered, &dispatch->first_i, &nb_i);
+	}
+	if (!ret)
+		return 0;
+
+	*p_lb = LOOP_BOUND(dispatch->lb, dispatch->st, dispatch->first_i);
+	*p_ub = LOOP_BOUND(dispatch->lb, dispatch->st, dispatch->first_i + nb_i - 1);
+	if (p_last)
+		*p_last = dispatch->first_i + nb_i == dispatch->nb_iterations;
+	return 1;
+}
+
+void __kmpc_dispatch_init_4(ident_t *loc, kmp_int32 gtid, enum sched_type schedule, kmp_int32 lb, kmp_int32 ub, kmp_int32 st, kmp_int32 chunk)
 {
 	(void) loc;
-	abort();
+	(void) gtid;
+	dispatch_init(schedule, (long long)lb, st, loop_trip_count(lb, ub, st), chunk);
 }
 
-void __kmpc_dispatch_next_4(ident_t *loc)
+void __kmpc_dispatch_init_4u(ident_t *loc, kmp_int32 gtid, enum sched_type schedule, kmp_uint32 lb, kmp_uint32 ub, kmp_int32 st, kmp_int32 chunk)
 {
 	(void) loc;
-	abort();
+	(void) gtid;
+	dispatch_init(schedule, lb, st, loop_trip_count_u(lb, ub, st), chunk);
 }
 
-/* Work sharing */
+void __kmpc_dispatch_init_8(ident_t *loc, kmp_int32 gtid, enum sched_type schedule, kmp_int64 lb, kmp_int64 ub, kmp_int64 st, kmp_int64 chunk)
+{
+	(void) loc;
+	(void) gtid;
+	dispatch_init(schedule, (long long)lb, st, loop_trip_count(lb, ub, st), chunk);
+}
+
+void __kmpc_dispatch_init_8u(ident_t *loc, kmp_int32 gtid, enum sched_type schedule, kmp_uint64 lb, kmp_uint64 ub, kmp_int64 st, kmp_int64 chunk)
+{
+	(void) loc;
+	(void) gtid;
+	dispatch_init(schedule, lb, st, loop_trip_count_u(lb, ub, st), chunk);
+}
+
+int __kmpc_dispatch_next_4(ident_t *loc, kmp_int32 gtid, kmp_int32 *p_last, kmp_int32 *p_lb, kmp_int32 *p_ub, kmp_int32 *p_st)
+{
+	(void) loc;
+	(void) gtid;
+	unsigned long long lb, ub;
+	if (!dispatch_next(p_last, &lb, &ub))
+		return 0;
+	*p_lb = lb;
+	*p_ub = ub;
+	if (p_st)
+		*p_st = _starpu_omp_get_task()->dispatch.st;
+	return 1;
+}
+
+int __kmpc_dispatch_next_4u(ident_t *loc, kmp_int32 gtid, kmp_int32 *p_last, kmp_uint32 *p_lb, kmp_uint32 *p_ub, kmp_int32 *p_st)
+{
+	(void) loc;
+	(void) gtid;
+	unsigned long long lb, ub;
+	if (!dispatch_next(p_last, &lb, &ub))
+		return 0;
+	*p_lb = lb;
+	*p_ub = ub;
+	if (p_st)
+		*p_st = _starpu_omp_get_task()->dispatch.st;
+	return 1;
+}
+
+int __kmpc_dispatch_next_8(ident_t *loc, kmp_int32 gtid, kmp_int32 *p_last, kmp_int64 *p_lb, kmp_int64 *p_ub, kmp_int64 *p_st)
+{
+	(void) loc;
+	(void) gtid;
+	unsigned long long lb, ub;
+	if (!dispatch_next(p_last, &lb, &ub))
+		return 0;
+	*p_lb = lb;
+	*p_ub = ub;
+	if (p_st)
+		*p_st = _starpu_omp_get_task()->dispatch.st;
+	return 1;
+}
+
+int __kmpc_dispatch_next_8u(ident_t *loc, kmp_int32 gtid, kmp_int32 *p_last, kmp_uint64 *p_lb, kmp_uint64 *p_ub, kmp_int64 *p_st)
+{
+	(void) loc;
+	(void) gtid;
+	unsigned long long lb, ub;
+	if (!dispatch_next(p_last, &lb, &ub))
+		return 0;
+	*p_lb = lb;
+	*p_ub = ub;
+	if (p_st)
+		*p_st = _starpu_omp_get_task()->dispatch.st;
+	return 1;
+}
+
+/* The compiler calls these after each chunk of ordered loops. They are no-ops:
+ * the ordered iterations are accounted for by __kmpc_end_ordered, and the
+ * shared loop state is released by starpu_omp_for_inline_next() once all
+ * chunks have been handed out */
+void __kmpc_dispatch_fini_4(ident_t *loc, kmp_int32 gtid)
+{
+	(void) loc;
+	(void) gtid;
+	/* nothing */
+}
+
+void __kmpc_dispatch_fini_4u(ident_t *loc, kmp_int32 gtid)
+{
+	(void) loc;
+	(void) gtid;
+	/* nothing */
+}
+
+void __kmpc_dispatch_fini_8(ident_t *loc, kmp_int32 gtid)
+{
+	(void) loc;
+	(void) gtid;
+	/* nothing */
+}
+
+void __kmpc_dispatch_fini_8u(ident_t *loc, kmp_int32 gtid)
+{
+	(void) loc;
+	(void) gtid;
+	/* nothing */
+}
+
+/* Critical sections are identified by the address of their lock variable,
+ * whose storage, zeroed by the compiler, is used to hold the name given to
+ * StarPU */
+static starpu_pthread_mutex_t critical_names_mutex = STARPU_PTHREAD_MUTEX_INITIALIZER;
+
+static const char *critical_name(kmp_critical_name *crit)
+{
+	char *name = (char *)crit;
+	if (crit == NULL)
+		return NULL;
+	STARPU_PTHREAD_MUTEX_LOCK(&critical_names_mutex);
+	if (name[0] == '\0')
+		snprintf(name, sizeof(*crit), "%p", (void *)crit);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&critical_names_mutex);
+	return name;
+}
+
+void __kmpc_critical(ident_t *loc, kmp_int32 global_tid, kmp_critical_name *crit)
+{
+	(void) loc;
+	(void) global_tid;
+	starpu_omp_critical_inline_begin(critical_name(crit));
+}
+
+void __kmpc_critical_with_hint(ident_t *loc, kmp_int32 global_tid, kmp_critical_name *crit, uint32_t hint)
+{
+	(void) hint;
+	__kmpc_critical(loc, global_tid, crit);
+}
+
+void __kmpc_end_critical(ident_t *loc, kmp_int32 global_tid, kmp_critical_name *crit)
+{
+	(void) loc;
+	(void) global_tid;
+	starpu_omp_critical_inline_end(critical_name(crit));
+}
+
+/* Synchronization */
 void __kmpc_flush(ident_t *loc)
 {
 	(void) loc;
-	abort();
+	STARPU_SYNCHRONIZE();
 }
 
 void __kmpc_barrier(ident_t *loc, kmp_int32 global_tid)
 {
 	(void) loc;
 	(void) global_tid;
-	starpu_omp_barrier();
+	if (!in_serialized())
+		starpu_omp_barrier();
 }
 
+/* The other threads wait in a second barrier for the master to complete the
+ * code between __kmpc_barrier_master and __kmpc_end_barrier_master */
 kmp_int32 __kmpc_barrier_master(ident_t *loc, kmp_int32 global_tid)
 {
 	(void) loc;
 	(void) global_tid;
-	abort();
+	if (in_serialized())
+		return 1;
+	starpu_omp_barrier();
+	if (starpu_omp_master_inline())
+		return 1;
+	starpu_omp_barrier();
+	return 0;
 }
 
 void __kmpc_end_barrier_master(ident_t *loc, kmp_int32 global_tid)
 {
 	(void) loc;
 	(void) global_tid;
-	abort();
+	if (!in_serialized())
+		starpu_omp_barrier();
 }
 
 kmp_int32 __kmpc_barrier_master_nowait(ident_t *loc, kmp_int32 global_tid)
 {
 	(void) loc;
 	(void) global_tid;
-	abort();
+	if (in_serialized())
+		return 1;
+	starpu_omp_barrier();
+	return starpu_omp_master_inline();
 }
 
-void __kmpc_reduce_nowait(ident_t *loc, kmp_int32 global_tid, kmp_int32 num_vars, size_t reduce_size, void *reduce_data, void (*reduce_func)(void *lhs_data, void *rhs_data), kmp_critical_name *lck)
+/* Reductions: each thread combines its private copy into the shared
+ * variables itself within a critical section (return value 1), the atomic
+ * method (return value 2) is never used */
+kmp_int32 __kmpc_reduce_nowait(ident_t *loc, kmp_int32 global_tid, kmp_int32 num_vars, size_t reduce_size, void *reduce_data, void (*reduce_func)(void *lhs_data, void *rhs_data), kmp_critical_name *lck)
 {
 	(void) loc;
 	(void) global_tid;
@@ -754,36 +1248,29 @@ void __kmpc_reduce_nowait(ident_t *loc, kmp_int32 global_tid, kmp_int32 num_vars
 	(void) reduce_size;
 	(void) reduce_data;
 	(void) reduce_func;
-	(void) lck;
-	abort();
+	if (team_num_threads() > 1)
+		starpu_omp_critical_inline_begin(critical_name(lck));
+	return 1;
 }
 
 void __kmpc_end_reduce_nowait(ident_t *loc, kmp_int32 global_tid, kmp_critical_name *lck)
 {
 	(void) loc;
 	(void) global_tid;
-	(void) lck;
-	abort();
+	if (team_num_threads() > 1)
+		starpu_omp_critical_inline_end(critical_name(lck));
 }
 
-void __kmpc_reduce(ident_t *loc, kmp_int32 global_tid, kmp_int32 num_vars, size_t reduce_size, void *reduce_data, void (*reduce_func)(void *lhs_data, void *rhs_data), kmp_critical_name *lck)
+kmp_int32 __kmpc_reduce(ident_t *loc, kmp_int32 global_tid, kmp_int32 num_vars, size_t reduce_size, void *reduce_data, void (*reduce_func)(void *lhs_data, void *rhs_data), kmp_critical_name *lck)
 {
-	(void) loc;
-	(void) global_tid;
-	(void) num_vars;
-	(void) reduce_size;
-	(void) reduce_data;
-	(void) reduce_func;
-	(void) lck;
-	abort();
+	return __kmpc_reduce_nowait(loc, global_tid, num_vars, reduce_size, reduce_data, reduce_func, lck);
 }
 
 void __kmpc_end_reduce(ident_t *loc, kmp_int32 global_tid, kmp_critical_name *lck)
 {
-	(void) loc;
-	(void) global_tid;
-	(void) lck;
-	abort();
+	__kmpc_end_reduce_nowait(loc, global_tid, lck);
+	if (!in_serialized())
+		starpu_omp_barrier();
 }
 
 /* lib constructor/destructor */
@@ -817,12 +1304,12 @@ void omp_set_num_threads(int threads)
 
 int omp_get_num_threads()
 {
-	return starpu_omp_get_num_threads();
+	return team_num_threads();
 }
 
 int omp_get_thread_num()
 {
-	return starpu_omp_get_thread_num();
+	return team_thread_num();
 }
 
 int omp_get_max_threads()
@@ -892,7 +1379,9 @@ int omp_get_max_active_levels(void)
 
 int omp_get_level(void)
 {
-	return starpu_omp_get_level();
+	/* serialized regions are inactive, but still count as levels */
+	struct starpu_omp_task *task = _starpu_omp_get_task();
+	return starpu_omp_get_level() + (task ? task->serialized_level : 0);
 }
 
 int omp_get_ancestor_thread_num(int level)
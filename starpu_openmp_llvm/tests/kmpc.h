@@ -0,0 +1,119 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#ifndef __KMPC_H__
+#define __KMPC_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The part of the libomp ABI which clang-generated code uses, as implemented
+ * by starpu_openmp_llvm/src/openmp_runtime_support_llvm.c, so that the tests
+ * can make the same calls as the compiler
+ */
+
+typedef struct ident ident_t;
+typedef int32_t kmp_int32;
+typedef uint32_t kmp_uint32;
+typedef int64_t kmp_int64;
+typedef uint64_t kmp_uint64;
+typedef void * kmp_intptr_t;
+typedef kmp_int32 kmp_critical_name[8];
+
+typedef void(* kmpc_micro) (kmp_int32 *global_tid, kmp_int32 *bound_tid,...);
+typedef kmp_int32 (*kmp_routine_entry_t)(kmp_int32 gtid, void *kmp_task);
+
+typedef struct kmp_depend_info
+{
+	kmp_intptr_t base_addr;
+	size_t len;
+	struct
+	{
+		bool in : 1;
+		bool out : 1;
+		bool mtx : 1;
+		bool set : 1;
+	} flags;
+	size_t elem_size;
+} kmp_depend_info_t;
+
+typedef union kmp_cmplrdata
+{
+	kmp_int32 priority;
+	kmp_routine_entry_t destructors;
+} kmp_cmplrdata_t;
+
+typedef struct kmp_task
+{
+	void *shareds;
+	kmp_routine_entry_t routine;
+	kmp_int32 part_id;
+	kmp_cmplrdata_t data1;
+	kmp_cmplrdata_t data2;
+} kmp_task_t;
+
+enum sched_type
+{
+	kmp_sch_static_chunked	= 33,
+	kmp_sch_static	= 34,
+	kmp_sch_dynamic_chunked	= 35,
+	kmp_ord_dynamic_chunked	= 67,
+};
+
+kmp_int32 __kmpc_global_thread_num(ident_t *loc);
+void __kmpc_push_num_threads(ident_t *loc, kmp_int32 global_tid, kmp_int32 num_threads);
+void __kmpc_fork_call(ident_t *loc, kmp_int32 argc, kmpc_micro microtask, ...);
+void __kmpc_serialized_parallel(ident_t *loc, kmp_int32 global_tid);
+void __kmpc_end_serialized_parallel(ident_t *loc, kmp_int32 global_tid);
+
+kmp_int32 __kmpc_master(ident_t *loc, kmp_int32 global_tid);
+void __kmpc_end_master(ident_t *loc, kmp_int32 global_tid);
+kmp_int32 __kmpc_single(ident_t *loc, kmp_int32 global_tid);
+void __kmpc_end_single(ident_t *loc, kmp_int32 global_tid);
+void __kmpc_ordered(ident_t *loc, kmp_int32 global_tid);
+void __kmpc_end_ordered(ident_t *loc, kmp_int32 global_tid);
+void __kmpc_critical(ident_t *loc, kmp_int32 global_tid, kmp_critical_name *crit);
+void __kmpc_end_critical(ident_t *loc, kmp_int32 global_tid, kmp_critical_name *crit);
+void __kmpc_barrier(ident_t *loc, kmp_int32 global_tid);
+kmp_int32 __kmpc_barrier_master(ident_t *loc, kmp_int32 global_tid);
+void __kmpc_end_barrier_master(ident_t *loc, kmp_int32 global_tid);
+
+void __kmpc_for_static_init_4(ident_t *loc, kmp_int32 gtid, kmp_int32 schedtype, kmp_int32 *plastiter,
+			      kmp_int32 *plower, kmp_int32 *pupper, kmp_int32 *pstride, kmp_int32 incr, kmp_int32 chunk);
+void __kmpc_for_static_fini(ident_t *loc, kmp_int32 global_tid);
+void __kmpc_dispatch_init_4(ident_t *loc, kmp_int32 gtid, enum sched_type schedule, kmp_int32 lb, kmp_int32 ub, kmp_int32 st, kmp_int32 chunk);
+int __kmpc_dispatch_next_4(ident_t *loc, kmp_int32 gtid, kmp_int32 *p_last, kmp_int32 *p_lb, kmp_int32 *p_ub, kmp_int32 *p_st);
+void __kmpc_dispatch_fini_4(ident_t *loc, kmp_int32 gtid);
+void __kmpc_dispatch_init_8u(ident_t *loc, kmp_int32 gtid, enum sched_type schedule, kmp_uint64 lb, kmp_uint64 ub, kmp_int64 st, kmp_int64 chunk);
+int __kmpc_dispatch_next_8u(ident_t *loc, kmp_int32 gtid, kmp_int32 *p_last, kmp_uint64 *p_lb, kmp_uint64 *p_ub, kmp_int64 *p_st);
+
+kmp_int32 __kmpc_reduce_nowait(ident_t *loc, kmp_int32 global_tid, kmp_int32 num_vars, size_t reduce_size, void *reduce_data, void (*reduce_func)(void *lhs_data, void *rhs_data), kmp_critical_name *lck);
+void __kmpc_end_reduce_nowait(ident_t *loc, kmp_int32 global_tid, kmp_critical_name *lck);
+
+kmp_task_t *__kmpc_omp_task_alloc(ident_t *loc_ref, kmp_int32 gtid, kmp_int32 flags,
+				  size_t sizeof_kmp_task_t, size_t sizeof_shareds, kmp_routine_entry_t task_entry);
+kmp_int32 __kmpc_omp_task_with_deps(ident_t *loc_ref, kmp_int32 gtid, kmp_task_t *new_task,
+				    kmp_int32 ndeps, kmp_depend_info_t *dep_list,
+				    kmp_int32 ndeps_noalias, kmp_depend_info_t *noalias_dep_list);
+kmp_int32 __kmpc_omp_taskwait(ident_t *loc_ref, kmp_int32 gtid);
+
+int omp_get_thread_num(void);
+int omp_get_num_threads(void);
+int omp_get_level(void);
+
+#endif /* __KMPC_H__ */
@@ -0,0 +1,157 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "kmpc.h"
+
+/*
+ * Check that tasks with depend clauses on overlapping but different array
+ * sections depend on each other, by calling the task entry points of the
+ * OpenMP LLVM support the way clang-generated code does
+ */
+
+#define N 64
+
+static int x[N];
+static int y[N/2];
+static int failed;
+
+#define FPRINTF(ofile, fmt, ...) do { if (!getenv("STARPU_SSILENT")) {fprintf(ofile, fmt, ## __VA_ARGS__); }} while(0)
+
+/* depend(out: x[0:N]): slow, so that the readers would run before if they
+ * did not depend on it */
+static kmp_int32 init_x(kmp_int32 gtid, void *task)
+{
+	(void) gtid;
+	(void) task;
+	int i;
+	usleep(100000);
+	for (i = 0; i < N; i++)
+		x[i] = i;
+	return 0;
+}
+
+/* depend(in: x[N/2:N/2]) depend(out: y[0:N/2]) */
+static kmp_int32 copy_half(kmp_int32 gtid, void *task)
+{
+	(void) gtid;
+	(void) task;
+	int i;
+	for (i = 0; i < N/2; i++)
+		y[i] = x[N/2 + i];
+	return 0;
+}
+
+/* depend(mutexinoutset: x[0:N]) depend(in: x[0:N/2]): the increments of
+ * the different tasks must not be interleaved */
+static kmp_int32 increment_x(kmp_int32 gtid, void *task)
+{
+	(void) gtid;
+	(void) task;
+	int i;
+	for (i = 0; i < N; i++)
+	{
+		int val = x[i];
+		if (i == N/2)
+			usleep(10000);
+		x[i] = val + 1;
+	}
+	return 0;
+}
+
+static void set_dep(kmp_depend_info_t *dep, void *ptr, size_t len, int in, int out, int mtx)
+{
+	memset(dep, 0, sizeof(*dep));
+	dep->base_addr = ptr;
+	dep->len = len;
+	dep->elem_size = sizeof(int);
+	dep->flags.in = in;
+	dep->flags.out = out;
+	dep->flags.mtx = mtx;
+}
+
+static void submit(kmp_int32 gtid, kmp_routine_entry_t routine, kmp_int32 ndeps, kmp_depend_info_t *deps)
+{
+	kmp_task_t *task = __kmpc_omp_task_alloc(NULL, gtid, 1, sizeof(kmp_task_t), 0, routine);
+	__kmpc_omp_task_with_deps(NULL, gtid, task, ndeps, deps, 0, NULL);
+}
+
+static void parallel_microtask(kmp_int32 *gtid, kmp_int32 *btid)
+{
+	(void) btid;
+	kmp_depend_info_t deps[2];
+	int i;
+
+	if (!__kmpc_single(NULL, *gtid))
+	{
+		__kmpc_barrier(NULL, *gtid);
+		return;
+	}
+
+	set_dep(&deps[0], x, N, 0, 1, 0);
+	submit(*gtid, init_x, 1, deps);
+
+	set_dep(&deps[0], &x[N/2], N/2, 1, 0, 0);
+	set_dep(&deps[1], y, N/2, 0, 1, 0);
+	submit(*gtid, copy_half, 2, deps);
+
+	/* Each of the two items overlaps the other one, their accesses get
+	 * merged on the same handles */
+	for (i = 0; i < 4; i++)
+	{
+		set_dep(&deps[0], x, N, 0, 0, 1);
+		set_dep(&deps[1], x, N/2, 1, 0, 0);
+		submit(*gtid, increment_x, 2, deps);
+	}
+
+	__kmpc_omp_taskwait(NULL, *gtid);
+	__kmpc_end_single(NULL, *gtid);
+	__kmpc_barrier(NULL, *gtid);
+}
+
+int main(void)
+{
+	int i;
+
+	for (i = 0; i < N; i++)
+		x[i] = -1;
+
+	__kmpc_fork_call(NULL, 0, (kmpc_micro) parallel_microtask);
+
+	for (i = 0; i < N/2; i++)
+	{
+		if (y[i] != N/2 + i)
+		{
+			FPRINTF(stderr, "y[%d] is %d instead of %d\n", i, y[i], N/2 + i);
+			failed = 1;
+			break;
+		}
+	}
+	for (i = 0; i < N; i++)
+	{
+		if (x[i] != i + 4)
+		{
+			FPRINTF(stderr, "x[%d] is %d instead of %d\n", i, x[i], i + 4);
+			failed = 1;
+			break;
+		}
+	}
+
+	return failed;
+}
@@ -0,0 +1,261 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "kmpc.h"
+
+/*
+ * Check the worksharing entry points of the OpenMP LLVM support by calling
+ * them the way clang-generated code does, so that this does not need clang
+ */
+
+#define N 1000
+
+static int hits[N];
+static int order[N];
+static int norder;
+static long sum;
+static int failed;
+static kmp_critical_name crit_lock;
+static kmp_critical_name reduce_lock;
+
+#define FPRINTF(ofile, fmt, ...) do { if (!getenv("STARPU_SSILENT")) {fprintf(ofile, fmt, ## __VA_ARGS__); }} while(0)
+
+static void check_sum(const char *name)
+{
+	if (sum != (long) N*(N-1)/2)
+	{
+		FPRINTF(stderr, "%s: sum is %ld instead of %ld\n", name, sum, (long) N*(N-1)/2);
+		failed = 1;
+	}
+	sum = 0;
+}
+
+static void check_hits(const char *name)
+{
+	int i;
+	for (i = 0; i < N; i++)
+	{
+		if (hits[i] != 1)
+		{
+			FPRINTF(stderr, "%s: iteration %d executed %d times\n", name, i, hits[i]);
+			failed = 1;
+			break;
+		}
+	}
+	memset(hits, 0, sizeof(hits));
+}
+
+/* #pragma omp for schedule(static[, chunk]) reduction(+:sum), with a stride of 2 */
+static void static_loop(kmp_int32 gtid, kmp_int32 schedtype, kmp_int32 chunk)
+{
+	kmp_int32 last = 0, lower = 0, upper = 2*N-1, stride = 1;
+	kmp_int32 i;
+	long local_sum = 0;
+
+	__kmpc_for_static_init_4(NULL, gtid, schedtype, &last, &lower, &upper, &stride, 2, chunk);
+	for (; lower <= 2*N-1; lower += stride, upper += stride)
+	{
+		for (i = lower; i <= upper && i <= 2*N-1; i += 2)
+		{
+			__sync_fetch_and_add(&hits[i/2], 1);
+			local_sum += i/2;
+		}
+		if (schedtype == kmp_sch_static)
+			break;
+	}
+	__kmpc_for_static_fini(NULL, gtid);
+
+	if (__kmpc_reduce_nowait(NULL, gtid, 1, sizeof(local_sum), &local_sum, NULL, &reduce_lock) == 1)
+	{
+		sum += local_sum;
+		__kmpc_end_reduce_nowait(NULL, gtid, &reduce_lock);
+	}
+	__kmpc_barrier(NULL, gtid);
+}
+
+/* #pragma omp for schedule(dynamic, 7) on an unsigned 64bit loop going down */
+static void dynamic_loop(kmp_int32 gtid)
+{
+	kmp_int32 last;
+	kmp_uint64 lower, upper;
+	kmp_int64 stride;
+	kmp_uint64 i;
+
+	__kmpc_dispatch_init_8u(NULL, gtid, kmp_sch_dynamic_chunked, N-1, 0, -1, 7);
+	while (__kmpc_dispatch_next_8u(NULL, gtid, &last, &lower, &upper, &stride))
+	{
+		for (i = lower; i + 1 >= upper + 1; i--)
+			__sync_fetch_and_add(&hits[i], 1);
+	}
+	__kmpc_barrier(NULL, gtid);
+}
+
+/* #pragma omp for ordered schedule(dynamic) */
+static void ordered_loop(kmp_int32 gtid)
+{
+	kmp_int32 last, lower, upper, stride;
+	kmp_int32 i;
+
+	__kmpc_dispatch_init_4(NULL, gtid, kmp_ord_dynamic_chunked, 0, N-1, 1, 1);
+	while (__kmpc_dispatch_next_4(NULL, gtid, &last, &lower, &upper, &stride))
+	{
+		for (i = lower; i <= upper; i++)
+		{
+			__kmpc_ordered(NULL, gtid);
+			order[norder++] = i;
+			__kmpc_end_ordered(NULL, gtid);
+			__kmpc_dispatch_fini_4(NULL, gtid);
+		}
+	}
+	__kmpc_barrier(NULL, gtid);
+}
+
+static void check_order(const char *name)
+{
+	int i;
+	if (norder != N)
+	{
+		FPRINTF(stderr, "%s: %d ordered iterations instead of %d\n", name, norder, N);
+		failed = 1;
+	}
+	for (i = 0; i < norder; i++)
+	{
+		if (order[i] != i)
+		{
+			FPRINTF(stderr, "%s: iteration %d executed at position %d\n", name, order[i], i);
+			failed = 1;
+			break;
+		}
+	}
+	norder = 0;
+}
+
+static void worksharing(kmp_int32 gtid)
+{
+	static_loop(gtid, kmp_sch_static, 0);
+	if (__kmpc_single(NULL, gtid))
+	{
+		check_hits("static");
+		check_sum("static");
+		__kmpc_end_single(NULL, gtid);
+	}
+	__kmpc_barrier(NULL, gtid);
+
+	static_loop(gtid, kmp_sch_static_chunked, 3);
+	if (__kmpc_master(NULL, gtid))
+	{
+		check_hits("static chunked");
+		check_sum("static chunked");
+		__kmpc_end_master(NULL, gtid);
+	}
+	__kmpc_barrier(NULL, gtid);
+
+	dynamic_loop(gtid);
+	if (__kmpc_barrier_master(NULL, gtid))
+	{
+		check_hits("dynamic");
+		__kmpc_end_barrier_master(NULL, gtid);
+	}
+
+	ordered_loop(gtid);
+	if (__kmpc_single(NULL, gtid))
+	{
+		check_order("ordered");
+		__kmpc_end_single(NULL, gtid);
+	}
+	__kmpc_barrier(NULL, gtid);
+}
+
+/* #pragma omp parallel if(0) */
+static void serialized_microtask(kmp_int32 *gtid, kmp_int32 *btid, int *outer_num)
+{
+	(void) btid;
+	if (omp_get_thread_num() != 0 || omp_get_num_threads() != 1)
+	{
+		FPRINTF(stderr, "serialized region: thread %d of %d\n", omp_get_thread_num(), omp_get_num_threads());
+		failed = 1;
+	}
+
+	/* the thread has all the iterations for itself */
+	static_loop(*gtid, kmp_sch_static, 0);
+	check_hits("serialized static loop");
+	check_sum("serialized static loop");
+	dynamic_loop(*gtid);
+	check_hits("serialized dynamic loop");
+	ordered_loop(*gtid);
+	check_order("serialized ordered loop");
+	(*outer_num)++;
+}
+
+static void parallel_microtask(kmp_int32 *gtid, kmp_int32 *btid, int *count, int *nthreads)
+{
+	(void) btid;
+	int outer_num = omp_get_thread_num();
+	int outer_level = omp_get_level();
+
+	__kmpc_critical(NULL, *gtid, &crit_lock);
+	(*count)++;
+	*nthreads = omp_get_num_threads();
+	__kmpc_end_critical(NULL, *gtid, &crit_lock);
+
+	worksharing(*gtid);
+
+	/* Only one thread at a time, since the serialized regions share the
+	 * result arrays */
+	__kmpc_critical(NULL, *gtid, &crit_lock);
+	__kmpc_serialized_parallel(NULL, *gtid);
+	if (omp_get_level() != outer_level + 1)
+	{
+		FPRINTF(stderr, "serialized region at level %d instead of %d\n", omp_get_level(), outer_level + 1);
+		failed = 1;
+	}
+	serialized_microtask(gtid, btid, &outer_num);
+	__kmpc_end_serialized_parallel(NULL, *gtid);
+	__kmpc_end_critical(NULL, *gtid, &crit_lock);
+
+	if (omp_get_thread_num() + 1 != outer_num)
+	{
+		FPRINTF(stderr, "thread number %d lost after the serialized region\n", omp_get_thread_num());
+		failed = 1;
+	}
+	__kmpc_barrier(NULL, *gtid);
+}
+
+int main(void)
+{
+	int count = 0, nthreads = 0;
+	int outer_num = 0;
+	kmp_int32 gtid = __kmpc_global_thread_num(NULL);
+
+	__kmpc_push_num_threads(NULL, gtid, 3);
+	__kmpc_fork_call(NULL, 2, (kmpc_micro) parallel_microtask, &count, &nthreads);
+	if (count != nthreads || nthreads < 1 || nthreads > 3)
+	{
+		FPRINTF(stderr, "%d threads ran the region of %d threads\n", count, nthreads);
+		failed = 1;
+	}
+
+	/* serialized region outside of any parallel region */
+	__kmpc_serialized_parallel(NULL, gtid);
+	serialized_microtask(&gtid, &gtid, &outer_num);
+	__kmpc_end_serialized_parallel(NULL, gtid);
+
+	return failed;
+}
@@ -17,6 +17,7 @@ package fr.labri.hpccloud.starpu.data;
 
 import fr.labri.hpccloud.starpu.Codelet;
 
+import java.nio.ByteBuffer;
 import java.util.Iterator;
 
 public abstract class DataHandle
@@ -200,6 +201,8 @@ public abstract class DataHandle
 
 	protected static native int vectorGetSize(long handle);
 
+	protected static native ByteBuffer vectorGetByteBuffer(long handle);
+
 	protected static native long vectorRegisterInt(int size);
 
 	protected static native int vectorGetIntAt(long handle, int index);
@@ -15,6 +15,8 @@
 //
 package fr.labri.hpccloud.starpu.data;
 
+import java.nio.IntBuffer;
+
 public class IntegerVectorHandle extends ScalarVectorHandle
 {
 	protected IntegerVectorHandle(long handle)
@@ -36,4 +38,9 @@ public class IntegerVectorHandle extends ScalarVectorHandle
 	{
 		vectorSetIntAt(nativeHandle, index, value);
 	}
+
+	public IntBuffer getIntBuffer()
+	{
+		return getByteBuffer().asIntBuffer();
+	}
 }
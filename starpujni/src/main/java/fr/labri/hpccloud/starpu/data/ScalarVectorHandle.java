@@ -15,6 +15,9 @@
 //
 package fr.labri.hpccloud.starpu.data;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
 public abstract class ScalarVectorHandle<T> extends DataHandle
 {
 	protected ScalarVectorHandle(long handle)
@@ -26,4 +29,15 @@ public abstract class ScalarVectorHandle<T> extends DataHandle
 	{
 		return vectorGetSize(nativeHandle);
 	}
+
+	/**
+	 * Give a direct access to the elements of the vector, without copying
+	 * them. The buffer is only valid while the data is accessed, i.e. in
+	 * the codelet which received this handle or between acquire() and
+	 * release().
+	 */
+	public ByteBuffer getByteBuffer()
+	{
+		return vectorGetByteBuffer(nativeHandle).order(ByteOrder.nativeOrder());
+	}
 }
@@ -0,0 +1,119 @@
+// StarPU --- Runtime system for heterogeneous multicore architectures.
+//
+// Copyright (C) 2020-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+//
+// StarPU is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or (at
+// your option) any later version.
+//
+// StarPU is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+// See the GNU Lesser General Public License in COPYING.LGPL for more details.
+//
+package fr.labri.hpccloud.starpu.examples;
+
+import fr.labri.hpccloud.starpu.Codelet;
+import fr.labri.hpccloud.starpu.StarPU;
+import fr.labri.hpccloud.starpu.data.DataHandle;
+import fr.labri.hpccloud.starpu.data.IntegerVectorHandle;
+
+import java.nio.IntBuffer;
+
+import static fr.labri.hpccloud.starpu.data.DataHandle.AccessMode.*;
+
+/*
+ * Measure the cost of running tiny Java codelets, which is mostly the cost
+ * of calling the Java code from the StarPU workers.
+ */
+public class CodeletOverhead
+{
+	public static final int NTASKS = 10000;
+	public static final int NX = 16;
+
+	static final Codelet empty = new Codelet()
+	{
+		@Override
+		public void run(DataHandle[] buffers)
+		{
+		}
+
+		@Override
+		public DataHandle.AccessMode[] getAccessModes()
+		{
+			return new DataHandle.AccessMode[]
+			{
+				STARPU_RW
+			};
+		}
+	};
+
+	static final Codelet increment = new Codelet()
+	{
+		@Override
+		public void run(DataHandle[] buffers)
+		{
+			IntBuffer v = ((IntegerVectorHandle) buffers[0]).getIntBuffer();
+			for (int i = 0; i < v.capacity(); i++)
+			{
+				v.put(i, v.get(i) + 1);
+			}
+		}
+
+		@Override
+		public DataHandle.AccessMode[] getAccessModes()
+		{
+			return new DataHandle.AccessMode[]
+			{
+				STARPU_RW
+			};
+		}
+	};
+
+	public static void main(String[] args) throws Exception
+	{
+		int ntasks = (args.length == 0) ? NTASKS : Integer.valueOf(args[0]);
+		compute(ntasks);
+	}
+
+	static double run(Codelet codelet, int ntasks, IntegerVectorHandle handle) throws Exception
+	{
+		long start = System.nanoTime();
+		for (int i = 0; i < ntasks; i++)
+		{
+			StarPU.submitTask(codelet, false, handle);
+		}
+		StarPU.taskWaitForAll();
+		long end = System.nanoTime();
+
+		return (end - start) / 1000.0 / ntasks;
+	}
+
+	public static void compute(int ntasks) throws Exception
+	{
+		StarPU.init();
+		IntegerVectorHandle handle = IntegerVectorHandle.register(NX);
+
+		/* warm up the workers and the JIT */
+		run(empty, ntasks, handle);
+
+		System.out.println(String.format("#tasks : %d", ntasks));
+		System.out.println(String.format("Per empty task: %f usecs", run(empty, ntasks, handle)));
+		System.out.println(String.format("Per increment task: %f usecs", run(increment, ntasks, handle)));
+
+		handle.acquire();
+		for (int i = 0; i < NX; i++)
+		{
+			if (handle.getValueAt(i) != ntasks)
+			{
+				throw new RuntimeException(String.format("v[%d] = %d instead of %d", i, handle.getValueAt(i), ntasks));
+			}
+		}
+		handle.release();
+
+		handle.unregister();
+		StarPU.shutdown();
+	}
+}
@@ -14,6 +14,7 @@
  * See the GNU Lesser General Public License in COPYING.LGPL for more details.
  */
 #include <assert.h>
+#include <pthread.h>
 #include <jni.h>
 #include "starpujni-data.h"
 #include "starpujni-codelet.h"
@@ -55,12 +56,82 @@ static const struct jclass_spec CODELET_CLASS_SPEC =
 	CODELET_FIELDS_SPEC
 };
 
+/*
+ * Java state kept by each native thread which runs Java codelets. The thread
+ * is attached to the VM on its first codelet and stays attached until it
+ * exits. The arrays and handle objects passed to Codelet.run() are allocated
+ * for each task, since the codelet may keep references to them.
+ */
+struct starpujni_thread
+{
+	JNIEnv *env;
+	int attached;
+};
+
+static pthread_key_t thread_key;
+static pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+
 static void s_invoke_java_codelet(void *buffers[], void *cl_arg);
 
+static void s_thread_destroy(void *data)
+{
+	struct starpujni_thread *thread = data;
+
+	/* Threads which were already attached are managed by their owner, which
+	 * may have detached them already */
+	if (thread->attached)
+		(*THE_VM)->DetachCurrentThread(THE_VM);
+	free(thread);
+}
+
+static void s_thread_key_create(void)
+{
+	pthread_key_create(&thread_key, s_thread_destroy);
+}
+
+static struct starpujni_thread *s_get_thread(void)
+{
+	struct starpujni_thread *thread = pthread_getspecific(thread_key);
+	JNIEnv *env = NULL;
+	int attached = 0;
+
+	/* The environment of a thread which we attached ourselves stays valid */
+	if (thread != NULL && thread->attached)
+		return thread;
+
+	if ((*THE_VM)->GetEnv(THE_VM, (void **) &env, JNI_VERSION_1_6) == JNI_EDETACHED)
+	{
+		if ((*THE_VM)->AttachCurrentThreadAsDaemon(THE_VM, (void **) &env, NULL) != JNI_OK)
+			return NULL;
+		attached = 1;
+	}
+	if (env == NULL)
+		return NULL;
+
+	if (thread == NULL)
+	{
+		thread = calloc(1, sizeof(*thread));
+		pthread_setspecific(thread_key, thread);
+	}
+	thread->env = env;
+	thread->attached = attached;
+
+	return thread;
+}
+
+JNIEnv *starpujni_get_thread_env(void)
+{
+	struct starpujni_thread *thread = s_get_thread();
+
+	return thread == NULL ? NULL : thread->env;
+}
+
 int starpujni_codelet_init(JNIEnv *env)
 {
 	assert(codelet_class == NULL);
 
+	pthread_once(&thread_key_once, s_thread_key_create);
+
 	return (starpujni_cache_class(env, &CODELET_CLASS_SPEC));
 }
 
@@ -165,21 +236,41 @@ static void s_invoke_java_codelet(void *buffers[], void *cl_arg)
 	jint i;
 	jobjectArray params;
 	struct starpujni_codelet *jcl = cl_arg;
-	JNIEnv *env = NULL;
+	struct starpujni_thread *thread = s_get_thread();
+	JNIEnv *env;
 
-	if ((*THE_VM)->AttachCurrentThread(THE_VM, (void **) &env, NULL) != JNI_OK)
+	if (thread == NULL)
 	{
 		fprintf(stderr, "Cannot attach current thread.\n");
 		return;
 	}
+	env = thread->env;
+
+	/* The thread stays attached, so local references would otherwise pile
+	 * up from one task to the other */
+	if ((*env)->PushLocalFrame(env, jcl->cl.nbuffers + 1) != 0)
+		goto out;
+
 	params = (*env)->NewObjectArray(env, jcl->cl.nbuffers, starpujni_data_handle_class, NULL);
+	if (params == NULL)
+		goto pop;
+
 	for (i = 0; i < jcl->cl.nbuffers; i++)
 	{
-		jobject hdl = (*env)->NewObject(env, jcl->handle_classes[i],
-						jcl->constructors[i],
-						PTR_SET_MARK(buffers[i]));
+		jobject hdl = (*env)->NewObject(env, jcl->handle_classes[i], jcl->constructors[i], PTR_SET_MARK(buffers[i]));
+		if (hdl == NULL)
+			goto pop;
 		(*env)->SetObjectArrayElement(env, params, i, hdl);
 	}
 	(*env)->CallVoidMethod(env, jcl->java_codelet, codelet_run_id, params);
-	(*THE_VM)->DetachCurrentThread(THE_VM);
+
+pop:
+	(*env)->PopLocalFrame(env, NULL);
+out:
+	/* The thread stays attached, do not let an exception leak to the next task */
+	if ((*env)->ExceptionCheck(env))
+	{
+		(*env)->ExceptionDescribe(env);
+		(*env)->ExceptionClear(env);
+	}
 }
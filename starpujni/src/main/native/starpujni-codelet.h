@@ -39,4 +39,6 @@ EXTERN void starpujni_codelet_set_ith_buffer_interface(JNIEnv *env, struct starp
 
 EXTERN void starpujni_codelet_destroy(JNIEnv *env, struct starpujni_codelet *cl);
 
+EXTERN JNIEnv *starpujni_get_thread_env(void);
+
 #endif /* __STARPUJNI_CODELET__ */
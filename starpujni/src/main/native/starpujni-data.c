@@ -306,6 +306,31 @@ JNIEXPORT jint JNICALL STARPU_DATA_FUNCNAME(DataHandle, vectorGetSize)(JNIEnv *e
 		     return (jint) STARPU_VECTOR_GET_NX(hdl));
 }
 
+/*
+ * Class:     fr_labri_hpccloud_starpu_data_DataHandle
+ * Method:    vectorGetByteBuffer
+ * Signature: (J)Ljava/nio/ByteBuffer;
+ */
+JNIEXPORT jobject JNICALL STARPU_DATA_FUNCNAME(DataHandle, vectorGetByteBuffer)(JNIEnv *env, jclass cls, jlong handle)
+{
+	void *ptr;
+	jlong size;
+	/* Not SELECT_ALGO: its arguments cannot be blocks */
+	if (PTR_HAS_MARK(handle))
+	{
+		void *hdl = PTR_GET_ADDR(handle);
+		ptr = (void *) STARPU_VECTOR_GET_PTR(hdl);
+		size = (jlong) STARPU_VECTOR_GET_NX(hdl) * STARPU_VECTOR_GET_ELEMSIZE(hdl);
+	}
+	else
+	{
+		starpu_data_handle_t hdl = (starpu_data_handle_t) handle;
+		ptr = (void *) starpu_vector_get_local_ptr(hdl);
+		size = (jlong) starpu_vector_get_nx(hdl) * starpu_vector_get_elemsize(hdl);
+	}
+	return (*env)->NewDirectByteBuffer(env, ptr, size);
+}
+
 static jlong s_register_vector(size_t elementSize, size_t nbElements)
 {
 	starpu_data_handle_t hdl = NULL;
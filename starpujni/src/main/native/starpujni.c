@@ -73,12 +73,9 @@ JNIEXPORT void JNICALL STARPUJNI_FUNCNAME(StarPUException, throwStarPUException)
 static void s_clear_task(void *data)
 {
 	struct starpu_task *task = data;
-	JNIEnv *env = NULL;
-	if ((*THE_VM)->AttachCurrentThread(THE_VM, (void **) &env, NULL) == JNI_OK)
-	{
+	JNIEnv *env = starpujni_get_thread_env();
+	if (env != NULL)
 		starpujni_codelet_destroy(env, task->cl_arg);
-		(*THE_VM)->DetachCurrentThread(THE_VM);
-	}
 }
 
 JNIEXPORT jlong JNICALL STARPUJNI_FUNCNAME(StarPU, submitTask_1)(JNIEnv *env, jclass cls, jobject codelet, jobjectArray jhandles)
@@ -0,0 +1,137 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2010-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Make data bounce in read-write mode between CPU workers of different NUMA
+ * nodes, so that it gets migrated rather than copied, and check its content.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define ITER 4
+#else
+#define ITER 32
+#endif
+#define NX (1024*1024)
+
+static void init_func(void *descr[], void *arg)
+{
+	int *v = (int *) STARPU_VECTOR_GET_PTR(descr[0]);
+	unsigned n = STARPU_VECTOR_GET_NX(descr[0]);
+	unsigned i;
+	(void)arg;
+
+	for (i = 0; i < n; i++)
+		v[i] = i;
+}
+
+static void inc_func(void *descr[], void *arg)
+{
+	int *v = (int *) STARPU_VECTOR_GET_PTR(descr[0]);
+	unsigned n = STARPU_VECTOR_GET_NX(descr[0]);
+	unsigned i;
+	int iter;
+
+	starpu_codelet_unpack_args(arg, &iter);
+	for (i = 0; i < n; i++)
+	{
+		STARPU_ASSERT_MSG(v[i] == (int) i + iter, "v[%u] is %d instead of %d\n", i, v[i], (int) i + iter);
+		v[i]++;
+	}
+}
+
+static struct starpu_codelet init_cl =
+{
+	.cpu_funcs = { init_func },
+	.nbuffers = 1,
+	.modes = { STARPU_W },
+};
+
+static struct starpu_codelet inc_cl =
+{
+	.cpu_funcs = { inc_func },
+	.nbuffers = 1,
+	.modes = { STARPU_RW },
+};
+
+int main(void)
+{
+	starpu_data_handle_t handle;
+	int workers[STARPU_NMAXWORKERS];
+	int worker[2] = { -1, -1 };
+	unsigned nworkers, i, migrated = 0;
+	int iter, ret;
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	/* Find two CPU workers on different NUMA nodes */
+	nworkers = starpu_worker_get_ids_by_type(STARPU_CPU_WORKER, workers, STARPU_NMAXWORKERS);
+	for (i = 0; i < nworkers; i++)
+	{
+		if (worker[0] == -1)
+			worker[0] = workers[i];
+		else if (starpu_worker_get_memory_node(workers[i]) != starpu_worker_get_memory_node(worker[0]))
+		{
+			worker[1] = workers[i];
+			break;
+		}
+	}
+	if (starpu_memory_nodes_get_numa_count() <= 1 || worker[1] == -1)
+	{
+		/* We need several NUMA nodes */
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	starpu_vector_data_register(&handle, -1, 0, NX, sizeof(int));
+
+	ret = starpu_task_insert(&init_cl, STARPU_W, handle, STARPU_EXECUTE_ON_WORKER, worker[0], 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+
+	for (iter = 0; iter < ITER; iter++)
+	{
+		int w = worker[(iter + 1) % 2];
+		unsigned src_node = starpu_worker_get_memory_node(worker[iter % 2]);
+
+		ret = starpu_task_insert(&inc_cl, STARPU_RW, handle,
+					 STARPU_VALUE, &iter, sizeof(iter),
+					 STARPU_EXECUTE_ON_WORKER, w, 0);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+
+		starpu_task_wait_for_all();
+		if (!starpu_data_test_if_allocated_on_node(handle, src_node))
+			migrated++;
+	}
+
+	ret = starpu_data_acquire(handle, STARPU_R);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire");
+	{
+		int *v = (int *) starpu_data_get_local_ptr(handle);
+		for (i = 0; i < NX; i++)
+			STARPU_ASSERT(v[i] == (int) i + ITER);
+	}
+	starpu_data_release(handle);
+	starpu_data_unregister(handle);
+
+	FPRINTF(stderr, "%u transfers out of %d were migrations\n", migrated, ITER);
+
+	starpu_shutdown();
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,189 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2015-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "../helper.h"
+
+/*
+ * Work out of core with CPU workers which fetch the input of their next tasks
+ * while executing the current one (STARPU_CPU_PIPELINE), and check that tasks
+ * are still executed in order with the right data.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#  define NDATA 4
+#  define NITER 16
+#elif !defined(STARPU_LONG_CHECK)
+#  define NDATA 32
+#  define NITER 256
+#else
+#  define NDATA 128
+#  define NITER 1024
+#endif
+#  define MEMSIZE 1
+#  define MEMSIZE_STR "1"
+
+#if !defined(STARPU_HAVE_SETENV)
+#warning setenv is not defined. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#elif STARPU_MAXNODES == 1
+/* Cannot register a disk */
+int main(int argc, char **argv)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+static unsigned values[NDATA];
+
+static void zero(void *buffers[], void *args)
+{
+	(void)args;
+	unsigned *val = (unsigned*) STARPU_VECTOR_GET_PTR(buffers[0]);
+	*val = 0;
+}
+
+static void inc(void *buffers[], void *args)
+{
+	unsigned *val = (unsigned*) STARPU_VECTOR_GET_PTR(buffers[0]);
+	unsigned i;
+	starpu_codelet_unpack_args(args, &i);
+	(*val)++;
+	STARPU_ATOMIC_ADD(&values[i], 1);
+}
+
+static void check(void *buffers[], void *args)
+{
+	unsigned *val = (unsigned*) STARPU_VECTOR_GET_PTR(buffers[0]);
+	unsigned i;
+	starpu_codelet_unpack_args(args, &i);
+	STARPU_ASSERT_MSG(*val == values[i], "Incorrect value. Value %u should be %u (index %u)", *val, values[i], i);
+}
+
+static struct starpu_codelet zero_cl =
+{
+	.cpu_funcs = { zero },
+	.nbuffers = 1,
+	.modes = { STARPU_W },
+};
+
+static struct starpu_codelet inc_cl =
+{
+	.cpu_funcs = { inc },
+	.nbuffers = 1,
+	.modes = { STARPU_RW },
+};
+
+static struct starpu_codelet check_cl =
+{
+	.cpu_funcs = { check },
+	.nbuffers = 1,
+	.modes = { STARPU_R },
+};
+
+static int dotest(const char *pipeline, char *base)
+{
+	starpu_data_handle_t handles[NDATA];
+	unsigned i, j;
+	int ret;
+
+	FPRINTF(stderr, "Testing with STARPU_CPU_PIPELINE=%s\n", pipeline);
+	setenv("STARPU_CPU_PIPELINE", pipeline, 1);
+
+	struct starpu_conf conf;
+	ret = starpu_conf_init(&conf);
+	if (ret == -EINVAL)
+		return EXIT_FAILURE;
+	conf.precedence_over_environment_variables = 1;
+	starpu_conf_noworker(&conf);
+	conf.ncpus = -1;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+
+	int new_dd = starpu_disk_register(&starpu_disk_unistd_ops, (void *) base, STARPU_DISK_SIZE_MIN);
+	/* can't write on /tmp/ */
+	if (new_dd == -ENOENT) goto enoent;
+
+	/* Initialize twice as much data as available memory */
+	for (i = 0; i < NDATA; i++)
+	{
+		starpu_vector_data_register(&handles[i], -1, 0, (MEMSIZE*1024*1024*2) / NDATA, sizeof(char));
+		ret = starpu_task_insert(&zero_cl, STARPU_W, handles[i], 0);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	memset(values, 0, sizeof(values));
+
+	for (i = 0; i < NITER; i++)
+	{
+		j = rand()%NDATA;
+		ret = starpu_task_insert(&inc_cl, STARPU_RW, handles[j], STARPU_VALUE, &j, sizeof(j), 0);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+
+	for (i = 0; i < NDATA; i++)
+	{
+		ret = starpu_task_insert(&check_cl, STARPU_R, handles[i], STARPU_VALUE, &i, sizeof(i), 0);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+		starpu_data_unregister(handles[i]);
+	}
+
+	starpu_shutdown();
+	return EXIT_SUCCESS;
+
+enoent:
+	FPRINTF(stderr, "Couldn't write data: ENOENT\n");
+enodev:
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
+
+int main(void)
+{
+	int ret, ret2;
+	char s[128];
+	char *ptr;
+
+	setenv("STARPU_CALIBRATE_MINIMUM", "1", 1);
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	ptr = _starpu_mkdtemp(s);
+	if (!ptr)
+	{
+		FPRINTF(stderr, "Cannot make directory '%s'\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	setenv("STARPU_LIMIT_CPU_MEM", MEMSIZE_STR, 1);
+
+	ret = dotest("2", s);
+	if (ret == EXIT_SUCCESS)
+		ret = dotest("4", s);
+
+	ret2 = rmdir(s);
+	STARPU_CHECK_RETURN_VALUE(ret2, "rmdir '%s'\n", s);
+
+	return ret;
+}
+#endif
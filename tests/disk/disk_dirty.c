@@ -0,0 +1,210 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "../helper.h"
+
+/*
+ * Push a vector to disk, modify a few pages of it in main memory, and push it
+ * again: with STARPU_DISK_DIRTY_TRACKING, only the modified pages should be
+ * written to the disk. Then check that the disk content is correct, and that
+ * tracking resumes after the main memory replica gets invalidated.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#  define	NX	(1024*1024/sizeof(double))
+#else
+#  define	NX	(16*1024*1024/sizeof(double))
+#endif
+/* Number of modified pages */
+#define	NMODIFIED	3
+
+#if !defined(STARPU_HAVE_SETENV)
+#warning setenv is not defined. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#elif STARPU_MAXNODES == 1
+/* Cannot register a disk */
+int main(int argc, char **argv)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+static unsigned long nwritten;
+
+/* Count the amount of data written to the disk */
+static int count_write(void *base, void *obj, const void *buf, off_t offset, size_t size)
+{
+	(void) STARPU_ATOMIC_ADDL(&nwritten, size);
+	return starpu_disk_unistd_ops.write(base, obj, buf, offset, size);
+}
+
+static void *count_async_write(void *base, void *obj, void *buf, off_t offset, size_t size)
+{
+	(void) STARPU_ATOMIC_ADDL(&nwritten, size);
+	return starpu_disk_unistd_ops.async_write(base, obj, buf, offset, size);
+}
+
+static int count_full_write(void *base, void *obj, void *ptr, size_t size)
+{
+	(void) STARPU_ATOMIC_ADDL(&nwritten, size);
+	return starpu_disk_unistd_ops.full_write(base, obj, ptr, size);
+}
+
+static void *count_async_full_write(void *base, void *obj, void *ptr, size_t size)
+{
+	(void) STARPU_ATOMIC_ADDL(&nwritten, size);
+	return starpu_disk_unistd_ops.async_full_write(base, obj, ptr, size);
+}
+
+int main(void)
+{
+	struct starpu_disk_ops ops;
+	starpu_data_handle_t handle;
+	double *A;
+	size_t j, page_size = sysconf(_SC_PAGESIZE);
+	unsigned i;
+	int ret, res = EXIT_SUCCESS;
+	char s[128];
+	char *ptr;
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	ptr = _starpu_mkdtemp(s);
+	if (!ptr)
+	{
+		FPRINTF(stderr, "Cannot make directory <%s>\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	setenv("STARPU_DISK_DIRTY_TRACKING", "1", 1);
+
+	struct starpu_conf conf;
+	ret = starpu_conf_init(&conf);
+	if (ret == -EINVAL)
+		return EXIT_FAILURE;
+	starpu_conf_noworker(&conf);
+	conf.ncpus = -1;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV) goto enodev;
+
+	ops = starpu_disk_unistd_ops;
+	ops.write = count_write;
+	ops.async_write = count_async_write;
+	ops.full_write = count_full_write;
+	ops.async_full_write = count_async_full_write;
+	int new_dd = starpu_disk_register(&ops, s, STARPU_DISK_SIZE_MIN + 2 * NX * sizeof(double));
+	/* can't write on /tmp/ */
+	if (new_dd == -ENOENT) goto enoent;
+
+	starpu_malloc_flags((void **)&A, NX*sizeof(double), STARPU_MALLOC_COUNT);
+	for (j = 0; j < NX; j++)
+		A[j] = j;
+	starpu_vector_data_register(&handle, STARPU_MAIN_RAM, (uintptr_t) A, NX, sizeof(double));
+
+	/* Make the disk and main memory replicas identical */
+	starpu_data_acquire_on_node(handle, new_dd, STARPU_R);
+	starpu_data_release_on_node(handle, new_dd);
+
+	/* Modify a few pages in main memory, which invalidates the disk
+	 * replica */
+	starpu_data_acquire(handle, STARPU_RW);
+	for (i = 0; i < NMODIFIED; i++)
+	{
+		size_t k = (i + 1) * (NX / (NMODIFIED + 1));
+		A[k] = -A[k];
+	}
+	starpu_data_release(handle);
+
+	/* Write back to the disk */
+	nwritten = 0;
+	starpu_data_acquire_on_node(handle, new_dd, STARPU_RW);
+	starpu_data_release_on_node(handle, new_dd);
+	FPRINTF(stderr, "wrote %lu bytes out of %lu\n", nwritten, (unsigned long) (NX * sizeof(double)));
+
+	if (nwritten >= NX * sizeof(double))
+	{
+		FPRINTF(stderr, "dirty tracking is not available\n");
+		res = STARPU_TEST_SKIPPED;
+	}
+	else if (nwritten > (NMODIFIED + 2) * page_size)
+	{
+		FPRINTF(stderr, "wrote more than the modified pages\n");
+		res = EXIT_FAILURE;
+	}
+
+	/* Only the disk replica is valid now, trash the main memory and
+	 * fetch back */
+	for (j = 0; j < NX; j++)
+		A[j] = 0;
+	starpu_data_acquire(handle, STARPU_R);
+	for (j = 0; j < NX; j++)
+	{
+		double expected = j;
+		for (i = 0; i < NMODIFIED; i++)
+			if (j == (i + 1) * (NX / (NMODIFIED + 1)))
+				expected = -expected;
+		if (A[j] != expected)
+		{
+			FPRINTF(stderr, "element %lu is %f instead of %f\n", (unsigned long) j, A[j], expected);
+			res = EXIT_FAILURE;
+			break;
+		}
+	}
+	starpu_data_release(handle);
+
+	/* Invalidate the main memory replica, then fetch it back and modify
+	 * one page: only that page should be written back */
+	starpu_data_acquire_on_node(handle, new_dd, STARPU_RW);
+	starpu_data_release_on_node(handle, new_dd);
+	starpu_data_acquire(handle, STARPU_RW);
+	A[NX / 2] = -A[NX / 2];
+	starpu_data_release(handle);
+	nwritten = 0;
+	starpu_data_acquire_on_node(handle, new_dd, STARPU_R);
+	starpu_data_release_on_node(handle, new_dd);
+	FPRINTF(stderr, "wrote %lu bytes after invalidation\n", nwritten);
+	if (res == EXIT_SUCCESS && nwritten > 3 * page_size)
+	{
+		FPRINTF(stderr, "wrote more than the modified page\n");
+		res = EXIT_FAILURE;
+	}
+
+	starpu_data_unregister(handle);
+	starpu_free_flags(A, NX*sizeof(double), STARPU_MALLOC_COUNT);
+
+	starpu_shutdown();
+
+	ret = rmdir(s);
+	if (ret < 0)
+		STARPU_CHECK_RETURN_VALUE(-errno, "rmdir '%s'\n", s);
+	return res;
+
+enodev:
+	rmdir(s);
+	return STARPU_TEST_SKIPPED;
+enoent:
+	FPRINTF(stderr, "Couldn't write data: ENOENT\n");
+	starpu_shutdown();
+	rmdir(s);
+	return STARPU_TEST_SKIPPED;
+}
+#endif
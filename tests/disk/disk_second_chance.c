@@ -0,0 +1,182 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "../helper.h"
+
+/*
+ * Fill the main memory, limited to three vectors, with vectors also written
+ * to a disk. Once the reference bits have been cleared by an eviction, use
+ * the oldest vector again: when a new vector needs room, the next oldest one,
+ * which was not used, has to be evicted instead of it.
+ */
+
+/* Three vectors fit in STARPU_LIMIT_CPU_MEM */
+#define	MEMSIZE_STR	"1"
+#define	NX	(300*1024)
+#define	NDATA	5
+
+#if !defined(STARPU_HAVE_SETENV)
+#warning setenv is not defined. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#elif STARPU_MAXNODES == 1
+/* Cannot register a disk */
+int main(int argc, char **argv)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+static void zero(void *descr[], void *arg)
+{
+	(void)arg;
+	memset((void *) STARPU_VECTOR_GET_PTR(descr[0]), 0, STARPU_VECTOR_GET_NX(descr[0]));
+}
+
+static struct starpu_codelet zero_cl =
+{
+	.cpu_funcs = { zero },
+	.nbuffers = 1,
+	.modes = { STARPU_W },
+};
+
+static void nop(void *descr[], void *arg)
+{
+	(void)descr;
+	(void)arg;
+}
+
+static struct starpu_codelet read_cl =
+{
+	.cpu_funcs = { nop },
+	.nbuffers = 1,
+	.modes = { STARPU_R },
+};
+
+static int use(struct starpu_codelet *cl, starpu_data_handle_t handle)
+{
+	int ret = starpu_task_insert(cl, cl->modes[0], handle, 0);
+	if (ret == -ENODEV)
+		return ret;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	return starpu_task_wait_for_all();
+}
+
+/* Also write the vector to the disk, so that its main memory copy can be
+ * evicted without a write-back, like the others */
+static void write_back(starpu_data_handle_t handle, int dd)
+{
+	int ret = starpu_data_acquire_on_node(handle, dd, STARPU_R);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+	starpu_data_release_on_node(handle, dd);
+}
+
+int main(void)
+{
+	starpu_data_handle_t handles[NDATA];
+	struct starpu_conf conf;
+	char s[128];
+	char *ptr;
+	int new_dd;
+	int ret, i;
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	ptr = _starpu_mkdtemp(s);
+	if (!ptr)
+	{
+		FPRINTF(stderr, "Cannot make directory '%s'\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	setenv("STARPU_LIMIT_CPU_MEM", MEMSIZE_STR, 1);
+	/* Do not let memory get tidied behind our back */
+	setenv("STARPU_MINIMUM_CLEAN_BUFFERS", "0", 1);
+	setenv("STARPU_TARGET_CLEAN_BUFFERS", "0", 1);
+
+	ret = starpu_conf_init(&conf);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_conf_init");
+	conf.precedence_over_environment_variables = 1;
+	starpu_conf_noworker(&conf);
+	conf.ncpus = 1;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+		goto skip_rmdir;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	new_dd = starpu_disk_register(&starpu_disk_unistd_ops, (void *) s, STARPU_DISK_SIZE_MIN);
+	if (new_dd == -ENOENT)
+		goto skip;
+
+	for (i = 0; i < NDATA; i++)
+		starpu_vector_data_register(&handles[i], -1, 0, NX, sizeof(char));
+
+	/* Fill the memory with 0, 1, 2, then 3 evicts 0 once the reference
+	 * bits, set by the first accesses, have been cleared */
+	for (i = 0; i < 4; i++)
+	{
+		ret = use(&zero_cl, handles[i]);
+		if (ret == -ENODEV)
+			goto skip_unregister;
+		write_back(handles[i], new_dd);
+	}
+	if (starpu_data_is_on_node(handles[0], STARPU_MAIN_RAM))
+	{
+		FPRINTF(stderr, "filling the memory did not evict anything\n");
+		ret = EXIT_FAILURE;
+		goto out;
+	}
+
+	/* 1 is now the oldest, use it again, and make room for 4 */
+	ret = use(&read_cl, handles[1]);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait_for_all");
+	ret = use(&zero_cl, handles[4]);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait_for_all");
+
+	ret = EXIT_SUCCESS;
+	if (!starpu_data_is_on_node(handles[1], STARPU_MAIN_RAM))
+	{
+		FPRINTF(stderr, "the recently used vector was evicted\n");
+		ret = EXIT_FAILURE;
+	}
+	if (starpu_data_is_on_node(handles[2], STARPU_MAIN_RAM))
+	{
+		FPRINTF(stderr, "the unused vector was not evicted\n");
+		ret = EXIT_FAILURE;
+	}
+
+out:
+	for (i = 0; i < NDATA; i++)
+		starpu_data_unregister(handles[i]);
+	starpu_shutdown();
+	rmdir(s);
+	return ret;
+
+skip_unregister:
+	for (i = 0; i < NDATA; i++)
+		starpu_data_unregister(handles[i]);
+skip:
+	starpu_shutdown();
+skip_rmdir:
+	rmdir(s);
+	return STARPU_TEST_SKIPPED;
+}
+#endif
@@ -0,0 +1,228 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "../helper.h"
+
+/*
+ * Push non-contiguous tiles of a matrix, a block and a tensor to disk and
+ * fetch them back, which uses the 2D/3D disk transfers, and report the
+ * achieved bandwidth, compared to transferring the blocks one by one.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#  define	N2	256
+#  define	N3	32
+#  define	N4	12
+#else
+#  define	N2	2048
+#  define	N3	128
+#  define	N4	32
+#endif
+#define	NPARTS	4
+
+#if STARPU_MAXNODES == 1
+/* Cannot register a disk */
+int main(int argc, char **argv)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+/* Push all tiles of handle to the disk, trash the main memory, and fetch them
+ * back, then check the content */
+static int roundtrip(const char *name, starpu_data_handle_t handle, struct starpu_data_filter *f, double *A, size_t n, int disk)
+{
+	double start, push, fetch;
+	unsigned i;
+	size_t j;
+	int ret = EXIT_SUCCESS;
+
+	starpu_data_partition(handle, f);
+
+	start = starpu_timing_now();
+	for (i = 0; i < NPARTS; i++)
+	{
+		starpu_data_handle_t tile = starpu_data_get_sub_data(handle, 1, i);
+		starpu_data_acquire_on_node(tile, disk, STARPU_RW);
+		starpu_data_release_on_node(tile, disk);
+	}
+	push = starpu_timing_now() - start;
+
+	/* The tiles are now only valid on the disk */
+	for (j = 0; j < n; j++)
+		A[j] = -1.;
+
+	start = starpu_timing_now();
+	for (i = 0; i < NPARTS; i++)
+	{
+		starpu_data_handle_t tile = starpu_data_get_sub_data(handle, 1, i);
+		starpu_data_acquire(tile, STARPU_R);
+		starpu_data_release(tile);
+	}
+	fetch = starpu_timing_now() - start;
+
+	starpu_data_unpartition(handle, STARPU_MAIN_RAM);
+
+	for (j = 0; j < n; j++)
+		if (A[j] != (double) j)
+		{
+			FPRINTF(stderr, "%s: element %lu is %f instead of %f\n", name, (unsigned long) j, A[j], (double) j);
+			ret = EXIT_FAILURE;
+			break;
+		}
+
+	FPRINTF(stderr, "%s: push %.1f MB/s, fetch %.1f MB/s\n", name,
+		n * sizeof(double) / push, n * sizeof(double) / fetch);
+	return ret;
+}
+
+int dotest(struct starpu_disk_ops *ops, void *param)
+{
+	starpu_data_handle_t handle;
+	double *A;
+	size_t n, j;
+	int ret, res = EXIT_SUCCESS;
+
+	struct starpu_conf conf;
+	ret = starpu_conf_init(&conf);
+	if (ret == -EINVAL)
+		return EXIT_FAILURE;
+	conf.precedence_over_environment_variables = 1;
+	starpu_conf_noworker(&conf);
+	conf.ncpus = -1;
+	conf.nmpi_ms = -1;
+	conf.ntcpip_ms = -1;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV) goto enodev;
+
+	int new_dd = starpu_disk_register(ops, param, STARPU_DISK_SIZE_MIN + 4 * (size_t) N2 * N2 * sizeof(double));
+	/* can't write on /tmp/ */
+	if (new_dd == -ENOENT) goto enoent;
+
+	/* Matrix tiles: rows of N2/NPARTS elements, N2 elements apart */
+	n = (size_t) N2 * N2;
+	starpu_malloc_flags((void **)&A, n*sizeof(double), STARPU_MALLOC_COUNT);
+	for (j = 0; j < n; j++)
+		A[j] = j;
+	starpu_matrix_data_register(&handle, STARPU_MAIN_RAM, (uintptr_t) A, N2, N2, N2, sizeof(double));
+	struct starpu_data_filter f2 =
+	{
+		.filter_func = starpu_matrix_filter_block,
+		.nchildren = NPARTS
+	};
+	if (roundtrip("matrix", handle, &f2, A, n, new_dd))
+		res = EXIT_FAILURE;
+	starpu_data_unregister(handle);
+	starpu_free_flags(A, n*sizeof(double), STARPU_MALLOC_COUNT);
+
+	/* Block tiles: rows in planes */
+	n = (size_t) N3 * N3 * N3;
+	starpu_malloc_flags((void **)&A, n*sizeof(double), STARPU_MALLOC_COUNT);
+	for (j = 0; j < n; j++)
+		A[j] = j;
+	starpu_block_data_register(&handle, STARPU_MAIN_RAM, (uintptr_t) A, N3, N3*N3, N3, N3, N3, sizeof(double));
+	struct starpu_data_filter f3 =
+	{
+		.filter_func = starpu_block_filter_block,
+		.nchildren = NPARTS
+	};
+	if (roundtrip("block", handle, &f3, A, n, new_dd))
+		res = EXIT_FAILURE;
+	starpu_data_unregister(handle);
+	starpu_free_flags(A, n*sizeof(double), STARPU_MALLOC_COUNT);
+
+	/* Tensor tiles: split along y, so that the rows of each plane are
+	 * contiguous */
+	n = (size_t) N4 * N4 * N4 * N4;
+	starpu_malloc_flags((void **)&A, n*sizeof(double), STARPU_MALLOC_COUNT);
+	for (j = 0; j < n; j++)
+		A[j] = j;
+	starpu_tensor_data_register(&handle, STARPU_MAIN_RAM, (uintptr_t) A, N4, N4*N4, N4*N4*N4, N4, N4, N4, N4, sizeof(double));
+	struct starpu_data_filter f4 =
+	{
+		.filter_func = starpu_tensor_filter_vertical_block,
+		.nchildren = NPARTS
+	};
+	if (roundtrip("tensor", handle, &f4, A, n, new_dd))
+		res = EXIT_FAILURE;
+	starpu_data_unregister(handle);
+	starpu_free_flags(A, n*sizeof(double), STARPU_MALLOC_COUNT);
+
+	starpu_shutdown();
+
+	return res;
+
+enodev:
+	return STARPU_TEST_SKIPPED;
+enoent:
+	FPRINTF(stderr, "Couldn't write data: ENOENT\n");
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
+
+static int merge_result(int old, int new)
+{
+	if (new == EXIT_FAILURE)
+		return EXIT_FAILURE;
+	if (old == 0)
+		return 0;
+	return new;
+}
+
+int main(void)
+{
+	struct starpu_disk_ops unistd_ops;
+	int ret = 0;
+	int ret2;
+	char s[128];
+	char *ptr;
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	ptr = _starpu_mkdtemp(s);
+	if (!ptr)
+	{
+		FPRINTF(stderr, "Cannot make directory <%s>\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	FPRINTF(stderr, "stdio:\n");
+	ret = merge_result(ret, dotest(&starpu_disk_stdio_ops, s));
+	FPRINTF(stderr, "unistd:\n");
+	ret = merge_result(ret, dotest(&starpu_disk_unistd_ops, s));
+
+	/* For reference, transfer block by block */
+	FPRINTF(stderr, "unistd without 2D operations:\n");
+	unistd_ops = starpu_disk_unistd_ops;
+	unistd_ops.read2d = NULL;
+	unistd_ops.write2d = NULL;
+	unistd_ops.async_read2d = NULL;
+	unistd_ops.async_write2d = NULL;
+	ret = merge_result(ret, dotest(&unistd_ops, s));
+#ifdef STARPU_HAVE_HDF5
+	FPRINTF(stderr, "hdf5:\n");
+	ret = merge_result(ret, dotest(&starpu_disk_hdf5_ops, s));
+#endif
+
+	ret2 = rmdir(s);
+	if (ret2 < 0)
+		STARPU_CHECK_RETURN_VALUE(-errno, "rmdir '%s'\n", s);
+	return ret;
+}
+#endif
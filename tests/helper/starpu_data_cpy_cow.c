@@ -0,0 +1,286 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Test that starpu_data_cpy and starpu_data_dup_ro defer the copy until
+ * either side gets modified, while still providing the value at the time of
+ * the copy
+ */
+
+static int failed;
+
+void check_cpu(void *descr[], void *arg)
+{
+	unsigned *var = (unsigned *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	unsigned expected;
+
+	starpu_codelet_unpack_args(arg, &expected);
+	if (*var != expected)
+	{
+		FPRINTF(stderr, "value is %u but it should be %u\n", *var, expected);
+		failed = 1;
+	}
+}
+
+static struct starpu_codelet check_cl =
+{
+	.cpu_funcs = {check_cpu},
+	.cpu_funcs_name = {"check_cpu"},
+	.nbuffers = 1,
+	.modes = {STARPU_R},
+	.name = "check"
+};
+
+void increment_cpu(void *descr[], void *arg)
+{
+	(void)arg;
+	unsigned *var = (unsigned *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	(*var)++;
+}
+
+static struct starpu_codelet increment_cl =
+{
+	.cpu_funcs = {increment_cpu},
+	.cpu_funcs_name = {"increment_cpu"},
+	.nbuffers = 1,
+	.modes = {STARPU_RW},
+	.name = "increment"
+};
+
+void set_cpu(void *descr[], void *arg)
+{
+	unsigned *var = (unsigned *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	starpu_codelet_unpack_args(arg, var);
+}
+
+static struct starpu_codelet set_cl =
+{
+	.cpu_funcs = {set_cpu},
+	.cpu_funcs_name = {"set_cpu"},
+	.nbuffers = 1,
+	.modes = {STARPU_W},
+	.name = "set"
+};
+
+static void check(starpu_data_handle_t handle, unsigned expected)
+{
+	int ret = starpu_task_insert(&check_cl, STARPU_R, handle, STARPU_VALUE, &expected, sizeof(expected), 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+}
+
+/* Prepare a task checking the value of the handle */
+static void check_task_init(struct starpu_task *task, starpu_data_handle_t handle, unsigned expected)
+{
+	starpu_task_init(task);
+	task->cl = &check_cl;
+	task->handles[0] = handle;
+	starpu_codelet_pack_args(&task->cl_arg, &task->cl_arg_size, STARPU_VALUE, &expected, sizeof(expected), 0);
+	task->cl_arg_free = 1;
+}
+
+/* Let the current task run three times */
+static void regenerate_callback(void *arg)
+{
+	unsigned *nregenerated = arg;
+	if (++*nregenerated == 3)
+		starpu_task_get_current()->regenerate = 0;
+}
+
+static void check_acquire(starpu_data_handle_t handle, unsigned expected)
+{
+	unsigned *var;
+
+	starpu_data_acquire(handle, STARPU_R);
+	var = starpu_data_get_local_ptr(handle);
+	if (*var != expected)
+	{
+		FPRINTF(stderr, "acquired value is %u but it should be %u\n", *var, expected);
+		failed = 1;
+	}
+	starpu_data_release(handle);
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
+	unsigned a = 42, b = 0, c = 0, d = 0, e = 0, g = 0, seven = 7;
+	starpu_data_handle_t a_handle, b_handle, c_handle, d_handle, e_handle, f_handle, g_handle;
+	struct starpu_task task, gate, *gatep;
+	unsigned nregenerated = 0, ngated = 0;
+
+	ret = starpu_initialize(NULL, &argc, &argv);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+	if (starpu_cpu_worker_get_count() == 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	starpu_variable_data_register(&a_handle, STARPU_MAIN_RAM, (uintptr_t)&a, sizeof(a));
+	starpu_variable_data_register(&b_handle, STARPU_MAIN_RAM, (uintptr_t)&b, sizeof(b));
+	starpu_variable_data_register(&c_handle, STARPU_MAIN_RAM, (uintptr_t)&c, sizeof(c));
+	starpu_variable_data_register(&d_handle, STARPU_MAIN_RAM, (uintptr_t)&d, sizeof(d));
+	starpu_variable_data_register(&e_handle, STARPU_MAIN_RAM, (uintptr_t)&e, sizeof(e));
+	starpu_variable_data_register(&g_handle, STARPU_MAIN_RAM, (uintptr_t)&g, sizeof(g));
+
+	/* Reading the copy reads the source */
+	ret = starpu_data_cpy(b_handle, a_handle, 1, NULL, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_cpy");
+	check(b_handle, 42);
+	starpu_task_wait_for_all();
+	if (b != 0 && starpu_getenv_number_default("STARPU_DATA_CPY_COW", 1))
+	{
+		FPRINTF(stderr, "the copy was performed while nothing was modified\n");
+		failed = 1;
+	}
+
+	/* Modifying the source copies it first */
+	ret = starpu_task_insert(&increment_cl, STARPU_RW, a_handle, 0);
+	if (ret == -ENODEV) goto enodev;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	check(b_handle, 42);
+	check(a_handle, 43);
+
+	/* Overwriting the copy does not need to copy */
+	ret = starpu_data_cpy(c_handle, a_handle, 1, NULL, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_cpy");
+	ret = starpu_task_insert(&set_cl, STARPU_W, c_handle, STARPU_VALUE, &seven, sizeof(seven), 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	check(c_handle, 7);
+	check(a_handle, 43);
+
+	/* Copy of a copy */
+	ret = starpu_data_cpy(d_handle, a_handle, 1, NULL, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_cpy");
+	ret = starpu_data_cpy(e_handle, d_handle, 1, NULL, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_cpy");
+	check(e_handle, 43);
+	ret = starpu_task_insert(&increment_cl, STARPU_RW, a_handle, 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	check(d_handle, 43);
+	check(e_handle, 43);
+	check(a_handle, 44);
+
+	/* Modifying the copy copies it first */
+	ret = starpu_data_cpy(b_handle, a_handle, 1, NULL, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_cpy");
+	ret = starpu_task_insert(&increment_cl, STARPU_RW, b_handle, 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	check(b_handle, 45);
+	check(a_handle, 44);
+
+	/* Read-only duplicate */
+	ret = starpu_data_dup_ro(&f_handle, a_handle, 1);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_dup_ro");
+	check(f_handle, 44);
+	check_acquire(f_handle, 44);
+	ret = starpu_task_insert(&increment_cl, STARPU_RW, a_handle, 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	check(f_handle, 44);
+	check_acquire(a_handle, 45);
+	starpu_data_unregister(f_handle);
+
+	/* A task reading a copy gets the handle of the application back */
+	ret = starpu_data_cpy(d_handle, a_handle, 1, NULL, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_cpy");
+	check_task_init(&task, d_handle, 45);
+	task.detach = 0;
+	ret = starpu_task_submit(&task);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+	ret = starpu_task_wait(&task);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait");
+	if (task.handles[0] != d_handle)
+	{
+		FPRINTF(stderr, "the handle of the task was not restored\n");
+		failed = 1;
+	}
+	starpu_task_clean(&task);
+	ret = starpu_task_insert(&increment_cl, STARPU_RW, a_handle, 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	check(d_handle, 45);
+
+	/* A regenerated task keeps reading the copy while the source gets
+	 * modified. Implicit dependencies do not work with regeneration, so
+	 * make it wait explicitly for the copy and the modifications, through
+	 * a gate task regenerated along with it */
+	ret = starpu_data_cpy(e_handle, a_handle, 1, NULL, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_cpy");
+	starpu_task_init(&gate);
+	gate.regenerate = 1;
+	gate.callback_func = regenerate_callback;
+	gate.callback_arg = &ngated;
+	check_task_init(&task, e_handle, 46);
+	task.regenerate = 1;
+	task.sequential_consistency = 0;
+	task.callback_func = regenerate_callback;
+	task.callback_arg = &nregenerated;
+	gatep = &gate;
+	starpu_task_declare_deps_array(&task, 1, &gatep);
+	ret = starpu_task_submit(&task);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+	check_acquire(e_handle, 46);
+	ret = starpu_task_insert(&increment_cl, STARPU_RW, a_handle, 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	ret = starpu_task_insert(&increment_cl, STARPU_RW, a_handle, 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	check_acquire(a_handle, 48);
+	ret = starpu_task_submit(&gate);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+	starpu_task_wait_for_all();
+	starpu_task_clean(&task);
+	starpu_task_clean(&gate);
+	if (nregenerated != 3)
+	{
+		FPRINTF(stderr, "the regenerated task ran %u times\n", nregenerated);
+		failed = 1;
+	}
+
+	/* Unregistration provides the value in the home node */
+	ret = starpu_data_cpy(g_handle, a_handle, 1, NULL, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_cpy");
+	check_acquire(c_handle, 7);
+
+	starpu_data_unregister(a_handle);
+	starpu_data_unregister(b_handle);
+	starpu_data_unregister(c_handle);
+	starpu_data_unregister(d_handle);
+	starpu_data_unregister(e_handle);
+	starpu_data_unregister(g_handle);
+
+	starpu_shutdown();
+
+	if (a != 48 || b != 45 || c != 7 || d != 45 || e != 46 || g != 48)
+	{
+		FPRINTF(stderr, "final values are %u %u %u %u %u %u\n", a, b, c, d, e, g);
+		failed = 1;
+	}
+
+	STARPU_RETURN(failed ? EXIT_FAILURE : EXIT_SUCCESS);
+
+enodev:
+	starpu_data_unregister(a_handle);
+	starpu_data_unregister(b_handle);
+	starpu_data_unregister(c_handle);
+	starpu_data_unregister(d_handle);
+	starpu_data_unregister(e_handle);
+	starpu_data_unregister(g_handle);
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
@@ -0,0 +1,128 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2010-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Check that offloaded callbacks are run outside workers, that they can
+ * submit tasks, and that waiting for tasks waits for their callbacks.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS 64
+#else
+#define NTASKS 1024
+#endif
+
+static unsigned ncallbacks;
+static unsigned nfollowups;
+static int offloaded;
+
+void func(void *descr[], void *arg)
+{
+	(void)descr;
+	(void)arg;
+}
+
+static struct starpu_codelet cl;
+
+void callback_func(void *arg)
+{
+	STARPU_ASSERT_MSG(!offloaded || starpu_worker_get_id() == -1, "offloaded callback should not be run by a worker\n");
+	(void)STARPU_ATOMIC_ADD(&ncallbacks, 1);
+
+	if (arg)
+	{
+		/* Submit a follow-up task from the callback */
+		int ret = starpu_task_insert(&cl, 0);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+		(void)STARPU_ATOMIC_ADD(&nfollowups, 1);
+	}
+}
+
+static struct starpu_codelet cl =
+{
+	.cpu_funcs = {func},
+	.nbuffers = 0,
+	.callback_func = callback_func,
+	.flags = STARPU_CODELET_CALLBACK_OFFLOAD,
+};
+
+static struct starpu_codelet cl_noflag =
+{
+	.cpu_funcs = {func},
+	.nbuffers = 0,
+};
+
+int main(void)
+{
+	int ret;
+	unsigned i;
+
+	offloaded = starpu_getenv_number_default("STARPU_NCALLBACK_THREADS", 1) != 0;
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	/* Offload requested by the codelet */
+	for (i = 0; i < NTASKS; i++)
+	{
+		ret = starpu_task_insert(&cl, 0);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	ret = starpu_task_wait_for_all();
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait_for_all");
+	STARPU_ASSERT(ncallbacks == NTASKS);
+
+	/* Offload requested by the task, check that starpu_task_wait waits for the callback */
+	ncallbacks = 0;
+	for (i = 0; i < NTASKS; i++)
+	{
+		struct starpu_task *task = starpu_task_create();
+		task->cl = &cl_noflag;
+		task->callback_func = callback_func;
+		task->callback_offload = 1;
+		task->detach = 0;
+		ret = starpu_task_submit(task);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+		ret = starpu_task_wait(task);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait");
+		STARPU_ASSERT(ncallbacks == i+1);
+	}
+
+	/* Callbacks submitting tasks */
+	ncallbacks = 0;
+	for (i = 0; i < NTASKS; i++)
+	{
+		ret = starpu_task_insert(&cl, STARPU_CALLBACK_ARG_NFREE, &ncallbacks, 0);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	ret = starpu_task_wait_for_all();
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait_for_all");
+	STARPU_ASSERT(nfollowups == NTASKS);
+	STARPU_ASSERT(ncallbacks == 2*NTASKS);
+
+	starpu_shutdown();
+	return EXIT_SUCCESS;
+
+enodev:
+	starpu_shutdown();
+	fprintf(stderr, "WARNING: No one can execute this task\n");
+	return STARPU_TEST_SKIPPED;
+}
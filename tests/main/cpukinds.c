@@ -0,0 +1,163 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2010-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <starpu.h>
+#include <common/utils.h>
+#include "../helper.h"
+
+/*
+ * Fake a machine with two kinds of cores, and check that CPU workers get
+ * one performance model arch per kind of core, which can also be given to
+ * starpu_perfmodel_set_per_devices_cost_function().
+ */
+
+#if !defined(STARPU_HAVE_HWLOC) || HWLOC_API_VERSION < 0x00020400 || !defined(STARPU_HAVE_SETENV) || defined(STARPU_SIMGRID)
+#warning hwloc cpukinds or setenv are not available. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+#define NCORES 2
+
+static double cost_function(struct starpu_task *task, struct starpu_perfmodel_arch *arch, unsigned nimpl)
+{
+	(void) task;
+	(void) arch;
+	(void) nimpl;
+	return 1.;
+}
+
+static struct starpu_perfmodel model =
+{
+	.type = STARPU_PER_WORKER,
+	.symbol = "cpukinds",
+};
+
+/* Core 0 is an efficiency core, core 1 is a performance core */
+static int export_topology(const char *path)
+{
+	hwloc_topology_t topology;
+	hwloc_bitmap_t cpuset;
+	int ret;
+
+	hwloc_topology_init(&topology);
+	hwloc_topology_set_synthetic(topology, "core:2 pu:1");
+	hwloc_topology_load(topology);
+
+	cpuset = hwloc_bitmap_alloc();
+	hwloc_bitmap_set(cpuset, 0);
+	hwloc_cpukinds_register(topology, cpuset, 0, 0, NULL, 0);
+	hwloc_bitmap_zero(cpuset);
+	hwloc_bitmap_set(cpuset, 1);
+	hwloc_cpukinds_register(topology, cpuset, 1, 0, NULL, 0);
+	hwloc_bitmap_free(cpuset);
+
+	ret = hwloc_topology_export_xml(topology, path, 0);
+	hwloc_topology_destroy(topology);
+	return ret;
+}
+
+int main(void)
+{
+	struct starpu_conf conf;
+	char dir[256], path[512];
+	char *tpath;
+	int workers[NCORES];
+	int ret, i, n;
+
+	tpath = starpu_getenv("TMPDIR");
+	if (!tpath)
+		tpath = "/tmp";
+	snprintf(dir, sizeof(dir), "%s/starpu_cpukinds_XXXXXX", tpath);
+	if (!_starpu_mkdtemp(dir))
+	{
+		FPRINTF(stderr, "Cannot make directory '%s'\n", dir);
+		return STARPU_TEST_SKIPPED;
+	}
+	snprintf(path, sizeof(path), "%s/topology.xml", dir);
+	if (export_topology(path))
+	{
+		FPRINTF(stderr, "Cannot export topology to '%s'\n", path);
+		ret = STARPU_TEST_SKIPPED;
+		goto out;
+	}
+
+	/* Do not mix the fake machine with the bus calibration of this one */
+	setenv("STARPU_HWLOC_INPUT", path, 1);
+	setenv("STARPU_PERF_MODEL_DIR", dir, 1);
+	setenv("STARPU_HOSTNAME", "cpukinds", 1);
+	/* The fake machine may have more cores than this one */
+	setenv("STARPU_WORKERS_GETBIND", "0", 1);
+	setenv("STARPU_WORKERS_NOBIND", "1", 1);
+	unsetenv("STARPU_WORKERS_CPUID");
+	unsetenv("STARPU_WORKERS_COREID");
+	unsetenv("STARPU_PERF_MODEL_HOMOGENEOUS_CPU");
+
+	starpu_conf_init(&conf);
+	starpu_conf_noworker(&conf);
+	conf.ncpus = NCORES;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+	{
+		ret = STARPU_TEST_SKIPPED;
+		goto out;
+	}
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	n = starpu_worker_get_ids_by_type(STARPU_CPU_WORKER, workers, NCORES);
+	ret = EXIT_SUCCESS;
+
+	/* Each kind can be given a cost function */
+	starpu_perfmodel_init(&model);
+	starpu_perfmodel_set_per_devices_cost_function(&model, 0, cost_function, STARPU_CPU_WORKER, 0, 1, -1);
+	starpu_perfmodel_set_per_devices_cost_function(&model, 0, cost_function, STARPU_CPU_WORKER, 1, 1, -1);
+	{
+		struct starpu_perfmodel_device dev0 = { .type = STARPU_CPU_WORKER, .devid = 0, .ncores = 1 };
+		struct starpu_perfmodel_device dev1 = { .type = STARPU_CPU_WORKER, .devid = 1, .ncores = 1 };
+		int comb0 = starpu_perfmodel_arch_comb_get(1, &dev0);
+		int comb1 = starpu_perfmodel_arch_comb_get(1, &dev1);
+		FPRINTF(stderr, "CPU kinds have combinations %d and %d\n", comb0, comb1);
+		if (comb0 < 0 || comb1 < 0 || comb0 == comb1)
+			ret = EXIT_FAILURE;
+	}
+
+	for (i = 0; i < n; i++)
+	{
+		int bindid = starpu_worker_get_bindid(workers[i]);
+		struct starpu_perfmodel_arch *arch = starpu_worker_get_perf_archtype(workers[i], STARPU_NMAX_SCHED_CTXS);
+		/* The most efficient kind comes first */
+		int expected = bindid == 1 ? 0 : 1;
+
+		FPRINTF(stderr, "worker %d bound to %d has CPU arch %d\n", workers[i], bindid, arch->devices[0].devid);
+		if (arch->devices[0].devid != expected)
+			ret = EXIT_FAILURE;
+	}
+	starpu_shutdown();
+
+out:
+	{
+		char cmd[512];
+		snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+		if (system(cmd) != 0)
+			FPRINTF(stderr, "Could not remove %s\n", dir);
+	}
+	return ret;
+}
+#endif
@@ -0,0 +1,151 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Check that with STARPU_MAIN_THREAD_HELP, the last CPU worker only runs
+ * tasks while the main thread waits in starpu_task_wait_for_all, except the
+ * tasks explicitly submitted to it.
+ */
+
+#if !defined(STARPU_HAVE_SETENV)
+#warning setenv is not defined. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS 32
+#else
+#define NTASKS 128
+#endif
+
+static int helper;
+static unsigned nhelped;
+static unsigned ran_on_each[STARPU_NMAXWORKERS];
+
+void func_cpu(void *descr[], void *arg)
+{
+	(void)descr;
+	(void)arg;
+	if (starpu_worker_get_id() == helper)
+		(void) STARPU_ATOMIC_ADD(&nhelped, 1);
+	starpu_usleep(1000);
+}
+
+static struct starpu_codelet cl =
+{
+	.cpu_funcs = {func_cpu},
+	.cpu_funcs_name = {"func_cpu"},
+	.nbuffers = 0,
+};
+
+void gate_cpu(void *descr[], void *arg)
+{
+	(void)descr;
+	(void)arg;
+	starpu_usleep(100000);
+}
+
+static struct starpu_codelet gate_cl =
+{
+	.cpu_funcs = {gate_cpu},
+	.cpu_funcs_name = {"gate_cpu"},
+	.nbuffers = 0,
+};
+
+static void on_each(void *arg)
+{
+	(void)arg;
+	ran_on_each[starpu_worker_get_id_check()]++;
+}
+
+int main(void)
+{
+	struct starpu_task *gate;
+	int workers[STARPU_NMAXWORKERS];
+	unsigned ncpus;
+	int i, ret;
+
+	setenv("STARPU_MAIN_THREAD_HELP", "1", 1);
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	ncpus = starpu_worker_get_ids_by_type(STARPU_CPU_WORKER, workers, STARPU_NMAXWORKERS);
+	if (ncpus < 2 || starpu_worker_get_count() != ncpus)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+	helper = workers[ncpus-1];
+
+	/* The main thread does not help in starpu_task_wait */
+	for (i = 0; i < NTASKS/4; i++)
+	{
+		ret = starpu_task_insert(&cl, STARPU_TASK_SYNCHRONOUS, 1, 0);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	if (nhelped)
+	{
+		FPRINTF(stderr, "worker %d ran %u tasks while the main thread was not waiting for all tasks\n", helper, nhelped);
+		ret = 1;
+		goto out;
+	}
+
+	/* Tasks targeting the helper are not refused */
+	starpu_execute_on_each_worker(on_each, NULL, STARPU_CPU);
+	for (i = 0; i < (int) ncpus; i++)
+	{
+		if (ran_on_each[workers[i]] != 1)
+		{
+			FPRINTF(stderr, "worker %d ran the function %u times instead of once\n", workers[i], ran_on_each[workers[i]]);
+			ret = 1;
+			goto out;
+		}
+	}
+
+	/* Make the tasks become ready while the main thread waits */
+	gate = starpu_task_create();
+	gate->cl = &gate_cl;
+	gate->destroy = 0;
+	ret = starpu_task_submit(gate);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+	for (i = 0; i < NTASKS; i++)
+	{
+		ret = starpu_task_insert(&cl, STARPU_TASK_DEPS_ARRAY, 1, &gate, 0);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_task_wait_for_all();
+	starpu_task_destroy(gate);
+	FPRINTF(stderr, "worker %d ran %u tasks while the main thread was waiting\n", helper, nhelped);
+	ret = nhelped == 0;
+
+out:
+	starpu_shutdown();
+	return ret;
+
+enodev:
+	starpu_shutdown();
+	fprintf(stderr, "WARNING: No one can execute this task\n");
+	return STARPU_TEST_SKIPPED;
+}
+#endif
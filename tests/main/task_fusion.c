@@ -0,0 +1,236 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Check that chains of fusable elementwise tasks are merged when
+ * STARPU_TASK_FUSION is set, and still compute the right result.
+ */
+
+#if !defined(STARPU_HAVE_SETENV)
+#warning setenv is not defined. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+#ifdef STARPU_QUICK_CHECK
+#define NITER 4
+#else
+#define NITER 16
+#endif
+
+/* Large enough to be processed in several blocks */
+#define NX (256*1024)
+
+static float y[NX], z[NX];
+static unsigned npartial;
+static unsigned ncallbacks;
+
+static void check_block(void *descr[])
+{
+	if (STARPU_VECTOR_GET_NX(descr[0]) < NX)
+		(void) STARPU_ATOMIC_ADD(&npartial, 1);
+}
+
+void init_cpu(void *descr[], void *arg)
+{
+	(void)arg;
+	float *v = (float *) STARPU_VECTOR_GET_PTR(descr[0]);
+	size_t offset = STARPU_VECTOR_GET_OFFSET(descr[0]) / sizeof(float);
+	unsigned n = STARPU_VECTOR_GET_NX(descr[0]);
+	unsigned i;
+
+	check_block(descr);
+	for (i = 0; i < n; i++)
+		v[i] = (offset + i) % 16;
+}
+
+void scal_cpu(void *descr[], void *arg)
+{
+	float factor;
+	float *v = (float *) STARPU_VECTOR_GET_PTR(descr[0]);
+	unsigned n = STARPU_VECTOR_GET_NX(descr[0]);
+	unsigned i;
+
+	starpu_codelet_unpack_args(arg, &factor);
+	check_block(descr);
+	for (i = 0; i < n; i++)
+		v[i] *= factor;
+}
+
+void axpy_cpu(void *descr[], void *arg)
+{
+	(void)arg;
+	float *vx = (float *) STARPU_VECTOR_GET_PTR(descr[0]);
+	float *vy = (float *) STARPU_VECTOR_GET_PTR(descr[1]);
+	unsigned n = STARPU_VECTOR_GET_NX(descr[0]);
+	unsigned i;
+
+	check_block(descr);
+	for (i = 0; i < n; i++)
+		vy[i] += vx[i];
+}
+
+static struct starpu_codelet init_cl =
+{
+	.cpu_funcs = {init_cpu},
+	.cpu_funcs_name = {"init_cpu"},
+	.nbuffers = 1,
+	.modes = {STARPU_W},
+	.flags = STARPU_CODELET_FUSABLE,
+};
+
+static struct starpu_codelet scal_cl =
+{
+	.cpu_funcs = {scal_cpu},
+	.cpu_funcs_name = {"scal_cpu"},
+	.nbuffers = 1,
+	.modes = {STARPU_RW},
+	.flags = STARPU_CODELET_FUSABLE,
+};
+
+static struct starpu_codelet axpy_cl =
+{
+	.cpu_funcs = {axpy_cpu},
+	.cpu_funcs_name = {"axpy_cpu"},
+	.nbuffers = 2,
+	.modes = {STARPU_R, STARPU_RW},
+	.flags = STARPU_CODELET_FUSABLE,
+};
+
+static void callback(void *arg)
+{
+	(void)arg;
+	(void) STARPU_ATOMIC_ADD(&ncallbacks, 1);
+}
+
+static void copy_callback(void *arg)
+{
+	(void)arg;
+}
+
+int main(void)
+{
+	starpu_data_handle_t hx, hy, hz;
+	float factor = 2.;
+	unsigned i, iter;
+	int ret, err = 0;
+
+	setenv("STARPU_TASK_FUSION", "8", 1);
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (starpu_cpu_worker_get_count() == 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	starpu_vector_data_register(&hx, -1, 0, NX, sizeof(float));
+	for (i = 0; i < NX; i++)
+		y[i] = 1.;
+	starpu_vector_data_register(&hy, STARPU_MAIN_RAM, (uintptr_t) y, NX, sizeof(y[0]));
+
+	/* x = i % 16, then y = y + 2^k x for each iteration */
+	ret = starpu_task_insert(&init_cl, STARPU_W, hx, 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	for (iter = 0; iter < NITER; iter++)
+	{
+		ret = starpu_task_insert(&scal_cl, STARPU_RW, hx, STARPU_VALUE, &factor, sizeof(factor), 0);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+		ret = starpu_task_insert(&axpy_cl, STARPU_R, hx, STARPU_RW, hy, STARPU_CALLBACK, callback, 0);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+
+	/* Acquiring the data has to submit the pending tasks */
+	ret = starpu_data_acquire(hy, STARPU_R);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire");
+	for (i = 0; i < NX; i++)
+	{
+		/* sum of 2^k for k in 1..NITER */
+		float expected = 1. + (float) (i % 16) * ((1 << (NITER+1)) - 2);
+		if (y[i] != expected)
+		{
+			FPRINTF(stderr, "y[%u] = %f instead of %f\n", i, y[i], expected);
+			err = 1;
+			break;
+		}
+	}
+	starpu_data_release(hy);
+
+	starpu_task_wait_for_all();
+	STARPU_ASSERT(ncallbacks == NITER);
+	/* Fused tasks run the kernels on blocks */
+	if (npartial == 0)
+	{
+		FPRINTF(stderr, "tasks were not merged\n");
+		err = 1;
+	}
+
+	/* Waiting for a callback without telling StarPU: the chain has to
+	 * be submitted by itself */
+	ret = starpu_task_insert(&axpy_cl, STARPU_R, hx, STARPU_RW, hy, STARPU_CALLBACK, callback, 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	for (i = 0; i < 10000 && STARPU_ATOMIC_ADD(&ncallbacks, 0) == NITER; i++)
+		starpu_usleep(1000);
+	if (STARPU_ATOMIC_ADD(&ncallbacks, 0) == NITER)
+	{
+		FPRINTF(stderr, "the pending chain was never submitted\n");
+		err = 1;
+	}
+
+	/* The copy, submitted as an internal task, has to see the result of
+	 * the pending chain */
+	starpu_vector_data_register(&hz, STARPU_MAIN_RAM, (uintptr_t) z, NX, sizeof(z[0]));
+	ret = starpu_data_acquire(hy, STARPU_R);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire");
+	for (i = 0; i < NX; i++)
+		z[i] = y[i];
+	starpu_data_release(hy);
+	ret = starpu_task_insert(&scal_cl, STARPU_RW, hy, STARPU_VALUE, &factor, sizeof(factor), 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	/* With a callback, so that the copy is actually performed */
+	ret = starpu_data_cpy(hz, hy, 0, copy_callback, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_cpy");
+	ret = starpu_data_acquire(hz, STARPU_R);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire");
+	ret = starpu_data_acquire(hy, STARPU_R);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire");
+	for (i = 0; i < NX; i++)
+	{
+		if (z[i] != y[i])
+		{
+			FPRINTF(stderr, "copy z[%u] = %f instead of %f\n", i, z[i], y[i]);
+			err = 1;
+			break;
+		}
+	}
+	starpu_data_release(hy);
+	starpu_data_release(hz);
+
+	starpu_data_unregister(hx);
+	starpu_data_unregister(hy);
+	starpu_data_unregister(hz);
+	starpu_shutdown();
+
+	return err;
+}
+#endif
@@ -0,0 +1,119 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2010-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <starpu.h>
+#include <datawizard/coherency.h>
+#include "../helper.h"
+
+/*
+ * Measure the memory used per handle and the registration / unregistration
+ * throughput when registering many small pieces of data, as done by
+ * applications with a handle per particle or per graph vertex
+ */
+
+#ifdef STARPU_QUICK_CHECK
+static unsigned nhandles = 10000;
+#else
+static unsigned nhandles = 1000000;
+#endif
+
+static void usage(char **argv)
+{
+	fprintf(stderr, "Usage: %s [-n nhandles] [-h]\n", argv[0]);
+	exit(EXIT_FAILURE);
+}
+
+static void parse_args(int argc, char **argv)
+{
+	int c;
+	while ((c = getopt(argc, argv, "n:h")) != -1)
+	switch(c)
+	{
+		case 'n':
+			nhandles = atoi(optarg);
+			break;
+		case 'h':
+			usage(argv);
+			break;
+	}
+}
+
+/* Resident memory of the process in bytes, 0 if unknown */
+static size_t rss(void)
+{
+	size_t size = 0;
+#ifdef __linux__
+	unsigned long pages;
+	FILE *f = fopen("/proc/self/statm", "r");
+	if (!f)
+		return 0;
+	if (fscanf(f, "%*u %lu", &pages) == 1)
+		size = pages * sysconf(_SC_PAGESIZE);
+	fclose(f);
+#endif
+	return size;
+}
+
+int main(int argc, char **argv)
+{
+	starpu_data_handle_t *handles;
+	float *values;
+	double start, end;
+	double register_time, unregister_time;
+	size_t rss_before, rss_after;
+	unsigned i;
+	int ret;
+
+	parse_args(argc, argv);
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	handles = malloc(nhandles * sizeof(*handles));
+	values = calloc(nhandles, sizeof(*values));
+	STARPU_ASSERT(handles && values);
+
+	rss_before = rss();
+	start = starpu_timing_now();
+	for (i = 0; i < nhandles; i++)
+		starpu_variable_data_register(&handles[i], STARPU_MAIN_RAM, (uintptr_t) &values[i], sizeof(values[i]));
+	end = starpu_timing_now();
+	rss_after = rss();
+	register_time = end - start;
+
+	start = starpu_timing_now();
+	for (i = 0; i < nhandles; i++)
+		starpu_data_unregister(handles[i]);
+	end = starpu_timing_now();
+	unregister_time = end - start;
+
+	fprintf(stderr, "#handles : %u\n", nhandles);
+	fprintf(stderr, "Handle structure: %u bytes\n", (unsigned) sizeof(struct _starpu_data_state));
+	if (rss_after > rss_before)
+		fprintf(stderr, "Memory per handle: %u bytes\n", (unsigned) ((rss_after - rss_before) / nhandles));
+	fprintf(stderr, "Per register: %f usecs\n", register_time/nhandles);
+	fprintf(stderr, "Per unregister: %f usecs\n", unregister_time/nhandles);
+
+	free(values);
+	free(handles);
+	starpu_shutdown();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <starpu.h>
+#include <stdlib.h>
+#include "../helper.h"
+
+/*
+ * Measure the cost of data accesses from all CPU workers concurrently, before
+ * and after registering a disk. The disk makes the main memory evictable, so
+ * that each access records the recent use of the memory chunk. This should
+ * not take the lock of the memory node, and thus not slow accesses down.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS	1000
+#elif !defined(STARPU_LONG_CHECK)
+#define NTASKS	10000
+#else
+#define NTASKS	100000
+#endif
+
+#define NDATA	16
+#define VECTORSIZE	1024
+
+#if STARPU_MAXNODES == 1
+/* Cannot register a disk */
+int main(int argc, char **argv)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+static starpu_data_handle_t handles[NDATA];
+
+static void codelet_null(void *descr[], void *arg)
+{
+	(void)descr;
+	(void)arg;
+}
+
+static struct starpu_codelet cl =
+{
+	.cpu_funcs = {codelet_null},
+	.nbuffers = 4,
+	.modes = {STARPU_R, STARPU_R, STARPU_R, STARPU_R},
+};
+
+/* Return the time per data access, in µs */
+static double run(void)
+{
+	double start, end;
+	unsigned i, j;
+	int ret;
+
+	start = starpu_timing_now();
+	for (i = 0; i < NTASKS; i++)
+	{
+		struct starpu_task *task = starpu_task_create();
+		task->cl = &cl;
+		for (j = 0; j < (unsigned) cl.nbuffers; j++)
+			task->handles[j] = handles[(i + j * 5) % NDATA];
+		ret = starpu_task_submit(task);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+	}
+	ret = starpu_task_wait_for_all();
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait_for_all");
+	end = starpu_timing_now();
+
+	return (end - start) / (NTASKS * cl.nbuffers);
+}
+
+int main(int argc, char **argv)
+{
+	double not_evictable, evictable;
+	unsigned i;
+	int ret, new_dd;
+	char s[128];
+	char *ptr;
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	ptr = _starpu_mkdtemp(s);
+	if (!ptr)
+	{
+		FPRINTF(stderr, "Cannot make directory <%s>\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	ret = starpu_initialize(NULL, &argc, &argv);
+	if (ret == -ENODEV) goto enodev;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (starpu_cpu_worker_get_count() == 0)
+	{
+		starpu_shutdown();
+		goto enodev;
+	}
+
+	for (i = 0; i < NDATA; i++)
+		starpu_vector_data_register(&handles[i], -1, 0, VECTORSIZE, sizeof(unsigned));
+	/* Allocate the data in main memory */
+	for (i = 0; i < NDATA; i++)
+	{
+		ret = starpu_data_acquire(handles[i], STARPU_W);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire");
+		starpu_data_release(handles[i]);
+	}
+
+	/* Warm up */
+	run();
+	not_evictable = run();
+
+	new_dd = starpu_disk_register(&starpu_disk_unistd_ops, s, STARPU_DISK_SIZE_MIN);
+	/* can't write on /tmp/ */
+	if (new_dd == -ENOENT)
+	{
+		FPRINTF(stderr, "Couldn't write data: ENOENT\n");
+		for (i = 0; i < NDATA; i++)
+			starpu_data_unregister(handles[i]);
+		starpu_shutdown();
+		goto enodev;
+	}
+
+	evictable = run();
+
+	FPRINTF(stdout, "# workers\tnot evictable (µs)\tevictable (µs)\n");
+	FPRINTF(stdout, "%u\t%f\t%f\n", starpu_cpu_worker_get_count(), not_evictable, evictable);
+
+	for (i = 0; i < NDATA; i++)
+		starpu_data_unregister(handles[i]);
+	starpu_shutdown();
+
+	ret = rmdir(s);
+	if (ret < 0)
+		STARPU_CHECK_RETURN_VALUE(-errno, "rmdir '%s'\n", s);
+	return EXIT_SUCCESS;
+
+enodev:
+	rmdir(s);
+	return STARPU_TEST_SKIPPED;
+}
+#endif
@@ -0,0 +1,172 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2010-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Measure the cost of a starpu_init/starpu_shutdown cycle, as done by
+ * libraries which use StarPU internally for each of their calls
+ */
+
+#ifdef STARPU_QUICK_CHECK
+static unsigned ncycles = 4;
+#else
+static unsigned ncycles = 32;
+#endif
+static int ncpus = -1;
+
+void dummy_func(void *descr[], void *arg)
+{
+	(void)descr;
+	(void)arg;
+}
+
+static struct starpu_codelet dummy_codelet =
+{
+	.cpu_funcs = {dummy_func},
+	.cuda_funcs = {dummy_func},
+	.opencl_funcs = {dummy_func},
+	.cpu_funcs_name = {"dummy_func"},
+	.model = NULL,
+	.nbuffers = 0,
+};
+
+/* starpu_timing_now() is not usable before starpu_init() */
+static double now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000000. + tv.tv_usec;
+}
+
+static void usage(char **argv)
+{
+	fprintf(stderr, "Usage: %s [-i ncycles] [-c ncpus] [-h]\n", argv[0]);
+	exit(EXIT_FAILURE);
+}
+
+static void parse_args(int argc, char **argv)
+{
+	int c;
+	while ((c = getopt(argc, argv, "i:c:h")) != -1)
+	switch(c)
+	{
+		case 'i':
+			ncycles = atoi(optarg);
+			break;
+		case 'c':
+			ncpus = atoi(optarg);
+			break;
+		case 'h':
+			usage(argv);
+			break;
+	}
+}
+
+static int cycle(double *init_time, double *shutdown_time)
+{
+	struct starpu_conf conf;
+	double start, end;
+	int ret;
+
+	starpu_conf_init(&conf);
+	conf.ncpus = ncpus;
+
+	start = now();
+	ret = starpu_init(&conf);
+	end = now();
+	if (ret == -ENODEV) return ret;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+	*init_time = end - start;
+
+	/* Run one task, as a library call would do */
+	ret = starpu_task_insert(&dummy_codelet, 0);
+	if (ret == -ENODEV)
+	{
+		starpu_shutdown();
+		return ret;
+	}
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	starpu_task_wait_for_all();
+
+	start = now();
+	starpu_shutdown();
+	end = now();
+	*shutdown_time = end - start;
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	double first_init, first_shutdown;
+	double init_time, shutdown_time;
+	double total_init = 0., total_shutdown = 0.;
+	unsigned i;
+	int ret;
+
+	parse_args(argc, argv);
+
+	/* The first cycle discovers the machine */
+	ret = cycle(&first_init, &first_shutdown);
+	if (ret == -ENODEV) goto enodev;
+
+	for (i = 0; i < ncycles; i++)
+	{
+		ret = cycle(&init_time, &shutdown_time);
+		if (ret == -ENODEV) goto enodev;
+		total_init += init_time;
+		total_shutdown += shutdown_time;
+	}
+
+	fprintf(stderr, "#cycles : %u\n", ncycles);
+	fprintf(stderr, "First init: %f msecs\n", first_init/1000);
+	fprintf(stderr, "First shutdown: %f msecs\n", first_shutdown/1000);
+	fprintf(stderr, "Per init: %f msecs\n", total_init/ncycles/1000);
+	fprintf(stderr, "Per shutdown: %f msecs\n", total_shutdown/ncycles/1000);
+
+	{
+		char *output_dir = getenv("STARPU_BENCH_DIR");
+		char *bench_id = getenv("STARPU_BENCH_ID");
+
+		if (output_dir && bench_id)
+		{
+			char file[1024];
+			FILE *f;
+
+			snprintf(file, sizeof(file), "%s/init_shutdown_overhead_init.dat", output_dir);
+			f = fopen(file, "a");
+			fprintf(f, "%s\t%f\n", bench_id, total_init/ncycles/1000);
+			fclose(f);
+
+			snprintf(file, sizeof(file), "%s/init_shutdown_overhead_shutdown.dat", output_dir);
+			f = fopen(file, "a");
+			fprintf(f, "%s\t%f\n", bench_id, total_shutdown/ncycles/1000);
+			fclose(f);
+		}
+	}
+
+	return EXIT_SUCCESS;
+
+enodev:
+	fprintf(stderr, "WARNING: No one can execute this task\n");
+	return STARPU_TEST_SKIPPED;
+}
@@ -0,0 +1,108 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2014-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+#include <stdio.h>
+
+/*
+ * Check that starpu_omp_data_lookup_overlaps() finds the registered handles
+ * whose data overlaps a given piece of memory.
+ */
+
+#if !defined(STARPU_OPENMP)
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+#define	NX	100
+int global_vector[NX];
+
+__attribute__((constructor))
+static void omp_constructor(void)
+{
+	int ret = starpu_omp_init();
+	if (ret == -EINVAL) exit(STARPU_TEST_SKIPPED);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_omp_init");
+}
+
+__attribute__((destructor))
+static void omp_destructor(void)
+{
+	starpu_omp_shutdown();
+}
+
+static int count(int first, int nx)
+{
+	starpu_data_handle_t handles[4];
+	return starpu_omp_data_lookup_overlaps(&global_vector[first], nx * sizeof(global_vector[0]), handles, 4);
+}
+
+int main(void)
+{
+	starpu_data_handle_t handles[4];
+	starpu_data_handle_t found[3];
+	int i, n;
+
+	/* [0,10), [10,20) and [5,15) */
+	starpu_vector_data_register(&handles[0], STARPU_MAIN_RAM, (uintptr_t)&global_vector[0], 10, sizeof(global_vector[0]));
+	starpu_vector_data_register(&handles[1], STARPU_MAIN_RAM, (uintptr_t)&global_vector[10], 10, sizeof(global_vector[0]));
+	starpu_vector_data_register(&handles[2], STARPU_MAIN_RAM, (uintptr_t)&global_vector[5], 10, sizeof(global_vector[0]));
+	/* A padded 4x3 matrix with ld = 10 spans [50,74), although it only
+	 * contains 12 elements */
+	starpu_matrix_data_register(&handles[3], STARPU_MAIN_RAM, (uintptr_t)&global_vector[50], 10, 4, 3, sizeof(global_vector[0]));
+	for (i = 0; i < 4; i++)
+		starpu_omp_handle_register(handles[i]);
+
+	n = count(0, 5);
+	STARPU_ASSERT(n == 1);
+	n = count(4, 1);
+	STARPU_ASSERT(n == 1);
+	n = count(8, 1);
+	STARPU_ASSERT(n == 2);
+	n = count(9, 2);
+	STARPU_ASSERT(n == 3);
+	n = count(15, 5);
+	STARPU_ASSERT(n == 1);
+	n = count(20, 10);
+	STARPU_ASSERT(n == 0);
+	n = count(70, 1);
+	STARPU_ASSERT(n == 1);
+	n = count(74, 10);
+	STARPU_ASSERT(n == 0);
+	n = count(0, NX);
+	STARPU_ASSERT(n == 4);
+
+	n = starpu_omp_data_lookup_overlaps(&global_vector[12], sizeof(global_vector[0]), found, 3);
+	STARPU_ASSERT(n == 2);
+	STARPU_ASSERT((found[0] == handles[2] && found[1] == handles[1]) || (found[0] == handles[1] && found[1] == handles[2]));
+
+	/* At most max handles are returned */
+	n = starpu_omp_data_lookup_overlaps(global_vector, sizeof(global_vector), found, 1);
+	STARPU_ASSERT(n == 4);
+
+	for (i = 0; i < 4; i++)
+	{
+		starpu_omp_handle_unregister(handles[i]);
+		starpu_data_unregister(handles[i]);
+	}
+	n = count(0, NX);
+	STARPU_ASSERT(n == 0);
+
+	return 0;
+}
+#endif
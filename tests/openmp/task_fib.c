@@ -0,0 +1,148 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2014-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+#include <stdio.h>
+
+/*
+ * Compute Fibonacci numbers recursively with OpenMP explicit tasks and
+ * taskwait, as done by the BOTS fib benchmark. This generates a lot of tiny
+ * tasks, and thus exercises the task cutoff (see STARPU_OMP_TASK_CUTOFF).
+ */
+
+#if !defined(STARPU_OPENMP)
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+#ifdef STARPU_QUICK_CHECK
+#define N 15
+#else
+#define N 22
+#endif
+
+__attribute__((constructor))
+static void omp_constructor(void)
+{
+	int ret = starpu_omp_init();
+	if (ret == -EINVAL) exit(STARPU_TEST_SKIPPED);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_omp_init");
+}
+
+__attribute__((destructor))
+static void omp_destructor(void)
+{
+	starpu_omp_shutdown();
+}
+
+struct fib_arg
+{
+	int n;
+	long *result;
+};
+
+static long fib_seq(int n)
+{
+	return n < 2 ? n : fib_seq(n-1) + fib_seq(n-2);
+}
+
+void fib_task(void *buffers[], void *args);
+
+static void fib_spawn(int n, long *result)
+{
+	struct starpu_omp_task_region_attr attr;
+	struct fib_arg *arg;
+
+	memset(&attr, 0, sizeof(attr));
+#ifdef STARPU_SIMGRID
+	attr.cl.model         = &starpu_perfmodel_nop;
+#endif
+	attr.cl.flags         = STARPU_CODELET_SIMGRID_EXECUTE;
+	attr.cl.cpu_funcs[0]  = fib_task;
+	attr.cl.where         = STARPU_CPU;
+	attr.if_clause        = 1;
+	attr.final_clause     = 0;
+	attr.untied_clause    = 1;
+	attr.mergeable_clause = 0;
+
+	arg = malloc(sizeof(*arg));
+	arg->n = n;
+	arg->result = result;
+	attr.cl_arg = arg;
+	attr.cl_arg_size = sizeof(*arg);
+	attr.cl_arg_free = 1;
+	starpu_omp_task_region(&attr);
+}
+
+void fib_task(void *buffers[], void *args)
+{
+	(void) buffers;
+	struct fib_arg *arg = args;
+	long x, y;
+
+	if (arg->n < 2)
+	{
+		*arg->result = arg->n;
+		return;
+	}
+
+	fib_spawn(arg->n - 1, &x);
+	fib_spawn(arg->n - 2, &y);
+	starpu_omp_taskwait();
+	*arg->result = x + y;
+}
+
+static long result;
+
+void spawn_fib(void *arg)
+{
+	(void) arg;
+	double start, end;
+
+	start = starpu_timing_now();
+	fib_spawn(N, &result);
+	starpu_omp_taskwait();
+	end = starpu_timing_now();
+
+	FPRINTF(stderr, "fib(%d) = %ld in %f ms\n", N, result, (end - start) / 1000.);
+}
+
+void parallel_region_f(void *buffers[], void *args)
+{
+	(void) buffers;
+	(void) args;
+	starpu_omp_single(spawn_fib, NULL, 0);
+}
+
+int main(void)
+{
+	struct starpu_omp_parallel_region_attr attr;
+	memset(&attr, 0, sizeof(attr));
+#ifdef STARPU_SIMGRID
+	attr.cl.model        = &starpu_perfmodel_nop;
+#endif
+	attr.cl.flags        = STARPU_CODELET_SIMGRID_EXECUTE;
+	attr.cl.cpu_funcs[0] = parallel_region_f;
+	attr.cl.where        = STARPU_CPU;
+	attr.if_clause       = 1;
+	starpu_omp_parallel_region(&attr);
+	STARPU_ASSERT(result == fib_seq(N));
+	return 0;
+}
+#endif
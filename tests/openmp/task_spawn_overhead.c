@@ -0,0 +1,113 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2014-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+#include <stdio.h>
+
+/*
+ * Measure the cost of spawning and running small OpenMP explicit tasks,
+ * which each run on their own stack.
+ */
+
+#if !defined(STARPU_OPENMP)
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS 1000
+#else
+#define NTASKS 20000
+#endif
+
+static unsigned nexecuted;
+
+__attribute__((constructor))
+static void omp_constructor(void)
+{
+	int ret = starpu_omp_init();
+	if (ret == -EINVAL) exit(STARPU_TEST_SKIPPED);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_omp_init");
+}
+
+__attribute__((destructor))
+static void omp_destructor(void)
+{
+	starpu_omp_shutdown();
+}
+
+void task_region_g(void *buffers[], void *args)
+{
+	(void) buffers;
+	(void) args;
+	(void) STARPU_ATOMIC_ADD(&nexecuted, 1);
+}
+
+void spawn_tasks(void *arg)
+{
+	(void) arg;
+	struct starpu_omp_task_region_attr attr;
+	double start, end;
+	int i;
+
+	memset(&attr, 0, sizeof(attr));
+#ifdef STARPU_SIMGRID
+	attr.cl.model         = &starpu_perfmodel_nop;
+#endif
+	attr.cl.flags         = STARPU_CODELET_SIMGRID_EXECUTE;
+	attr.cl.cpu_funcs[0]  = task_region_g;
+	attr.cl.where         = STARPU_CPU;
+	attr.if_clause        = 1;
+	attr.final_clause     = 0;
+	attr.untied_clause    = 1;
+	attr.mergeable_clause = 0;
+
+	start = starpu_timing_now();
+	for (i = 0; i < NTASKS; i++)
+		starpu_omp_task_region(&attr);
+	starpu_omp_taskwait();
+	end = starpu_timing_now();
+
+	FPRINTF(stderr, "#tasks : %d\n", NTASKS);
+	FPRINTF(stderr, "Per task: %f usecs\n", (end - start) / NTASKS);
+}
+
+void parallel_region_f(void *buffers[], void *args)
+{
+	(void) buffers;
+	(void) args;
+	starpu_omp_single(spawn_tasks, NULL, 0);
+}
+
+int main(void)
+{
+	struct starpu_omp_parallel_region_attr attr;
+	memset(&attr, 0, sizeof(attr));
+#ifdef STARPU_SIMGRID
+	attr.cl.model        = &starpu_perfmodel_nop;
+#endif
+	attr.cl.flags        = STARPU_CODELET_SIMGRID_EXECUTE;
+	attr.cl.cpu_funcs[0] = parallel_region_f;
+	attr.cl.where        = STARPU_CPU;
+	attr.if_clause       = 1;
+	starpu_omp_parallel_region(&attr);
+	STARPU_ASSERT(nexecuted == NTASKS);
+	return 0;
+}
+#endif
@@ -0,0 +1,179 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2011-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <core/perfmodel/perfmodel.h>
+#include "../helper.h"
+
+/*
+ * Check that several processes calibrating the same performance model in
+ * the same directory do not lose each other's measurements
+ */
+
+#if defined(STARPU_HAVE_WINDOWS) || !defined(STARPU_HAVE_SETENV) || defined(STARPU_SIMGRID)
+#warning fork or setenv are not available. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define NPROCS 4
+#ifdef STARPU_QUICK_CHECK
+#define NSAMPLES 10
+#else
+#define NSAMPLES 100
+#endif
+
+static struct starpu_perfmodel model =
+{
+	.type = STARPU_REGRESSION_BASED,
+	.symbol = "concurrent_save"
+};
+
+static struct starpu_codelet cl =
+{
+	.model = &model,
+	.nbuffers = 1,
+	.modes = {STARPU_W}
+};
+
+static int init(void)
+{
+	struct starpu_conf conf;
+
+	starpu_conf_init(&conf);
+	starpu_conf_noworker(&conf);
+	conf.ncpus = 1;
+	return starpu_init(&conf);
+}
+
+/* Record NSAMPLES measurements in each process, the model gets saved on shutdown */
+static int feed(void)
+{
+	struct starpu_task task;
+	struct starpu_perfmodel_device device = { .type = STARPU_CPU_WORKER, .devid = 0, .ncores = 1 };
+	struct starpu_perfmodel_arch arch = { .ndevices = 1, .devices = &device };
+	starpu_data_handle_t handle;
+	int ret, i;
+
+	ret = init();
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	starpu_vector_data_register(&handle, -1, 0, 1024, sizeof(float));
+	starpu_task_init(&task);
+	task.cl = &cl;
+	task.handles[0] = handle;
+	for (i = 0; i < NSAMPLES; i++)
+		starpu_perfmodel_update_history(&model, &task, &arch, 0, 0, 100. + (i % 10));
+	starpu_task_clean(&task);
+	starpu_data_unregister(handle);
+
+	starpu_shutdown();
+	return EXIT_SUCCESS;
+}
+
+int main(void)
+{
+	char dir[256];
+	char *tpath;
+	pid_t pids[NPROCS];
+	int ret, i, status;
+
+	tpath = starpu_getenv("TMPDIR");
+	if (!tpath)
+		tpath = "/tmp";
+	snprintf(dir, sizeof(dir), "%s/starpu_sampling_XXXXXX", tpath);
+	if (!_starpu_mkdtemp(dir))
+	{
+		FPRINTF(stderr, "Cannot make directory '%s'\n", dir);
+		return STARPU_TEST_SKIPPED;
+	}
+	setenv("STARPU_PERF_MODEL_DIR", dir, 1);
+	setenv("STARPU_HOSTNAME", "concurrent_save", 1);
+
+	/* Calibrate the bus once before forking */
+	ret = init();
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+	starpu_shutdown();
+
+	for (i = 0; i < NPROCS; i++)
+	{
+		pids[i] = fork();
+		STARPU_ASSERT(pids[i] >= 0);
+		if (pids[i] == 0)
+			_exit(feed());
+	}
+
+	ret = EXIT_SUCCESS;
+	for (i = 0; i < NPROCS; i++)
+	{
+		waitpid(pids[i], &status, 0);
+		if (!WIFEXITED(status))
+			ret = EXIT_FAILURE;
+		else if (WEXITSTATUS(status) == STARPU_TEST_SKIPPED)
+			ret = STARPU_TEST_SKIPPED;
+		else if (WEXITSTATUS(status) != EXIT_SUCCESS)
+			ret = EXIT_FAILURE;
+	}
+	if (ret != EXIT_SUCCESS)
+		goto out;
+
+	/* Check that all processes' measurements are there */
+	struct starpu_perfmodel lmodel;
+	unsigned nsamples = 0, nentries_samples = 0;
+
+	ret = init();
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+	memset(&lmodel, 0, sizeof(lmodel));
+	lmodel.type = model.type;
+	ret = starpu_perfmodel_load_symbol(model.symbol, &lmodel);
+	STARPU_ASSERT_MSG(ret != 1, "The performance model could not be loaded\n");
+	for (i = 0; i < lmodel.state->ncombs; i++)
+	{
+		int comb = lmodel.state->combs[i];
+		int impl;
+		for (impl = 0; impl < lmodel.state->nimpls[comb]; impl++)
+		{
+			struct starpu_perfmodel_history_list *ptr;
+			nsamples += lmodel.state->per_arch[comb][impl].regression.nsample;
+			for (ptr = lmodel.state->per_arch[comb][impl].list; ptr; ptr = ptr->next)
+				nentries_samples += ptr->entry->nsample;
+		}
+	}
+	starpu_perfmodel_unload_model(&lmodel);
+	starpu_shutdown();
+
+	FPRINTF(stderr, "%u regression samples and %u history samples, expected %u\n", nsamples, nentries_samples, NPROCS * NSAMPLES);
+	if (nsamples != NPROCS * NSAMPLES || nentries_samples != NPROCS * NSAMPLES)
+		ret = EXIT_FAILURE;
+
+out:
+	{
+		char cmd[512];
+		snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+		if (system(cmd) != 0)
+			FPRINTF(stderr, "Could not remove %s\n", dir);
+	}
+	return ret;
+}
+#endif
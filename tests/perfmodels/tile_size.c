@@ -0,0 +1,162 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <math.h>
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Test the starpu_perfmodel_select_tile_size function, on a sweep over the
+ * tiles of a matrix, whose model is fed with starpu_perfmodel_update_history
+ */
+
+#if !defined(STARPU_HAVE_SETENV)
+#warning setenv is not defined. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+#define N 4096
+#define NSAMPLES 16
+
+static const unsigned tiles[] = { 64, 128, 256, 512, 1024 };
+#define NTILES (sizeof(tiles)/sizeof(tiles[0]))
+
+void func_cpu(void *descr[], void *arg)
+{
+	(void)descr;
+	(void)arg;
+}
+
+static struct starpu_perfmodel model =
+{
+	.type = STARPU_REGRESSION_BASED,
+	.symbol = "tile_size"
+};
+
+static struct starpu_codelet cl =
+{
+	.cpu_funcs = {func_cpu},
+	.model = &model,
+	.nbuffers = 1,
+	.modes = {STARPU_RW}
+};
+
+static double ntasks(unsigned tile, void *arg)
+{
+	(void)arg;
+	return ((double) N / tile) * ((double) N / tile);
+}
+
+/* Each tile depends on the previous one */
+static double ncritical(unsigned tile, void *arg)
+{
+	return ntasks(tile, arg);
+}
+
+static size_t size(unsigned tile, void *arg)
+{
+	(void)arg;
+	return (size_t) tile * tile * sizeof(double);
+}
+
+static void feed(unsigned tile)
+{
+	starpu_data_handle_t handle;
+	struct starpu_task task;
+	unsigned worker, i;
+
+	starpu_matrix_data_register(&handle, -1, 0, tile, tile, tile, sizeof(double));
+	starpu_task_init(&task);
+	task.cl = &cl;
+	task.handles[0] = handle;
+
+	for (worker = 0; worker < starpu_worker_get_count(); worker++)
+	{
+		struct starpu_perfmodel_arch *arch = starpu_worker_get_perf_archtype(worker, STARPU_NMAX_SCHED_CTXS);
+		if (starpu_worker_get_type(worker) != STARPU_CPU_WORKER)
+			continue;
+		for (i = 0; i < NSAMPLES; i++)
+			starpu_perfmodel_update_history(&model, &task, arch, worker, 0, 1e-6 * tile * tile * tile);
+	}
+
+	starpu_task_clean(&task);
+	starpu_data_unregister(handle);
+}
+
+int main(void)
+{
+	struct starpu_tile_size_kernel kernel =
+	{
+		.cl = &cl,
+		.ntasks = ntasks,
+		.ncritical = ncritical,
+		.size = size,
+	};
+	struct starpu_conf conf;
+	double makespan;
+	unsigned tile, i;
+	int ret;
+
+	starpu_conf_init(&conf);
+	/* Start from an empty model */
+	conf.calibrate = 2;
+	conf.ncuda = 0;
+	conf.nhip = 0;
+	conf.nopencl = 0;
+	conf.nmpi_ms = 0;
+	conf.ntcpip_ms = 0;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (starpu_cpu_worker_get_count() == 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	/* Nothing is known, the first tile size should be tried */
+	tile = starpu_perfmodel_select_tile_size(&kernel, 1, tiles, NTILES, &makespan);
+	STARPU_ASSERT(tile == tiles[0] && isnan(makespan));
+
+	/* Then one which was never measured */
+	feed(tiles[0]);
+	tile = starpu_perfmodel_select_tile_size(&kernel, 1, tiles, NTILES, &makespan);
+	STARPU_ASSERT(tile == tiles[1] && isnan(makespan));
+
+	for (i = 1; i < NTILES; i++)
+		feed(tiles[i]);
+
+	/* Without overhead, smaller tiles have less work */
+	setenv("STARPU_TILE_SIZE_TASK_OVERHEAD", "0", 1);
+	tile = starpu_perfmodel_select_tile_size(&kernel, 1, tiles, NTILES, &makespan);
+	FPRINTF(stderr, "without overhead: tile size %u, makespan %f us\n", tile, makespan);
+	STARPU_ASSERT(tile == tiles[0] && !isnan(makespan));
+
+	/* With a huge overhead per task, bigger tiles are better */
+	setenv("STARPU_TILE_SIZE_TASK_OVERHEAD", "1000000", 1);
+	tile = starpu_perfmodel_select_tile_size(&kernel, 1, tiles, NTILES, &makespan);
+	FPRINTF(stderr, "with overhead: tile size %u, makespan %f us\n", tile, makespan);
+	STARPU_ASSERT(tile == tiles[NTILES-1] && !isnan(makespan));
+
+	starpu_shutdown();
+
+	return EXIT_SUCCESS;
+}
+#endif
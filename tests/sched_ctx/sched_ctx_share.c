@@ -0,0 +1,123 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2017-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Check that contexts sharing their workers lend them to each other with a
+ * lower priority, and that tasks of a context can then be executed by the
+ * workers of the other context: while the only worker of a context is busy
+ * with one of its tasks, another ready task of the context has to be executed
+ * by the worker borrowed from the other context.
+ */
+
+/* Only bounds the wait when the worker is not lent, in microseconds */
+#define TIMEOUT	(10*1000000.)
+
+static unsigned nexecuted[STARPU_NMAXWORKERS];
+static unsigned nstarted;
+static int timedout;
+
+void func_cpu(void *descr[], void *arg)
+{
+	double start = starpu_timing_now();
+	(void)descr;
+	(void)arg;
+	(void)STARPU_ATOMIC_ADD(&nexecuted[starpu_worker_get_id_check()], 1);
+	(void)STARPU_ATOMIC_ADD(&nstarted, 1);
+
+	/* Keep this worker busy until the other task has started */
+	while (STARPU_ATOMIC_ADD(&nstarted, 0) < 2)
+	{
+		if (starpu_timing_now() - start > TIMEOUT)
+		{
+			timedout = 1;
+			break;
+		}
+		starpu_usleep(1000);
+	}
+}
+
+struct starpu_codelet mycodelet =
+{
+	.cpu_funcs = {func_cpu},
+	.cpu_funcs_name = {"func_cpu"},
+	.nbuffers = 0,
+};
+
+int main(void)
+{
+	int ret, i;
+	int nprocs;
+	int procs[STARPU_NMAXWORKERS];
+	unsigned sched_ctxs[2];
+	int failed = 0;
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	nprocs = starpu_cpu_worker_get_count();
+	if (nprocs < 2)
+	{
+		starpu_shutdown();
+		FPRINTF(stderr, "This test needs at least 2 CPU workers\n");
+		return STARPU_TEST_SKIPPED;
+	}
+	starpu_worker_get_ids_by_type(STARPU_CPU_WORKER, procs, nprocs);
+
+	sched_ctxs[0] = starpu_sched_ctx_create(&procs[0], 1, "ctx_0", STARPU_SCHED_CTX_POLICY_NAME, "eager", 0);
+	sched_ctxs[1] = starpu_sched_ctx_create(&procs[1], 1, "ctx_1", STARPU_SCHED_CTX_POLICY_NAME, "eager", 0);
+
+	starpu_sched_ctx_share_workers(sched_ctxs, 2, 1);
+
+	/* Each worker is now also in the other context, with a lower priority */
+	STARPU_ASSERT(starpu_sched_ctx_contains_worker(procs[0], sched_ctxs[1]));
+	STARPU_ASSERT(starpu_sched_ctx_contains_worker(procs[1], sched_ctxs[0]));
+	STARPU_ASSERT(starpu_sched_ctx_get_nworkers(sched_ctxs[0]) == 2);
+	STARPU_ASSERT(starpu_sched_ctx_get_nworkers(sched_ctxs[1]) == 2);
+	STARPU_ASSERT(starpu_sched_ctx_get_priority(procs[0], sched_ctxs[0]) > starpu_sched_ctx_get_priority(procs[0], sched_ctxs[1]));
+	STARPU_ASSERT(starpu_sched_ctx_get_priority(procs[1], sched_ctxs[1]) > starpu_sched_ctx_get_priority(procs[1], sched_ctxs[0]));
+
+	/* Only the second context has work, each task waits for the other
+	 * one, which can thus only be executed by the borrowed worker */
+	for (i = 0; i < 2; i++)
+	{
+		ret = starpu_task_insert(&mycodelet, STARPU_SCHED_CTX, sched_ctxs[1], 0);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_task_wait_for_all();
+
+	FPRINTF(stderr, "worker %d executed %u tasks, worker %d executed %u tasks\n", procs[0], nexecuted[procs[0]], procs[1], nexecuted[procs[1]]);
+	STARPU_ASSERT(nexecuted[procs[0]] + nexecuted[procs[1]] == 2);
+	if (timedout || nexecuted[procs[0]] != 1)
+	{
+		FPRINTF(stderr, "the borrowed worker did not execute a task of the other context\n");
+		failed = 1;
+	}
+
+	starpu_sched_ctx_delete(sched_ctxs[0]);
+	starpu_sched_ctx_delete(sched_ctxs[1]);
+	starpu_shutdown();
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+
+enodev:
+	starpu_shutdown();
+	fprintf(stderr, "WARNING: No one can execute this task\n");
+	return STARPU_TEST_SKIPPED;
+}